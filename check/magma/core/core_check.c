@@ -197,6 +197,21 @@ START_TEST (check_inx_hashed_s) {
 }
 END_TEST
 
+START_TEST (check_inx_hashed_growth_s) {
+
+	log_disable();
+	bool_t outcome = true;
+	char *errmsg = NULL;
+
+	if (!check_indexes_hashed_growth(&errmsg)) {
+		outcome = false;
+	}
+
+	log_test("CORE / INDEX / HASHED GROWTH / SINGLE THREADED:", NULLER(errmsg));
+	ck_assert_msg(outcome, errmsg);
+}
+END_TEST
+
 START_TEST (check_inx_hashed_m) {
 
 	log_disable();
@@ -442,6 +457,19 @@ START_TEST (check_reallocation)	{
 }
 END_TEST
 
+START_TEST (check_import) {
+
+	log_disable();
+	stringer_t *errmsg = NULL;
+
+	if (!check_string_import()) errmsg = NULLER("Standard import check failed.");
+	else if (!check_string_import_mapped()) errmsg = NULLER("Mapped file import check failed.");
+
+	log_test("CORE / STRINGS / IMPORT / SINGLE THREADED:", errmsg);
+	ck_assert_msg(!errmsg, st_char_get(errmsg));
+}
+END_TEST
+
 START_TEST (check_duplication) {
 
 	log_disable();
@@ -721,6 +749,22 @@ START_TEST (check_zbase32) {
 }
 END_TEST
 
+START_TEST (check_memory_span)
+{
+
+	log_disable();
+	bool_t outcome = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (status() && !check_memory_span_sthread(errmsg)) {
+		outcome = false;
+	}
+
+	log_test("CORE / MEMORY / SPAN TEXT / SINGLE THREADED:", errmsg);
+	ck_assert_msg(outcome, st_char_get(errmsg));
+}
+END_TEST
+
 START_TEST (check_checksum)
 {
 
@@ -920,6 +964,7 @@ Suite * suite_check_core(void) {
 	suite_check_testcase(s, "CORE", "Strings / Allocation", check_allocation);
 	suite_check_testcase(s, "CORE", "Strings / Reallocation", check_reallocation);
 	suite_check_testcase(s, "CORE", "Strings / Duplication", check_duplication);
+	suite_check_testcase(s, "CORE", "Strings / Import", check_import);
 	suite_check_testcase(s, "CORE", "Strings / Merge", check_merge);
 	suite_check_testcase(s, "CORE", "Strings / Print", check_print);
 	suite_check_testcase(s, "CORE", "Strings / Write", check_write);
@@ -928,6 +973,7 @@ Suite * suite_check_core(void) {
 	suite_check_testcase(s, "CORE", "Strings / Bitwise Operations", check_bitwise);
 
 	suite_check_testcase(s, "CORE", "Memory / Checksum", check_checksum);
+	suite_check_testcase(s, "CORE", "Memory / Span Text", check_memory_span);
 	suite_check_testcase(s, "CORE", "Memory / Secure Address Range", check_secmem);
 
 	suite_check_testcase(s, "CORE", "Host / System / Signal Names", check_signames_s);
@@ -952,6 +998,7 @@ Suite * suite_check_core(void) {
 	suite_check_testcase(s, "CORE", "Indexes / Linked/M", check_inx_linked_m);
 	suite_check_testcase(s, "CORE", "Indexes / Hashed/S", check_inx_hashed_s);
 	suite_check_testcase(s, "CORE", "Indexes / Hashed/M", check_inx_hashed_m);
+	suite_check_testcase(s, "CORE", "Indexes / Hashed Growth/S", check_inx_hashed_growth_s);
 	suite_check_testcase(s, "CORE", "Indexes / Tree/S", check_inx_tree_s);
 	suite_check_testcase(s, "CORE", "Indexes / Tree/M", check_inx_tree_m);
 	suite_check_testcase(s, "CORE", "Indexes / Linked Cursor/S", check_inx_linked_cursor_s);
@@ -215,6 +215,7 @@ chr_t * check_clamp_min_max_invalid(void);
 bool_t   check_string_alloc(uint32_t check);
 bool_t   check_string_dupe(uint32_t check);
 bool_t   check_string_import(void);
+bool_t   check_string_import_mapped(void);
 bool_t   check_string_merge(void);
 bool_t   check_string_print(void);
 bool_t   check_string_write(void);
@@ -261,6 +262,7 @@ bool_t   check_encoding_base64_mod(bool_t secure_on);
 /// hashed_check.c
 bool_t   check_indexes_hashed_cursor(char **errmsg);
 bool_t   check_indexes_hashed_cursor_compare(uint64_t values[], inx_cursor_t *cursor);
+bool_t   check_indexes_hashed_growth(char **errmsg);
 bool_t   check_indexes_hashed_simple(char **errmsg);
 
 /// system_check.c
@@ -288,6 +290,10 @@ bool_t   check_bitwise_parameters(void);
 bool_t   check_bitwise_determinism(void);
 bool_t   check_bitwise_simple(void);
 
+/// memory_check.c
+size_t check_memory_span_reference(const uchr_t *data, size_t len, bool_t ascii);
+bool_t check_memory_span_sthread(stringer_t *errmsg);
+
 /// checksum_check.c
 bool_t check_checksum_fuzz_sthread(void);
 bool_t check_checksum_fixed_sthread(void);
@@ -210,3 +210,73 @@ bool_t check_indexes_hashed_simple(char **errmsg) {
 	return true;
 }
 
+bool_t check_indexes_hashed_growth(char **errmsg) {
+
+	void *val;
+	inx_t *inx;
+	multi_t key;
+	uint64_t options[] = { M_INX_HASHED, M_INX_HASHED | M_INX_LOCK_MANUAL };
+
+	// Sequential keys force the table to double several times, after which every record should still be found exactly once.
+	for (uint_t i = 0; status() && i < (sizeof(options) / sizeof(uint64_t)); i++) {
+
+		if (!(inx = inx_alloc(options[i], mm_free))) {
+			*errmsg = "index allocation failed";
+			return false;
+		}
+
+		mm_wipe(&key, sizeof(multi_t));
+		key.type = M_TYPE_UINT64;
+
+		for (uint64_t j = 0; status() && j < (HASHED_INSERTS_CHECK * 8); j++) {
+
+			if (!(val = mm_alloc(sizeof(uint64_t)))) {
+				*errmsg = "value buffer allocation failed";
+				inx_free(inx);
+				return false;
+			}
+
+			key.val.u64 = j;
+			mm_copy(val, &j, sizeof(uint64_t));
+
+			if (!inx_insert(inx, key, val)) {
+				*errmsg = "insert operation failed";
+				inx_free(inx);
+				mm_free(val);
+				return false;
+			}
+		}
+
+		if (inx_count(inx) != (HASHED_INSERTS_CHECK * 8)) {
+			*errmsg = "record count mismatch after growing the index";
+			inx_free(inx);
+			return false;
+		}
+
+		for (uint64_t j = 0; status() && j < (HASHED_INSERTS_CHECK * 8); j++) {
+
+			key.val.u64 = j;
+
+			if (!(val = inx_find(inx, key)) || *((uint64_t *)val) != j) {
+				*errmsg = "find operation failed after growing the index";
+				inx_free(inx);
+				return false;
+			}
+			else if (j % 2 == 0 && !inx_delete(inx, key)) {
+				*errmsg = "delete operation failed after growing the index";
+				inx_free(inx);
+				return false;
+			}
+		}
+
+		if (inx_count(inx) != (HASHED_INSERTS_CHECK * 4)) {
+			*errmsg = "record count mismatch after deleting from the index";
+			inx_free(inx);
+			return false;
+		}
+
+		inx_free(inx);
+	}
+
+	return true;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file /check/magma/core/memory_check.c
+ *
+ * @brief The memory scanning test cases.
+ */
+
+#include "magma_check.h"
+
+/**
+ * @brief	Count the bytes at the start of a buffer which aren't a line break, using a simple byte by byte scan.
+ * @note	This is the reference which mm_span_text() is checked against, since the vectorized scan must always agree with it.
+ */
+size_t check_memory_span_reference(const uchr_t *data, size_t len, bool_t ascii) {
+
+	for (size_t i = 0; i < len; i++) {
+		if (data[i] == '\r' || data[i] == '\n' || (ascii && data[i] >= 0x80)) {
+			return i;
+		}
+	}
+
+	return len;
+}
+
+/**
+ * @brief	Compare mm_span_text() against the byte by byte reference with line breaks, dot stuffed lines and high bytes placed on
+ * 			either side of the 16 and 32 byte vector boundaries, and at the end of the buffer.
+ * @return	True if every span matched the reference, false otherwise.
+ */
+bool_t check_memory_span_sthread(stringer_t *errmsg) {
+
+	uchr_t buffer[128 + 1];
+	size_t got, expected, lengths[] = { 0, 1, 15, 16, 17, 31, 32, 33, 48, 63, 64, 65, 96, 128 }, offsets[] = { 0, 15, 16, 17, 31, 32, 33 };
+	chr_t *patterns[] = { "\r", "\n", "\r\n", "\r\n.\r\n", "\n.\n", "\r\n..\r\n", "\n..", ".\r\n", "\x80", "\xff", "\xc3\xa9" };
+
+	for (size_t l = 0; l < (sizeof(lengths) / sizeof(size_t)); l++) {
+		for (size_t p = 0; p < (sizeof(patterns) / sizeof(chr_t *)); p++) {
+
+			// The fixed offsets, plus the end of the buffer, where the pattern may be cut short.
+			for (size_t o = 0; o <= (sizeof(offsets) / sizeof(size_t)); o++) {
+
+				size_t offset = (o < (sizeof(offsets) / sizeof(size_t))) ? offsets[o] : (lengths[l] ? lengths[l] - 1 : 0);
+
+				// Fill the buffer with plain text, then place the pattern, and scan from each byte of misalignment.
+				for (size_t i = 0; i < sizeof(buffer); i++) {
+					buffer[i] = 'a' + (i % 26);
+				}
+
+				for (size_t i = 0; patterns[p][i] && offset + i < sizeof(buffer); i++) {
+					buffer[offset + i] = (uchr_t)patterns[p][i];
+				}
+
+				for (size_t shift = 0; shift < 2 && shift <= lengths[l]; shift++) {
+					for (int_t ascii = 0; ascii < 2; ascii++) {
+
+						expected = check_memory_span_reference(buffer + shift, lengths[l] - shift, ascii);
+
+						if ((got = mm_span_text(buffer + shift, lengths[l] - shift, ascii)) != expected) {
+							st_sprint(errmsg, "The text span didn't match the byte by byte scan. { length = %zu / offset = %zu / pattern = %zu / "
+								"shift = %zu / ascii = %i / expected = %zu / got = %zu }", lengths[l] - shift, offset, p, shift, ascii, expected, got);
+							return false;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// Random data, which mixes every byte value, including the line breaks and high bytes, at random positions.
+	for (size_t i = 0; status() && i < 4096; i++) {
+
+		size_t length = (rand_get_uint8() % sizeof(buffer));
+
+		if (rand_write(PLACER(buffer, sizeof(buffer))) != sizeof(buffer)) {
+			st_sprint(errmsg, "Unable to generate the random data.");
+			return false;
+		}
+
+		// Without this, almost every random buffer would end at the first byte when the ASCII limit applies.
+		for (size_t j = 0; j < length; j++) {
+			if (rand_get_uint8() < 192) buffer[j] &= 0x7f;
+		}
+
+		for (int_t ascii = 0; ascii < 2; ascii++) {
+			if ((got = mm_span_text(buffer, length, ascii)) != (expected = check_memory_span_reference(buffer, length, ascii))) {
+				st_sprint(errmsg, "The text span of random data didn't match the byte by byte scan. { length = %zu / ascii = %i / "
+					"expected = %zu / got = %zu }", length, ascii, expected, got);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
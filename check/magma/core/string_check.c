@@ -189,6 +189,38 @@ bool_t check_string_import(void) {
 	return true;
 }
 
+bool_t check_string_import_mapped(void) {
+
+	int fd;
+	stringer_t *s;
+	size_t offset = 17;
+
+	// Write the constant into a temporary file at an offset which isn't page aligned.
+	if ((fd = spool_mktemp(MAGMA_SPOOL_DATA, "check")) == -1) {
+		return false;
+	}
+	else if (pwrite(fd, st_data_get(string_check_constant), st_length_get(string_check_constant), offset) != st_length_get(string_check_constant)) {
+		close(fd);
+		return false;
+	}
+
+	// On success the string owns the descriptor.
+	if (!(s = st_import_mapped(fd, offset, st_length_get(string_check_constant)))) {
+		close(fd);
+		return false;
+	}
+
+	if (st_length_get(s) != st_length_get(string_check_constant) || memcmp(st_char_get(s), st_char_get(string_check_constant),
+		st_length_get(string_check_constant))) {
+		st_free(s);
+		return false;
+	}
+
+	st_free(s);
+
+	return true;
+}
+
 bool_t check_string_merge(void) {
 
 	uint64_t total;
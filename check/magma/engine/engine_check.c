@@ -29,11 +29,172 @@ START_TEST (check_engine_context_system_s) {
 }
 END_TEST
 
+START_TEST (check_engine_status_stats_s) {
+
+	log_disable();
+	int64_t histogram;
+	bool_t result = true;
+	uint64_t position, value, total, sum;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (status()) {
+
+		// The statistic handle should resolve to the same counter as the name.
+		if (!(position = stats_get_name_pos("web.register.blocked")) || st_cmp_cs_eq(NULLER(stats_get_name(position)), NULLER("web.register.blocked"))) {
+			st_sprint(errmsg, "The statistic handle lookup failed.");
+			result = false;
+		}
+
+		if (result) {
+
+			value = stats_get_value_by_num(position);
+			stats_increment_by_num(position);
+			stats_increment_by_name("web.register.blocked");
+			stats_adjust_by_num(position, 5);
+			stats_decrement_by_num(position);
+
+			if (stats_get_value_by_name("web.register.blocked") != value + 6) {
+				st_sprint(errmsg, "The statistic counter returned an unexpected value.");
+				result = false;
+			}
+
+			stats_set_by_num(position, value);
+		}
+
+		// Invalid names and positions should be ignored.
+		if (result && (stats_get_name_pos("check.does.not.exist") || stats_get_name(stats_get_count()) || stats_get_value_by_num(stats_get_count()))) {
+			st_sprint(errmsg, "The statistics interface accepted an invalid name or position.");
+			result = false;
+		}
+
+		if (result && (histogram = stats_histogram_pos("core.jobs.duration")) < 0) {
+			st_sprint(errmsg, "The histogram handle lookup failed.");
+			result = false;
+		}
+		else if (result) {
+
+			total = stats_histogram_total(histogram);
+			sum = stats_histogram_sum(histogram);
+
+			for (uint64_t i = 0; i < 100; i++) {
+				stats_histogram_record(histogram, i < 99 ? 1 : 1000000);
+			}
+
+			if (stats_histogram_total(histogram) != total + 100 || stats_histogram_sum(histogram) != sum + 99 + 1000000) {
+				st_sprint(errmsg, "The histogram totals don't match the recorded samples.");
+				result = false;
+			}
+			else if (!total && (stats_histogram_percentile(histogram, 50) != 1 || stats_histogram_percentile(histogram, 100) < 1000000)) {
+				st_sprint(errmsg, "The histogram percentiles don't match the recorded samples.");
+				result = false;
+			}
+
+		}
+
+	}
+
+	log_test("ENGINE / STATUS / STATISTICS / SINGLE THREADED:", errmsg);
+	ck_assert_msg(result, st_char_get(errmsg));
+
+}
+END_TEST
+
+START_TEST (check_engine_log_limits_s) {
+
+	log_disable();
+	ssize_t got;
+	struct pollfd poller;
+	bool_t result = true;
+	chr_t buffer[65536];
+	size_t used = 0, location;
+	uint64_t position, suppressed;
+	int_t descriptor, saved = -1, pipes[2] = { -1, -1 }, line = 0;
+	stringer_t *errmsg = MANAGEDBUF(1024), *needle = MANAGEDBUF(1024);
+
+	if (status()) {
+
+		// Send the log output through a pipe, so we can look for the summary entry.
+		fflush(stdout);
+		descriptor = fileno(stdout);
+
+		if (!(position = stats_get_name_pos("core.log.suppressed"))) {
+			st_sprint(errmsg, "The suppressed log entry statistic lookup failed.");
+			result = false;
+		}
+		else if (pipe(pipes) || fcntl(pipes[0], F_SETFL, O_NONBLOCK) || (saved = dup(descriptor)) < 0 || dup2(pipes[1], descriptor) < 0) {
+			st_sprint(errmsg, "Unable to redirect the log output.");
+			result = false;
+		}
+
+		// Exceed the burst limit from a single call site, and then leave it alone.
+		if (result) {
+
+			suppressed = stats_get_value_by_num(position);
+			log_enable();
+
+			for (int_t i = 0; i < (MAGMA_LOG_BURST * 32); i++) {
+				line = __LINE__ + 1;
+				log_options(M_LOG_INFO | M_LOG_STACK_TRACE_DISABLE, "Checking the log rate limiter. { entry = %i }", i);
+			}
+
+			log_disable();
+
+			if (stats_get_value_by_num(position) <= suppressed) {
+				st_sprint(errmsg, "The log rate limiter didn't suppress any entries.");
+				result = false;
+			}
+		}
+
+		// The logging thread should write the summary once the second ends, even though the call site never logs again.
+		if (result && st_sprint(needle, "Repeated log entries were suppressed. { file = %s / line = %i / suppressed = ", __FILE__, line) > 0) {
+
+			result = false;
+
+			for (int_t i = 0; !result && i < 40; i++) {
+
+				poller.fd = pipes[0];
+				poller.events = POLLIN;
+
+				if (poll(&poller, 1, 100) > 0 && (got = read(pipes[0], buffer + used, sizeof(buffer) - used)) > 0) {
+					used += got;
+					result = st_search_cs(PLACER(buffer, used), needle, &location);
+
+					// Keep the tail of the output, in case the summary was split across reads.
+					if (!result && used > (sizeof(buffer) / 2)) {
+						mm_move(buffer, buffer + used - 1024, 1024);
+						used = 1024;
+					}
+				}
+			}
+
+			if (!result) {
+				st_sprint(errmsg, "The logging thread didn't write a summary of the suppressed log entries.");
+			}
+		}
+
+		if (saved >= 0) {
+			fflush(stdout);
+			dup2(saved, descriptor);
+			close(saved);
+		}
+
+		if (pipes[0] >= 0) close(pipes[0]);
+		if (pipes[1] >= 0) close(pipes[1]);
+	}
+
+	log_test("ENGINE / LOG / RATE LIMITS / SINGLE THREADED:", errmsg);
+	ck_assert_msg(result, st_char_get(errmsg));
+
+}
+END_TEST
+
 Suite * suite_check_engine(void) {
 
 	Suite *s = suite_create("\tEngine");
 
 	suite_check_testcase(s, "ENGINE", "Engine System Interfaces/S", check_engine_context_system_s);
+	suite_check_testcase(s, "ENGINE", "Engine Statistics/S", check_engine_status_stats_s);
+	suite_check_testcase(s, "ENGINE", "Engine Log Rate Limits/S", check_engine_log_limits_s);
 
 	return s;
 }
@@ -127,6 +127,8 @@ void suite_check_testcase(Suite *s, const char *tags, const char *name, TFun fun
 
 #define MAIL_CHECK_LOAD_MAX 64 // Maximum number of messages loaded per user.
 
+#define IMAP_CHECK_IDLE_CONNECTIONS 64 // The number of idle connections held open at once.
+
 #define REGRESSION_CHECK_FILE_DESCRIPTORS_LEAK_MTHREADS 8
 
 //! Exhaustive Test
@@ -211,6 +213,8 @@ void suite_check_testcase(Suite *s, const char *tags, const char *name, TFun fun
 
 #define MAIL_CHECK_LOAD_MAX UINT64_MAX // Maximum number of messages loaded per user.
 
+#define IMAP_CHECK_IDLE_CONNECTIONS 1024 // The number of idle connections held open at once.
+
 #define REGRESSION_CHECK_FILE_DESCRIPTORS_LEAK_MTHREADS 32
 
 #endif
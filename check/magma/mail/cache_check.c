@@ -0,0 +1,101 @@
+
+/**
+ * @file /magma/check/magma/mail/cache_check.c
+ */
+
+#include "magma_check.h"
+
+bool_t check_mail_cache_sthread(stringer_t *errmsg) {
+
+	uint64_t limit;
+	bool_t result = true;
+	stringer_t *text = NULL, *cached = NULL;
+
+	limit = magma.storage.cache;
+	mail_cache_reset();
+
+	if (!(text = st_alloc(1024)) || !rand_write(text)) {
+		st_sprint(errmsg, "Unable to generate the sample message text.");
+		result = false;
+	}
+
+	// Use a limit that can hold four copies of our sample text inside each shard.
+	else {
+		magma.storage.cache = (sizeof(mail_cache_t) + st_length_get(text)) * 4 * MAIL_CACHE_SHARDS;
+	}
+
+	// Fill a single shard beyond its limit, so the first message should be evicted.
+	for (uint64_t i = 1; result && i <= 5; i++) {
+		mail_cache_set(i * MAIL_CACHE_SHARDS, text);
+	}
+
+	if (result && (cached = mail_cache_get(MAIL_CACHE_SHARDS))) {
+		st_sprint(errmsg, "The least recently used message wasn't evicted from the cache.");
+		result = false;
+	}
+
+	for (uint64_t i = 2; result && i <= 5; i++) {
+		if (!(cached = mail_cache_get(i * MAIL_CACHE_SHARDS)) || st_cmp_cs_eq(cached, text)) {
+			st_sprint(errmsg, "The cached message text is missing or doesn't match. { messagenum = %lu }", i * MAIL_CACHE_SHARDS);
+			result = false;
+		}
+		st_cleanup(cached);
+		cached = NULL;
+	}
+
+	// Retrieving the second message should protect it from the next eviction.
+	if (result) {
+		st_cleanup(mail_cache_get(2 * MAIL_CACHE_SHARDS));
+		mail_cache_set(6 * MAIL_CACHE_SHARDS, text);
+
+		if (!(cached = mail_cache_get(2 * MAIL_CACHE_SHARDS))) {
+			st_sprint(errmsg, "A recently used message was evicted from the cache.");
+			result = false;
+		}
+
+		st_cleanup(cached);
+		cached = NULL;
+
+		if (result && (cached = mail_cache_get(3 * MAIL_CACHE_SHARDS))) {
+			st_sprint(errmsg, "The least recently used message wasn't evicted from the cache.");
+			result = false;
+		}
+	}
+
+	// A structure added for a message without cached text shouldn't make the text appear, and should survive the text being added.
+	if (result) {
+		mail_cache_set_structure(8 * MAIL_CACHE_SHARDS, PLACER("(\"TEXT\" \"PLAIN\")", 16));
+
+		if ((cached = mail_cache_get(8 * MAIL_CACHE_SHARDS))) {
+			st_sprint(errmsg, "A structure only cache entry returned message text.");
+			result = false;
+		}
+
+		mail_cache_set(8 * MAIL_CACHE_SHARDS, text);
+
+		if (result && (!(cached = mail_cache_get_structure(8 * MAIL_CACHE_SHARDS)) || st_cmp_cs_eq(cached, PLACER("(\"TEXT\" \"PLAIN\")", 16)))) {
+			st_sprint(errmsg, "The cached message structure is missing or doesn't match.");
+			result = false;
+		}
+
+		st_cleanup(cached);
+		cached = NULL;
+	}
+
+	// Messages larger than a shard shouldn't be cached.
+	if (result) {
+		magma.storage.cache = 512 * MAIL_CACHE_SHARDS;
+		mail_cache_set(7 * MAIL_CACHE_SHARDS, text);
+
+		if ((cached = mail_cache_get(7 * MAIL_CACHE_SHARDS))) {
+			st_sprint(errmsg, "A message larger than the cache limit was cached.");
+			result = false;
+		}
+	}
+
+	st_cleanup(cached, text);
+	magma.storage.cache = limit;
+	mail_cache_reset();
+
+	return result;
+}
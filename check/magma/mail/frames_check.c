@@ -0,0 +1,153 @@
+/**
+ * @file /magma/check/magma/mail/frames_check.c
+ */
+
+#include "magma_check.h"
+
+bool_t check_mail_frames_sthread(stringer_t *errmsg) {
+
+	bool_t result = true;
+	mail_frames_head_t *head;
+	stringer_t *message = NULL, *framed = NULL, *restored = NULL;
+	size_t length = (MAIL_FRAMES_LENGTH * 2) + 4096;
+
+	// Build a message which spans three frames, with content that changes between them.
+	if (!(message = st_alloc(length))) {
+		st_sprint(errmsg, "Unable to allocate the message buffer.");
+		return false;
+	}
+
+	for (size_t i = 0; i < length; i++) {
+		*(st_char_get(message) + i) = (chr_t)('A' + ((i / 97) % 26));
+	}
+
+	st_length_set(message, length);
+
+	if (!(framed = mail_frames_compress(message)) || !(head = st_data_get(framed)) || head->count != 3 || head->length != length) {
+		st_sprint(errmsg, "The message wasn't compressed into the expected number of frames.");
+		result = false;
+	}
+	else if (!(restored = mail_frames_decompress(framed)) || st_cmp_cs_eq(message, restored)) {
+		st_sprint(errmsg, "The framed message didn't decompress back into the original.");
+		result = false;
+	}
+
+	// A truncated frame table should be rejected.
+	else if (mail_frames_decompress(PLACER(st_char_get(framed), sizeof(mail_frames_head_t) + sizeof(uint64_t)))) {
+		st_sprint(errmsg, "A truncated framed message was accepted.");
+		result = false;
+	}
+
+	st_cleanup(restored);
+	st_cleanup(framed);
+	st_free(message);
+
+	return result;
+}
+
+bool_t check_mail_frames_stream_sthread(stringer_t *errmsg) {
+
+	int_t state = 0;
+	chr_t *path = NULL;
+	placer_t chunk;
+	bool_t result = true;
+	meta_message_t meta;
+	mail_stream_t *stream;
+	size_t expected, chunks, frame = MAIL_FRAMES_LENGTH;
+	stringer_t *message = NULL, *framed = NULL, *collected = NULL;
+	size_t length = (MAIL_FRAMES_LENGTH * 2) + 4096;
+	struct {
+		size_t start, length, chunks;
+	} ranges[] = {
+		{ 0, SIZE_MAX, 3 },
+		{ 0, MAIL_FRAMES_LENGTH, 1 },
+		{ MAIL_FRAMES_LENGTH - 16, 32, 2 },
+		{ MAIL_FRAMES_LENGTH - 1, MAIL_FRAMES_LENGTH + 2, 3 },
+		{ MAIL_FRAMES_LENGTH, MAIL_FRAMES_LENGTH, 1 },
+		{ (MAIL_FRAMES_LENGTH * 2) + 100, SIZE_MAX, 1 },
+		{ 1, (MAIL_FRAMES_LENGTH * 2) + 4094, 3 }
+	};
+
+	mm_wipe(&meta, sizeof(meta_message_t));
+	meta.messagenum = (1ULL << 62) + rand_get_uint32();
+	snprintf(meta.server, sizeof(meta.server), "%.*s", st_length_int(magma.storage.active), st_char_get(magma.storage.active));
+
+	// Build a message which spans three frames, with content that changes between them, and store it in frames.
+	if (!(message = st_alloc(length))) {
+		st_sprint(errmsg, "Unable to allocate the message buffer.");
+		return false;
+	}
+
+	for (size_t i = 0; i < length; i++) {
+		*(st_char_get(message) + i) = (chr_t)('A' + ((i / 97) % 26));
+	}
+
+	st_length_set(message, length);
+
+	if (!(framed = mail_frames_compress(message)) ||
+		!mail_store_message_data(meta.messagenum, FMESSAGE_OPT_COMPRESSED | FMESSAGE_OPT_FRAMED, framed, &path)) {
+		st_sprint(errmsg, "Unable to store the framed message.");
+		st_cleanup(framed);
+		st_free(message);
+		return false;
+	}
+
+	// Every range must match the original message, and should take one chunk per frame it overlaps.
+	for (size_t i = 0; result && i < (sizeof(ranges) / sizeof(ranges[0])); i++) {
+
+		chunks = 0;
+		expected = (ranges[i].length < length - ranges[i].start) ? ranges[i].length : length - ranges[i].start;
+
+		if (!(stream = mail_stream_open(&meta, ranges[i].start, ranges[i].length)) || !(collected = st_alloc(expected))) {
+			st_sprint(errmsg, "Unable to open a message stream. { start = %zu / length = %zu }", ranges[i].start, ranges[i].length);
+			result = false;
+		}
+
+		while (result && (state = mail_stream_next(stream, &chunk)) == 1) {
+			if (st_length_get(collected) + pl_length_get(chunk) > expected) {
+				st_sprint(errmsg, "The message stream returned too much data. { start = %zu / length = %zu }", ranges[i].start,
+					ranges[i].length);
+				result = false;
+			}
+			else {
+				mm_copy(st_char_get(collected) + st_length_get(collected), pl_data_get(chunk), pl_length_get(chunk));
+				st_length_set(collected, st_length_get(collected) + pl_length_get(chunk));
+				chunks++;
+			}
+		}
+
+		if (result && state != 0) {
+			st_sprint(errmsg, "The message stream failed. { start = %zu / length = %zu }", ranges[i].start, ranges[i].length);
+			result = false;
+		}
+		else if (result && (st_length_get(collected) != expected ||
+			st_cmp_cs_eq(collected, PLACER(st_char_get(message) + ranges[i].start, expected)))) {
+			st_sprint(errmsg, "The message stream didn't match the original message. { start = %zu / length = %zu }",
+				ranges[i].start, ranges[i].length);
+			result = false;
+		}
+		else if (result && chunks != ranges[i].chunks) {
+			st_sprint(errmsg, "The message stream didn't return one chunk per frame. { start = %zu / length = %zu / chunks = %zu }",
+				ranges[i].start, ranges[i].length, chunks);
+			result = false;
+		}
+
+		mail_stream_close(stream);
+		st_cleanup(collected);
+		collected = NULL;
+	}
+
+	// Ranges starting past the end of the message, or which are empty, can't be streamed.
+	if (result && ((stream = mail_stream_open(&meta, length, frame)) || (stream = mail_stream_open(&meta, 0, 0)))) {
+		st_sprint(errmsg, "A message stream was opened for an empty range.");
+		mail_stream_close(stream);
+		result = false;
+	}
+
+	unlink(path);
+	ns_free(path);
+	st_cleanup(framed);
+	st_free(message);
+
+	return result;
+}
@@ -37,6 +37,84 @@ START_TEST (check_mail_store_s) {
 }
 END_TEST
 
+START_TEST (check_mail_cache_s) {
+
+	log_disable();
+	bool_t result = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (status()) result = check_mail_cache_sthread(errmsg);
+
+	log_test("MAIL / CACHE / SINGLE THREADED:", errmsg);
+	ck_assert_msg(result, st_char_get(errmsg));
+}
+END_TEST
+
+START_TEST (check_mail_search_s) {
+
+	log_disable();
+	bool_t result = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (status()) result = check_mail_search_sthread(errmsg);
+
+	log_test("MAIL / SEARCH / SINGLE THREADED:", errmsg);
+	ck_assert_msg(result, st_char_get(errmsg));
+}
+END_TEST
+
+START_TEST (check_mail_mime_s) {
+
+	log_disable();
+	bool_t result = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (status()) result = check_mail_mime_sthread(errmsg);
+
+	log_test("MAIL / MIME / SINGLE THREADED:", errmsg);
+	ck_assert_msg(result, st_char_get(errmsg));
+}
+END_TEST
+
+START_TEST (check_mail_summary_s) {
+
+	log_disable();
+	bool_t result = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (status()) result = check_mail_summary_sthread(errmsg);
+
+	log_test("MAIL / SUMMARY / SINGLE THREADED:", errmsg);
+	ck_assert_msg(result, st_char_get(errmsg));
+}
+END_TEST
+
+START_TEST (check_mail_frames_s) {
+
+	log_disable();
+	bool_t result = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (status()) result = check_mail_frames_sthread(errmsg);
+
+	log_test("MAIL / FRAMES / SINGLE THREADED:", errmsg);
+	ck_assert_msg(result, st_char_get(errmsg));
+}
+END_TEST
+
+START_TEST (check_mail_frames_stream_s) {
+
+	log_disable();
+	bool_t result = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (status()) result = check_mail_frames_stream_sthread(errmsg);
+
+	log_test("MAIL / FRAMES / STREAM / SINGLE THREADED:", errmsg);
+	ck_assert_msg(result, st_char_get(errmsg));
+}
+END_TEST
+
 START_TEST (check_mail_headers_s) {
 
 	log_disable();
@@ -54,9 +132,15 @@ Suite * suite_check_mail(void) {
 
 	Suite *s = suite_create("\tMail");
 
+	suite_check_testcase(s, "MAIL", "Mail Frames/S", check_mail_frames_s);
+	suite_check_testcase(s, "MAIL", "Mail Frames Stream/S", check_mail_frames_stream_s);
 	suite_check_testcase(s, "MAIL", "Mail Store/S", check_mail_store_s);
 	suite_check_testcase(s, "MAIL", "Mail Load/S", check_mail_load_s);
 	suite_check_testcase(s, "MAIL", "Mail Headers/S", check_mail_headers_s);
+	suite_check_testcase(s, "MAIL", "Mail MIME/S", check_mail_mime_s);
+	suite_check_testcase(s, "MAIL", "Mail Summary/S", check_mail_summary_s);
+	suite_check_testcase(s, "MAIL", "Mail Cache/S", check_mail_cache_s);
+	suite_check_testcase(s, "MAIL", "Mail Search/S", check_mail_search_s);
 
 	return s;
 }
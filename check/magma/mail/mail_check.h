@@ -13,9 +13,25 @@ bool_t   check_mail_store_plaintext_sthread(stringer_t *errmsg);
 /// load_check.c
 bool_t   check_mail_load_sthread(stringer_t *errmsg);
 
+/// cache_check.c
+bool_t   check_mail_cache_sthread(stringer_t *errmsg);
+
+/// search_check.c
+bool_t   check_mail_search_sthread(stringer_t *errmsg);
+
 /// headers_check.c
 bool_t   check_mail_headers_sthread(stringer_t *errmsg);
 
+/// mime_check.c
+bool_t   check_mail_mime_sthread(stringer_t *errmsg);
+
+/// summary_check.c
+bool_t   check_mail_summary_sthread(stringer_t *errmsg);
+
+/// frames_check.c
+bool_t   check_mail_frames_sthread(stringer_t *errmsg);
+bool_t   check_mail_frames_stream_sthread(stringer_t *errmsg);
+
 /// mail_check.c
 Suite *  suite_check_mail(void);
 
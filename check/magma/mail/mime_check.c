@@ -0,0 +1,77 @@
+
+/**
+ * @file /magma/check/magma/mail/mime_check.c
+ */
+
+#include "magma_check.h"
+
+bool_t check_mail_mime_sthread(stringer_t *errmsg) {
+
+	placer_t part;
+	size_t offset = 0;
+	array_t *children;
+	bool_t result = true;
+	mail_mime_t *mime = NULL, *inner;
+	chr_t *text = "Content-Type: multipart/mixed; boundary=\"outer\"\r\n\r\n"
+		"Preamble text.\r\n"
+		"--outer\r\n"
+		"Content-Type: multipart/alternative; boundary=\"inner\"\r\n\r\n"
+		"--inner\r\n"
+		"Content-Type: text/plain\r\n\r\n"
+		"Plain.\r\n"
+		"--inner\r\n"
+		"Content-Type: text/html\r\n\r\n"
+		"<p>HTML.</p>\r\n"
+		"--inner--\r\n"
+		"--outer\r\n"
+		"Content-Type: application/octet-stream\r\n"
+		"Content-Transfer-Encoding: base64\r\n\r\n"
+		"AAECAw==\r\n"
+		"--outer--\r\n"
+		"Epilogue text.\r\n";
+
+	if (!(mime = mail_mime_part(NULLER(text), 1)) || mime->type != MESSAGE_TYPE_MULTI_MIXED || !mime->boundary) {
+		st_sprint(errmsg, "The top level MIME part wasn't parsed correctly.");
+		result = false;
+	}
+
+	// The children shouldn't be parsed until they're requested.
+	else if (mime->expanded || mime->children) {
+		st_sprint(errmsg, "The MIME children were parsed before they were requested.");
+		result = false;
+	}
+	else if (mail_mime_count(mime->body, mime->boundary) != 2) {
+		st_sprint(errmsg, "The wrong number of MIME children was counted.");
+		result = false;
+	}
+
+	// Walk the children manually, and make sure the boundary lines are excluded.
+	else if (!mail_mime_next(mime->body, mime->boundary, &offset, &part) || !pl_starts_with_char(part, 'C') ||
+		!mail_mime_next(mime->body, mime->boundary, &offset, &part) || st_cmp_cs_starts(&part, NULLER("Content-Type: application/octet-stream")) ||
+		mail_mime_next(mime->body, mime->boundary, &offset, &part)) {
+		st_sprint(errmsg, "The MIME children weren't found in a single pass.");
+		result = false;
+	}
+
+	else if (!(children = mail_mime_children(mime)) || ar_length_get(children) != 2 || !(inner = ar_field_ptr(children, 0)) ||
+		inner->type != MESSAGE_TYPE_MULTI_ALTERNATIVE || inner->expanded) {
+		st_sprint(errmsg, "The first level of MIME children wasn't parsed correctly.");
+		result = false;
+	}
+	else if (((mail_mime_t *)ar_field_ptr(children, 1))->encoding != MESSAGE_ENCODING_BASE64 ||
+		st_cmp_cs_starts(&(((mail_mime_t *)ar_field_ptr(children, 1))->body), NULLER("AAECAw=="))) {
+		st_sprint(errmsg, "The attachment wasn't parsed correctly.");
+		result = false;
+	}
+	else if (!(children = mail_mime_children(inner)) || ar_length_get(children) != 2 ||
+		((mail_mime_t *)ar_field_ptr(children, 0))->type != MESSAGE_TYPE_PLAIN ||
+		((mail_mime_t *)ar_field_ptr(children, 1))->type != MESSAGE_TYPE_HTML ||
+		st_cmp_cs_starts(&(((mail_mime_t *)ar_field_ptr(children, 1))->body), NULLER("<p>HTML.</p>"))) {
+		st_sprint(errmsg, "The nested MIME children weren't parsed correctly.");
+		result = false;
+	}
+
+	mail_mime_free(mime);
+
+	return result;
+}
@@ -0,0 +1,69 @@
+
+/**
+ * @file /magma/check/magma/mail/search_check.c
+ */
+
+#include "magma_check.h"
+
+bool_t check_mail_search_sthread(stringer_t *errmsg) {
+
+	chr_t *path = NULL;
+	bool_t result = true;
+	mail_search_t *search = NULL;
+	uint64_t usernum = (uint64_t)UINT32_MAX + rand_get_uint32();
+
+	// Use a user number well beyond anything in the sample data so we start with an empty index.
+	if (!(path = mail_search_path(usernum, true))) {
+		st_sprint(errmsg, "Unable to build the search index path.");
+		return false;
+	}
+
+	unlink(path);
+
+	if (!mail_search_index(usernum, 1, PLACER("The Quick Brown Fox Jumps Over The Lazy Dog", 43)) ||
+		!mail_search_index(usernum, 2, PLACER("Pack my box with five dozen liquor jugs.", 40))) {
+		st_sprint(errmsg, "Unable to add the sample messages to the search index.");
+		result = false;
+	}
+	else if (!(search = mail_search_open(usernum))) {
+		st_sprint(errmsg, "Unable to open the search index.");
+		result = false;
+	}
+	else if (!mail_search_check(search, 1, PLACER("brown fox", 9)) || !mail_search_check(search, 2, PLACER("LIQUOR", 6))) {
+		st_sprint(errmsg, "The search index rejected a term found inside the message.");
+		result = false;
+	}
+	else if (mail_search_check(search, 1, PLACER("liquor jugs", 11))) {
+		st_sprint(errmsg, "The search index accepted a term that isn't inside the message.");
+		result = false;
+	}
+	else if (!mail_search_check(search, 3, PLACER("anything", 8))) {
+		st_sprint(errmsg, "The search index rejected a message which wasn't indexed.");
+		result = false;
+	}
+
+	mail_search_close(search);
+	search = NULL;
+
+	// Removed messages should no longer have a record, which means they will always be loaded.
+	if (result) {
+
+		mail_search_remove(usernum, 1);
+
+		if (!(search = mail_search_open(usernum))) {
+			st_sprint(errmsg, "Unable to reopen the search index.");
+			result = false;
+		}
+		else if (!mail_search_check(search, 1, PLACER("liquor jugs", 11)) || mail_search_check(search, 2, PLACER("brown fox", 9))) {
+			st_sprint(errmsg, "The search index records weren't updated after a message was removed.");
+			result = false;
+		}
+
+		mail_search_close(search);
+	}
+
+	unlink(path);
+	ns_free(path);
+
+	return result;
+}
@@ -0,0 +1,51 @@
+/**
+ * @file /magma/check/magma/mail/summary_check.c
+ */
+
+#include "magma_check.h"
+
+bool_t check_mail_summary_sthread(stringer_t *errmsg) {
+
+	mail_mime_t *mime = NULL;
+	bool_t result = true;
+	stringer_t *structure = NULL;
+	mail_summary_t *summary = NULL, *bare = NULL;
+	chr_t *text = "From: Sender <sender@example.com>\r\n"
+		"To: Recipient <recipient@example.com>\r\n"
+		"Subject: Summary\r\n"
+		"Content-Type: multipart/mixed; boundary=\"part\"\r\n\r\n"
+		"--part\r\n"
+		"Content-Type: text/plain\r\n\r\n"
+		"Plain.\r\n"
+		"--part--\r\n";
+
+	if (!(summary = mail_summary_build(NULLER(text), true)) || !(bare = mail_summary_build(NULLER(text), false))) {
+		st_sprint(errmsg, "The message summary couldn't be built.");
+		result = false;
+	}
+
+	// The header should include the blank line, just like the header returned by mail_load_header().
+	else if (st_cmp_cs_eq(summary->header, PLACER(text, mail_header_end(NULLER(text)))) ||
+		st_cmp_cs_ends(summary->header, NULLER("\r\n\r\n"))) {
+		st_sprint(errmsg, "The message summary header doesn't match the message.");
+		result = false;
+	}
+	else if (st_cmp_cs_starts(summary->envelope, NULLER("(")) || !st_search_cs(summary->envelope, NULLER("\"Summary\""), NULL)) {
+		st_sprint(errmsg, "The message summary envelope is invalid.");
+		result = false;
+	}
+
+	// The structure should match the one computed when the message is fetched, and be omitted when it's not wanted.
+	else if (!(mime = mail_mime_part(NULLER(text), 1)) || !(structure = imap_fetch_bodystructure(mime)) ||
+		st_cmp_cs_eq(summary->structure, structure) || bare->structure) {
+		st_sprint(errmsg, "The message summary structure is invalid.");
+		result = false;
+	}
+
+	mail_summary_free(bare);
+	mail_summary_free(summary);
+	mail_mime_free(mime);
+	st_cleanup(structure);
+
+	return result;
+}
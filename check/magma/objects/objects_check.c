@@ -12,6 +12,7 @@ START_TEST (check_object_serials_s) {
 	log_disable();
 	uint64_t num = 1;
 	bool_t result = true;
+	uint64_t serials[SERIAL_OBJECTS];
 	stringer_t *errmsg = NULL;
 
 	// Flush the cache, otherwise we won't get what we expect back.
@@ -62,6 +63,14 @@ START_TEST (check_object_serials_s) {
 			errmsg = NULLER("The interface for handling message serial numbers failed.");
 			result = false;
 		}
+
+		// Fetch the whole group at once, which should match the values above and leave the untouched types at zero.
+		if (result && (serial_get_all(num, serials) != 3 ||
+			serials[OBJECT_USER] != 3 || serials[OBJECT_FOLDERS] != 3 || serials[OBJECT_MESSAGES] != 3 ||
+			serials[OBJECT_CONFIG] != 0 || serials[OBJECT_CONTACTS] != 0 || serials[OBJECT_ALIASES] != 0)) {
+			errmsg = NULLER("The interface for fetching a group of serial numbers failed.");
+			result = false;
+		}
 	}
 
 	// Check the edge cases.
@@ -74,6 +83,17 @@ START_TEST (check_object_serials_s) {
 		result = false;
 	}
 
+	// The local cache must never move a serial number backward, and the uncached variant must always see the memcached value.
+	if (result && (serial_increment(OBJECT_CONTACTS, num) != 1 ||
+		serial_increment(OBJECT_CONTACTS, num) != 2 ||
+		(serial_cache_set(OBJECT_CONTACTS, num, 1), serial_get(OBJECT_CONTACTS, num)) != 2 ||
+		serial_get_uncached(OBJECT_CONTACTS, num) != 2 ||
+		serial_increment(OBJECT_CONTACTS, num) != 3 ||
+		serial_get(OBJECT_CONTACTS, num) != 3)) {
+		errmsg = NULLER("The local serial number cache returned a stale value.");
+		result = false;
+	}
+
   log_test("OBJECTS / SERIALS / SINGLE THREADED:", errmsg);
   ck_assert_msg(result, st_char_get(errmsg));
 }
@@ -117,12 +137,142 @@ START_TEST (check_warehouse_domains_s) {
 }
 END_TEST
 
+START_TEST (check_object_sequences_s) {
+
+	log_disable();
+	bool_t result = true;
+	meta_user_t user;
+	meta_sequence_t *sequence;
+	meta_message_t messages[9];
+	stringer_t *errmsg = NULL;
+	multi_t key = { .type = M_TYPE_UINT64, .val.u64 = 0 };
+
+	mm_wipe(&user, sizeof(meta_user_t));
+	mm_wipe(messages, sizeof(messages));
+
+	if (!(user.messages = inx_alloc(M_INX_LINKED, NULL))) {
+		errmsg = NULLER("Unable to allocate the messages index.");
+		result = false;
+	}
+
+	// Spread the messages across three folders, in message number order, which is how they're loaded from the database.
+	for (uint64_t i = 0; result && i < 9; i++) {
+
+		messages[i].messagenum = key.val.u64 = (i + 1) * 10;
+		messages[i].foldernum = (i % 3) + 1;
+
+		if (!inx_insert(user.messages, key, messages + i)) {
+			errmsg = NULLER("Unable to add a message to the messages index.");
+			result = false;
+		}
+	}
+
+	if (result) {
+
+		meta_messages_update_sequences(&user);
+
+		// Every folder should have a view holding its three messages, in UID order, and the sequence numbers should follow it.
+		for (uint64_t folder = 1; result && folder <= 3; folder++) {
+			if (!(sequence = meta_messages_sequence(&user, folder)) || sequence->count != 3 || sequence->messages[0]->foldernum != folder ||
+				sequence->messages[0]->sequencenum != 1 || sequence->messages[2]->sequencenum != 3 ||
+				sequence->messages[0]->messagenum >= sequence->messages[2]->messagenum ||
+				meta_sequence_position(sequence, sequence->messages[1]->messagenum) != 1 ||
+				meta_sequence_position(sequence, sequence->messages[2]->messagenum + 1) != 3) {
+				errmsg = NULLER("The message sequence views weren't built correctly.");
+				result = false;
+			}
+		}
+
+		if (result && meta_messages_sequence(&user, 4)) {
+			errmsg = NULLER("The message sequence views returned a view for an empty folder.");
+			result = false;
+		}
+	}
+
+	inx_cleanup(user.sequences.views);
+	inx_cleanup(user.messages);
+
+	log_test("OBJECTS / SEQUENCES / SINGLE THREADED:", errmsg);
+	ck_assert_msg(result, st_char_get(errmsg));
+}
+END_TEST
+
+/**
+ * @brief	Wait for the held lock in a separate thread, so it occupies the local queue for the lock name.
+ * @param	key		a managed string containing the name of the lock.
+ * @return	This function always returns NULL.
+ */
+void * check_object_locks_waiter(stringer_t *key) {
+
+	thread_start();
+
+	if (lock_get(key) == 1) {
+		lock_release(key);
+	}
+
+	thread_stop();
+
+	return NULL;
+}
+
+START_TEST (check_object_locks_s) {
+
+	log_disable();
+	pthread_t waiter;
+	uint64_t started;
+	bool_t result = true;
+	stringer_t *errmsg = NULL, *held = MANAGEDBUF(128), *other = MANAGEDBUF(128), *suffixed = MANAGEDBUF(128);
+	uint32_t bucket;
+
+	st_sprint(held, "check.lock.%lu", rand_get_uint64());
+	st_sprint(suffixed, "%.*s.lock", st_length_int(held), st_char_get(held));
+	bucket = hash_murmur32(st_data_get(suffixed), st_length_get(suffixed)) % 64;
+
+	// Find another lock name which lands in the same local queue bucket, of the 64 (MAGMA_LOCK_QUEUES) used by lock_get().
+	for (uint64_t i = 0; i < 100000; i++) {
+		st_sprint(other, "%.*s.%lu", st_length_int(held), st_char_get(held), i);
+		st_sprint(suffixed, "%.*s.lock", st_length_int(other), st_char_get(other));
+		if (hash_murmur32(st_data_get(suffixed), st_length_get(suffixed)) % 64 == bucket) break;
+	}
+
+	if (status() && lock_get(held) != 1) {
+		errmsg = NULLER("Unable to acquire a cache lock.");
+		result = false;
+	}
+	else if (status() && thread_launch(&waiter, &check_object_locks_waiter, held)) {
+		errmsg = NULLER("Unable to launch the lock waiter thread.");
+		lock_release(held);
+		result = false;
+	}
+	else if (status()) {
+
+		// While another thread waits on the held lock, an unrelated name in the same bucket should be acquired right away.
+		usleep(100000);
+		started = time_microseconds();
+
+		if (lock_get(other) != 1 || time_microseconds() - started > 5000000) {
+			errmsg = NULLER("A lock was blocked by a thread waiting on an unrelated lock name.");
+			result = false;
+		}
+
+		lock_release(other);
+		lock_release(held);
+		thread_join(waiter);
+	}
+
+	log_test("OBJECTS / LOCKS / SINGLE THREADED:", errmsg);
+	ck_assert_msg(result, st_char_get(errmsg));
+}
+END_TEST
+
 Suite * suite_check_objects(void) {
 
 	Suite *s = suite_create("\tObjects");
 
 	suite_check_testcase(s, "OBJECTS", "Object Serials/S", check_object_serials_s);
 	suite_check_testcase(s, "OBJECTS", "Object Warehouse Domains/S", check_warehouse_domains_s);
+	suite_check_testcase(s, "OBJECTS", "Object Message Sequences/S", check_object_sequences_s);
+	suite_check_testcase(s, "OBJECTS", "Object Locks/S", check_object_locks_s);
 
 	return s;
 }
@@ -87,6 +87,61 @@ START_TEST (check_http_mime_types_s) {
 }
 END_TEST
 
+START_TEST (check_http_network_dynamic_s) {
+
+	log_disable();
+	bool_t outcome = true;
+	server_t *server = NULL;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (!(server = servers_get_by_protocol(HTTP, true))) {
+		st_sprint(errmsg, "No HTTP servers were configured to support TLS connections.");
+		outcome = false;
+	}
+	else if (status() && !check_http_network_dynamic_sthread(errmsg, server->network.port, true)) {
+		outcome = false;
+	}
+
+	log_test("HTTP / NETWORK / DYNAMIC / SINGLE THREADED:", errmsg);
+	ck_assert_msg(outcome, st_char_get(errmsg));
+}
+END_TEST
+
+START_TEST (check_http_network_static_s) {
+
+	log_disable();
+	bool_t outcome = true;
+	server_t *server = NULL;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (!(server = servers_get_by_protocol(HTTP, true))) {
+		st_sprint(errmsg, "No HTTP servers were configured to support TLS connections.");
+		outcome = false;
+	}
+	else if (status() && !check_http_network_static_sthread(errmsg, server->network.port, true)) {
+		outcome = false;
+	}
+
+	log_test("HTTP / NETWORK / STATIC / SINGLE THREADED:", errmsg);
+	ck_assert_msg(outcome, st_char_get(errmsg));
+}
+END_TEST
+
+START_TEST (check_http_template_s) {
+
+	log_disable();
+	bool_t outcome = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (status() && !check_http_template_sthread(errmsg)) {
+		outcome = false;
+	}
+
+	log_test("HTTP / TEMPLATES / SINGLE THREADED:", errmsg);
+	ck_assert_msg(outcome, st_char_get(errmsg));
+}
+END_TEST
+
 Suite * suite_check_http(void) {
 
 	Suite *s = suite_create("\tHTTP");
@@ -95,6 +150,9 @@ Suite * suite_check_http(void) {
 	suite_check_testcase(s, "HTTP", "HTTP Network Basic/ TCP/S", check_http_network_basic_tcp_s);
 	suite_check_testcase(s, "HTTP", "HTTP Network Basic/ TLS/S", check_http_network_basic_tls_s);
 	suite_check_testcase(s, "HTTP", "HTTP Network Options/S", check_http_network_options_s);
+	suite_check_testcase(s, "HTTP", "HTTP Network Dynamic/S", check_http_network_dynamic_s);
+	suite_check_testcase(s, "HTTP", "HTTP Network Static/S", check_http_network_static_s);
+	suite_check_testcase(s, "HTTP", "HTTP Templates/S", check_http_template_s);
 
 	return s;
 }
@@ -11,11 +11,19 @@
 bool_t check_http_read_to_empty(client_t *client);
 int32_t check_http_content_length_get(client_t *client);
 bool_t check_http_mime_types_sthread(stringer_t *errmsg, uint32_t port, bool_t secure);
+bool_t check_http_header_get(stringer_t *header, chr_t *name, placer_t *value);
 bool_t check_http_network_basic_sthread(stringer_t *errmsg, uint32_t port, bool_t secure);
+bool_t check_http_network_dynamic_sthread(stringer_t *errmsg, uint32_t port, bool_t secure);
 bool_t check_http_network_options_sthread(stringer_t *errmsg, uint32_t port, bool_t secure);
+bool_t check_http_network_static_sthread(stringer_t *errmsg, uint32_t port, bool_t secure);
 bool_t check_http_content_length_test(client_t *client, uint32_t content_length, stringer_t *errmsg);
+bool_t check_http_exchange(uint32_t port, bool_t secure, chr_t *request, stringer_t **header, stringer_t **body, stringer_t *errmsg);
 bool_t check_http_options(client_t *client, chr_t *options[], uint32_t options_count, stringer_t *errmsg);
 
+/// template_check.c
+bool_t check_http_template_compare(chr_t *template, chr_t *expected, stringer_t *errmsg);
+bool_t check_http_template_sthread(stringer_t *errmsg);
+
 Suite * suite_check_http(void);
 
 #endif
@@ -378,3 +378,258 @@ bool_t check_http_mime_types_sthread(stringer_t *errmsg, uint32_t port, bool_t s
 
 	return true;
 }
+
+/**
+ * @brief	Submit a request over a new connection and read back the complete response.
+ * @param	port		the port the HTTP server is listening on.
+ * @param	secure		whether the connection should use TLS.
+ * @param	request		the complete request, including the blank line which terminates the header block.
+ * @param	header		a pointer which will be set to the response header block, including the status line, which must be freed by the caller.
+ * @param	body		a pointer which will be set to the response body, as delimited by the Content-Length header, which must be freed
+ * 						by the caller. If the response didn't include a Content-Length the pointer is left NULL.
+ * @return	True if a complete response was read, false otherwise.
+ */
+bool_t check_http_exchange(uint32_t port, bool_t secure, chr_t *request, stringer_t **header, stringer_t **body, stringer_t *errmsg) {
+
+	int64_t read = 0;
+	client_t *client = NULL;
+	size_t location = 0, length = 0;
+	placer_t value = pl_null();
+
+	*header = *body = NULL;
+
+	if (!(client = client_connect("localhost", port)) || (secure && (client_secure(client) == -1)) || client_status(client) != 1) {
+		st_sprint(errmsg, "Failed to connect with the HTTP server.");
+		client_close(client);
+		return false;
+	}
+	else if (client_write(client, NULLER(request)) != (int64_t)ns_length_get(request) || client_status(client) != 1) {
+		st_sprint(errmsg, "Failed to submit the HTTP request.");
+		client_close(client);
+		return false;
+	}
+
+	// Collect the status line and headers, stopping at the blank line.
+	while (client_read_line(client) > 0 && pl_length_get(client->line) != 2) {
+		if (!(*header = st_append(*header, &(client->line)))) {
+			st_sprint(errmsg, "Failed to store the HTTP response header.");
+			client_close(client);
+			return false;
+		}
+	}
+
+	if (pl_length_get(client->line) != 2 || st_empty(*header)) {
+		st_sprint(errmsg, "The HTTP response header block wasn't terminated by a blank line.");
+		client_close(client);
+		return false;
+	}
+
+	// Without a length there is no body to read, which is what the server does for 304 responses.
+	if (!check_http_header_get(*header, "Content-Length", &value)) {
+		client_close(client);
+		return true;
+	}
+	else if (!size_conv_bl(pl_char_get(value), pl_length_get(value), &length)) {
+		st_sprint(errmsg, "The HTTP response Content-Length header isn't a valid number. { value = %.*s }", pl_length_int(value),
+			pl_char_get(value));
+		client_close(client);
+		return false;
+	}
+	else if (!(*body = st_alloc(length + 1))) {
+		st_sprint(errmsg, "Failed to allocate a buffer for the HTTP response body.");
+		client_close(client);
+		return false;
+	}
+
+	// The first read returns whatever followed the header block in the client buffer, before going back to the network.
+	while (location < length && (read = client_read(client)) > 0) {
+		if (location + (size_t)read > length) {
+			st_sprint(errmsg, "The HTTP response body was longer than the Content-Length header. { length = %zu }", length);
+			client_close(client);
+			return false;
+		}
+		mm_copy(st_data_get(*body) + location, st_data_get(client->buffer), read);
+		location += read;
+		st_length_set(client->buffer, 0);
+	}
+
+	st_length_set(*body, location);
+	client_close(client);
+
+	if (location != length) {
+		st_sprint(errmsg, "The HTTP response body was shorter than the Content-Length header. { length = %zu / received = %zu }",
+			length, location);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief	Find a header in a response header block.
+ * @param	header	the response header block, starting with the status line.
+ * @param	name	the name of the header, without the trailing colon.
+ * @param	value	a pointer which will be set to the header value, without the trailing line break.
+ * @return	True if the header was found, false otherwise.
+ */
+bool_t check_http_header_get(stringer_t *header, chr_t *name, placer_t *value) {
+
+	size_t location = 0, end = 0;
+	stringer_t *needle = MANAGEDBUF(128);
+
+	if (!st_sprint(needle, "\r\n%s: ", name) || !st_search_ci(header, needle, &location)) {
+		return false;
+	}
+
+	location += st_length_get(needle);
+	*value = pl_init(st_char_get(header) + location, st_length_get(header) - location);
+
+	if (!st_search_cs(value, PLACER("\r\n", 2), &end)) {
+		return false;
+	}
+
+	*value = pl_init(st_char_get(header) + location, end);
+	return true;
+}
+
+/**
+ * @brief	Verify that a dynamic response carries a well formed header block, and that its Content-Length matches the body.
+ * @note	A request for a location that doesn't exist gets the plain text 404 response, which is built by http_response_header().
+ */
+bool_t check_http_network_dynamic_sthread(stringer_t *errmsg, uint32_t port, bool_t secure) {
+
+	placer_t value = pl_null();
+	stringer_t *header = NULL, *body = NULL;
+
+	if (!check_http_exchange(port, secure, "GET /check/missing/location HTTP/1.1\r\nHost: localhost\r\n\r\n", &header, &body, errmsg)) {
+		if (st_empty(errmsg)) st_sprint(errmsg, "Failed to complete the HTTP exchange.");
+		st_cleanup(header, body);
+		return false;
+	}
+	else if (st_cmp_cs_starts(header, PLACER("HTTP/1.1 404 ", 13))) {
+		st_sprint(errmsg, "The HTTP status line was wrong. { header = %.*s }", st_length_int(header), st_char_get(header));
+		st_cleanup(header, body);
+		return false;
+	}
+	else if (!check_http_header_get(header, "Content-Type", &value) || st_cmp_ci_eq(&value, PLACER("text/plain", 10))) {
+		st_sprint(errmsg, "The HTTP Content-Type header was missing or wrong. { header = %.*s }", st_length_int(header), st_char_get(header));
+		st_cleanup(header, body);
+		return false;
+	}
+	else if (!check_http_header_get(header, "Content-Length", &value) || st_cmp_cs_eq(&value, PLACER("21", 2))) {
+		st_sprint(errmsg, "The HTTP Content-Length header was missing or wrong. { header = %.*s }", st_length_int(header), st_char_get(header));
+		st_cleanup(header, body);
+		return false;
+	}
+	// The Content-Length line must be followed by the Connection header, or the blank line, not run into another header.
+	else if (!st_search_ci(header, PLACER("\r\nContent-Length: 21\r\n", 22), NULL)) {
+		st_sprint(errmsg, "The HTTP Content-Length header wasn't terminated properly. { header = %.*s }", st_length_int(header),
+			st_char_get(header));
+		st_cleanup(header, body);
+		return false;
+	}
+	else if (st_length_get(body) != 21) {
+		st_sprint(errmsg, "The HTTP response body didn't match the Content-Length header. { length = %zu }", st_length_get(body));
+		st_cleanup(header, body);
+		return false;
+	}
+
+	st_cleanup(header, body);
+	return true;
+}
+
+/**
+ * @brief	Verify the cache validation and compression logic used for static resources.
+ * @note	The default index page is requested, then revalidated using the entity tag and the modification time, both of which
+ * 			should yield a 304 without a body. The page is then requested with gzip accepted, and with gzip explicitly refused.
+ */
+bool_t check_http_network_static_sthread(stringer_t *errmsg, uint32_t port, bool_t secure) {
+
+	bool_t result = true;
+	placer_t value = pl_null();
+	stringer_t *header = NULL, *body = NULL, *plain = NULL, *etag = NULL, *modified = NULL, *request = NULL;
+
+	// The plain response, which supplies the validators used below.
+	if (!check_http_exchange(port, secure, "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n", &header, &plain, errmsg) ||
+		st_cmp_cs_starts(header, PLACER("HTTP/1.1 200 ", 13)) || !plain) {
+		if (st_empty(errmsg)) st_sprint(errmsg, "The static resource request failed.");
+		st_cleanup(header, plain);
+		return false;
+	}
+	else if (check_http_header_get(header, "Content-Encoding", &value)) {
+		st_sprint(errmsg, "The static resource was compressed even though the client didn't ask for it.");
+		st_cleanup(header, plain);
+		return false;
+	}
+	else if (!check_http_header_get(header, "ETag", &value) || !(etag = st_import(pl_data_get(value), pl_length_get(value))) ||
+		!check_http_header_get(header, "Last-Modified", &value) || !(modified = st_import(pl_data_get(value), pl_length_get(value)))) {
+		st_sprint(errmsg, "The static resource response didn't include the cache validators. { header = %.*s }", st_length_int(header),
+			st_char_get(header));
+		st_cleanup(header, plain, etag, modified);
+		return false;
+	}
+	else if (!check_http_header_get(header, "Vary", &value) || st_cmp_ci_eq(&value, PLACER("Accept-Encoding", 15))) {
+		st_sprint(errmsg, "The static resource response didn't include the Vary header.");
+		st_cleanup(header, plain, etag, modified);
+		return false;
+	}
+
+	st_free(header);
+	header = NULL;
+
+	// Revalidate using the entity tag.
+	if (result && (!(request = st_aprint("GET / HTTP/1.1\r\nHost: localhost\r\nIf-None-Match: %.*s\r\n\r\n", st_length_int(etag),
+		st_char_get(etag))) || !check_http_exchange(port, secure, st_char_get(request), &header, &body, errmsg) ||
+		st_cmp_cs_starts(header, PLACER("HTTP/1.1 304 ", 13)) || body)) {
+		if (st_empty(errmsg)) st_sprint(errmsg, "Revalidating a static resource using its entity tag didn't yield an empty 304 response.");
+		result = false;
+	}
+
+	st_cleanup(header, body, request);
+	header = body = request = NULL;
+
+	// A stale entity tag must get the full resource, even when the modification time still matches.
+	if (result && (!(request = st_aprint("GET / HTTP/1.1\r\nHost: localhost\r\nIf-None-Match: \"stale\"\r\nIf-Modified-Since: %.*s\r\n\r\n",
+		st_length_int(modified), st_char_get(modified))) || !check_http_exchange(port, secure, st_char_get(request), &header, &body, errmsg) ||
+		st_cmp_cs_starts(header, PLACER("HTTP/1.1 200 ", 13)) || st_cmp_cs_eq(body, plain))) {
+		if (st_empty(errmsg)) st_sprint(errmsg, "A static resource with a stale entity tag wasn't sent in full.");
+		result = false;
+	}
+
+	st_cleanup(header, body, request);
+	header = body = request = NULL;
+
+	// Revalidate using the modification time.
+	if (result && (!(request = st_aprint("GET / HTTP/1.1\r\nHost: localhost\r\nIf-Modified-Since: %.*s\r\n\r\n", st_length_int(modified),
+		st_char_get(modified))) || !check_http_exchange(port, secure, st_char_get(request), &header, &body, errmsg) ||
+		st_cmp_cs_starts(header, PLACER("HTTP/1.1 304 ", 13)) || body)) {
+		if (st_empty(errmsg)) st_sprint(errmsg, "Revalidating a static resource using its modification time didn't yield an empty 304 response.");
+		result = false;
+	}
+
+	st_cleanup(header, body, request);
+	header = body = request = NULL;
+
+	// The index page is large enough to be compressed, so a client accepting gzip should get the compressed copy.
+	if (result && (!check_http_exchange(port, secure, "GET / HTTP/1.1\r\nHost: localhost\r\nAccept-Encoding: deflate, gzip\r\n\r\n",
+		&header, &body, errmsg) || st_cmp_cs_starts(header, PLACER("HTTP/1.1 200 ", 13)) || !check_http_header_get(header, "Content-Encoding", &value) ||
+		st_cmp_ci_eq(&value, PLACER("gzip", 4)) || st_length_get(body) < 2 || *(st_uchar_get(body)) != 0x1f || *(st_uchar_get(body) + 1) != 0x8b ||
+		st_length_get(body) >= st_length_get(plain))) {
+		if (st_empty(errmsg)) st_sprint(errmsg, "A client accepting gzip didn't receive the compressed static resource.");
+		result = false;
+	}
+
+	st_cleanup(header, body);
+	header = body = NULL;
+
+	// A zero quality value means the client refuses gzip, so the plain copy must be sent.
+	if (result && (!check_http_exchange(port, secure, "GET / HTTP/1.1\r\nHost: localhost\r\nAccept-Encoding: gzip;q=0, identity\r\n\r\n",
+		&header, &body, errmsg) || st_cmp_cs_starts(header, PLACER("HTTP/1.1 200 ", 13)) || check_http_header_get(header, "Content-Encoding", &value) ||
+		st_cmp_cs_eq(body, plain))) {
+		if (st_empty(errmsg)) st_sprint(errmsg, "A client refusing gzip received the compressed static resource.");
+		result = false;
+	}
+
+	st_cleanup(header, body, plain, etag, modified);
+	return result;
+}
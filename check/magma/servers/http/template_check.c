@@ -0,0 +1,97 @@
+/**
+ * @file /check/magma/servers/http/template_check.c
+ *
+ * @brief HTTP template test functions.
+ */
+
+#include "magma_check.h"
+
+/**
+ * @brief	Compile a template, render it with the session and error slots, and compare the result with the expected page.
+ * @param	template	a null-terminated string with the template content.
+ * @param	expected	a null-terminated string with the page the template should render.
+ * @return	True if the rendered page matched, false otherwise.
+ */
+bool_t check_http_template_compare(chr_t *template, chr_t *expected, stringer_t *errmsg) {
+
+	int_t used;
+	size_t length = 0;
+	struct iovec *vector;
+	bool_t result = true;
+	http_content_t *content;
+	stringer_t *page = NULL;
+	http_slot_t slots[] = {
+		{ .name = "SESSION", .value = NULLER("abc") },
+		{ .name = "ERROR", .value = NULL }
+	};
+
+	if (!(content = mm_alloc(sizeof(http_content_t))) || !(content->resource = st_import(template, ns_length_get(template))) ||
+		!http_template_compile(content)) {
+		st_sprint(errmsg, "Unable to compile the template. { template = %s }", template);
+		http_free_content(content);
+		return false;
+	}
+	else if (!(vector = mm_alloc(sizeof(struct iovec) * ((content->compiled.count * 2) + 1)))) {
+		st_sprint(errmsg, "Unable to allocate memory for the template vector.");
+		http_free_content(content);
+		return false;
+	}
+
+	used = http_template_render(content, slots, sizeof(slots) / sizeof(http_slot_t), vector);
+
+	for (int_t i = 0; i < used; i++) {
+		length += vector[i].iov_len;
+	}
+
+	// Assemble the page from the vectors, the same way con_write_iv() would send it.
+	if (!(page = st_alloc(length + 1))) {
+		st_sprint(errmsg, "Unable to allocate memory for the rendered page.");
+		result = false;
+	}
+	else {
+		for (int_t i = 0; i < used; i++) {
+			mm_copy(st_char_get(page) + st_length_get(page), vector[i].iov_base, vector[i].iov_len);
+			st_length_set(page, st_length_get(page) + vector[i].iov_len);
+		}
+	}
+
+	if (result && st_cmp_cs_eq(page, NULLER(expected))) {
+		st_sprint(errmsg, "The rendered template didn't match. { template = %s / expected = %s / got = %.*s }", template, expected,
+			st_length_int(page), st_char_get(page));
+		result = false;
+	}
+
+	http_free_content(content);
+	st_cleanup(page);
+	mm_free(vector);
+
+	return result;
+}
+
+/**
+ * @brief	Check the template placeholders, including adjacent placeholders, and those which share a dollar sign.
+ * @return	True if every template rendered as expected, false otherwise.
+ */
+bool_t check_http_template_sthread(stringer_t *errmsg) {
+
+	chr_t *templates[][2] = {
+		{ "plain text", "plain text" },
+		{ "$SESSION$", "abc" },
+		{ "<a>$SESSION$</a>", "<a>abc</a>" },
+		{ "$SESSION$$SESSION$", "abcabc" },
+		{ "A$B$SESSION$", "A$Babc" },
+		{ "$B$SESSION$B$", "$BabcB$" },
+		{ "$SESSION$ERROR$", "abcERROR$" },
+		{ "$ERROR$$SESSION$", "abc" },
+		{ "$UNKNOWN$ and $lower$ and $$ and $SESSION", "$UNKNOWN$ and $lower$ and $$ and $SESSION" },
+		{ "$$SESSION$$", "$abc$" }
+	};
+
+	for (size_t i = 0; status() && i < (sizeof(templates) / sizeof(templates[0])); i++) {
+		if (!check_http_template_compare(templates[i][0], templates[i][1], errmsg)) {
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -108,6 +108,26 @@ START_TEST (check_imap_network_starttls_s) {
 }
 END_TEST
 
+START_TEST (check_imap_network_idle_s) {
+
+	log_disable();
+	bool_t outcome = true;
+	server_t *server = NULL;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (!(server = servers_get_by_protocol(IMAP, false))) {
+		st_sprint(errmsg, "No IMAP servers were configured to support TCP connections.");
+		outcome = false;
+	}
+	else if (status() && !check_imap_network_idle_sthread(errmsg, server->network.port)) {
+		outcome = false;
+	}
+
+	log_test("IMAP / NETWORK / IDLE CONNECTIONS / SINGLE THREADED:", errmsg);
+	ck_assert_msg(outcome, st_char_get(errmsg));
+}
+END_TEST
+
 Suite * suite_check_imap(void) {
 
 	Suite *s = suite_create("\tIMAP");
@@ -117,6 +137,7 @@ Suite * suite_check_imap(void) {
 	suite_check_testcase(s, "IMAP", "IMAP Network Search/S", check_imap_network_search_s);
 	suite_check_testcase(s, "IMAP", "IMAP Network Fetch/S", check_imap_network_fetch_s);
 	suite_check_testcase(s, "IMAP", "IMAP Network STARTTLS/S", check_imap_network_starttls_s);
+	suite_check_testcase(s, "IMAP", "IMAP Network Idle Connections/S", check_imap_network_idle_s);
 
 	return s;
 }
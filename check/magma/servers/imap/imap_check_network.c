@@ -445,3 +445,42 @@ bool_t check_imap_network_starttls_sthread(stringer_t *errmsg, uint32_t tcp_port
 	client_close(client);
 	return true;
 }
+
+/**
+ * @brief	Hold open more idle connections than there are worker threads, and then make sure every one of them is still serviced.
+ * @note	Idle connections are parked inside the poller, so they shouldn't be pinning worker threads while they wait for input.
+ * @param	errmsg	A stringer_t* into which the error message will be printed in the even of an error.
+ * @param	port	The port of the IMAP server.
+ * @return	True if every connection responded to the NOOP command, otherwise false.
+ */
+bool_t check_imap_network_idle_sthread(stringer_t *errmsg, uint32_t port) {
+
+	bool_t outcome = true;
+	client_t *clients[IMAP_CHECK_IDLE_CONNECTIONS];
+
+	mm_wipe(clients, sizeof(clients));
+
+	// Open all of the connections, and read the greeting, without sending a command.
+	for (uint32_t i = 0; outcome && i < IMAP_CHECK_IDLE_CONNECTIONS; i++) {
+		if (!(clients[i] = client_connect("localhost", port)) || !net_set_timeout(clients[i]->sockd, 20, 20) ||
+			client_read_line(clients[i]) <= 0 || (clients[i]->status != 1) || st_cmp_cs_starts(&(clients[i]->line), NULLER("* OK"))) {
+			st_sprint(errmsg, "Failed to connect with the IMAP server. { connection = %u }", i);
+			outcome = false;
+		}
+	}
+
+	// Now wake every connection up, in reverse order, and make sure they all respond.
+	for (int32_t i = IMAP_CHECK_IDLE_CONNECTIONS - 1; outcome && i >= 0; i--) {
+		if (client_print(clients[i], "A1 NOOP\r\n") <= 0 || !check_imap_client_read_end(clients[i], "A1") ||
+			client_status(clients[i]) != 1 || st_cmp_cs_starts(&(clients[i]->line), NULLER("A1 OK"))) {
+			st_sprint(errmsg, "Failed to return a successful state after NOOP. { connection = %i }", i);
+			outcome = false;
+		}
+	}
+
+	for (uint32_t i = 0; i < IMAP_CHECK_IDLE_CONNECTIONS; i++) {
+		if (clients[i]) client_close(clients[i]);
+	}
+
+	return outcome;
+}
@@ -282,6 +282,181 @@ bool_t check_smtp_checkers_filters_sthread(stringer_t *errmsg, int_t action, int
 	return true;
 }
 
+bool_t check_smtp_checkers_filters_cache_sthread(stringer_t *errmsg) {
+
+	inx_t *filters;
+	multi_t key = { .type = M_TYPE_UINT64, .val.u64 = 1 };
+	smtp_inbound_filter_t *filter;
+	smtp_filter_program_t *program, *cached;
+	uint64_t serial, usernum = rand_get_uint64();
+
+	if (!(filters = inx_alloc(M_INX_LINKED, &mm_free)) || !(filter = mm_alloc(sizeof(smtp_inbound_filter_t))) ||
+		!inx_insert(filters, key, filter)) {
+		st_sprint(errmsg, "Failed to create the filter list.");
+		inx_cleanup(filters);
+		return false;
+	}
+
+	filter->expression = NULLER("Princess");
+
+	// The first request compiles the program, and the second should return the same program from the cache.
+	if (!(program = smtp_filters_get(usernum, filters)) || program->count != 1 || program->errors[0]) {
+		st_sprint(errmsg, "Failed to compile the filter program.");
+		smtp_filters_free(program);
+		inx_cleanup(filters);
+		return false;
+	}
+
+	smtp_filters_release(program);
+
+	if ((cached = smtp_filters_get(usernum, filters)) != program) {
+		st_sprint(errmsg, "Failed to retrieve the compiled filter program from the cache.");
+		smtp_filters_release(cached);
+		inx_cleanup(filters);
+		return false;
+	}
+
+	serial = cached->serial;
+	smtp_filters_release(cached);
+
+	// Changing an expression should change the serial, and force the program to be compiled again.
+	filter->expression = NULLER("[this[is[not[valid[regex[");
+
+	if (!(program = smtp_filters_get(usernum, filters)) || program->serial == serial || !program->errors[0]) {
+		st_sprint(errmsg, "Failed to recompile the filter program after the filters changed.");
+		smtp_filters_release(program);
+		inx_cleanup(filters);
+		return false;
+	}
+
+	smtp_filters_release(program);
+	inx_cleanup(filters);
+
+	return true;
+}
+
+bool_t check_smtp_checkers_pipeline_sthread(stringer_t *errmsg) {
+
+	connection_t con;
+	smtp_message_t message;
+	smtp_inbound_prefs_t prefs;
+	uint32_t timeout;
+	int_t virus, dkim;
+
+	mm_wipe(&con, sizeof(connection_t));
+	mm_wipe(&prefs, sizeof(smtp_inbound_prefs_t));
+	mm_wipe(&message, sizeof(smtp_message_t));
+
+	message.id = NULLER("check.pipeline");
+	message.text = NULLER("To: magma@lavabit.com\r\nFrom: princess@example.com\r\nSubject: Pipeline\r\n\r\nThis is a clean message.\r\n");
+
+	prefs.usernum = 1;
+	prefs.virus = prefs.dkim = 1;
+	con.smtp.message = &message;
+	con.smtp.in_prefs = &prefs;
+	con.smtp.mailfrom = NULLER("princess@example.com");
+
+	// The pipeline should store the same results the checkers return when they're called directly.
+	virus = virus_check(message.text);
+	dkim = dkim_signature_verify(message.id, message.text);
+	smtp_pipeline_run(&con);
+
+	if (!magma.smtp.checkers.threads && (con.smtp.checked.virus || con.smtp.checked.dkim)) {
+		st_sprint(errmsg, "The message checkers were run without a checker thread pool.");
+		return false;
+	}
+	else if (magma.smtp.checkers.threads && (con.smtp.checked.virus != virus || con.smtp.checked.dkim != dkim)) {
+		st_sprint(errmsg, "The message checker pipeline returned unexpected results. { virus = %i / dkim = %i }", con.smtp.checked.virus,
+			con.smtp.checked.dkim);
+		return false;
+	}
+
+	// Checks which have already been run shouldn't be launched again.
+	con.smtp.checked.virus = con.smtp.checked.dkim = 10;
+	smtp_pipeline_run(&con);
+
+	if (con.smtp.checked.virus != 10 || con.smtp.checked.dkim != 10) {
+		st_sprint(errmsg, "The message checker pipeline repeated a check which had already been run.");
+		return false;
+	}
+
+	// A virus scan which misses its deadline must be scanned inline, or deferred, but never recorded as a failure and skipped.
+	if (magma.smtp.checkers.threads) {
+
+		timeout = magma.smtp.checkers.timeout.virus;
+		magma.smtp.checkers.timeout.virus = 0;
+		con.smtp.checked.virus = con.smtp.checked.dkim = 0;
+		prefs.dkim = 0;
+
+		smtp_pipeline_run(&con);
+		magma.smtp.checkers.timeout.virus = timeout;
+
+		if (con.smtp.checked.virus != virus && con.smtp.checked.virus != 0 && con.smtp.checked.virus != SMTP_PIPELINE_TIMEOUT) {
+			st_sprint(errmsg, "The message checker pipeline stored an unexpected result for a virus scan which missed its deadline. "
+				"{ virus = %i }", con.smtp.checked.virus);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool_t check_smtp_checkers_prefs_cache_sthread(stringer_t *errmsg) {
+
+	int_t state;
+	smtp_inbound_prefs_t *prefs = NULL, *cached = NULL;
+	stringer_t *unknown = MANAGEDBUF(128);
+
+	// The first request loads the preferences, and the second should return an identical copy from the cache.
+	if ((state = smtp_prefs_fetch(NULLER("magma@lavabit.com"), &prefs)) != 1 || !prefs || !prefs->usernum) {
+		st_sprint(errmsg, "Failed to fetch the recipient preferences. { state = %i }", state);
+		smtp_free_inbound(prefs);
+		return false;
+	}
+	else if ((state = smtp_prefs_fetch(NULLER("magma@lavabit.com"), &cached)) != 1 || !cached || cached == prefs ||
+		cached->usernum != prefs->usernum || cached->inbox != prefs->inbox || st_cmp_cs_eq(cached->rcptto, prefs->rcptto) ||
+		cached->rcptto == prefs->rcptto || (prefs->filters && inx_count(cached->filters) != inx_count(prefs->filters))) {
+		st_sprint(errmsg, "Failed to fetch a copy of the recipient preferences from the cache. { state = %i }", state);
+		smtp_free_inbound(prefs);
+		smtp_free_inbound(cached);
+		return false;
+	}
+
+	// The storage quota fields are refreshed from the database on every cache hit, since storing a message doesn't change the serial.
+	cached->stor_size = prefs->stor_size + 1;
+	cached->overquota = !prefs->overquota;
+
+	if (smtp_fetch_quota(cached) != 1 || cached->stor_size != prefs->stor_size || cached->quota != prefs->quota ||
+		cached->overquota != prefs->overquota) {
+		st_sprint(errmsg, "Failed to refresh the storage quota of the cached recipient preferences.");
+		smtp_free_inbound(prefs);
+		smtp_free_inbound(cached);
+		return false;
+	}
+
+	smtp_free_inbound(prefs);
+	smtp_free_inbound(cached);
+	prefs = NULL;
+
+	// Unknown recipients and non-local domains should be remembered, and returned the same way a second time.
+	st_sprint(unknown, "unknown.%lu@lavabit.com", rand_get_uint64());
+
+	for (int_t i = 0; i < 2; i++) {
+		if ((state = smtp_prefs_fetch(unknown, &prefs)) != 0 || prefs) {
+			st_sprint(errmsg, "Failed to reject an unknown recipient. { state = %i / attempt = %i }", state, i + 1);
+			smtp_free_inbound(prefs);
+			return false;
+		}
+		else if ((state = smtp_prefs_fetch(NULLER("princess@example.com"), &prefs)) != -6 || prefs) {
+			st_sprint(errmsg, "Failed to reject a recipient in a non-local domain. { state = %i / attempt = %i }", state, i + 1);
+			smtp_free_inbound(prefs);
+			return false;
+		}
+	}
+
+	return true;
+}
+
 bool_t check_smtp_checkers_rbl_sthread(stringer_t *errmsg) {
 
 	connection_t con;
@@ -321,3 +496,65 @@ bool_t check_smtp_checkers_rbl_sthread(stringer_t *errmsg) {
 	mm_free(con.network.reverse.ip);
 	return true;
 }
+
+bool_t check_smtp_checkers_rbl_cache_sthread(stringer_t *errmsg) {
+
+	int_t length;
+	uint64_t hits;
+	uint32_t ttl = 0;
+	HEADER *header;
+	uchr_t packet[NS_PACKETSZ];
+	chr_t *listed = "2.0.0.127.rbl.check.example.com", *failed = "1.0.0.127.rbl.check.example.com";
+
+	// An A record, which points back at the question name, with a TTL of 600 seconds.
+	uchr_t record[] = { 0xC0, 0x0C, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x02, 0x58, 0x00, 0x04, 0x7F, 0x00, 0x00, 0x02 };
+
+	// Build a query, and then turn it into a response.
+	if ((length = res_mkquery(ns_o_query, listed, ns_c_in, ns_t_a, NULL, 0, NULL, packet, sizeof(packet))) <= 0 ||
+		length + sizeof(record) > sizeof(packet)) {
+		st_sprint(errmsg, "Failed to build the blacklist query packet.");
+		return false;
+	}
+
+	header = (HEADER *)packet;
+	header->qr = 1;
+	header->ancount = htons(1);
+	mm_copy(packet + length, record, sizeof(record));
+
+	if (smtp_rbl_parse(packet, length + sizeof(record), &ttl) != -2 || ttl != 600) {
+		st_sprint(errmsg, "Failed to parse a blacklist response with an A record. { ttl = %u }", ttl);
+		return false;
+	}
+
+	// A name error without an SOA record should use the default negative TTL.
+	header->ancount = 0;
+	header->rcode = ns_r_nxdomain;
+
+	if (smtp_rbl_parse(packet, length, &ttl) != 1 || ttl != SMTP_RBL_NEGATIVE_TTL) {
+		st_sprint(errmsg, "Failed to parse a negative blacklist response. { ttl = %u }", ttl);
+		return false;
+	}
+
+	header->rcode = ns_r_servfail;
+
+	if (smtp_rbl_parse(packet, length, &ttl) != -1) {
+		st_sprint(errmsg, "Failed to recognize a blacklist server failure.");
+		return false;
+	}
+
+	// Cached results should be returned, and counted as hits, while errors should never be cached.
+	smtp_rbl_cache_set(listed, -2, 600);
+	smtp_rbl_cache_set(failed, -1, 600);
+	hits = stats_get_value_by_name("smtp.rbl.cache.hits");
+
+	if (smtp_rbl_cache_get(listed) != -2 || stats_get_value_by_name("smtp.rbl.cache.hits") != hits + 1) {
+		st_sprint(errmsg, "Failed to retrieve a cached blacklist result.");
+		return false;
+	}
+	else if (smtp_rbl_cache_get(failed) != 0) {
+		st_sprint(errmsg, "A blacklist error was incorrectly cached.");
+		return false;
+	}
+
+	return true;
+}
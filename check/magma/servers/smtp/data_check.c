@@ -0,0 +1,202 @@
+/**
+ * @file /check/magma/servers/smtp/data_check.c
+ *
+ * @brief SMTP DATA reader test functions.
+ */
+
+#include "magma_check.h"
+
+/**
+ * @brief	Process an incoming message one byte at a time, using the same state machine as smtp_data_read().
+ * @note	This is the reference which the bulk copy logic in smtp_data_read() is checked against, so it deliberately avoids it.
+ * @param	input	the message data, as sent by the client, including the terminating sequence.
+ * @return	NULL on failure, or a managed string containing the message as smtp_data_read() should return it.
+ */
+stringer_t * check_smtp_data_reference(stringer_t *input) {
+
+	chr_t *stream, *buffer;
+	stringer_t *result;
+	size_t used = 0;
+	int_t header = 1, checker = 1, carriage = 0;
+
+	// Every byte could be a bare line feed, which gets a carriage return added.
+	if (!(result = st_alloc((st_length_get(input) * 2) + 1))) {
+		return NULL;
+	}
+
+	stream = st_char_get(input);
+	buffer = st_char_get(result);
+
+	for (size_t increment = 0; checker != 4 && increment < st_length_get(input); increment++) {
+
+		if (header != 3) {
+			if (header == 0 && *stream == '\n') {
+				header++;
+			}
+			else if (header == 1 && *stream == '\n') {
+				header += 2;
+			}
+			else if (header == 1 && *stream == '\r') {
+				header++;
+			}
+			else if (header == 2 && *stream == '\n') {
+				header++;
+			}
+			else if (header != 0) {
+				header = 0;
+			}
+		}
+
+		if (checker == 0 && *stream == '\n') {
+			checker++;
+		}
+		else if (checker == 1 && *stream == '.') {
+			checker++;
+		}
+		else if (checker == 2 && *stream == '\n') {
+			checker += 2;
+		}
+		else if (checker == 2 && *stream == '\r') {
+			checker++;
+		}
+		else if (checker == 3 && *stream == '\n') {
+			checker++;
+		}
+		else if (*stream == '\n') {
+			checker = 1;
+		}
+		else if (checker != 0) {
+			checker = 0;
+		}
+
+		if (*stream == '\n' && carriage == 0) {
+			*buffer++ = '\r';
+			used++;
+		}
+		else if (*stream == '\r') {
+			carriage = 1;
+		}
+		else if (carriage != 0) {
+			carriage = 0;
+		}
+
+		if (header != 3 && *stream >= 0) {
+			*buffer++ = *stream;
+			used++;
+		}
+		else if (header == 3) {
+			*buffer++ = *stream;
+			used++;
+		}
+
+		stream++;
+	}
+
+	st_length_set(result, used);
+	return result;
+}
+
+/**
+ * @brief	Feed a message to smtp_data_read() over a socket pair, and compare the result with the byte by byte reference.
+ * @param	input	the message data, as sent by the client, including the terminating sequence.
+ * @return	True if the result matched the reference, false otherwise.
+ */
+bool_t check_smtp_data_compare(stringer_t *input, stringer_t *errmsg) {
+
+	int sockets[2];
+	connection_t con;
+	bool_t result = true;
+	stringer_t *message = NULL, *expected = NULL;
+
+	mm_wipe(&con, sizeof(connection_t));
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets)) {
+		st_sprint(errmsg, "Unable to create the socket pair.");
+		return false;
+	}
+	else if (write(sockets[1], st_data_get(input), st_length_get(input)) != st_length_get(input)) {
+		st_sprint(errmsg, "Unable to write the message to the socket pair.");
+		close(sockets[0]);
+		close(sockets[1]);
+		return false;
+	}
+
+	con.network.sockd = sockets[0];
+	con.smtp.max_length = 1024 * 1024;
+
+	if (!(expected = check_smtp_data_reference(input))) {
+		st_sprint(errmsg, "Unable to build the reference message.");
+		result = false;
+	}
+	else if (smtp_data_read(&con, &message) != 1 || !message) {
+		st_sprint(errmsg, "The DATA reader failed. { input = %.*s }", st_length_int(input), st_char_get(input));
+		result = false;
+	}
+	else if (st_length_get(message) != st_length_get(expected) || st_cmp_cs_eq(message, expected)) {
+		st_sprint(errmsg, "The DATA reader didn't match the byte by byte reference. { input = %.*s / expected = %zu / got = %zu }",
+			st_length_int(input), st_char_get(input), st_length_get(expected), st_length_get(message));
+		result = false;
+	}
+
+	st_cleanup(message, expected, con.network.buffer);
+	close(sockets[0]);
+	close(sockets[1]);
+
+	return result;
+}
+
+/**
+ * @brief	Check the bulk copy logic in the DATA reader, with line breaks, non-ASCII header bytes, dot stuffed lines and the terminating
+ * 			sequence placed on either side of the 16 and 32 byte vector boundaries, and at the end of the message.
+ * @return	True if every message matched the byte by byte reference, false otherwise.
+ */
+bool_t check_smtp_data_sthread(stringer_t *errmsg) {
+
+	stringer_t *input, *run = MANAGEDBUF(64);
+	size_t offsets[] = { 0, 15, 16, 17, 31, 32, 33 };
+	chr_t *breaks[] = { "\r\n", "\n", "\r", "\r\n..stuffed\r\n", "\n..stuffed\n", "\r\n.x\r\n", "\r\n.\r", "\r\n\r\n" };
+	chr_t *terminators[] = { "\r\n.\r\n", "\n.\n", "\n.\r\n", "\r\n.\n" };
+
+	for (size_t o = 0; status() && o < (sizeof(offsets) / sizeof(size_t)); o++) {
+
+		// A run of plain text, so the interesting bytes land at the given offset from the start of the run.
+		st_wipe(run);
+		for (size_t i = 0; i < offsets[o]; i++) {
+			*(st_char_get(run) + i) = 'a' + (i % 26);
+		}
+		st_length_set(run, offsets[o]);
+
+		for (size_t b = 0; b < (sizeof(breaks) / sizeof(chr_t *)); b++) {
+			for (size_t t = 0; t < (sizeof(terminators) / sizeof(chr_t *)); t++) {
+
+				// A line break in the body, after the run.
+				if (!(input = st_merge("nsnsnnn", "Subject: check\r\n\r\n", run, breaks[b], run, "tail", terminators[t], "QUIT\r\n")) ||
+					!check_smtp_data_compare(input, errmsg)) {
+					st_cleanup(input);
+					return false;
+				}
+
+				st_free(input);
+
+				// A line break in the header, after a non-ASCII byte which the header logic drops.
+				if (!(input = st_merge("snsnnsnnn", run, "\xc3\xa9", run, breaks[b], "X-Check: value", run, "\r\n\r\nbody", terminators[t],
+					"QUIT\r\n")) || !check_smtp_data_compare(input, errmsg)) {
+					st_cleanup(input);
+					return false;
+				}
+
+				st_free(input);
+
+				// The terminating sequence directly after the run, at the end of the data sent by the client.
+				if (!(input = st_merge("nsn", "Subject: check\r\n\r\n", run, terminators[t])) || !check_smtp_data_compare(input, errmsg)) {
+					st_cleanup(input);
+					return false;
+				}
+
+				st_free(input);
+			}
+		}
+	}
+
+	return true;
+}
@@ -90,6 +90,19 @@ START_TEST (check_smtp_checkers_filters_s) {
 }
 END_TEST
 
+START_TEST (check_smtp_checkers_filters_cache_s) {
+
+	log_disable();
+	bool_t outcome = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (status()) outcome = check_smtp_checkers_filters_cache_sthread(errmsg);
+
+	log_test("SMTP / CHECKERS / FILTERS CACHE / SINGLE THREADED:", errmsg);
+	ck_assert_msg(outcome, st_char_get(errmsg));
+}
+END_TEST
+
 START_TEST (check_smtp_checkers_rbl_s) {
 
 	log_disable();
@@ -103,6 +116,19 @@ START_TEST (check_smtp_checkers_rbl_s) {
 }
 END_TEST
 
+START_TEST (check_smtp_checkers_rbl_cache_s) {
+
+	log_disable();
+	bool_t outcome = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (status()) outcome = check_smtp_checkers_rbl_cache_sthread(errmsg);
+
+	log_test("SMTP / CHECKERS / RBL CACHE / SINGLE THREADED:", errmsg);
+	ck_assert_msg(outcome, st_char_get(errmsg));
+}
+END_TEST
+
 START_TEST (check_smtp_network_auth_plain_s) {
 
 	log_disable();
@@ -191,14 +217,58 @@ START_TEST (check_smtp_network_starttls_s) {
 }
 END_TEST
 
+START_TEST (check_smtp_checkers_pipeline_s) {
+
+	log_disable();
+	bool_t outcome = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (status()) outcome = check_smtp_checkers_pipeline_sthread(errmsg);
+
+	log_test("SMTP / CHECKERS / PIPELINE / SINGLE THREADED:", errmsg);
+	ck_assert_msg(outcome, st_char_get(errmsg));
+}
+END_TEST
+
+START_TEST (check_smtp_checkers_prefs_cache_s) {
+
+	log_disable();
+	bool_t outcome = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (status()) outcome = check_smtp_checkers_prefs_cache_sthread(errmsg);
+
+	log_test("SMTP / CHECKERS / PREFS CACHE / SINGLE THREADED:", errmsg);
+	ck_assert_msg(outcome, st_char_get(errmsg));
+}
+END_TEST
+
+START_TEST (check_smtp_data_read_s) {
+
+	log_disable();
+	bool_t outcome = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (status()) outcome = check_smtp_data_sthread(errmsg);
+
+	log_test("SMTP / DATA / READ / SINGLE THREADED:", errmsg);
+	ck_assert_msg(outcome, st_char_get(errmsg));
+}
+END_TEST
+
 Suite * suite_check_smtp(void) {
 
 	Suite *s = suite_create("\tSMTP");
 
 	suite_check_testcase(s, "SMTP", "SMTP Accept Message/S", check_smtp_accept_store_message_s);
+	suite_check_testcase(s, "SMTP", "SMTP Data Read/S", check_smtp_data_read_s);
 	suite_check_testcase(s, "SMTP", "SMTP Checkers Greylist/S", check_smtp_checkers_greylist_s);
 	suite_check_testcase(s, "SMTP", "SMTP Checkers Filters/S", check_smtp_checkers_filters_s);
+	suite_check_testcase(s, "SMTP", "SMTP Checkers Filters Cache/S", check_smtp_checkers_filters_cache_s);
+	suite_check_testcase(s, "SMTP", "SMTP Checkers Prefs Cache/S", check_smtp_checkers_prefs_cache_s);
+	suite_check_testcase(s, "SMTP", "SMTP Checkers Pipeline/S", check_smtp_checkers_pipeline_s);
 	suite_check_testcase(s, "SMTP", "SMTP Checkers RBL", check_smtp_checkers_rbl_s);
+	suite_check_testcase(s, "SMTP", "SMTP Checkers RBL Cache/S", check_smtp_checkers_rbl_cache_s);
 	suite_check_testcase(s, "SMTP", "SMTP Network Basic/ TCP/S", check_smtp_network_basic_tcp_s);
 	suite_check_testcase(s, "SMTP", "SMTP Network Basic/ TLS/S", check_smtp_network_basic_tls_s);
 	suite_check_testcase(s, "SMTP", "SMTP Network Auth Plain/S", check_smtp_network_auth_plain_s);
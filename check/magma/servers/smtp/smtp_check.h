@@ -11,11 +11,20 @@
 bool_t check_smtp_accept_message_sthread(stringer_t *errmsg);
 
 /// checkers_check.c
+bool_t check_smtp_checkers_rbl_cache_sthread(stringer_t *errmsg);
 bool_t check_smtp_checkers_rbl_sthread(stringer_t *errmsg);
 bool_t check_smtp_checkers_regex_sthread(stringer_t *errmsg);
 bool_t check_smtp_checkers_greylist_sthread(stringer_t *errmsg);
+bool_t check_smtp_checkers_filters_cache_sthread(stringer_t *errmsg);
+bool_t check_smtp_checkers_pipeline_sthread(stringer_t *errmsg);
+bool_t check_smtp_checkers_prefs_cache_sthread(stringer_t *errmsg);
 bool_t check_smtp_checkers_filters_sthread(stringer_t *errmsg, int_t action, int_t expected);
 
+/// data_check.c
+bool_t check_smtp_data_compare(stringer_t *input, stringer_t *errmsg);
+stringer_t * check_smtp_data_reference(stringer_t *input);
+bool_t check_smtp_data_sthread(stringer_t *errmsg);
+
 /// smtp_check_network.c
 bool_t check_smtp_client_read_end(client_t *client);
 bool_t check_smtp_client_quit(client_t *client, stringer_t *errmsg);
@@ -12,6 +12,8 @@ memcached_return_t (*memcached_server_add_with_weight_d)(memcached_st *ptr, cons
 memcached_return_t (*memcached_decrement_d)(memcached_st *ptr, const char *key, size_t key_length, uint32_t offset, uint64_t *value) = NULL;
 memcached_return_t (*memcached_increment_d)(memcached_st *ptr, const char *key, size_t key_length, uint32_t offset, uint64_t *value) = NULL;
 char * (*memcached_get_d)(memcached_st *ptr, const char *key, size_t key_length, size_t *value_length, uint32_t *flags, memcached_return_t *error) = NULL;
+char * (*memcached_fetch_d)(memcached_st *ptr, char *key, size_t *key_length, size_t *value_length, uint32_t *flags, memcached_return_t *error) = NULL;
+memcached_return_t (*memcached_mget_d)(memcached_st *ptr, const char * const *keys, const size_t *key_length, size_t number_of_keys) = NULL;
 memcached_return_t (*memcached_add_d)(memcached_st *ptr, const char *key, size_t key_length, const char *value, size_t value_length, time_t expiration, uint32_t flags) = NULL;
 memcached_return_t (*memcached_set_d)(memcached_st *ptr, const char *key, size_t key_length, const char *value, size_t value_length, time_t expiration, uint32_t flags) = NULL;
 memcached_return_t (*memcached_append_d)(memcached_st *ptr, const char *key, size_t key_length, const char *value, size_t value_length, time_t expiration, uint32_t flags) = NULL;
@@ -526,6 +528,7 @@ void (*xmlMemoryDump_d)(void) = NULL;
 void (*xmlCleanupParser_d)(void) = NULL;
 void (*xmlCleanupGlobals_d)(void) = NULL;
 void (*xmlFreeDoc_d)(xmlDocPtr doc) = NULL;
+xmlDocPtr (*xmlCopyDoc_d)(xmlDocPtr doc, int recursive) = NULL;
 void (*xmlFreeNode_d)(xmlNodePtr cur) = NULL;
 xmlBufferPtr (*xmlBufferCreate_d)(void) = NULL;
 void (*xmlBufferFree_d)(xmlBufferPtr buf) = NULL;
@@ -562,6 +565,8 @@ if ((*(void **)&(memcached_server_add_with_weight_d) = dlsym(magma, "memcached_s
 if ((*(void **)&(memcached_decrement_d) = dlsym(magma, "memcached_decrement")) == NULL) return "memcached_decrement";
 if ((*(void **)&(memcached_increment_d) = dlsym(magma, "memcached_increment")) == NULL) return "memcached_increment";
 if ((*(void **)&(memcached_get_d) = dlsym(magma, "memcached_get")) == NULL) return "memcached_get";
+if ((*(void **)&(memcached_fetch_d) = dlsym(magma, "memcached_fetch")) == NULL) return "memcached_fetch";
+if ((*(void **)&(memcached_mget_d) = dlsym(magma, "memcached_mget")) == NULL) return "memcached_mget";
 if ((*(void **)&(memcached_add_d) = dlsym(magma, "memcached_add")) == NULL) return "memcached_add";
 if ((*(void **)&(memcached_set_d) = dlsym(magma, "memcached_set")) == NULL) return "memcached_set";
 if ((*(void **)&(memcached_append_d) = dlsym(magma, "memcached_append")) == NULL) return "memcached_append";
@@ -1073,6 +1078,7 @@ if ((*(void **)&(xmlMemoryDump_d) = dlsym(magma, "xmlMemoryDump")) == NULL) retu
 if ((*(void **)&(xmlCleanupParser_d) = dlsym(magma, "xmlCleanupParser")) == NULL) return "xmlCleanupParser";
 if ((*(void **)&(xmlCleanupGlobals_d) = dlsym(magma, "xmlCleanupGlobals")) == NULL) return "xmlCleanupGlobals";
 if ((*(void **)&(xmlFreeDoc_d) = dlsym(magma, "xmlFreeDoc")) == NULL) return "xmlFreeDoc";
+if ((*(void **)&(xmlCopyDoc_d) = dlsym(magma, "xmlCopyDoc")) == NULL) return "xmlCopyDoc";
 if ((*(void **)&(xmlFreeNode_d) = dlsym(magma, "xmlFreeNode")) == NULL) return "xmlFreeNode";
 if ((*(void **)&(xmlBufferCreate_d) = dlsym(magma, "xmlBufferCreate")) == NULL) return "xmlBufferCreate";
 if ((*(void **)&(xmlBufferFree_d) = dlsym(magma, "xmlBufferFree")) == NULL) return "xmlBufferFree";
@@ -70,3 +70,60 @@ CREATE TABLE `Realms` (
   CONSTRAINT `User_Realms_ibfk_1` FOREIGN KEY (`usernum`) REFERENCES `Users` (`usernum`) ON UPDATE CASCADE
 ) ENGINE=InnoDB AUTO_INCREMENT=1 DEFAULT CHARSET=latin1 MAX_ROWS=4294967295 AVG_ROW_LENGTH=100 COMMENT='User shard values for the different realms.';
 
+
+/* The message change log, used to refresh cached mailboxes without reloading every message. The log is populated by triggers, so
+	every statement which modifies a message, or its tags, is recorded. Old entries are pruned by the daily script. */
+DROP TABLE IF EXISTS `Message_Changes`;
+CREATE TABLE `Message_Changes` (
+  `changenum` bigint(20) unsigned NOT NULL AUTO_INCREMENT,
+  `usernum` bigint(20) unsigned NOT NULL,
+  `messagenum` bigint(20) unsigned NOT NULL,
+  `timestamp` datetime NOT NULL,
+  PRIMARY KEY (`changenum`),
+  KEY `IX_USERNUM_TIMESTAMP` (`usernum`, `timestamp`),
+  KEY `IX_TIMESTAMP` (`timestamp`)
+) ENGINE=InnoDB AUTO_INCREMENT=1 DEFAULT CHARSET=latin1 MAX_ROWS=4294967295 AVG_ROW_LENGTH=40 COMMENT='A log of recently modified messages.';
+
+/* The IMAP summaries of plain text messages, computed once during delivery so FETCH requests for the ENVELOPE, BODYSTRUCTURE and
+	header fields don't need to read the message file. Messages without a summary are still parsed on demand. */
+DROP TABLE IF EXISTS `Message_Summaries`;
+CREATE TABLE `Message_Summaries` (
+  `messagenum` bigint(20) unsigned NOT NULL,
+  `envelope` mediumblob NOT NULL,
+  `bodystructure` mediumblob DEFAULT NULL,
+  `header` mediumblob NOT NULL,
+  PRIMARY KEY (`messagenum`),
+  CONSTRAINT `Message_Summaries_ibfk_1` FOREIGN KEY (`messagenum`) REFERENCES `Messages` (`messagenum`) ON DELETE CASCADE ON UPDATE CASCADE
+) ENGINE=InnoDB DEFAULT CHARSET=latin1 MAX_ROWS=4294967295 AVG_ROW_LENGTH=2048 COMMENT='The IMAP summaries computed when a message is stored.';
+
+DELIMITER $$
+
+DROP TRIGGER IF EXISTS `Messages_Insert_Change`$$
+CREATE TRIGGER `Messages_Insert_Change` AFTER INSERT ON `Messages` FOR EACH ROW BEGIN
+	INSERT INTO Message_Changes (usernum, messagenum, timestamp) VALUES (NEW.usernum, NEW.messagenum, NOW());
+END$$
+
+DROP TRIGGER IF EXISTS `Messages_Update_Change`$$
+CREATE TRIGGER `Messages_Update_Change` AFTER UPDATE ON `Messages` FOR EACH ROW BEGIN
+	INSERT INTO Message_Changes (usernum, messagenum, timestamp) VALUES (NEW.usernum, NEW.messagenum, NOW());
+	IF OLD.usernum <> NEW.usernum THEN
+		INSERT INTO Message_Changes (usernum, messagenum, timestamp) VALUES (OLD.usernum, OLD.messagenum, NOW());
+	END IF;
+END$$
+
+DROP TRIGGER IF EXISTS `Messages_Delete_Change`$$
+CREATE TRIGGER `Messages_Delete_Change` AFTER DELETE ON `Messages` FOR EACH ROW BEGIN
+	INSERT INTO Message_Changes (usernum, messagenum, timestamp) VALUES (OLD.usernum, OLD.messagenum, NOW());
+END$$
+
+DROP TRIGGER IF EXISTS `Message_Tags_Insert_Change`$$
+CREATE TRIGGER `Message_Tags_Insert_Change` AFTER INSERT ON `Message_Tags` FOR EACH ROW BEGIN
+	INSERT INTO Message_Changes (usernum, messagenum, timestamp) SELECT usernum, messagenum, NOW() FROM Messages WHERE messagenum = NEW.messagenum;
+END$$
+
+DROP TRIGGER IF EXISTS `Message_Tags_Delete_Change`$$
+CREATE TRIGGER `Message_Tags_Delete_Change` AFTER DELETE ON `Message_Tags` FOR EACH ROW BEGIN
+	INSERT INTO Message_Changes (usernum, messagenum, timestamp) SELECT usernum, messagenum, NOW() FROM Messages WHERE messagenum = OLD.messagenum;
+END$$
+
+DELIMITER ;
@@ -19,6 +19,10 @@ DELETE FROM Transmitting WHERE timestamp < DATE_SUB(NOW(), INTERVAL 7 DAY);
 -- Cleanup the receiving table, delete records which are older than 7 days.
 DELETE FROM Receiving WHERE timestamp < DATE_SUB(NOW(), INTERVAL 7 DAY);
 
+-- Cleanup the message change log, delete records which are older than 1 day. Cached mailboxes older than the MESSAGES_CHANGES_WINDOW
+-- are reloaded in full, so the retention period must be longer than that window.
+DELETE FROM Message_Changes WHERE timestamp < DATE_SUB(NOW(), INTERVAL 1 DAY);
+
 -- New isolation level for these big updates.
 SET SESSION TRANSACTION ISOLATION LEVEL READ UNCOMMITTED;
 
@@ -22,6 +22,11 @@
  */
 #define MAGMA_CORE_POOL_TIMEOUT_LIMIT 86400
 
+/**
+ *  The number of pools each thread remembers its last object for.
+ */
+#define MAGMA_CORE_POOL_AFFINITY 4
+
 // Defines for the array type.
 #define ARRAY_MAX_ELEMENTS 16384
 #define ARRAY_TYPE_EMPTY 0
@@ -59,9 +64,12 @@ typedef struct {
 	uint32_t count; /* Number of objects allocated. */
 	uint32_t timeout; /* How long to wait for an object before timing out. Zero is forever. */
 	uint64_t failures; /* Tracks the number of times a thread was forced to return empty handed. */
+	uint64_t head; /* The free list head, holding a change counter in the upper half and the item number plus one in the lower half. */
 	sem_t available; /* Semaphore holding the number of objects currently available. */
 	pthread_mutex_t lock; /* Mutex for locking coordinating updates between threads. */
 	status_t *status; /* Array of booleans to indicate object availability. */
+	uint32_t *next; /* The free list links, holding the next item number plus one. */
+	uint32_t *listed; /* Array of flags indicating whether an item is on the free list. */
 	void **objects; /* Array of objects. */
 } pool_t;
 
@@ -3,10 +3,97 @@
  * @file /magma/core/buckets/pool.c
  *
  * @brief	A collection of functions used to create, maintain and safely utilize collections of object pointers that are accessed by multiple threads.
+ * @note	Objects are reserved by atomically flipping their status. A thread first tries the object it used last time, which keeps
+ * 			connection specific state like prepared statements warm, and then falls back to a lock free list of available objects.
+ * 			The semaphore still tracks the number of available objects, so threads only block when the pool is exhausted.
  */
 
 #include "../core.h"
 
+__thread struct {
+	pool_t *pool;
+	uint32_t item;
+} pool_affinity[MAGMA_CORE_POOL_AFFINITY]; /* The object each thread last used, for a handful of pools. */
+
+/**
+ * @brief	Push an item onto the free list of a pool.
+ * @note	An item is only pushed if it isn't already on the list, so a stale entry left behind by an affinity reservation never
+ * 			results in the same item being linked twice.
+ * @param	pool	the pool holding the item.
+ * @param	item	the item number.
+ * @return	This function returns no value.
+ */
+void pool_list_push(pool_t *pool, uint32_t item) {
+
+	uint64_t head, replacement;
+
+	if (__atomic_exchange_n(pool->listed + item, 1, __ATOMIC_ACQ_REL)) {
+		return;
+	}
+
+	head = __atomic_load_n(&(pool->head), __ATOMIC_ACQUIRE);
+
+	do {
+		__atomic_store_n(pool->next + item, (uint32_t)head, __ATOMIC_RELAXED);
+		replacement = (((head >> 32) + 1) << 32) | (item + 1);
+	} while (!__atomic_compare_exchange_n(&(pool->head), &head, replacement, true, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE));
+
+	return;
+}
+
+/**
+ * @brief	Pop an item off the free list of a pool.
+ * @note	The change counter stored alongside the head prevents a concurrent pop and push of the same item from corrupting the list.
+ * @param	pool	the pool holding the list.
+ * @param	item	a pointer to receive the item number.
+ * @return	false if the list is empty, or true if an item was removed.
+ */
+bool_t pool_list_pop(pool_t *pool, uint32_t *item) {
+
+	uint64_t head, replacement;
+
+	head = __atomic_load_n(&(pool->head), __ATOMIC_ACQUIRE);
+
+	do {
+		if (!(uint32_t)head) {
+			return false;
+		}
+
+		replacement = (((head >> 32) + 1) << 32) | __atomic_load_n(pool->next + ((uint32_t)head - 1), __ATOMIC_RELAXED);
+	} while (!__atomic_compare_exchange_n(&(pool->head), &head, replacement, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+	*item = (uint32_t)head - 1;
+	__atomic_store_n(pool->listed + *item, 0, __ATOMIC_RELEASE);
+	return true;
+}
+
+/**
+ * @brief	Attempt to reserve a specific item in a pool.
+ * @param	pool	the pool holding the item.
+ * @param	item	the item number.
+ * @return	true if the item was available and is now reserved, or false otherwise.
+ */
+bool_t pool_claim(pool_t *pool, uint32_t item) {
+
+	status_t expected = PL_AVAILABLE;
+
+	return __atomic_compare_exchange_n(pool->status + item, &expected, PL_RESERVED, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief	Return an item to the available state and make sure it can be found on the free list.
+ * @param	pool	the pool holding the item.
+ * @param	item	the item number.
+ * @return	This function returns no value.
+ */
+void pool_return(pool_t *pool, uint32_t item) {
+
+	__atomic_store_n(pool->status + item, PL_AVAILABLE, __ATOMIC_RELEASE);
+	pool_list_push(pool, item);
+
+	return;
+}
+
 /**
  * @brief	Free an object pool.
  * @warning	This function will not free the underlying objects contained by the pool!
@@ -33,7 +120,7 @@ void pool_free(pool_t *pool) {
 pool_t * pool_alloc(uint32_t count, uint32_t timeout) {
 
 	pool_t *pool;
-	size_t pool_size = sizeof(pool_t) + (sizeof(status_t) * count) + (sizeof(void *) * count);
+	size_t pool_size = sizeof(pool_t) + (sizeof(status_t) * count) + (sizeof(uint32_t) * count * 2) + (sizeof(void *) * count);
 
 	if (count > MAGMA_CORE_POOL_OBJECTS_LIMIT) {
 		mclog_info("%u exceeds the maximum number of pool objects allowed.", count);
@@ -55,8 +142,15 @@ pool_t * pool_alloc(uint32_t count, uint32_t timeout) {
 	pool->count = count;
 	pool->timeout = timeout;
 
-	pool->status = (status_t *)((char *)pool + sizeof(pool_t));
-	pool->objects = (void *)((char *)pool + sizeof(pool_t) + ((sizeof(status_t) * count)));
+	pool->objects = (void *)((char *)pool + sizeof(pool_t));
+	pool->status = (status_t *)((char *)pool->objects + (sizeof(void *) * count));
+	pool->next = (uint32_t *)((char *)pool->status + (sizeof(status_t) * count));
+	pool->listed = pool->next + count;
+
+	// Every item starts out available, and on the free list.
+	for (uint32_t i = count; i > 0; i--) {
+		pool_list_push(pool, i - 1);
+	}
 
 	if (sem_init(&(pool->available), 0, count)) {
 		mclog_info("Unable to initialize the pool semaphore.");
@@ -118,15 +212,10 @@ uint32_t pool_get_timeout(pool_t *pool) {
  */
 uint64_t pool_get_failures(pool_t *pool) {
 
-	uint64_t result;
 	if (!pool)
 		return 0;
 
-	mutex_lock(&(pool->lock));
-	result = pool->failures;
-	mutex_unlock(&(pool->lock));
-
-	return result;
+	return __atomic_load_n(&(pool->failures), __ATOMIC_RELAXED);
 }
 
 /**
@@ -145,7 +234,7 @@ status_t pool_get_status(pool_t *pool, uint32_t item) {
 
 	mclog_check(*(pool->status + item) != PL_AVAILABLE && *(pool->status + item) != PL_RESERVED);
 
-	return *(pool->status + item);
+	return __atomic_load_n(pool->status + item, __ATOMIC_ACQUIRE);
 }
 
 /**
@@ -165,56 +254,82 @@ status_t pool_set_status(pool_t *pool, uint32_t item, status_t status) {
 
 	mclog_check(status != PL_AVAILABLE && status != PL_RESERVED);
 
-	return *(pool->status + item) = status;
+	__atomic_store_n(pool->status + item, status, __ATOMIC_RELEASE);
+	return status;
+}
+
+/**
+ * @brief	Acquire one of the available slots tracked by a pool semaphore.
+ * @note	The semaphore is checked without blocking first, and only if the pool is exhausted do we wait, up to the pool timeout.
+ * @param	pool	the pool to be checked.
+ * @return	true if a slot was acquired, or false if the wait timed out.
+ */
+bool_t pool_wait(pool_t *pool) {
+
+	struct timespec timeout;
+
+	if (!sem_trywait(&(pool->available))) {
+		return true;
+	}
+	else if (!pool->timeout) {
+		sem_wait(&(pool->available));
+		return true;
+	}
+	else if (clock_gettime(CLOCK_REALTIME, &timeout)) {
+		return false;
+	}
+
+	timeout.tv_sec += pool->timeout;
+
+	return !sem_timedwait(&(pool->available), &timeout);
 }
 
 /**
  * @brief	Return the first available object in a pool.
  * @note	If no object can be returned immediately, wait for the pool's configured timeout value, in seconds, for
- * 			an object to become available. If the timeout is zero, wait indefinitely.
+ * 			an object to become available. If the timeout is zero, wait indefinitely. Once a slot has been acquired from the
+ * 			semaphore, the object last used by the calling thread is preferred, otherwise an object is taken from the free list.
  * @param	item	A pointer to a number that will store the zero-based indexed of the first available item in the pool.
  * @return	PL_RESERVED on success or PL_ERROR if an object couldn't be reserved.
  */
 status_t pool_pull(pool_t *pool, uint32_t *item) {
 
-	status_t result = PL_ERROR;
-	struct timespec timeout;
+	uint32_t slot, candidate;
 
 	if (!pool || !item)
 		return PL_ERROR;
 
-	if (pool->timeout != 0) {
-
-		if (clock_gettime(CLOCK_REALTIME, &timeout))
-			return PL_ERROR;
-
-		timeout.tv_sec += pool->timeout;
+	if (!pool_wait(pool)) {
+		__atomic_add_fetch(&(pool->failures), 1, __ATOMIC_RELAXED);
+		return PL_ERROR;
+	}
 
-		if (sem_timedwait(&(pool->available), &timeout)) {
-			mutex_lock(&(pool->lock));
-			pool->failures++;
-			mutex_unlock(&(pool->lock));
-			return PL_ERROR;
-		}
+	slot = ((uintptr_t)pool >> 6) % MAGMA_CORE_POOL_AFFINITY;
 
-	} else {
-		sem_wait(&(pool->available));
+	// Try the object this thread used last.
+	if (pool_affinity[slot].pool == pool && pool_affinity[slot].item < pool->count && pool_claim(pool, pool_affinity[slot].item)) {
+		*item = pool_affinity[slot].item;
+		return PL_RESERVED;
 	}
 
-	mutex_lock(&(pool->lock));
-	for (uint32_t i = 0; result == PL_ERROR && i < pool->count; i++) {
-		if (pool_get_status(pool, i) == PL_AVAILABLE) {
-			result = pool_set_status(pool, i, PL_RESERVED);
-			*item = i;
+	// Holding a semaphore slot guarantees an object is available, but it may still be on its way back to the free list, or the list
+	// may hold stale entries for objects reserved through affinity, so we keep trying until we win one.
+	while (true) {
+		if (pool_list_pop(pool, &candidate)) {
+			if (pool_claim(pool, candidate)) {
+				break;
+			}
+		}
+		else {
+			sched_yield();
 		}
 	}
 
-	if (result == PL_ERROR)
-		pool->failures++;
+	pool_affinity[slot].pool = pool;
+	pool_affinity[slot].item = candidate;
+	*item = candidate;
 
-	mutex_unlock(&(pool->lock));
-
-	return result;
+	return PL_RESERVED;
 }
 
 /**
@@ -226,9 +341,7 @@ status_t pool_pull(pool_t *pool, uint32_t *item) {
 void pool_release(pool_t *pool, uint32_t item) {
 	if (!pool)
 		return;
-	mutex_lock(&(pool->lock));
-	pool_set_status(pool, item, PL_AVAILABLE);
-	mutex_unlock(&(pool->lock));
+	pool_return(pool, item);
 	sem_post(&(pool->available));
 }
 
@@ -292,7 +405,6 @@ void * pool_set_obj(pool_t *pool, uint32_t item, void *object) {
  */
 void * pool_swap_obj(pool_t *pool, uint32_t item, void *object) {
 
-	bool_t loop = true;
 	void *current = NULL;
 	struct timespec delay;
 
@@ -303,22 +415,16 @@ void * pool_swap_obj(pool_t *pool, uint32_t item, void *object) {
 	delay.tv_sec = 0;
 	delay.tv_nsec = 10000000;
 
-	do {
-		mutex_lock(&(pool->lock));
-		if (pool_get_status(pool, item) == PL_AVAILABLE) {
-			current = pool_get_obj(pool, item);
-			pool_set_obj(pool, item, object);
-			loop = false;
-		}
-		mutex_unlock(&(pool->lock));
-
-		/// LOW: Currently the function loops until the requested object is available. A superior implementation would hook into the release function and detect when
-		/// the desired object is available and perform the swap at that point.
-		if (loop) {
-			nanosleep(&delay, NULL);
-		}
+	/// LOW: Currently the function loops until the requested object is available. A superior implementation would hook into the release function and detect when
+	/// the desired object is available and perform the swap at that point.
+	while (!pool_claim(pool, item)) {
+		nanosleep(&delay, NULL);
+	}
 
-	} while (loop);
+	// The item is reserved without taking a semaphore slot, so it goes straight back once the object has been replaced.
+	current = pool_get_obj(pool, item);
+	pool_set_obj(pool, item, object);
+	pool_return(pool, item);
 
 	return current;
 }
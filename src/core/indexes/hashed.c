@@ -3,191 +3,227 @@
  * @file /magma/core/indexes/hashed.c
  *
  * @brief	Function declarations and types for the hashed list.
+ * @note	The bucket array always holds a power of two number of chains, and is doubled whenever the number of records exceeds three
+ * 			quarters of the bucket count, so lookups stay constant time no matter how large the index grows. Indexes that use automatic
+ * 			locking are concurrent: records are found, inserted and deleted while holding the shared index lock, with each chain
+ * 			protected by one of a fixed set of striped mutexes, and the exclusive lock is only taken to resize, replace or truncate.
  */
 
 #include "../core.h"
 
-#define MAGMA_HASHED_BUCKETS 1024
+#define MAGMA_HASHED_BUCKETS 64
+#define MAGMA_HASHED_STRIPES 16
 
 // Hashed lists.
-typedef struct __attribute__ ((packed)) {
+typedef struct hashed_bucket_t {
 	void *data;
 	multi_t key;
+	uint64_t hash; /* The full hash of the key, kept so chains can be compared and redistributed without rehashing. */
 	struct hashed_bucket_t *next;
 } hashed_bucket_t;
 
-typedef struct __attribute__ ((packed)) {
+typedef struct {
 	inx_t *inx;
-	hashed_bucket_t *bucket;
-	uint64_t serial, slot, count;
+	uint64_t slot; /* The bucket holding the active record. */
+	uint64_t position; /* The position of the active record inside its chain, counting from one; zero means no record is active yet. */
 } hashed_cursor_t;
 
-typedef struct __attribute__ ((packed)) {
-	uint32_t buckets;
+typedef struct {
+	uint64_t mask; /* The number of buckets minus one. */
+	uint64_t limit; /* The record count which triggers the next resize. */
+	hashed_bucket_t **buckets;
+	pthread_mutex_t *stripes; /* The chain locks, only allocated for indexes using automatic locking. */
 } hashed_index_t;
 
-// TODO: Finish implementing the hashed iterators.
-// TODO: Respect dupe/lock flags.
-// TODO: Move locking calls to the inx functions.
-
 /**
- * @brief	Get the hash bucket for a key.
- * @note	If the key is passed as a string, it will be mapped to a bucket using the Fletcher32 hash.
- * @param	buckets		the total number of buckets for grouping items.
- * @param	key			a multi-type key with the value to be looked up; numbers and strings are supported.
- * @return	the number of the hash bucket corresponding to the specified key.
+ * @brief	Calculate the hash value for a key.
+ * @note	Strings are hashed using murmur, while numbers are run through the murmur finalizer so sequential values are spread
+ * 			across the table.
+ * @param	key		a multi-type key with the value to be hashed; numbers and strings are supported.
+ * @return	the 64-bit hash value of the key.
  */
-uint32_t hashed_bucket(uint32_t buckets, multi_t key) {
+uint64_t hashed_hash(multi_t key) {
 
-	uint32_t result = 0, count;
+	uint64_t result;
 
 	if (mt_is_number(key)) {
-		if ((result = mt_get_number(key)) < buckets) {
-
-			// If my math is right, the bit count should never exceed the value of result. That also means the expression should never return a negative number.
-			mclog_check((count = bitwise_count(result)) > result);
-
-			result = (((count = bitwise_count(result)) % 2) ? result + count : result - count);
-			result = (buckets <= result ? (buckets - 1) : result);
-		}
-		else {
-			result = (result % buckets);
-		}
+		result = mt_get_number(key);
+		result ^= result >> 33;
+		result *= 0xff51afd7ed558ccdULL;
+		result ^= result >> 33;
+		result *= 0xc4ceb9fe1a85ec53ULL;
+		result ^= result >> 33;
 	}
 	else {
-		result = hash_fletcher32(mt_get_char(&key), mt_get_length(key)) % buckets;
+		result = hash_murmur64(mt_get_char(&key), mt_get_length(key));
 	}
 
 	return result;
 }
 
+/**
+ * @brief	Lock the chain stored in a bucket.
+ * @note	Only concurrent indexes have chain locks; for everything else the index lock is sufficient and this function does nothing.
+ * @param	hashed	the hash table holding the bucket.
+ * @param	slot	the bucket number.
+ * @return	This function returns no value.
+ */
+void hashed_lock(hashed_index_t *hashed, uint64_t slot) {
+
+	if (hashed->stripes) {
+		mutex_lock(&(hashed->stripes[slot & (MAGMA_HASHED_STRIPES - 1)]));
+	}
+
+	return;
+}
+
+/**
+ * @brief	Unlock the chain stored in a bucket.
+ * @param	hashed	the hash table holding the bucket.
+ * @param	slot	the bucket number.
+ * @return	This function returns no value.
+ */
+void hashed_unlock(hashed_index_t *hashed, uint64_t slot) {
+
+	if (hashed->stripes) {
+		mutex_unlock(&(hashed->stripes[slot & (MAGMA_HASHED_STRIPES - 1)]));
+	}
+
+	return;
+}
+
 /**
  * @brief	Allocate and initialize hashed bucket object.
  * @param	key		a multi-type key that will be hashed on lookup.
+ * @param	hash	the hash value of the key.
  * @param	data	a pointer to a data buffer associated with the key.
  * @return	NULL on failure, or a pointer to the newly allocated hashed bucket object on success.
  */
-hashed_bucket_t * hashed_bucket_alloc(multi_t key, void *data) {
+hashed_bucket_t * hashed_bucket_alloc(multi_t key, uint64_t hash, void *data) {
 
 	hashed_bucket_t *bucket;
 
-	if ((bucket = mm_alloc(sizeof(hashed_bucket_t))) == NULL) {
-		//lavalog(LOG_DEBUG, LOG_FRAMEWORK, "Unable to allocate %i bytes for a hash bucket.", sizeof(hashed_bucket_t));
+	if (!(bucket = mm_alloc(sizeof(hashed_bucket_t)))) {
+		mclog_pedantic("Failed to allocate %zu bytes for a hash bucket.", sizeof(hashed_bucket_t));
 		return NULL;
 	}
 
 	bucket->key = mt_dupe(key);
+	bucket->hash = hash;
 	bucket->data = data;
 	return bucket;
 }
 
-// Gets the bucket from the list.
-hashed_bucket_t * hashed_bucket_get_ptr(hashed_index_t *hashed, uint32_t num) {
-
-	hashed_bucket_t *result = NULL;
-
-	if (num < hashed->buckets) {
-		result = *(hashed_bucket_t **)((chr_t *)hashed + sizeof(hashed_index_t) + (sizeof(hashed_bucket_t *) * num));
-	}
+/**
+ * @brief	Free a hashed bucket object, and the data it holds.
+ * @param	index	the index which owns the bucket.
+ * @param	bucket	the bucket to be freed.
+ * @return	This function returns no value.
+ */
+void hashed_bucket_free(inx_t *index, hashed_bucket_t *bucket) {
 
-#ifdef MAGMA_PEDANTIC
-	else {
-		mclog_pedantic("Invalid hash bucket requested.");
+	if (bucket->data && index->data_free) {
+		index->data_free(bucket->data);
 	}
-#endif
 
-	return result;
+	mt_free(bucket->key);
+	mm_free(bucket);
+	return;
 }
 
-// Sets the bucket on the list.
-void hashed_bucket_set_ptr(hashed_index_t *hashed, uint32_t num, hashed_bucket_t *bucket) {
+/**
+ * @brief	Double the number of buckets used by a hash table, and redistribute the existing records.
+ * @note	The caller must have exclusive access to the index. If the larger bucket array can't be allocated, the table is left
+ * 			untouched, and will simply have longer chains.
+ * @param	inx		the index to be resized.
+ * @return	This function returns no value.
+ */
+void hashed_resize(void *inx) {
 
-	if (num < hashed->buckets) {
-		*(hashed_bucket_t **)((chr_t *)hashed + sizeof(hashed_index_t) + (sizeof(hashed_bucket_t *) * num)) = bucket;
-	}
+	uint64_t mask;
+	inx_t *index = inx;
+	hashed_index_t *hashed;
+	hashed_bucket_t **buckets, *bucket, *holder;
 
-#ifdef MAGMA_PEDANTIC
-	else {
-		mclog_pedantic("Invalid hash bucket requested.");
+	if (!index || !(hashed = index->index)) {
+		return;
 	}
-#endif
 
-	return;
-}
+	index->resize = 0;
 
-// Tacks on a bucket at the end.
-void hashed_bucket_add(hashed_bucket_t *bucket, hashed_bucket_t *new) {
+	if (index->count <= hashed->limit) {
+		return;
+	}
 
-	if (bucket == NULL) {
-		//lavalog(LOG_DEBUG, LOG_FRAMEWORK, "Passed a NULL pointer.");
+	mask = (hashed->mask << 1) | 1;
+
+	if (!(buckets = mm_alloc(sizeof(hashed_bucket_t *) * (mask + 1)))) {
+		mclog_pedantic("Failed to allocate %zu bytes for a larger hash table.", sizeof(hashed_bucket_t *) * (mask + 1));
 		return;
 	}
 
-	// Find the end.
-	while (bucket->next != NULL) {
-		bucket = (hashed_bucket_t *)bucket->next;
+	for (uint64_t slot = 0; slot <= hashed->mask; slot++) {
+		for (bucket = hashed->buckets[slot]; bucket; bucket = holder) {
+			holder = bucket->next;
+			bucket->next = buckets[bucket->hash & mask];
+			buckets[bucket->hash & mask] = bucket;
+		}
 	}
 
-	bucket->next = (struct hashed_bucket_t *)new;
+	mm_free(hashed->buckets);
+	hashed->buckets = buckets;
+	hashed->mask = mask;
+	hashed->limit = ((mask + 1) / 4) * 3;
+
 	return;
 }
 
 // Add a data item to the list.
 bool_t hashed_insert(void *inx, multi_t key, void *data) {
 
-	uint32_t num;
+	uint64_t hash, slot;
 	inx_t *index = inx;
 	hashed_index_t *hashed;
-	hashed_bucket_t *bucket, *holder;
+	hashed_bucket_t *holder;
 
 	if (index == NULL || index->index == NULL) {
 		return false;
 	}
 
 	hashed = index->index;
+	hash = hashed_hash(key);
 
 	// Create the new bucket.
-	if ((holder = hashed_bucket_alloc(key, data)) == NULL) {
+	if ((holder = hashed_bucket_alloc(key, hash, data)) == NULL) {
 		return false;
 	}
 
-	// Figure out the bucket number.
-	num = hashed_bucket(hashed->buckets, key);
+	slot = hash & hashed->mask;
 
-	// Get the bucket.
-	bucket = hashed_bucket_get_ptr(hashed, num);
+	// New records go at the front of the chain, so the insert doesn't depend on the chain length.
+	hashed_lock(hashed, slot);
+	holder->next = hashed->buckets[slot];
+	hashed->buckets[slot] = holder;
+	hashed_unlock(hashed, slot);
 
-	// We need to create a bucket.
-	if (bucket == NULL) {
-		hashed_bucket_set_ptr(hashed, num, holder);
-	} else {
-		hashed_bucket_add(bucket, holder);
-	}
-
-	index->count++;
-	index->serial++;
-	return true;
-}
-
-// Searches a bucket list for the key.
-void * hashed_bucket_find_key(hashed_bucket_t *bucket, multi_t key) {
-
-	void *data = NULL;
-
-	while (bucket != NULL && data == NULL) {
-		if (ident_mt_mt(bucket->key, key) == true) {
-			data = bucket->data;
+	// Concurrent indexes can't be resized while the shared lock is held, so they flag the index and let inx_insert() handle it.
+	if (__atomic_add_fetch(&(index->count), 1, __ATOMIC_RELAXED) > hashed->limit) {
+		if (hashed->stripes) {
+			__atomic_store_n(&(index->resize), 1, __ATOMIC_RELAXED);
+		}
+		else {
+			hashed_resize(index);
 		}
-		bucket = (hashed_bucket_t *)bucket->next;
 	}
 
-	return data;
+	__atomic_add_fetch(&(index->serial), 1, __ATOMIC_RELAXED);
+	return true;
 }
 
 // Gets a data item, or returns NULL.
 void * hashed_find(void *inx, multi_t key) {
 
-	uint32_t num;
+	uint64_t hash, slot;
 	void *data = NULL;
 	inx_t *index = inx;
 	hashed_index_t *hashed;
@@ -198,197 +234,144 @@ void * hashed_find(void *inx, multi_t key) {
 	}
 
 	hashed = index->index;
+	hash = hashed_hash(key);
+	slot = hash & hashed->mask;
 
-	// Figure out the bucket number.
-	num = hashed_bucket(hashed->buckets, key);
-
-	// Get the bucket.
-	bucket = hashed_bucket_get_ptr(hashed, num);
+	hashed_lock(hashed, slot);
 
-	// We need to search the bucket for the key.
-	if (bucket != NULL) {
-		data = hashed_bucket_find_key(bucket, key);
+	for (bucket = hashed->buckets[slot]; bucket && !data; bucket = bucket->next) {
+		if (bucket->hash == hash && ident_mt_mt(bucket->key, key)) {
+			data = bucket->data;
+		}
 	}
 
+	hashed_unlock(hashed, slot);
+
 	return data;
 }
 
 bool_t hashed_delete(void *inx, multi_t key) {
 
-	uint32_t num;
+	uint64_t hash, slot;
 	inx_t *index = inx;
-	bool_t found = false;
 	hashed_index_t *hashed;
-	hashed_bucket_t *bucket, *holder = NULL;
+	hashed_bucket_t **link, *bucket = NULL;
 
 	if (index == NULL || index->index == NULL) {
 		return false;
 	}
 
 	hashed = index->index;
+	hash = hashed_hash(key);
+	slot = hash & hashed->mask;
 
-	// Figure out the bucket number.
-	num = hashed_bucket(hashed->buckets, key);
-
-	// Get the bucket.
-	bucket = hashed_bucket_get_ptr(hashed, num);
-
-	// There is only one bucket.
-	while (bucket && !found) {
+	hashed_lock(hashed, slot);
 
-		// This is the bucket to free.
-		if ((found = ident_mt_mt(bucket->key, key)) == true) {
+	for (link = &(hashed->buckets[slot]); *link; link = &((*link)->next)) {
 
-			// Its the first bucket.
-			if (holder == NULL) {
-				hashed_bucket_set_ptr(hashed, num, (hashed_bucket_t *)bucket->next);
-			}
-			// Takes this bucket out of the list.
-			else {
-				holder->next = (struct hashed_bucket_t *)bucket->next;
-			}
-
-			if (bucket->data && index->data_free) {
-				index->data_free(bucket->data);
-			}
-
-			mt_free(bucket->key);
-			mm_free(bucket);
-
-		} else {
-			holder = bucket;
-			bucket = (hashed_bucket_t *)bucket->next;
+		// Take the bucket out of the chain.
+		if ((*link)->hash == hash && ident_mt_mt((*link)->key, key)) {
+			bucket = *link;
+			*link = bucket->next;
+			break;
 		}
 	}
 
-	if (found) {
-		index->count--;
-		index->serial++;
+	hashed_unlock(hashed, slot);
+
+	if (!bucket) {
+		return false;
 	}
 
-	return found;
+	// The data is freed outside the chain lock.
+	hashed_bucket_free(index, bucket);
+
+	__atomic_sub_fetch(&(index->count), 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&(index->serial), 1, __ATOMIC_RELAXED);
+	return true;
 }
 
-/// BUG: It's a little unclear what's happening, but when this function gets called, the serials don't match, and the count is greater than the number of available
-/// data buckets, because a bucket has been removed, the cursor will get stuck returning the last item endlessly (I think).
-hashed_bucket_t * hashed_cursor_active(hashed_cursor_t *cursor) {
+/**
+ * @brief	Locate the record a cursor points to, or advance the cursor to the following record.
+ * @note	The cursor only tracks a bucket number and a position inside the chain, so it never holds a pointer to a record which
+ * 			may be deleted between calls. If records are added or removed while iterating, records may be skipped or repeated. The
+ * 			key is copied while the chain is locked, but string keys still point at the memory held by the index.
+ * @param	cursor	the cursor.
+ * @param	advance	if true, the cursor is moved to the next record, otherwise the active record is returned.
+ * @param	key		if not NULL, receives the key of the record.
+ * @return	NULL if there is no record, or the data associated with the record.
+ */
+void * hashed_cursor_locate(hashed_cursor_t *cursor, bool_t advance, multi_t *key) {
 
-	uint64_t count = 0;
-	hashed_bucket_t *bucket = NULL, *loop;
+	void *data = NULL;
+	hashed_bucket_t *bucket = NULL;
+	hashed_index_t *hashed = cursor->inx->index;
+	uint64_t position = cursor->position + (advance ? 1 : 0);
 
-	// If the serial numbers match, return the bucket pointer.
-	if (cursor->serial == cursor->inx->serial) {
-		bucket = (hashed_bucket_t *)cursor->bucket;
+	if (key) {
+		*key = mt_get_null();
 	}
 
-	// Otherwise pull the bucket pointer and count off the items till we have a match.
-	if (!bucket && cursor->slot < ((hashed_index_t *)cursor->inx->index)->buckets) {
-
-		if ((loop = hashed_bucket_get_ptr(cursor->inx->index, cursor->slot))) {
-
-			count++;
+	while (position && !bucket && cursor->slot <= hashed->mask) {
 
-			// Advance to the active node.
-			while (loop && count != cursor->count) {
-				loop = (hashed_bucket_t *)loop->next;
-				count++;
-			}
-
-			if (loop && count == cursor->count) {
-				cursor->bucket = bucket = loop;
-				cursor->count = 1;
-			}
-		}
-	}
+		hashed_lock(hashed, cursor->slot);
 
-	// The bucket above didn't contain enough items to satisfy the counter, so all we need to do is look for the next slot with a valid entry.
-	if (!bucket && cursor->slot < ((hashed_index_t *)cursor->inx->index)->buckets) {
-		for (count = cursor->slot; !bucket && count < ((hashed_index_t *)cursor->inx->index)->buckets; count++) {
-			bucket = hashed_bucket_get_ptr(cursor->inx->index, count);
+		for (bucket = hashed->buckets[cursor->slot]; bucket && position > 1; position--) {
+			bucket = bucket->next;
 		}
 
 		if (bucket) {
-			cursor->count = 1;
-			cursor->slot = count - 1;
-			cursor->bucket = bucket;
-			cursor->serial = cursor->inx->serial;
+			data = bucket->data;
+			if (key) *key = bucket->key;
 		}
 
-	}
-
-	return bucket;
-}
+		hashed_unlock(hashed, cursor->slot);
 
-hashed_bucket_t * hashed_cursor_next(hashed_cursor_t *cursor) {
-
-	hashed_bucket_t *bucket = NULL;
-
-	// If the serials match up, see if the bucket pointer will lead us to the next entry.
-	if (cursor->serial == cursor->inx->serial && cursor->bucket && (bucket = (hashed_bucket_t *)(cursor->bucket->next))) {
-		cursor->count++;
-		cursor->bucket = bucket;
-	}
-	// Otherwise if the serials match, advance the slot number.
-	else if (!bucket && cursor->serial == cursor->inx->serial) {
-		cursor->slot++;
-		cursor->count = 0;
-		cursor->bucket = NULL;
-		bucket = hashed_cursor_active(cursor);
-	}
-	// The serials don't match so we'll be counting out the items in the current bucket. So we just need to increase our counter.
-	else if (cursor->slot < ((hashed_index_t *)cursor->inx->index)->buckets){
-		bucket = hashed_cursor_active(cursor);
+		// Move on to the next bucket.
+		if (!bucket && advance) {
+			position = 1;
+			cursor->slot++;
+			cursor->position = 0;
+		}
+		else if (!bucket) {
+			break;
+		}
+		else {
+			cursor->position += (advance ? 1 : 0);
+		}
 	}
 
-	return bucket;
+	return data;
 }
 
 void * hashed_cursor_value_next(hashed_cursor_t *cursor) {
-
-	hashed_bucket_t *bucket;
-
-	if ((bucket = hashed_cursor_next(cursor))) {
-		return bucket->data;
-	}
-	return NULL;
-
+	return hashed_cursor_locate(cursor, true, NULL);
 }
 
 void * hashed_cursor_value_active(hashed_cursor_t *cursor) {
-
-	hashed_bucket_t *bucket;
-
-	if ((bucket = hashed_cursor_active(cursor))) {
-		return bucket->data;
-	}
-	return NULL;
+	return hashed_cursor_locate(cursor, false, NULL);
 }
 
 multi_t hashed_cursor_key_next(hashed_cursor_t *cursor) {
 
-	hashed_bucket_t *bucket;
+	multi_t key;
 
-	if ((bucket = hashed_cursor_next(cursor))) {
-		return bucket->key;
-	}
-	return mt_get_null();
+	hashed_cursor_locate(cursor, true, &key);
+	return key;
 }
 
 multi_t hashed_cursor_key_active(hashed_cursor_t *cursor) {
 
-	hashed_bucket_t *bucket;
+	multi_t key;
 
-	if ((bucket = hashed_cursor_active(cursor))) {
-		return bucket->key;
-	}
-	return mt_get_null();
+	hashed_cursor_locate(cursor, false, &key);
+	return key;
 }
 
 void hashed_cursor_reset(hashed_cursor_t *cursor) {
 
 	if (cursor) {
-		cursor->bucket = NULL;
-		cursor->serial = cursor->count = cursor->slot = 0;
+		cursor->slot = cursor->position = 0;
 	}
 
 	return;
@@ -417,9 +400,8 @@ void * hashed_cursor_alloc(inx_t *inx) {
 	return cursor;
 }
 
-void hashed_free(void *inx) {
+void hashed_truncate(void *inx) {
 
-	uint32_t num;
 	inx_t *index = inx;
 	hashed_index_t *hashed;
 	hashed_bucket_t *bucket, *holder;
@@ -430,89 +412,95 @@ void hashed_free(void *inx) {
 
 	hashed = index->index;
 
-	for (num = 0; num < hashed->buckets; num++) {
-
-		bucket = hashed_bucket_get_ptr(hashed, num);
-		while (bucket) {
-			holder = bucket;
-			bucket = (hashed_bucket_t *)holder->next;
-			if (holder->data && index->data_free) {
-				index->data_free(holder->data);
-			}
-			mt_free(holder->key);
-			mm_free(holder);
+	for (uint64_t slot = 0; slot <= hashed->mask; slot++) {
+		for (bucket = hashed->buckets[slot]; bucket; bucket = holder) {
+			holder = bucket->next;
+			hashed_bucket_free(index, bucket);
 		}
-
+		hashed->buckets[slot] = NULL;
 	}
 
-	mm_free(index->index);
-	index->index = NULL;
+	index->count = 0;
+	index->resize = 0;
+	index->serial++;
+
 	return;
 }
 
-void hashed_truncate(void *inx) {
+void hashed_free(void *inx) {
 
-	uint32_t num;
 	inx_t *index = inx;
 	hashed_index_t *hashed;
-	hashed_bucket_t *bucket, *holder;
 
-	if (index == NULL || index->index == NULL) {
+	if (index == NULL || (hashed = index->index) == NULL) {
 		return;
 	}
 
-	hashed = index->index;
+	hashed_truncate(index);
 
-	for (num = 0; num < hashed->buckets; num++) {
-		if ((bucket = hashed_bucket_get_ptr(hashed, num))) {
-			while (bucket) {
-				holder = bucket;
-				bucket = (hashed_bucket_t *)holder->next;
-				if (holder->data && index->data_free) {
-					index->data_free(holder->data);
-				}
-				mt_free(holder->key);
-				mm_free(holder);
-			}
-			hashed_bucket_set_ptr(hashed, num, NULL);
-		}
+	for (uint64_t i = 0; hashed->stripes && i < MAGMA_HASHED_STRIPES; i++) {
+		mutex_destroy(&(hashed->stripes[i]));
 	}
 
-	index->count = 0;
-	index->serial++;
-
+	mm_cleanup(hashed->stripes, hashed->buckets);
+	mm_free(hashed);
+	index->index = NULL;
 	return;
 }
 
 /**
  * @brief	Allocate a new hash table.
+ * @note	Unless the M_INX_LOCK_MANUAL option is provided, the table is allocated with striped chain locks, and the index is flagged
+ * 			as concurrent so inserts, deletes and lookups only acquire the shared index lock.
  * @param	options		an options value for the hash table.
- * @param	data_free	a pointer to a function
- *
- *
- *
+ * @param	data_free	a pointer to a function used to free the data associated with each record.
  * @return	NULL on failure, or a pointer to the newly allocated hash table object on success.
  */
 inx_t * hashed_alloc(uint64_t options, void *data_free) {
 
 	inx_t *result;
+	hashed_index_t *hashed;
 
-	if ((result = mm_alloc(sizeof(inx_t))) == NULL) {
+	if (!(result = mm_alloc(sizeof(inx_t)))) {
 		return NULL;
 	}
-	else if (!(result->index = mm_alloc(sizeof(hashed_index_t) + (sizeof(hashed_bucket_t *) * MAGMA_HASHED_BUCKETS)))) {
-		mm_free(result);
+	else if (!(result->index = hashed = mm_alloc(sizeof(hashed_index_t))) ||
+		!(hashed->buckets = mm_alloc(sizeof(hashed_bucket_t *) * MAGMA_HASHED_BUCKETS))) {
+		mm_cleanup(hashed, result);
 		return NULL;
 	}
 
+	hashed->mask = MAGMA_HASHED_BUCKETS - 1;
+	hashed->limit = (MAGMA_HASHED_BUCKETS / 4) * 3;
+
+	if (!(options & M_INX_LOCK_MANUAL)) {
+
+		if (!(hashed->stripes = mm_alloc(sizeof(pthread_mutex_t) * MAGMA_HASHED_STRIPES))) {
+			mm_cleanup(hashed->buckets, hashed, result);
+			return NULL;
+		}
+
+		for (uint64_t i = 0; i < MAGMA_HASHED_STRIPES; i++) {
+			if (mutex_init(&(hashed->stripes[i]), NULL)) {
+				for (uint64_t j = 0; j < i; j++) {
+					mutex_destroy(&(hashed->stripes[j]));
+				}
+				mm_cleanup(hashed->stripes, hashed->buckets, hashed, result);
+				return NULL;
+			}
+		}
+
+		result->concurrent = 1;
+	}
+
 	// The last variable is only applicable to linked lists.
 	result->last = NULL;
 
 	result->options = options;
 	result->data_free = data_free;
 	result->index_free = hashed_free;
+	result->index_resize = hashed_resize;
 	result->index_truncate = hashed_truncate;
-	((hashed_index_t *)(result->index))->buckets = MAGMA_HASHED_BUCKETS;
 
 	result->find = hashed_find;
 	result->append = hashed_insert;
@@ -38,9 +38,13 @@ typedef struct {
 	pthread_rwlock_t lock;
 	uint64_t count, serial, automatic, options, references;
 
+	// Concurrent indexes modify records while holding the shared lock, and raise the resize flag when they need the exclusive lock.
+	uint64_t concurrent, resize;
+
 	// Index function pointers.
 	void (*data_free)(void *data);
 	void (*index_free)(void *index);
+	void (*index_resize)(void *index);
 	void (*index_truncate)(void *index);
 
 	bool_t (*delete)(void *index, multi_t envelope);
@@ -78,7 +82,9 @@ typedef inx_t *(*inx_allocator)(uint64_t options, void *data_free);
 /// inx.c
 inx_t *    inx_alloc(uint64_t options, void *data_free);
 bool_t     inx_append(inx_t *inx, multi_t key, void *data);
+void       inx_auto_modify(inx_t *inx);
 void       inx_auto_read(inx_t *inx);
+void       inx_auto_resize(inx_t *inx);
 void       inx_auto_unlock(inx_t *inx);
 void       inx_auto_write(inx_t *inx);
 void       inx_cleanup(inx_t *inx);
@@ -7,7 +7,7 @@
 
 #include "../core.h"
 
-static inx_allocator tree_allocator = NULL;
+static inx_allocator tree_allocator = NULL, linked_allocator = &linked_alloc, hashed_allocator = &hashed_alloc;
 
 /**
  * @brief	Unlock an inx object.
@@ -66,6 +66,38 @@ void inx_auto_write(inx_t *inx) {
 	return;
 }
 
+/**
+ * @brief	Acquire the lock needed to insert or delete a single record.
+ * @note	Concurrent indexes protect their records internally, so only a reader's lock is needed; everything else gets a writer's lock.
+ * @param	inx		a pointer to the inx object to be locked.
+ * @return	This function returns no value.
+ */
+void inx_auto_modify(inx_t *inx) {
+	if (inx->automatic && inx->concurrent) {
+		rwlock_lock_read(&(inx->lock));
+	}
+	else if (inx->automatic) {
+		rwlock_lock_write(&(inx->lock));
+	}
+	return;
+}
+
+/**
+ * @brief	Resize a concurrent index which flagged itself as needing more room during an insert.
+ * @note	The resize flag is checked again by the index after the writer's lock is acquired, since another thread may have
+ * 			already done the work.
+ * @param	inx		a pointer to the inx object to be resized.
+ * @return	This function returns no value.
+ */
+void inx_auto_resize(inx_t *inx) {
+	if (inx->automatic && inx->index_resize && __atomic_load_n(&(inx->resize), __ATOMIC_RELAXED)) {
+		rwlock_lock_write(&(inx->lock));
+		inx->index_resize(inx);
+		rwlock_unlock(&(inx->lock));
+	}
+	return;
+}
+
 /**
  * @brief	Return the options value of an inx object.
  * @param	inx		a pointer to the inx object to be examined.
@@ -150,9 +182,10 @@ bool_t inx_append(inx_t *inx, multi_t key, void *data) {
 	}
 #endif
 
-	inx_auto_write(inx);
+	inx_auto_modify(inx);
 	result = inx->append(inx, key, data);
 	inx_auto_unlock(inx);
+	inx_auto_resize(inx);
 
 	return result;
 }
@@ -175,9 +208,10 @@ bool_t inx_insert(inx_t *inx, multi_t key, void *data) {
 	}
 #endif
 
-	inx_auto_write(inx);
+	inx_auto_modify(inx);
 	result = inx->insert(inx, key, data);
 	inx_auto_unlock(inx);
+	inx_auto_resize(inx);
 
 	return result;
 }
@@ -206,6 +240,7 @@ bool_t inx_replace(inx_t *inx, multi_t key, void *data) {
 	// Insert the new record.
 	result = inx->insert(inx, key, data);
 	inx_auto_unlock(inx);
+	inx_auto_resize(inx);
 
 	return result;
 
@@ -228,7 +263,7 @@ bool_t inx_delete(inx_t *inx, multi_t key) {
 	}
 #endif
 
-	inx_auto_write(inx);
+	inx_auto_modify(inx);
 	result = inx->delete(inx, key);
 	inx_auto_unlock(inx);
 
@@ -328,10 +363,12 @@ inx_t * inx_alloc(uint64_t options, void *data_free) {
 			inx = tree_allocator(options, data_free);
 		break;
 	case M_INX_LINKED:
-		inx = linked_alloc(options, data_free);
+		if(linked_allocator)
+			inx = linked_allocator(options, data_free);
 		break;
 	case M_INX_HASHED:
-		inx = hashed_alloc(options, data_free);
+		if(hashed_allocator)
+			inx = hashed_allocator(options, data_free);
 		break;
 	default:
 		mclog_options(M_LOG_ERROR | M_LOG_STACK_TRACE, "Unsupported index type detected. {type = %lu}", options & MAGMA_INDEX_TYPE);
@@ -349,15 +386,28 @@ inx_t * inx_alloc(uint64_t options, void *data_free) {
 
 /**
  * @brief	Register a new inx type allocator callback.
- * @param	options	 	a value indicating the inx type. Can be M_INX_TREE only.
+ * @note	The linked and hashed types default to the allocators provided by the core, and may be overridden; the tree type has no
+ * 			default, and must be registered by the provider implementing it.
+ * @param	options	 	a value indicating the inx type. Can be M_INX_TREE, M_INX_LINKED or M_INX_HASHED.
+ * @param	allocator	the function used to allocate indexes of the given type.
 * @return	false on failure or true on success.
  */
 bool_t inx_register_allocator(uint64_t options, inx_allocator allocator)
 {
-	if (M_INX_TREE != (options & MAGMA_INDEX_TYPE))
+	switch (options & MAGMA_INDEX_TYPE) {
+	case M_INX_TREE:
+		tree_allocator = allocator;
+		break;
+	case M_INX_LINKED:
+		linked_allocator = allocator;
+		break;
+	case M_INX_HASHED:
+		hashed_allocator = allocator;
+		break;
+	default:
 		return false;
+	}
 
-	tree_allocator = allocator;
 	return true;
 }
 
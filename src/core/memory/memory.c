@@ -7,6 +7,12 @@
 
 #include "../core.h"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 /**
  * @brief	A checked cleanup function which can be used free a variable number memory buffers.
  * @see		mm_free
@@ -73,6 +79,55 @@ void * mm_move(void *dst, void *src, size_t len) {
 	return memmove(dst, src, len);
 }
 
+/**
+ * @brief	Count the number of bytes at the start of a buffer which aren't a carriage return or line feed.
+ * @note	The buffer is scanned 32 or 16 bytes at a time when AVX2 or SSE2 support is available at compile time, with a byte by byte
+ * 			scan handling whatever is left over.
+ * @param	block	a pointer to the buffer to be scanned.
+ * @param	len		the length, in bytes, of the buffer.
+ * @param	ascii	if true, the span also ends at the first byte outside of the 7-bit ASCII range.
+ * @return	the length of the span, which will equal len if none of the bytes end the span.
+ */
+size_t mm_span_text(const void *block, size_t len, bool_t ascii) {
+
+	size_t i = 0;
+	const uchr_t *data = block;
+
+#if defined(__AVX2__)
+	uint32_t wide;
+	__m256i chunk, cr = _mm256_set1_epi8('\r'), lf = _mm256_set1_epi8('\n');
+
+	for (; i + 32 <= len; i += 32) {
+		chunk = _mm256_loadu_si256((const __m256i *)(data + i));
+		wide = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, cr), _mm256_cmpeq_epi8(chunk, lf)));
+
+		// The movemask of the data itself collects the high bit of every byte.
+		if (ascii) wide |= _mm256_movemask_epi8(chunk);
+		if (wide) return i + __builtin_ctz(wide);
+	}
+#elif defined(__SSE2__)
+	uint32_t mask;
+	__m128i chunk, cr = _mm_set1_epi8('\r'), lf = _mm_set1_epi8('\n');
+
+	for (; i + 16 <= len; i += 16) {
+		chunk = _mm_loadu_si128((const __m128i *)(data + i));
+		mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, cr), _mm_cmpeq_epi8(chunk, lf)));
+
+		// The movemask of the data itself collects the high bit of every byte.
+		if (ascii) mask |= _mm_movemask_epi8(chunk);
+		if (mask) return i + __builtin_ctz(mask);
+	}
+#endif
+
+	for (; i < len; i++) {
+		if (data[i] == '\r' || data[i] == '\n' || (ascii && data[i] >= 0x80)) {
+			return i;
+		}
+	}
+
+	return len;
+}
+
 /**
  * @brief	Sets a block of memory to a specified value.
  * @note Uses the 'optimize (0)' and 'noinline' function attributes to prevent compiler optimization from removing logic it might consider unnecessary.
@@ -16,6 +16,7 @@ typedef struct {
 
 /// time.c
 uint64_t      time_datestamp(void);
+uint64_t      time_microseconds(void);
 stringer_t *  time_print_gmt(stringer_t *s, chr_t *format, time_t moment);
 stringer_t *  time_print_local(stringer_t *s, chr_t *format, time_t moment);
 uint64_t      time_till_midnight(void);
@@ -51,6 +51,21 @@ uint64_t time_datestamp(void) {
 	return result;
 }
 
+/**
+ * @brief	Get the value of the monotonic clock in microseconds, for use when measuring elapsed time.
+ * @return	0 on failure, or the number of microseconds since an unspecified starting point.
+ */
+uint64_t time_microseconds(void) {
+
+	struct timespec now;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &now)) {
+		return 0;
+	}
+
+	return ((uint64_t)now.tv_sec * 1000000) + ((uint64_t)now.tv_nsec / 1000);
+}
+
 /**
  * @brief	Get a specified time as a formatted string.
  * @param	s	a managed string where the formatted time is to be stored.
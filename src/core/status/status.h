@@ -8,6 +8,16 @@
 #ifndef MAGMA_CORE_STATUS_H
 #define MAGMA_CORE_STATUS_H
 
+// The number of independent copies of each counter. Threads are spread across the shards, and the shards are summed when a value is read.
+#define MAGMA_STATS_SHARDS 16
+
+// The number of slots in the statistic name lookup table. Must be a power of two larger than the number of statistics.
+#define MAGMA_STATS_SLOTS 256
+
+// The maximum number of histograms, and the number of power of two buckets in each histogram.
+#define MAGMA_STATS_HISTOGRAMS 8
+#define MAGMA_STATS_BUCKETS 40
+
 /************  BUILD  ************/
 const char * build_stamp(void);
 const char * build_commit(void);
@@ -37,6 +47,7 @@ void stats_shutdown(void);
 
 uint64_t stats_get_count(void);
 char * stats_get_name(uint64_t position);
+uint64_t stats_get_name_pos(char *name);
 
 uint64_t stats_get_value_by_name(char *name);
 uint64_t stats_get_value_by_num(uint64_t position);
@@ -52,6 +63,14 @@ void stats_set_by_num(uint64_t position, uint64_t value);
 
 void stats_adjust_by_name(char *name, int32_t value);
 void stats_adjust_by_num(uint64_t position, int32_t value);
+
+uint64_t stats_histogram_count(void);
+char * stats_histogram_name(uint64_t position);
+uint64_t stats_histogram_percentile(int64_t position, uint_t percentile);
+int64_t stats_histogram_pos(char *name);
+void stats_histogram_record(int64_t position, uint64_t value);
+uint64_t stats_histogram_sum(int64_t position);
+uint64_t stats_histogram_total(int64_t position);
 /************  STATISTICS  ************/
 
 stringer_t *  host_platform(stringer_t *output);
@@ -71,7 +71,9 @@ void st_free(stringer_t *s) {
 			release(s);
 			break;
 		case (MAPPED_T | JOINTED):
-			munmap(((mapped_t *)s)->data, ((mapped_t *)s)->avail);
+			// Strings created by st_import_mapped() may start part way into the first page, so we unmap from the page boundary.
+			munmap((chr_t *)((mapped_t *)s)->data - ((uintptr_t)((mapped_t *)s)->data % magma_core.page_length),
+				((mapped_t *)s)->avail + ((uintptr_t)((mapped_t *)s)->data % magma_core.page_length));
 //			int_t oldstate, ret1 = pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &oldstate);
 			close(((mapped_t *)s)->handle);
 			//int_t midstate, ret2 = pthread_setcancelstate(oldstate, &midstate);
@@ -255,6 +257,51 @@ stringer_t * st_import(const void *s, size_t len) {
 	return st_import_opts(MANAGED_T | CONTIGUOUS | HEAP, s, len);
 }
 
+/**
+ * @brief	Create a mapped string which references a region of a file, without copying the data.
+ * @note	The region is mapped privately, so changes made to the string are never written back to the file. On success the string takes
+ * 			ownership of the file descriptor, and it will be closed when the string is freed. Mapped strings created this way can't be
+ * 			resized, since the descriptor is only expected to be open for reading.
+ *
+ * @param	handle	the file descriptor of the file to be mapped.
+ * @param	offset	the offset, in bytes, of the region inside the file.
+ * @param	len		the length, in bytes, of the region to be mapped.
+ *
+ * @return	NULL on failure, or a pointer to the newly allocated mapped string on success.
+ */
+stringer_t * st_import_mapped(int handle, size_t offset, size_t len) {
+
+	void *base;
+	size_t skip, total;
+	stringer_t *result;
+
+	if (handle < 0 || !len) {
+		mclog_pedantic("Invalid file region passed in. { handle = %i / length = %zu }", handle, len);
+		return NULL;
+	}
+
+	// The mapping has to start on a page boundary, so we map the beginning of the page and skip over any leading bytes.
+	skip = offset % magma_core.page_length;
+	total = align(magma_core.page_length, skip + len);
+
+	if (!(result = mm_alloc(sizeof(mapped_t)))) {
+		return NULL;
+	}
+	else if ((base = mmap64(NULL, total, PROT_READ | PROT_WRITE, MAP_PRIVATE, handle, offset - skip)) == MAP_FAILED) {
+		mclog_pedantic("Unable to map the file region into memory. { error = %s }", strerror_r(errno, MEMORYBUF(1024), 1024));
+		mm_free(result);
+		return NULL;
+	}
+
+	((mapped_t *)result)->opts = MAPPED_T | JOINTED | HEAP;
+	((mapped_t *)result)->length = len;
+	((mapped_t *)result)->avail = total - skip;
+	((mapped_t *)result)->data = (chr_t *)base + skip;
+	((mapped_t *)result)->handle = handle;
+
+	return result;
+}
+
 /**
  * @brief	Copy data into a managed string.
  * @param	s	the managed string to store the copied contents of the data.
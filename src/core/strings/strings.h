@@ -133,6 +133,7 @@ stringer_t * st_dupe(stringer_t *s);
 //stringer_t * st_merge(chr_t *format, ...);
 //stringer_t * st_aprint(chr_t *format, va_list list);
 stringer_t * st_import(const void *s, size_t len);
+stringer_t * st_import_mapped(int handle, size_t offset, size_t len);
 stringer_t * st_copy_in(stringer_t *s, void *buf, size_t len);
 stringer_t * st_realloc(stringer_t *s, size_t len);
 stringer_t * st_output(stringer_t *output, size_t len);
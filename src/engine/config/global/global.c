@@ -382,6 +382,23 @@ bool_t config_validate_settings(void) {
 		result = false;
 	}
 
+	// The message checker thread pool, and the time each checker is given.
+	if (magma.smtp.checkers.threads > 256) {
+		log_critical("magma.smtp.checkers.threads is required to be 256 or smaller.");
+		result = false;
+	}
+
+	if (!magma.smtp.checkers.timeout.virus || !magma.smtp.checkers.timeout.dkim || !magma.smtp.checkers.timeout.spf) {
+		log_critical("magma.smtp.checkers.timeout values are required to be 1 or larger.");
+		result = false;
+	}
+
+	// The number of idle connections held for each mail relay.
+	if (magma.relay.pool.limit > 1024) {
+		log_critical("magma.relay.pool.limit is required to be 1024 or smaller.");
+		result = false;
+	}
+
 	// The legal thread stack range.
 	if (magma.system.thread_stack_size < PTHREAD_STACK_MIN) {
 		log_critical("magma.system.thread_stack_size is required to be %i or larger.", PTHREAD_STACK_MIN);
@@ -44,6 +44,8 @@ typedef struct {
 
 	struct {
 		chr_t *tank; /* The path of the storage tank. */
+		uint64_t cache; /* The maximum number of bytes of decompressed message text held by the shared message cache. */
+		bool_t framed; /* Store new plain text messages in independently compressed frames. */
 		stringer_t *active; /* The default storage server used by the legacy mail storage logic. */
 		stringer_t *root; /* The root portion of the storage server directory paths. */
 	} storage;
@@ -62,6 +64,14 @@ typedef struct {
 			stringer_t *domain[MAGMA_BLACKLIST_INSTANCES];
 		} blacklists;
 
+		// The thread pool used to run the message checkers concurrently, and the number of seconds each checker is given.
+		struct {
+			uint32_t threads;
+			struct {
+				uint32_t virus, dkim, spf;
+			} timeout;
+		} checkers;
+
 		stringer_t *bypass_addr; /* Bypass address/subnet string for smtp checks. This value used only by config. */
 		inx_t *bypass_subnets; /* Holder for all the address/subnets to be waived through for bypass */
 	} smtp;
@@ -82,6 +92,10 @@ typedef struct {
 			uint32_t standard;
 		} count;
 		uint32_t timeout;
+		struct {
+			uint32_t limit; /* The maximum number of idle connections held open for each relay. */
+			uint32_t timeout; /* The number of seconds an idle relay connection is held open before it's closed. */
+		} pool;
 	} relay;
 
 	struct {
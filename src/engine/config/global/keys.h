@@ -75,6 +75,30 @@ magma_keys_t magma_keys[] = {
 		.set = false,
 		.required = true
 	},
+	{
+		.store = (void *)&(magma.storage.cache),
+		.norm.type = M_TYPE_UINT64,
+		.norm.val.u64 = 64ULL << 20,
+		.name = "magma.storage.cache",
+		.description = "The maximum number of bytes of decompressed message text held in memory by the shared message cache. Use 0 to disable the cache.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.storage.framed),
+		.norm.type = M_TYPE_BOOLEAN,
+		.norm.val.binary = false,
+		.name = "magma.storage.framed",
+		.description = "Store new plain text messages in compressed frames, so large messages can be streamed. Only enable once every node can read framed messages.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
 	{
 		.store = (void *)&(magma.system.daemonize),
 		.norm.type = M_TYPE_BOOLEAN,
@@ -808,6 +832,54 @@ magma_keys_t magma_keys[] = {
 		.set = false,
 		.required = false
 	},
+	{
+		.store = (void *)&(magma.smtp.checkers.threads),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 4,
+		.name = "magma.smtp.checkers.threads",
+		.description = "The number of threads used to run the virus, DKIM and SPF checks concurrently once a message has been received. Use 0 to run the checks sequentially.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.smtp.checkers.timeout.virus),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 30,
+		.name = "magma.smtp.checkers.timeout.virus",
+		.description = "The number of seconds the virus scanner may spend on an inbound message before the message is deferred.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.smtp.checkers.timeout.dkim),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 15,
+		.name = "magma.smtp.checkers.timeout.dkim",
+		.description = "The number of seconds the DKIM verifier may spend on an inbound message before its result is ignored.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.smtp.checkers.timeout.spf),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 15,
+		.name = "magma.smtp.checkers.timeout.spf",
+		.description = "The number of seconds the SPF checker may spend on an inbound message before its result is ignored.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
 	{
 		.store = (void *)&(magma.smtp.bypass_addr),
 		.norm.type = M_TYPE_STRINGER,
@@ -976,6 +1048,30 @@ magma_keys_t magma_keys[] = {
 		.set = false,
 		.required = false
 	},
+	{
+		.store = (void *)&(magma.relay.pool.limit),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 4,
+		.name = "magma.relay.pool.limit",
+		.description = "The maximum number of idle connections held open for each mail relay, so they can be reused by later messages. Use 0 to disable connection reuse.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.relay.pool.timeout),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 30,
+		.name = "magma.relay.pool.timeout",
+		.description = "The number of seconds an idle mail relay connection is held open before it's closed.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
 };
 
 #endif
@@ -107,10 +107,16 @@ void process_stop(void) {
 		mail_cache_stop,
 		warehouse_stop,
 		http_content_stop,
+		smtp_client_pool_stop,
+		smtp_rbl_stop,
+		smtp_filters_stop,
+		smtp_prefs_stop,
+		smtp_pipeline_stop,
 		NULL, /* Protocol handlers. */
 		servers_encryption_stop,
 		queue_shutdown, /* Shutdown the thread pool. */
-		NULL /* Logging */
+		poller_stop, /* Release any parked connections, before the thread pool is shutdown. */
+		log_stop /* Stop the logging thread, and write out any queued entries. */
 	};
 
 #ifdef MAGMA_PEDANTIC
@@ -205,9 +211,15 @@ bool_t process_start(void) {
 		(void *)&mail_cache_start,
 		(void *)&warehouse_start,
 		(void *)&http_content_start,
+		(void *)&smtp_client_pool_start,
+		(void *)&smtp_rbl_start,
+		(void *)&smtp_filters_start,
+		(void *)&smtp_prefs_start,
+		(void *)&smtp_pipeline_start,
 		(void *)&protocol_init,
 		(void *)&servers_encryption_start,
 		(void *)&queue_init,
+		(void *)&poller_start,
 		(void *)&log_start
 	};
 
@@ -252,9 +264,15 @@ bool_t process_start(void) {
 		"Unable to initialize the thread local mail cache. Exiting.",
 		"Unable to initialize the data warehouse engine. Exiting.",
 		"Unable to initialize the web content cache. Exiting.",
+		"Unable to initialize the mail relay connection pools. Exiting.",
+		"Unable to initialize the blacklist cache. Exiting.",
+		"Unable to initialize the inbound filter cache. Exiting.",
+		"Unable to initialize the recipient preference cache. Exiting.",
+		"Unable to initialize the message checker thread pool. Exiting.",
 		"Unable to initialize the protocol handlers. Exiting.",
 		"Unable to initialize the server encryption context. Exiting.",
 		"Unable to initialize the thread pool. Exiting.",
+		"Unable to initialize the connection poller. Exiting.",
 		"Initialization of the log configuration failed. Exiting."
 	};
 
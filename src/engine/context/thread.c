@@ -15,7 +15,8 @@ void thread_stop(void) {
 
 	sql_thread_stop();
 	ssl_thread_stop();
-	mail_cache_thread_stop();
+	queue_thread_stop();
+	log_thread_stop();
 
 	return;
 }
@@ -8,12 +8,16 @@
 #ifndef MAGMA_ENGINE_CONTROLLER_H
 #define MAGMA_ENGINE_CONTROLLER_H
 
+// The number of spare job nodes each thread keeps for reuse before returning them to the shared list.
+#define MAGMA_QUEUE_CACHE 64
+
 /// queue.c
-void     dequeue(void);
+void     dequeue(void *index);
 void     enqueue(void *function, void *data);
 bool_t   queue_init(void);
 void     queue_shutdown(void);
 void     queue_signal(void);
+void     queue_thread_stop(void);
 void     requeue(void *function, void *requeue, void *data);
 
 /// protocol.c
@@ -8,6 +8,20 @@
 
 #include "magma.h"
 
+// The connection statistics for each protocol, resolved by protocol_init() so they aren't looked up by name for every connection.
+struct {
+	uint64_t total, secure;
+} protocol_stats[6];
+
+enum {
+	PROTOCOL_STATS_POP = 0,
+	PROTOCOL_STATS_IMAP = 1,
+	PROTOCOL_STATS_HTTP = 2,
+	PROTOCOL_STATS_SMTP = 3,
+	PROTOCOL_STATS_DMTP = 4,
+	PROTOCOL_STATS_MOLTEN = 5
+};
+
 stringer_t * protocol_type(connection_t *con) {
 
 	static stringer_t *protocols[] = {
@@ -80,10 +94,24 @@ stringer_t * protocol_type(connection_t *con) {
 }
 
 /**
- * @brief	Initialize all protocol modules, and prime their command arrays for binary searching.
+ * @brief	Initialize all protocol modules, prime their command arrays for binary searching, and resolve the protocol statistics.
  * @return	This function always returns true.
  */
 bool_t protocol_init(void) {
+
+	chr_t *names[][2] = {
+		{ "pop.connections.total", "pop.connections.secure" },
+		{ "imap.connections.total", "imap.connections.secure" },
+		{ "http.connections.total", "http.connections.secure" },
+		{ "smtp.connections.total", "smtp.connections.secure" },
+		{ "dmtp.connections.total", "dmtp.connections.secure" },
+		{ "molten.connections.total", "molten.connections.secure" }
+	};
+
+	for (uint_t i = 0; i < sizeof(protocol_stats) / sizeof(*protocol_stats); i++) {
+		protocol_stats[i].total = stats_get_name_pos(names[i][0]);
+		protocol_stats[i].secure = stats_get_name_pos(names[i][1]);
+	}
 	pop_sort();
 	imap_sort();
 	smtp_sort();
@@ -110,38 +138,38 @@ void protocol_enqueue(connection_t *con) {
 	switch (con->server->protocol) {
 
 		case (POP):
-			stats_increment_by_name("pop.connections.total");
-			if (con_secure(con) == 1) stats_increment_by_name("pop.connections.secure");
+			stats_increment_by_num(protocol_stats[PROTOCOL_STATS_POP].total);
+			if (con_secure(con) == 1) stats_increment_by_num(protocol_stats[PROTOCOL_STATS_POP].secure);
 			function = &pop_init;
 			break;
 		case (IMAP):
-			stats_increment_by_name("imap.connections.total");
-			if (con_secure(con) == 1) stats_increment_by_name("imap.connections.secure");
+			stats_increment_by_num(protocol_stats[PROTOCOL_STATS_IMAP].total);
+			if (con_secure(con) == 1) stats_increment_by_num(protocol_stats[PROTOCOL_STATS_IMAP].secure);
 			function = &imap_init;
 			break;
 		case (HTTP):
-			stats_increment_by_name("http.connections.total");
-			if (con_secure(con) == 1) stats_increment_by_name("http.connections.secure");
+			stats_increment_by_num(protocol_stats[PROTOCOL_STATS_HTTP].total);
+			if (con_secure(con) == 1) stats_increment_by_num(protocol_stats[PROTOCOL_STATS_HTTP].secure);
 			function = &http_init;
 			break;
 		case (SMTP):
-			stats_increment_by_name("smtp.connections.total");
-			if (con_secure(con) == 1) stats_increment_by_name("smtp.connections.secure");
+			stats_increment_by_num(protocol_stats[PROTOCOL_STATS_SMTP].total);
+			if (con_secure(con) == 1) stats_increment_by_num(protocol_stats[PROTOCOL_STATS_SMTP].secure);
 			function = &smtp_init;
 			break;
 		case (DMTP):
-			stats_increment_by_name("dmtp.connections.total");
-			if (con_secure(con) == 1) stats_increment_by_name("dmtp.connections.secure");
+			stats_increment_by_num(protocol_stats[PROTOCOL_STATS_DMTP].total);
+			if (con_secure(con) == 1) stats_increment_by_num(protocol_stats[PROTOCOL_STATS_DMTP].secure);
 			function = &dmtp_init;
 			break;
 		case (SUBMISSION):
-			stats_increment_by_name("smtp.connections.total");
-			if (con_secure(con) == 1) stats_increment_by_name("smtp.connections.secure");
+			stats_increment_by_num(protocol_stats[PROTOCOL_STATS_SMTP].total);
+			if (con_secure(con) == 1) stats_increment_by_num(protocol_stats[PROTOCOL_STATS_SMTP].secure);
 			function = &submission_init;
 			break;
 		case (MOLTEN):
-			stats_increment_by_name("molten.connections.total");
-			if (con_secure(con) == 1) stats_increment_by_name("molten.connections.secure");
+			stats_increment_by_num(protocol_stats[PROTOCOL_STATS_MOLTEN].total);
+			if (con_secure(con) == 1) stats_increment_by_num(protocol_stats[PROTOCOL_STATS_MOLTEN].secure);
 			function = &molten_init;
 			break;
 		default:
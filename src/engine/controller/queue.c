@@ -3,25 +3,151 @@
  * @file /magma/engine/controller/queue.c
  *
  * @brief	Functions used to distribute tasks to available worker threads.
+ * @note	Each worker thread owns a job list. Jobs queued by a worker are appended to its own list, jobs queued by any other thread
+ * 			are distributed across the worker lists in round robin order, and a worker which finds its own list empty steals from the
+ * 			other workers. The job nodes are recycled through thread local caches so the hot path never touches the heap.
  */
 
 #include "magma.h"
 
-typedef struct {
+typedef struct queue_t {
 	void (*function)(void *data), (*requeue)(void *data), *data;
 	struct queue_t *next;
 } queue_t;
 
+typedef struct {
+	pthread_mutex_t lock;
+	queue_t *head, *tail;
+} queue_list_t;
+
 struct {
 	sem_t sema;
+	uint64_t count; /* The number of worker threads, and job lists. */
+	uint64_t cursor; /* Round robin position used to distribute jobs from threads outside the pool. */
 	pthread_t *workers;
-	pthread_mutex_t lock;
-	queue_t *items;
+	queue_list_t *lists;
+
+	struct {
+		uint64_t working; /* The statistic tracking busy worker threads. */
+		int64_t duration; /* The histogram tracking job execution time. */
+	} handles;
+
+	struct {
+		pthread_mutex_t lock;
+		queue_t *nodes; /* Spare nodes released by threads whose local cache was full. */
+	} spare;
 } queue = {
+		.count = 0,
+		.cursor = 0,
 		.workers = NULL,
-		.items = NULL
+		.lists = NULL,
+		.spare = {
+			.nodes = NULL
+		}
 };
 
+__thread int64_t queue_worker = -1; /* The job list owned by the current thread, or -1 if the thread isn't a worker. */
+__thread queue_t *queue_cache = NULL; /* Spare job nodes held by the current thread. */
+__thread uint32_t queue_cached = 0; /* The number of nodes in the thread local cache. */
+
+/**
+ * @brief	Get a job node, preferring the thread local cache, then the shared spares, and only then the heap.
+ * @return	NULL on failure, or a pointer to the job node.
+ */
+queue_t * queue_node_alloc(void) {
+
+	queue_t *node;
+
+	if ((node = queue_cache)) {
+		queue_cache = node->next;
+		queue_cached--;
+	}
+	else {
+
+		mutex_lock(&queue.spare.lock);
+
+		// Move up to half a cache worth of nodes from the shared list so we don't come back here on every call.
+		for (uint32_t i = 0; queue.spare.nodes && i < (MAGMA_QUEUE_CACHE / 2); i++) {
+			node = queue.spare.nodes;
+			queue.spare.nodes = node->next;
+			node->next = queue_cache;
+			queue_cache = node;
+			queue_cached++;
+		}
+
+		mutex_unlock(&queue.spare.lock);
+
+		if ((node = queue_cache)) {
+			queue_cache = node->next;
+			queue_cached--;
+		}
+		else if (!(node = mm_alloc(sizeof(queue_t)))) {
+			return NULL;
+		}
+	}
+
+	node->next = NULL;
+	return node;
+}
+
+/**
+ * @brief	Return a job node to the thread local cache, or the shared spares if the local cache is full.
+ * @param	node	the job node being released.
+ * @return	This function returns no value.
+ */
+void queue_node_free(queue_t *node) {
+
+	if (queue_cached < MAGMA_QUEUE_CACHE) {
+		node->next = queue_cache;
+		queue_cache = node;
+		queue_cached++;
+	}
+	else {
+		mutex_lock(&queue.spare.lock);
+		node->next = queue.spare.nodes;
+		queue.spare.nodes = node;
+		mutex_unlock(&queue.spare.lock);
+	}
+
+	return;
+}
+
+/**
+ * @brief	Release the job nodes cached by the calling thread.
+ * @return	This function returns no value.
+ */
+void queue_thread_stop(void) {
+
+	queue_t *node;
+
+	while ((node = queue_cache)) {
+		queue_cache = node->next;
+		mm_free(node);
+	}
+
+	queue_cached = 0;
+	return;
+}
+
+/**
+ * @brief	Remove the job at the front of a worker job list.
+ * @param	list	the job list to be checked.
+ * @return	NULL if the list is empty, or the job which was removed.
+ */
+queue_t * queue_list_pop(queue_list_t *list) {
+
+	queue_t *work;
+
+	mutex_lock(&list->lock);
+
+	if ((work = list->head) && !(list->head = work->next)) {
+		list->tail = NULL;
+	}
+
+	mutex_unlock(&list->lock);
+	return work;
+}
+
 /**
  * @brief	Push a function on the job queue to be executed asynchronously.
  * @note	Warning: If this function fails to allocate a new queue_t object, the work unit is lost forever.
@@ -32,9 +158,10 @@ struct {
  */
 void requeue(void *function, void *requeue, void *data) {
 
-	queue_t *local, *work;
+	queue_t *work;
+	queue_list_t *list;
 
-	if (!(work = mm_alloc(sizeof(queue_t)))) {
+	if (!(work = queue_node_alloc())) {
 		log_critical("Failed to allocate a queue_t structure. Work request is lost forever!");
 		return;
 	}
@@ -43,17 +170,26 @@ void requeue(void *function, void *requeue, void *data) {
 	work->requeue = requeue;
 	work->data = data;
 
-	mutex_lock(&queue.lock);
+	// Workers keep the jobs they create, everyone else spreads their jobs across the pool.
+	if (queue_worker >= 0) {
+		list = queue.lists + queue_worker;
+	}
+	else {
+		list = queue.lists + (__atomic_fetch_add(&queue.cursor, 1, __ATOMIC_RELAXED) % queue.count);
+	}
 
-	if ((local = queue.items)) {
-		while (local->next) local = (queue_t *)local->next;
-		local->next = (struct queue_t *)work;
+	mutex_lock(&list->lock);
+
+	if (list->tail) {
+		list->tail->next = work;
 	}
 	else {
-		queue.items = work;
+		list->head = work;
 	}
 
-	mutex_unlock(&queue.lock);
+	list->tail = work;
+
+	mutex_unlock(&list->lock);
 	sem_post(&queue.sema);
 
 	return;
@@ -73,48 +209,51 @@ void enqueue(void *function, void *data) {
 
 /**
  * @brief	Wait for work to appear on the queue and then perform the work; if the job is to be requeue'd then requeue it.
- * @note	This is the thread pool entry point called from queue_init().
+ * @note	This is the thread pool entry point called from queue_init(). Each semaphore post corresponds to a single job, so a worker
+ * 			that was woken up keeps checking its own list, and then stealing from the other lists, until it finds a job. The only
+ * 			exception is during shutdown, when the semaphore is posted without a job.
+ * @param	index	the job list owned by this worker.
  * @return	This function returns no value.
  */
-void dequeue(void) {
+void dequeue(void *index) {
 
 	queue_t *work;
+	uint64_t started;
 
 	if (!thread_start()) {
 		log_error("Unable to setup the thread context.");
 		pthread_exit(NULL);
 	}
 
+	queue_worker = (int64_t)(uintptr_t)index;
+
 	do {
 
 		// Wait until the semaphore indicates a job is queued.
 		sem_wait(&queue.sema);
 
 		// Track how many worker threads are being used.
-		stats_increment_by_name("core.threads.working");
+		stats_increment_by_num(queue.handles.working);
 
-		// Lock the queue stack until we finish with it.
-		mutex_lock(&queue.lock);
-		work = queue.items;
-
-		if (work) {
-			queue.items = (queue_t *)work->next;
-		}
-
-		mutex_unlock(&queue.lock);
+		// Check our own list first, and then try stealing from our neighbors.
+		do {
+			for (uint64_t i = 0; !(work = queue_list_pop(queue.lists + ((queue_worker + i) % queue.count))) && i < queue.count; i++);
+		} while (!work && status());
 
 		if (work) {
+			started = time_microseconds();
 			work->function(work->data);
 
 			if (work->requeue) {
 				work->requeue(work->data);
 			}
 
-			mm_free(work);
+			stats_histogram_record(queue.handles.duration, time_microseconds() - started);
+			queue_node_free(work);
 		}
 
 		// Decrement the busy thread counter.
-		stats_decrement_by_name("core.threads.working");
+		stats_decrement_by_num(queue.handles.working);
 
 	// Continue processing until the work queue is empty and the status tracker indicates a shutdown.
 	} while (work || status());
@@ -147,20 +286,38 @@ void queue_signal(void) {
 
 /**
  * @brief	Create a queue of worker threads and set them into motion.
- * @note	Up to magma.system.worker_threads number of threads will be created.
+ * @note	Up to magma.system.worker_threads number of threads will be created, each with its own job list.
  * @return	false on failure or true on success.
  */
 bool_t queue_init(void) {
 
+	// Resolve the statistics once so the workers don't look them up by name for every job.
+	queue.handles.working = stats_get_name_pos("core.threads.working");
+	queue.handles.duration = stats_histogram_pos("core.jobs.duration");
+
 	if (sem_init(&queue.sema, 0, 0)) {
 		return false;
 	}
 
-	if (mutex_init(&queue.lock, NULL)) {
+	if (mutex_init(&queue.spare.lock, NULL)) {
 		sem_destroy(&queue.sema);
 		return false;
 	}
 
+	if (!(queue.lists = mm_alloc(sizeof(queue_list_t) * magma.system.worker_threads))) {
+		mutex_destroy(&queue.spare.lock);
+		sem_destroy(&queue.sema);
+		return false;
+	}
+
+	for (uint64_t i = 0; i < magma.system.worker_threads; i++) {
+		if (mutex_init(&(queue.lists[i].lock), NULL)) {
+			queue_shutdown();
+			return false;
+		}
+		queue.count++;
+	}
+
 	if (!(queue.workers = mm_alloc(sizeof(pthread_t) * magma.system.worker_threads))) {
 		queue_shutdown();
 		return false;
@@ -168,7 +325,7 @@ bool_t queue_init(void) {
 
 	for (uint64_t i = 0; i < magma.system.worker_threads; i++) {
 
-		if (thread_launch(queue.workers + i, &dequeue, NULL)) {
+		if (thread_launch(queue.workers + i, &dequeue, (void *)(uintptr_t)i)) {
 			log_error("Unable to launch the configured number of worker threads. {threads = %lu / configured = %u}", i, magma.system.worker_threads);
 			queue_shutdown();
 			return false;
@@ -186,6 +343,8 @@ bool_t queue_init(void) {
  */
 void queue_shutdown(void) {
 
+	queue_t *node;
+
 	for (uint64_t i = 0; queue.workers && i < magma.system.worker_threads + 128; i++) {
 		sem_post(&queue.sema);
 	}
@@ -199,8 +358,27 @@ void queue_shutdown(void) {
 
 	}
 
-	mm_cleanup(queue.workers);
-	mutex_destroy(&queue.lock);
+	// Any jobs left on the lists are lost, but we still release the nodes.
+	for (uint64_t i = 0; queue.lists && i < queue.count; i++) {
+		while ((node = queue_list_pop(queue.lists + i))) {
+			mm_free(node);
+		}
+		mutex_destroy(&(queue.lists[i].lock));
+	}
+
+	while ((node = queue.spare.nodes)) {
+		queue.spare.nodes = node->next;
+		mm_free(node);
+	}
+
+	queue_thread_stop();
+
+	mm_cleanup(queue.workers, queue.lists);
+	queue.workers = NULL;
+	queue.lists = NULL;
+	queue.count = 0;
+
+	mutex_destroy(&queue.spare.lock);
 	sem_destroy(&queue.sema);
 
 	return;
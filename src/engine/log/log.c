@@ -2,22 +2,66 @@
  * @file /magma/engine/log/log.c
  *
  * @brief	Internal logging functions. This function should be accessed using the appropriate macro.
+ * @note	Once log_start() launches the logging thread, each thread formats its entries into a private ring buffer, and the logging
+ * 			thread drains the rings in batches, so callers never block on the log mutex or the log file.
  */
 
 #include "magma.h"
 
+typedef struct log_ring_t {
+	uint64_t head; /* The total number of bytes written by the owning thread. */
+	uint64_t tail; /* The total number of bytes consumed by the logging thread. */
+	uint64_t dropped; /* The number of entries discarded because the ring was full. */
+	bool_t abandoned; /* Set once the owning thread exits, so the logging thread knows to free the ring after it has been drained. */
+	struct log_ring_t *next;
+
+	time_t stamp; /* The second used to generate the cached clock string. */
+	chr_t clock[16];
+
+	bool_t suppressing; /* Set once an entry is suppressed, so the logging thread knows to check the tracking slots. */
+	pthread_mutex_t limiter; /* Protects the suppressed counts, and the call site of any slot with a suppressed count. */
+
+	struct {
+		const char *file;
+		int line;
+		time_t second;
+		uint64_t count, suppressed;
+	} limits[MAGMA_LOG_LIMITS]; /* Tracks how often each call site has logged during the current second. */
+
+	chr_t data[MAGMA_LOG_RING];
+} log_ring_t;
+
 uint64_t log_date;
 bool_t log_enabled = true;
 pthread_mutex_t log_mutex =	PTHREAD_MUTEX_INITIALIZER;
 
+struct {
+	sem_t wake;
+	bool_t running; /* True while the logging thread is draining the rings. */
+	bool_t sleeping; /* Set by the logging thread before it waits, so writers know to wake it. */
+	pthread_t *thread;
+	log_ring_t *rings;
+	pthread_mutex_t lock; /* Protects the list of rings. */
+
+	struct {
+		uint64_t dropped, suppressed;
+	} stats;
+} log_async = {
+	.running = false,
+	.sleeping = false,
+	.thread = NULL,
+	.rings = NULL,
+	.lock = PTHREAD_MUTEX_INITIALIZER
+};
+
+__thread log_ring_t *log_ring = NULL; /* The ring buffer owned by the current thread. */
+
 /**
  * @brief	Disable logging.
  * @return	This function returns no value.
  */
 void log_disable(void) {
-	mutex_lock(&log_mutex);
-	log_enabled = false;
-	mutex_unlock(&log_mutex);
+	__atomic_store_n(&log_enabled, false, __ATOMIC_RELAXED);
 	return;
 }
 
@@ -26,9 +70,7 @@ void log_disable(void) {
  * @return	This function returns no value.
  */
 void log_enable(void) {
-	mutex_lock(&log_mutex);
-	log_enabled = true;
-	mutex_unlock(&log_mutex);
+	__atomic_store_n(&log_enabled, true, __ATOMIC_RELAXED);
 	return;
 }
 
@@ -96,9 +138,392 @@ int_t print_backtrace(void) {
 	return result;
 }
 
+/**
+ * @brief	Write a block of log output directly to the log file descriptor.
+ * @note	The caller must be holding the log mutex, which keeps the descriptor stable while the log is being rotated.
+ * @param	buffer	the data to be written.
+ * @param	length	the number of bytes to be written.
+ * @return	This function returns no value.
+ */
+void log_write(const chr_t *buffer, size_t length) {
+
+	ssize_t written;
+
+	fflush(stdout);
+
+	while (length && ((written = write(fileno(stdout), buffer, length)) > 0 || (written == -1 && errno == EINTR))) {
+		if (written > 0) {
+			buffer += written;
+			length -= written;
+		}
+	}
+
+	return;
+}
+
+/**
+ * @brief	Copy a formatted log entry into the calling thread's ring buffer.
+ * @note	Only the owning thread writes to the ring, and only the logging thread reads from it, so the head and tail are the only
+ * 			synchronization required. If the entry doesn't fit, it is dropped and counted, instead of blocking the caller.
+ * @param	ring	the ring buffer owned by the calling thread.
+ * @param	entry	the formatted log entry.
+ * @param	length	the length of the entry.
+ * @return	This function returns no value.
+ */
+void log_ring_push(log_ring_t *ring, const chr_t *entry, size_t length) {
+
+	size_t offset, first;
+	uint64_t head = ring->head, tail = __atomic_load_n(&(ring->tail), __ATOMIC_ACQUIRE);
+
+	if (MAGMA_LOG_RING - (head - tail) < length) {
+		__atomic_add_fetch(&(ring->dropped), 1, __ATOMIC_RELAXED);
+		stats_increment_by_num(log_async.stats.dropped);
+		return;
+	}
+
+	offset = head & (MAGMA_LOG_RING - 1);
+	first = (length < MAGMA_LOG_RING - offset) ? length : MAGMA_LOG_RING - offset;
+
+	mm_copy(ring->data + offset, entry, first);
+	mm_copy(ring->data, entry + first, length - first);
+
+	__atomic_store_n(&(ring->head), head + length, __ATOMIC_SEQ_CST);
+
+	// Wake the logging thread if it's waiting for work.
+	if (__atomic_load_n(&(log_async.sleeping), __ATOMIC_SEQ_CST) && __atomic_exchange_n(&(log_async.sleeping), false, __ATOMIC_SEQ_CST)) {
+		sem_post(&(log_async.wake));
+	}
+
+	return;
+}
+
+/**
+ * @brief	Get the ring buffer owned by the calling thread, allocating and registering one if necessary.
+ * @return	NULL if the logging thread isn't running or the ring couldn't be allocated, otherwise a pointer to the ring buffer.
+ */
+log_ring_t * log_ring_get(void) {
+
+	log_ring_t *ring;
+
+	if (!__atomic_load_n(&(log_async.running), __ATOMIC_ACQUIRE)) {
+		return NULL;
+	}
+	else if (log_ring) {
+		return log_ring;
+	}
+
+	// The ring is allocated with the system allocator, since the memory functions may themselves need to log.
+	if (!(ring = calloc(1, sizeof(log_ring_t)))) {
+		return NULL;
+	}
+	else if (pthread_mutex_init(&(ring->limiter), NULL)) {
+		free(ring);
+		return NULL;
+	}
+
+	mutex_lock(&(log_async.lock));
+	ring->next = log_async.rings;
+	log_async.rings = ring;
+	mutex_unlock(&(log_async.lock));
+
+	log_ring = ring;
+	return ring;
+}
+
+/**
+ * @brief	Decide whether a log entry should be suppressed because the call site is repeating itself.
+ * @note	Each thread may record up to MAGMA_LOG_BURST entries per second from a given call site. The logging thread writes a summary
+ * 			of the suppressed entries once the second has ended, and if the tracking slot is claimed by another call site before then,
+ * 			the summary is queued here instead. The limiter mutex is only taken when a count is suppressed, or a slot with a suppressed
+ * 			count is reclaimed, since those are the only fields the logging thread touches.
+ * @param	ring	the ring buffer owned by the calling thread.
+ * @param	file	the source file of the call site.
+ * @param	line	the source line of the call site.
+ * @param	now		the current time.
+ * @return	true if the entry should be discarded, or false if it should be recorded.
+ */
+bool_t log_ring_limit(log_ring_t *ring, const char *file, int line, time_t now) {
+
+	int length;
+	chr_t summary[256];
+	uint64_t slot = (((uintptr_t)file >> 3) ^ (line * 31)) % MAGMA_LOG_LIMITS;
+
+	if (ring->limits[slot].file == file && ring->limits[slot].line == line && ring->limits[slot].second == now) {
+		if (++(ring->limits[slot].count) > MAGMA_LOG_BURST) {
+			pthread_mutex_lock(&(ring->limiter));
+			ring->limits[slot].suppressed++;
+			__atomic_store_n(&(ring->suppressing), true, __ATOMIC_RELEASE);
+			pthread_mutex_unlock(&(ring->limiter));
+			stats_increment_by_num(log_async.stats.suppressed);
+			return true;
+		}
+		return false;
+	}
+
+	// Only the owning thread increments the suppressed count, so if it's zero, the logging thread won't be reading this slot.
+	if (!__atomic_load_n(&(ring->limits[slot].suppressed), __ATOMIC_ACQUIRE)) {
+		ring->limits[slot].file = file;
+		ring->limits[slot].line = line;
+		ring->limits[slot].second = now;
+		ring->limits[slot].count = 1;
+		return false;
+	}
+
+	pthread_mutex_lock(&(ring->limiter));
+
+	if (ring->limits[slot].suppressed && (length = snprintf(summary, sizeof(summary), "Repeated log entries were suppressed. { file = %s / line = %i / suppressed = %lu }\n",
+		ring->limits[slot].file, ring->limits[slot].line, ring->limits[slot].suppressed)) > 0) {
+		log_ring_push(ring, summary, (size_t)length < sizeof(summary) ? (size_t)length : sizeof(summary) - 1);
+	}
+
+	ring->limits[slot].file = file;
+	ring->limits[slot].line = line;
+	ring->limits[slot].second = now;
+	ring->limits[slot].count = 1;
+	__atomic_store_n(&(ring->limits[slot].suppressed), 0, __ATOMIC_RELEASE);
+
+	pthread_mutex_unlock(&(ring->limiter));
+
+	return false;
+}
+
+/**
+ * @brief	Write a summary entry for every call site in a ring whose entries were suppressed during a second which has since ended.
+ * @note	This lets the logging thread report suppressed entries even when the call site never logs again. The caller must be holding the
+ * 			log mutex. The mutex functions aren't used, since they may log, and this thread already holds the log mutex.
+ * @param	ring	the ring buffer to be checked.
+ * @param	now		the current time.
+ * @param	force	if true, every suppressed count is summarized, regardless of the second, which is used once the owner has exited.
+ * @return	This function returns no value.
+ */
+void log_ring_summarize(log_ring_t *ring, time_t now, bool_t force) {
+
+	int length;
+	chr_t summary[256];
+	bool_t pending = false;
+
+	if (!__atomic_load_n(&(ring->suppressing), __ATOMIC_ACQUIRE)) {
+		return;
+	}
+
+	pthread_mutex_lock(&(ring->limiter));
+
+	for (int i = 0; i < MAGMA_LOG_LIMITS; i++) {
+
+		if (!ring->limits[i].suppressed) {
+			continue;
+		}
+		// The owning thread may still be suppressing entries from this call site.
+		else if (!force && ring->limits[i].second >= now) {
+			pending = true;
+			continue;
+		}
+
+		if ((length = snprintf(summary, sizeof(summary), "Repeated log entries were suppressed. { file = %s / line = %i / suppressed = %lu }\n",
+			ring->limits[i].file, ring->limits[i].line, ring->limits[i].suppressed)) > 0) {
+			log_write(summary, (size_t)length < sizeof(summary) ? (size_t)length : sizeof(summary) - 1);
+		}
+
+		__atomic_store_n(&(ring->limits[i].suppressed), 0, __ATOMIC_RELEASE);
+	}
+
+	__atomic_store_n(&(ring->suppressing), pending, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&(ring->limiter));
+
+	return;
+}
+
+/**
+ * @brief	Move the contents of every ring buffer to the log file descriptor.
+ * @note	The pending data is gathered into a single batch and written with writev(). Abandoned rings are freed once they are empty.
+ * 			Summaries of suppressed entries are written after the batch, so they're reported even if the call site never logs again.
+ * 			Only one thread may drain the rings at a time: the logging thread while it runs, or log_stop() once it has exited. The log
+ * 			mutex is held throughout, which also keeps log_thread_stop() from freeing a ring we're still using.
+ * @return	the number of bytes written.
+ */
+size_t log_ring_drain(void) {
+
+	time_t now;
+	chr_t note[256];
+	ssize_t written = 0;
+	int count = 0, length;
+	log_ring_t *ring, **link;
+	size_t total = 0, remaining, used;
+	struct iovec iov[MAGMA_LOG_BATCH];
+	uint64_t head, tail, offset, dropped = 0;
+	struct {
+		log_ring_t *ring;
+		uint64_t length;
+	} pending[MAGMA_LOG_BATCH];
+	int rings = 0;
+
+	mutex_lock(&log_mutex);
+	mutex_lock(&(log_async.lock));
+
+	for (link = &(log_async.rings); (ring = *link) && count <= (MAGMA_LOG_BATCH - 2);) {
+
+		head = __atomic_load_n(&(ring->head), __ATOMIC_ACQUIRE);
+		tail = ring->tail;
+		dropped += __atomic_exchange_n(&(ring->dropped), 0, __ATOMIC_RELAXED);
+
+		// Once the owner is gone and the ring is empty, release it.
+		if (head == tail && __atomic_load_n(&(ring->abandoned), __ATOMIC_ACQUIRE)) {
+			*link = ring->next;
+			log_ring_summarize(ring, 0, true);
+			pthread_mutex_destroy(&(ring->limiter));
+			free(ring);
+			continue;
+		}
+		else if (head != tail) {
+
+			offset = tail & (MAGMA_LOG_RING - 1);
+			pending[rings].ring = ring;
+			pending[rings++].length = head - tail;
+			total += head - tail;
+
+			// The pending data may wrap around the end of the buffer, in which case it takes two vectors.
+			used = (head - tail) < (MAGMA_LOG_RING - offset) ? (head - tail) : (MAGMA_LOG_RING - offset);
+			iov[count].iov_base = ring->data + offset;
+			iov[count++].iov_len = used;
+
+			if (used != head - tail) {
+				iov[count].iov_base = ring->data;
+				iov[count++].iov_len = (head - tail) - used;
+			}
+		}
+
+		link = &(ring->next);
+	}
+
+	mutex_unlock(&(log_async.lock));
+
+	if (count) {
+
+		fflush(stdout);
+
+		while ((written = writev(fileno(stdout), iov, count)) == -1 && errno == EINTR);
+
+		// If the descriptor returned an error, the pending data is discarded so the writers aren't blocked forever.
+		remaining = written < 0 ? total : (size_t)written;
+
+		for (int i = 0; i < rings; i++) {
+			used = remaining < pending[i].length ? remaining : pending[i].length;
+			__atomic_store_n(&(pending[i].ring->tail), pending[i].ring->tail + used, __ATOMIC_RELEASE);
+			remaining -= used;
+		}
+	}
+
+	now = time(NULL);
+	mutex_lock(&(log_async.lock));
+
+	for (ring = log_async.rings; ring; ring = ring->next) {
+		log_ring_summarize(ring, now, false);
+	}
+
+	mutex_unlock(&(log_async.lock));
+
+	if (dropped && (length = snprintf(note, sizeof(note), "Log entries were dropped because a thread buffer was full. { dropped = %lu }\n", dropped)) > 0) {
+		log_write(note, (size_t)length < sizeof(note) ? (size_t)length : sizeof(note) - 1);
+	}
+
+	mutex_unlock(&log_mutex);
+
+	return written > 0 ? (size_t)written : 0;
+}
+
+/**
+ * @brief	The logging thread entry point, which drains the ring buffers until the logging system is stopped.
+ * @note	While idle, the thread wakes every 100 milliseconds, so summaries of suppressed entries are written shortly after each second ends.
+ * @return	This function returns no value.
+ */
+void log_ring_loop(void) {
+
+	struct timespec deadline;
+
+	thread_start();
+
+	while (__atomic_load_n(&(log_async.running), __ATOMIC_ACQUIRE)) {
+
+		if (!log_ring_drain()) {
+
+			// Announce that we're going to sleep, then check once more in case an entry was queued before the flag was visible.
+			__atomic_store_n(&(log_async.sleeping), true, __ATOMIC_SEQ_CST);
+
+			if (!log_ring_drain()) {
+				clock_gettime(CLOCK_REALTIME, &deadline);
+				deadline.tv_nsec += 100000000;
+				if (deadline.tv_nsec >= 1000000000) {
+					deadline.tv_sec++;
+					deadline.tv_nsec -= 1000000000;
+				}
+				sem_timedwait(&(log_async.wake), &deadline);
+			}
+
+			__atomic_store_n(&(log_async.sleeping), false, __ATOMIC_SEQ_CST);
+		}
+	}
+
+	thread_stop();
+	return;
+}
+
+/**
+ * @brief	Release the ring buffer owned by the calling thread.
+ * @note	If the logging thread is running, the ring is flagged and freed by the logging thread once it has been drained. Otherwise any
+ * 			pending entries are written out immediately, and the ring is freed here.
+ * @return	This function returns no value.
+ */
+void log_thread_stop(void) {
+
+	uint64_t offset, used;
+	log_ring_t *ring, **link;
+
+	if (!(ring = log_ring)) {
+		return;
+	}
+
+	log_ring = NULL;
+	mutex_lock(&log_mutex);
+	mutex_lock(&(log_async.lock));
+
+	if (__atomic_load_n(&(log_async.running), __ATOMIC_ACQUIRE)) {
+		__atomic_store_n(&(ring->abandoned), true, __ATOMIC_RELEASE);
+		mutex_unlock(&(log_async.lock));
+		mutex_unlock(&log_mutex);
+		return;
+	}
+
+	for (link = &(log_async.rings); *link && *link != ring; link = &((*link)->next));
+
+	if (*link) {
+		*link = ring->next;
+	}
+
+	mutex_unlock(&(log_async.lock));
+
+	// The logging thread is gone, so write out anything left in the ring ourselves.
+	while (ring->head != ring->tail) {
+		offset = ring->tail & (MAGMA_LOG_RING - 1);
+		used = (ring->head - ring->tail) < (MAGMA_LOG_RING - offset) ? (ring->head - ring->tail) : (MAGMA_LOG_RING - offset);
+		log_write(ring->data + offset, used);
+		ring->tail += used;
+	}
+
+	log_ring_summarize(ring, 0, true);
+	mutex_unlock(&log_mutex);
+
+	pthread_mutex_destroy(&(ring->limiter));
+	free(ring);
+
+	return;
+}
+
 /**
  *
  * @brief	Logs the message described by format, and provided as a variadic argument list.
+ * @note	Once the logging thread has been started, entries are formatted by the caller and queued inside a thread specific ring buffer,
+ * 			so the caller never waits on the log file. Entries requesting a stack trace, and entries too large for the ring, are still
+ * 			written directly.
  * @param	file	The log macros set this to the caller's filename.
  * @param	function	The log macros set this to the caller's function.
  * @param	line	The log macros set this to the line number where the log function was called.
@@ -109,79 +534,113 @@ int_t print_backtrace(void) {
  */
 void log_internal(const char *file, const char *function, const int line, M_LOG_OPTIONS options, const char *format, ...) {
 
+	int ret;
 	time_t now;
 	va_list args;
 	struct tm local;
-	bool_t output = false;
-	char buffer[128];
+	log_ring_t *ring;
+	size_t length = 0;
+	bool_t output = false, stack;
+	chr_t buffer[MAGMA_LOG_LINE], clock[16], *entry = buffer;
 
-	va_start(args, format);
+	// Someone has disabled the log output.
+	if (!__atomic_load_n(&log_enabled, __ATOMIC_RELAXED)) {
+		return;
+	}
 
-	mutex_lock(&log_mutex);
+	now = time(NULL);
+	ring = log_ring_get();
+	stack = (magma.log.stack || M_LOG_STACK_TRACE == (options & M_LOG_STACK_TRACE)) && !(M_LOG_STACK_TRACE_DISABLE == (options & M_LOG_STACK_TRACE_DISABLE));
 
-	// Someone has disabled the log output.
-	if (!log_enabled) {
-		mutex_unlock(&log_mutex);
+	if (ring && !stack && log_ring_limit(ring, file, line, now)) {
 		return;
 	}
 
 	if ((magma.log.time || M_LOG_TIME == (options & M_LOG_TIME)) && !(M_LOG_TIME_DISABLE == (options & M_LOG_TIME_DISABLE))) {
-		now = time(NULL);
-		localtime_r(&now, &local);
-		strftime(buffer, 128, "%T", &local);
 
-		fprintf(stdout, "%s%s", (output ? " - " : "["), buffer);
+		// Threads with a ring cache the clock string, so it only gets regenerated once a second.
+		if (ring && ring->stamp != now) {
+			localtime_r(&now, &local);
+			strftime(ring->clock, 16, "%T", &local);
+			ring->stamp = now;
+		}
+		else if (!ring) {
+			localtime_r(&now, &local);
+			strftime(clock, 16, "%T", &local);
+		}
+
+		length += snprintf(buffer + length, MAGMA_LOG_LINE - length, "%s%s", (output ? " - " : "["), ring ? ring->clock : clock);
 		output = true;
 	}
 
-	if ((magma.log.file || M_LOG_FILE == (options & M_LOG_FILE)) && !(M_LOG_FILE_DISABLE == (options & M_LOG_FILE_DISABLE))) {
-		fprintf(stdout, "%s%s", (output ? " - " : "["), file);
+	if ((magma.log.file || M_LOG_FILE == (options & M_LOG_FILE)) && !(M_LOG_FILE_DISABLE == (options & M_LOG_FILE_DISABLE)) && length < MAGMA_LOG_LINE) {
+		length += snprintf(buffer + length, MAGMA_LOG_LINE - length, "%s%s", (output ? " - " : "["), file);
 		output = true;
 	}
 
-	if ((magma.log.function || M_LOG_FUNCTION == (options & M_LOG_FUNCTION)) && !(M_LOG_FUNCTION_DISABLE == (options & M_LOG_FUNCTION_DISABLE))) {
-		fprintf(stdout, "%s%s%s", (output ? " - " : "["), function, "()");
+	if ((magma.log.function || M_LOG_FUNCTION == (options & M_LOG_FUNCTION)) && !(M_LOG_FUNCTION_DISABLE == (options & M_LOG_FUNCTION_DISABLE)) &&
+		length < MAGMA_LOG_LINE) {
+		length += snprintf(buffer + length, MAGMA_LOG_LINE - length, "%s%s%s", (output ? " - " : "["), function, "()");
 		output = true;
 	}
 
-	if ((magma.log.line || M_LOG_LINE == (options & M_LOG_LINE)) && !(M_LOG_LINE_DISABLE == (options & M_LOG_LINE_DISABLE))) {
-		fprintf(stdout, "%s%i", (output ? " - " : "["), line);
+	if ((magma.log.line || M_LOG_LINE == (options & M_LOG_LINE)) && !(M_LOG_LINE_DISABLE == (options & M_LOG_LINE_DISABLE)) && length < MAGMA_LOG_LINE) {
+		length += snprintf(buffer + length, MAGMA_LOG_LINE - length, "%s%i", (output ? " - " : "["), line);
 		output = true;
 	}
 
-	if (output)
-		fprintf(stdout, "] = ");
+	if (output && length < MAGMA_LOG_LINE) {
+		length += snprintf(buffer + length, MAGMA_LOG_LINE - length, "] = ");
+	}
 
-	vfprintf(stdout, format, args);
+	// The prefix is bounded by the length of the file and function names, so this should never happen.
+	if (length >= MAGMA_LOG_LINE) {
+		length = 0;
+	}
+
+	va_start(args, format);
+	ret = vsnprintf(buffer + length, MAGMA_LOG_LINE - length, format, args);
+	va_end(args);
+
+	// If the message didn't fit on the stack, format it again using a heap buffer large enough to hold it.
+	if (ret > 0 && length + ret + 2 > MAGMA_LOG_LINE && (entry = malloc(length + ret + 2))) {
+		memcpy(entry, buffer, length);
+		va_start(args, format);
+		vsnprintf(entry + length, ret + 1, format, args);
+		va_end(args);
+		length += ret;
+	}
+	else if (ret > 0 && length + ret + 2 > MAGMA_LOG_LINE) {
+		entry = buffer;
+		length = MAGMA_LOG_LINE - 2;
+	}
+	else if (ret > 0) {
+		length += ret;
+	}
 
 	if (!(M_LOG_LINE_FEED_DISABLE == (options & M_LOG_LINE_FEED_DISABLE))) {
-		fprintf(stdout, "\n");
+		entry[length++] = '\n';
 	}
 
-	if ((magma.log.stack || M_LOG_STACK_TRACE == (options & M_LOG_STACK_TRACE)) && !(M_LOG_STACK_TRACE_DISABLE == (options & M_LOG_STACK_TRACE_DISABLE))) {
+	if (ring && !stack && length <= (MAGMA_LOG_RING / 4)) {
+		log_ring_push(ring, entry, length);
+	}
+	else {
 
-		if (print_backtrace() < 0) {
-			fprintf(stdout, "Error printing stack backtrace to stdout!\n");
-		}
+		mutex_lock(&log_mutex);
 
-		/***
-		size = backtrace(array, 1024);
-		strings = backtrace_symbols(array, size);
+		log_write(entry, length);
 
-		for (uint64_t i = 0; i < size; i++) {
-			fprintf(stdout, "   %s\n", strings[i]);
+		if (stack && print_backtrace() < 0) {
+			log_write("Error printing stack backtrace to stdout!\n", 42);
 		}
 
-		if (strings)
-			free(strings);
-
-		***/
+		mutex_unlock(&log_mutex);
 	}
 
-	fflush(stdout);
-	mutex_unlock(&log_mutex);
-
-	va_end(args);
+	if (entry != buffer) {
+		free(entry);
+	}
 
 	return;
 }
@@ -208,8 +667,8 @@ void log_rotate(void) {
 		pthread_mutex_lock(&log_mutex);
 		if (!(stdout = freopen64(log_file, "a", stdout))) {
 			stdout = orig_out;
-			log_critical("Unable to rotate the error log. { file = %s }", log_file);
 			pthread_mutex_unlock(&log_mutex);
+			log_critical("Unable to rotate the error log. { file = %s }", log_file);
 			return;
 		}
 
@@ -218,8 +677,8 @@ void log_rotate(void) {
 			fclose(stdout);
 			stdout = orig_out;
 			stderr = orig_err;
-			log_critical("Unable to rotate the error log. { file = %s }", log_file);
 			pthread_mutex_unlock(&log_mutex);
+			log_critical("Unable to rotate the error log. { file = %s }", log_file);
 			return;
 		}
 		pthread_mutex_unlock(&log_mutex);
@@ -266,6 +725,49 @@ bool_t log_start(void) {
 	}
 
 	fclose(stdin);
+
+	log_async.stats.dropped = stats_get_name_pos("core.log.dropped");
+	log_async.stats.suppressed = stats_get_name_pos("core.log.suppressed");
+
+	// Launch the logging thread, which takes over writing log entries from the rest of the process.
+	if (sem_init(&(log_async.wake), 0, 0)) {
+		log_critical("Unable to initialize the logging thread semaphore.");
+		return false;
+	}
+
+	__atomic_store_n(&(log_async.running), true, __ATOMIC_RELEASE);
+
+	if (!(log_async.thread = thread_alloc(log_ring_loop, NULL))) {
+		__atomic_store_n(&(log_async.running), false, __ATOMIC_RELEASE);
+		sem_destroy(&(log_async.wake));
+		log_critical("Unable to launch the logging thread.");
+		return false;
+	}
+
 	return true;
 }
 
+/**
+ * @brief	Stop the logging thread, write out any queued log entries, and return to writing log entries directly.
+ * @return	This function returns no value.
+ */
+void log_stop(void) {
+
+	if (!log_async.thread) {
+		return;
+	}
+
+	__atomic_store_n(&(log_async.running), false, __ATOMIC_RELEASE);
+	sem_post(&(log_async.wake));
+
+	thread_join(*(log_async.thread));
+	mm_free(log_async.thread);
+	log_async.thread = NULL;
+
+	// With the logging thread gone, we drain whatever is left. Rings owned by live threads are freed when those threads exit.
+	while (log_ring_drain());
+
+	sem_destroy(&(log_async.wake));
+	return;
+}
+
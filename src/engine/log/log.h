@@ -10,6 +10,12 @@
 #ifndef MAGMA_CORE_LOG_H
 #define MAGMA_CORE_LOG_H
 
+#define MAGMA_LOG_RING 65536 /* The size of the ring buffer allocated for each thread; must be a power of two. */
+#define MAGMA_LOG_LINE 2048 /* The stack buffer used to format an entry, longer entries are formatted using the heap. */
+#define MAGMA_LOG_BATCH 64 /* The maximum number of vectors passed to writev() by the logging thread. */
+#define MAGMA_LOG_LIMITS 64 /* The number of call sites each thread tracks for rate limiting. */
+#define MAGMA_LOG_BURST 32 /* The number of entries a call site may record per second, per thread, before being suppressed. */
+
 // log.c
 int_t    print_backtrace();
 void     log_internal(const char *file, const char *function, const int line, M_LOG_OPTIONS options, const char *format, ...) __attribute__((format (printf, 5, 6)));
@@ -17,6 +23,8 @@ void     log_disable(void);
 void     log_enable(void);
 void     log_rotate(void);
 bool_t   log_start(void);
+void     log_stop(void);
+void     log_thread_stop(void);
 
 #undef log_pedantic
 #undef log_check
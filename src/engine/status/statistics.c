@@ -7,22 +7,59 @@
 
 #include "magma.h"
 
-struct {
-	size_t count;
-	pthread_mutex_t locks[128][2];
+typedef struct {
+	uint64_t total, sum, buckets[MAGMA_STATS_BUCKETS];
+} stats_histogram_t;
+
+// Each shard is aligned to a cache line boundary so threads assigned to different shards never write to the same line.
+typedef struct __attribute__ ((aligned (64))) {
 	uint64_t values[128];
+	stats_histogram_t histograms[MAGMA_STATS_HISTOGRAMS];
+} stats_shard_t;
+
+struct {
+	size_t count, histograms;
+	uint64_t cursor; /* Used to assign threads to the counter shards in round robin order. */
+	uint16_t slots[MAGMA_STATS_SLOTS]; /* An open addressed hash table mapping names to positions, plus one so zero marks an empty slot. */
+	stats_shard_t shards[MAGMA_STATS_SHARDS];
 	char *names[128];
+	char *histogram_names[MAGMA_STATS_HISTOGRAMS];
 } stats = {
+		.histogram_names = {
+
+			// The number of microseconds a worker thread spent executing a job.
+			"core.jobs.duration",
+
+			// The number of microseconds a thread spent waiting for a database connection.
+			"provider.database.pool.wait",
+
+			// The number of microseconds each SMTP message checker spent on a message.
+			"smtp.checkers.virus",
+			"smtp.checkers.dkim",
+			"smtp.checkers.spf",
+			"smtp.checkers.dspam"
+		},
 		.names = {
 			"default",
 
 			// Core Statistics
 			"core.threads.allocated",
 			"core.threads.working",
+			"core.connections.parked",
+			"core.log.dropped",
+			"core.log.suppressed",
 
 			// SMTP Statistics
 			"smtp.connections.total",
 			"smtp.connections.secure",
+			"smtp.rbl.cache.hits",
+			"smtp.rbl.cache.misses",
+			"smtp.rbl.errors",
+			"smtp.filters.cache.hits",
+			"smtp.filters.cache.misses",
+			"smtp.prefs.cache.hits",
+			"smtp.prefs.cache.misses",
+			"smtp.checkers.timeouts",
 
 			// DMTP Statistics
 			"dmtp.connections.total",
@@ -74,6 +111,9 @@ struct {
 			"objects.meta.expired",
 			"objects.sessions.total",
 			"objects.sessions.expired",
+			"objects.mail.cache.hits",
+			"objects.mail.cache.misses",
+			"objects.mail.cache.evictions",
 
 			// Patterns
 			"objects.patterns.checked",
@@ -129,6 +169,8 @@ char *derived[] = {
 	"errors.total"
 };
 
+__thread int64_t stats_shard_index = -1; /* The counter shard assigned to the current thread. */
+
 /**
  * @brief	Get the total sum of all error statistics maintained by magma (traditional and derived stats).
  * @note	Error statistics are all statistics that have a name that begins with "errors." or ends with ".errors".
@@ -241,22 +283,38 @@ uint64_t stats_derived_value(uint64_t position) {
 	return result;
 }
 
-// LOW: There should be some index validation for functions that reference statistics by index.
+/**
+ * @brief	Get the counter shard assigned to the calling thread.
+ * @note	Threads are assigned a shard the first time they update a statistic, and keep it for their lifetime.
+ * @return	a pointer to the calling thread's counter shard.
+ */
+stats_shard_t * stats_shard(void) {
+
+	if (stats_shard_index < 0) {
+		stats_shard_index = __atomic_fetch_add(&stats.cursor, 1, __ATOMIC_RELAXED) % MAGMA_STATS_SHARDS;
+	}
+
+	return &(stats.shards[stats_shard_index]);
+}
 
 /**
  * @brief	Get the index of a statistic by name.
+ * @note	The result can be stored and passed to the stats_*_by_num() functions, which avoids the name lookup on every update.
  * @param	name	the name of the statistic to be queried.
  * @return	0 on failure, or the zero-based index of the requested statistic on success.
  */
 uint64_t stats_get_name_pos(char *name) {
 
-	bool_t match = false;
+	uint16_t slot;
 
-	for (uint64_t i = 0; i < stats.count; i++) {
-		mutex_lock(&stats.locks[i][0]);
-		match = !st_cmp_cs_eq(NULLER(name), NULLER(stats.names[i]));
-		mutex_unlock(&stats.locks[i][0]);
-		if (match) return i;
+	if (!name) {
+		return 0;
+	}
+
+	for (uint32_t i = hash_murmur32(name, ns_length_get(name)) & (MAGMA_STATS_SLOTS - 1); (slot = stats.slots[i]); i = (i + 1) & (MAGMA_STATS_SLOTS - 1)) {
+		if (!st_cmp_cs_eq(NULLER(name), NULLER(stats.names[slot - 1]))) {
+			return slot - 1;
+		}
 	}
 
 	log_info("Could not find the statistic requested. {name = %s}", name);
@@ -267,17 +325,15 @@ uint64_t stats_get_name_pos(char *name) {
 /**
  * @brief	Get the name of a statistic by its index.
  * @param	position	the zero-based index of the statistic to be queried.
- * @return	0 on failure, or the name of the requested statistic on success.
+ * @return	NULL on failure, or the name of the requested statistic on success.
  */
 char * stats_get_name(uint64_t position) {
 
-	char *name;
-
-	mutex_lock(&stats.locks[position][0]);
-	name = stats.names[position];
-	mutex_unlock(&stats.locks[position][0]);
+	if (position >= stats.count) {
+		return NULL;
+	}
 
-	return name;
+	return stats.names[position];
 }
 
 /**
@@ -294,23 +350,29 @@ void stats_set_by_name(char *name, uint64_t value) {
 		return;
 	}
 
-	mutex_lock(&stats.locks[position][1]);
-	stats.values[position] = value;
-	mutex_unlock(&stats.locks[position][1]);
+	stats_set_by_num(position, value);
 	return;
 }
 
 /**
  * @brief	Provided a statistic by index, set its value.
+ * @note	The value is stored in the first shard and the others are cleared, so an update made by another thread while the value is
+ * 			being set may be lost.
  * @param	position	the zero-based index of the statistic to be set.
  * @param	value		the new value of the specified statistic.
  * @return	This function returns no value.
  */
 void stats_set_by_num(uint64_t position, uint64_t value) {
 
-	mutex_lock(&stats.locks[position][1]);
-	stats.values[position] = value;
-	mutex_unlock(&stats.locks[position][1]);
+	if (position >= stats.count) {
+		return;
+	}
+
+	__atomic_store_n(&(stats.shards[0].values[position]), value, __ATOMIC_RELAXED);
+
+	for (uint64_t i = 1; i < MAGMA_STATS_SHARDS; i++) {
+		__atomic_store_n(&(stats.shards[i].values[position]), 0, __ATOMIC_RELAXED);
+	}
 
 	return;
 }
@@ -318,35 +380,36 @@ void stats_set_by_num(uint64_t position, uint64_t value) {
 /**
  * @brief	Provided a statistic by name, get its value.
  * @param	name	a null-terminated string containing the name of the statistic to be queried.
- * @return	the specified statistic's value, as an unsigned 64 bit integer.
+ * @return	the value of the specified statistic, or 0 on failure.
  */
 uint64_t stats_get_value_by_name(char *name) {
 
-	uint64_t position, value;
+	uint64_t position;
 
 	if (!(position = stats_get_name_pos(name))) {
-			return 0;
+		return 0;
 	}
 
-	mutex_lock(&stats.locks[position][1]);
-	value = stats.values[position];
-	mutex_unlock(&stats.locks[position][1]);
-
-	return value;
+	return stats_get_value_by_num(position);
 }
 
 /**
  * @brief	Provided a statistic by index, get its value.
+ * @note	The value is the sum of every shard, so updates which wrap around inside an individual shard still produce the correct total.
  * @param	position	the zero-based index of the statistic to be queried.
- * @return	the specified statistic's value, as an unsigned 64 bit integer.
+ * @return	the value of the specified statistic, or 0 on failure.
  */
 uint64_t stats_get_value_by_num(uint64_t position) {
 
-	uint64_t value;
+	uint64_t value = 0;
 
-	mutex_lock(&stats.locks[position][1]);
-	value = stats.values[position];
-	mutex_unlock(&stats.locks[position][1]);
+	if (position >= stats.count) {
+		return 0;
+	}
+
+	for (uint64_t i = 0; i < MAGMA_STATS_SHARDS; i++) {
+		value += __atomic_load_n(&(stats.shards[i].values[position]), __ATOMIC_RELAXED);
+	}
 
 	return value;
 }
@@ -365,10 +428,7 @@ void stats_adjust_by_name(char *name, int32_t value) {
 		return;
 	}
 
-	mutex_lock(&stats.locks[position][1]);
-	stats.values[position] += value;
-	mutex_unlock(&stats.locks[position][1]);
-
+	stats_adjust_by_num(position, value);
 	return;
 }
 
@@ -380,10 +440,11 @@ void stats_adjust_by_name(char *name, int32_t value) {
  */
 void stats_adjust_by_num(uint64_t position, int32_t value) {
 
-	mutex_lock(&stats.locks[position][1]);
-	stats.values[position] += value;
-	mutex_unlock(&stats.locks[position][1]);
+	if (position >= stats.count) {
+		return;
+	}
 
+	__atomic_fetch_add(&(stats_shard()->values[position]), (uint64_t)(int64_t)value, __ATOMIC_RELAXED);
 	return;
 }
 
@@ -400,10 +461,7 @@ void stats_increment_by_name(char *name) {
 		return;
 	}
 
-	mutex_lock(&stats.locks[position][1]);
-	stats.values[position]++;
-	mutex_unlock(&stats.locks[position][1]);
-
+	stats_increment_by_num(position);
 	return;
 }
 
@@ -414,10 +472,11 @@ void stats_increment_by_name(char *name) {
  */
 void stats_increment_by_num(uint64_t position) {
 
-	mutex_lock(&stats.locks[position][1]);
-	stats.values[position]++;
-	mutex_unlock(&stats.locks[position][1]);
+	if (position >= stats.count) {
+		return;
+	}
 
+	__atomic_fetch_add(&(stats_shard()->values[position]), 1, __ATOMIC_RELAXED);
 	return;
 }
 
@@ -434,10 +493,7 @@ void stats_decrement_by_name(char *name) {
 		return;
 	}
 
-	mutex_lock(&stats.locks[position][1]);
-	stats.values[position]--;
-	mutex_unlock(&stats.locks[position][1]);
-
+	stats_decrement_by_num(position);
 	return;
 }
 
@@ -448,10 +504,11 @@ void stats_decrement_by_name(char *name) {
  */
 void stats_decrement_by_num(uint64_t position) {
 
-	mutex_lock(&stats.locks[position][1]);
-	stats.values[position]--;
-	mutex_unlock(&stats.locks[position][1]);
+	if (position >= stats.count) {
+		return;
+	}
 
+	__atomic_fetch_sub(&(stats_shard()->values[position]), 1, __ATOMIC_RELAXED);
 	return;
 }
 
@@ -464,39 +521,180 @@ uint64_t stats_get_count(void) {
 	return stats.count;
 }
 
+/**
+ * @brief	Get the number of histograms being tracked.
+ * @return	the total number of histograms maintained by magma.
+ */
+uint64_t stats_histogram_count(void) {
+
+	return stats.histograms;
+}
+
+/**
+ * @brief	Get the name of a histogram by its index.
+ * @param	position	the zero-based index of the histogram to be queried.
+ * @return	NULL on failure, or the name of the requested histogram on success.
+ */
+char * stats_histogram_name(uint64_t position) {
+
+	if (position >= stats.histograms) {
+		return NULL;
+	}
+
+	return stats.histogram_names[position];
+}
+
+/**
+ * @brief	Get the index of a histogram by name.
+ * @note	Histograms are meant to be resolved once, and then updated by index.
+ * @param	name	the name of the histogram to be queried.
+ * @return	-1 on failure, or the zero-based index of the requested histogram on success.
+ */
+int64_t stats_histogram_pos(char *name) {
+
+	for (uint64_t i = 0; name && i < stats.histograms; i++) {
+		if (!st_cmp_cs_eq(NULLER(name), NULLER(stats.histogram_names[i]))) {
+			return i;
+		}
+	}
+
+	log_info("Could not find the histogram requested. {name = %s}", name);
+
+	return -1;
+}
+
+/**
+ * @brief	Record a sample in a histogram.
+ * @note	Samples are counted in power of two buckets, so bucket N holds values between 2^(N-1) and 2^N - 1, and the last bucket holds
+ * 			everything larger.
+ * @param	position	the zero-based index of the histogram to be updated.
+ * @param	value		the value being recorded.
+ * @return	This function returns no value.
+ */
+void stats_histogram_record(int64_t position, uint64_t value) {
+
+	uint64_t bucket;
+	stats_histogram_t *histogram;
+
+	if (position < 0 || position >= stats.histograms) {
+		return;
+	}
+
+	histogram = &(stats_shard()->histograms[position]);
+	bucket = value ? 64 - __builtin_clzll(value) : 0;
+
+	__atomic_fetch_add(&(histogram->buckets[bucket < MAGMA_STATS_BUCKETS ? bucket : MAGMA_STATS_BUCKETS - 1]), 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&(histogram->sum), value, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&(histogram->total), 1, __ATOMIC_RELAXED);
+
+	return;
+}
+
+/**
+ * @brief	Get the number of samples recorded by a histogram.
+ * @param	position	the zero-based index of the histogram to be queried.
+ * @return	the number of recorded samples, or 0 on failure.
+ */
+uint64_t stats_histogram_total(int64_t position) {
+
+	uint64_t total = 0;
+
+	for (uint64_t i = 0; position >= 0 && position < stats.histograms && i < MAGMA_STATS_SHARDS; i++) {
+		total += __atomic_load_n(&(stats.shards[i].histograms[position].total), __ATOMIC_RELAXED);
+	}
+
+	return total;
+}
+
+/**
+ * @brief	Get the sum of every sample recorded by a histogram.
+ * @param	position	the zero-based index of the histogram to be queried.
+ * @return	the sum of the recorded samples, or 0 on failure.
+ */
+uint64_t stats_histogram_sum(int64_t position) {
+
+	uint64_t sum = 0;
+
+	for (uint64_t i = 0; position >= 0 && position < stats.histograms && i < MAGMA_STATS_SHARDS; i++) {
+		sum += __atomic_load_n(&(stats.shards[i].histograms[position].sum), __ATOMIC_RELAXED);
+	}
+
+	return sum;
+}
+
+/**
+ * @brief	Estimate a percentile for the samples recorded by a histogram.
+ * @note	The result is the upper bound of the bucket holding the requested percentile, so it is only accurate to within a power of two.
+ * @param	position	the zero-based index of the histogram to be queried.
+ * @param	percentile	the percentile being requested, between 0 and 100.
+ * @return	the estimated percentile, or 0 if the histogram is empty or invalid.
+ */
+uint64_t stats_histogram_percentile(int64_t position, uint_t percentile) {
+
+	uint64_t buckets[MAGMA_STATS_BUCKETS], total = 0, seen = 0;
+
+	if (position < 0 || position >= stats.histograms) {
+		return 0;
+	}
+
+	mm_wipe(buckets, sizeof(buckets));
+
+	for (uint64_t i = 0; i < MAGMA_STATS_SHARDS; i++) {
+		for (uint64_t j = 0; j < MAGMA_STATS_BUCKETS; j++) {
+			buckets[j] += __atomic_load_n(&(stats.shards[i].histograms[position].buckets[j]), __ATOMIC_RELAXED);
+		}
+	}
+
+	for (uint64_t j = 0; j < MAGMA_STATS_BUCKETS; j++) {
+		total += buckets[j];
+	}
+
+	for (uint64_t j = 0; total && j < MAGMA_STATS_BUCKETS; j++) {
+		if (((seen += buckets[j]) * 100) >= (total * percentile)) {
+			return j ? (1UL << j) - 1 : 0;
+		}
+	}
+
+	return 0;
+}
+
 /**
  * @brief	Initialize and reset all statistics counters.
  * @return	false on failure or true on success.
  */
 bool_t stats_init(void) {
 
-	mm_wipe(stats.locks, sizeof(stats.locks));
-	mm_wipe(stats.values, sizeof(stats.values));
+	uint32_t slot;
+
+	stats.count = stats.histograms = stats.cursor = 0;
+	mm_wipe(stats.slots, sizeof(stats.slots));
+	mm_wipe(stats.shards, sizeof(stats.shards));
 
 	for (uint64_t i = 0; i < sizeof(stats.names) / sizeof(char *); i++) {
 		if (stats.names[i]) stats.count++;
 	}
 
+	for (uint64_t i = 0; i < sizeof(stats.histogram_names) / sizeof(char *); i++) {
+		if (stats.histogram_names[i]) stats.histograms++;
+	}
+
+	// Build the name lookup table. Since the table is larger than the list of names, we will always find an empty slot.
 	for (uint64_t i = 0; i < stats.count; i++) {
-		if (mutex_init(&stats.locks[i][0], NULL) || mutex_init(&stats.locks[i][1], NULL)) {
-			log_critical("Could not initialize the statistic locks.");
-			return false;
-		}
+		for (slot = hash_murmur32(stats.names[i], ns_length_get(stats.names[i])) & (MAGMA_STATS_SLOTS - 1); stats.slots[slot];
+			slot = (slot + 1) & (MAGMA_STATS_SLOTS - 1));
+		stats.slots[slot] = i + 1;
 	}
 
 	return true;
 }
 
 /**
- * @brief	Destroy all statistics locks.
+ * @brief	Shutdown the statistics interface.
+ * @note	The counters don't hold any resources, so there is nothing to release, but the function is kept so the startup and shutdown
+ * 			sequences remain symmetric.
  * @return	This function returns no value.
  */
 void stats_shutdown(void) {
 
-	for (uint64_t i = 0; i < stats.count; i++) {
-		mutex_destroy(&stats.locks[i][0]);
-		mutex_destroy(&stats.locks[i][1]);
-	}
-
 	return;
 }
@@ -36,8 +36,11 @@
 #include <sys/utsname.h>
 #include <sys/prctl.h>
 #include <sys/epoll.h>
+#include <poll.h>
+#include <sys/uio.h>
 #include <sys/sysctl.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <arpa/nameser.h>
 #include <netdb.h>
@@ -47,6 +50,7 @@
 #include <search.h>
 #include <semaphore.h>
 #include <sys/mman.h>
+#include <sys/file.h>
 
 // GNU C Library
 #include <gnu/libc-version.h>
@@ -152,6 +152,9 @@ void con_destroy(connection_t *con) {
 				break;
 		}
 
+		// Send anything still sitting in the output buffer, like a goodbye message.
+		con_flush(con);
+
 		if (con->network.tls) {
 			tls_free(con->network.tls);
 		}
@@ -161,6 +164,7 @@ void con_destroy(connection_t *con) {
 		}
 
 		st_cleanup(con->network.buffer);
+		st_cleanup(con->network.output);
 		mm_cleanup(con->network.reverse.ip);
 		st_cleanup(con->network.reverse.domain);
 		mutex_destroy(&(con->lock));
@@ -38,8 +38,26 @@ typedef struct {
 	stringer_t *name, *value;
 } http_data_t;
 
+typedef struct {
+	chr_t *name; /* The placeholder name, without the dollar signs. */
+	stringer_t *value; /* The substituted value, or NULL to remove the placeholder. */
+} http_slot_t;
+
 typedef struct {
 	stringer_t *location, *resource, *type;
+
+	struct {
+		xmlDocPtr doc; /* The parsed document, which is copied by each request that needs to modify the page tree. */
+		size_t count; /* The number of placeholders. */
+		placer_t *slots; /* Every $NAME$ placeholder in the template, in order, including those which start on the closing dollar sign of the one before. */
+	} compiled;
+
+	struct {
+		time_t modified; /* The file modification time, which is sent as the Last-Modified header. */
+		stringer_t *etag; /* The strong entity tag, derived from a hash of the resource. */
+		stringer_t *gzip; /* The precompressed resource, or NULL if compression didn't make it smaller. */
+	} cache;
+
 	struct http_content_t *next;
 } http_content_t;
 
@@ -22,6 +22,7 @@ typedef struct {
 
 typedef struct {
 	stringer_t *key, *value;
+	struct mail_stream_t *stream; /* Used in place of the value for message literals which are streamed. */
 	struct imap_fetch_response_t *next;
 } imap_fetch_response_t;
 
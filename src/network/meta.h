@@ -85,6 +85,11 @@ typedef struct {
 	uint64_t messagenum, foldernum, sequencenum, signum, sigkey, created;
 } meta_message_t;
 
+typedef struct {
+	uint64_t foldernum, count;
+	meta_message_t **messages; /* The folder's messages, in sequence order, so a message's sequence number is its position plus one. */
+} meta_sequence_t;
+
 typedef struct {
 	chr_t name[128]; // Even though we limit folder names to 16 characters, with modified UTF-7 escaping, the string could be longer.
 	uint32_t order;
@@ -111,14 +116,20 @@ typedef struct {
 		stringer_t *signet;
 	} prime;
 
+	// The per-folder message views, which are only valid while the messages index matches the source pointer and serial number.
+	struct {
+		uint64_t serial;
+		inx_t *views, *source;
+	} sequences;
+
 	struct {
 		uint64_t user, messages, folders, contacts, aliases;
+		uint64_t synced; /* The database time the messages were last loaded, used to fetch only the messages changed since. */
 	} serials;
 
 	struct {
 		time_t stamp;
-		uint64_t smtp, pop, imap, web, generic;
-		pthread_mutex_t lock;
+		uint64_t smtp, pop, imap, web, generic; /* Updated atomically, so lookups can take a reference while holding the shared cache lock. */
 	} refs;
 
 } meta_user_t;
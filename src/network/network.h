@@ -16,6 +16,18 @@
 #include "imap.h"
 #include "http.h"
 
+// The number of one second slots in the poller timeout wheel.
+#define MAGMA_POLLER_WHEEL 1024
+
+// The maximum number of events collected by each call to epoll_wait().
+#define MAGMA_POLLER_EVENTS 256
+
+// The amount of output buffered for each connection, which matches the largest TLS record payload.
+#define MAGMA_NETWORK_OUTPUT 16384
+
+// The number of milliseconds to wait for a socket to become writable before retrying a write.
+#define MAGMA_NETWORK_WAIT 1000
+
 enum {
 	REVERSE_ERROR = -1,
 	REVERSE_EMPTY = 0,
@@ -37,6 +49,9 @@ typedef struct {
 	int status; /* Track whether the last network generated an error. */
 	placer_t line; /* The current line being processed. */
 	stringer_t *buffer; /* The connection buffer. */
+	void *pool; /* The relay pool a client was checked out of, or NULL if the client isn't pooled. */
+	uint32_t options; /* The session options, like the service extensions advertised by the remote host. */
+	time_t idle; /* When the client was last returned to its pool. */
 } client_t;
 
 typedef struct {
@@ -59,6 +74,8 @@ typedef struct {
 		int status; /* Track whether the last network operation generated an error. */
 		placer_t line; /* The current line being processed. */
 		stringer_t *buffer; /* The connection buffer. */
+		stringer_t *output; /* The buffered output waiting to be flushed. */
+		bool_t corked; /* Whether the socket is corked while a large block is being written. */
 
 		struct {
 			ip_t *ip;
@@ -67,6 +84,15 @@ typedef struct {
 		} reverse;
 
 	} network;
+
+	struct {
+		bool_t parked; /* Whether the connection is currently parked inside the poller. */
+		bool_t registered; /* Whether the socket has been added to the poller descriptor. */
+		time_t deadline; /* When a parked connection should be timed out, or zero if it never expires. */
+		void *function; /* The handler enqueued once the connection becomes readable. */
+		void *next, *prev; /* The timeout wheel links. */
+	} poller;
+
 	uint64_t refs; /* The number of memory references or threads pointing at this structure. */
 	pthread_mutex_t lock; /* The mutex used for locking during non-thread save operations. */
 	server_t *server; /* The server instance that accepted the connection. */
@@ -115,6 +141,12 @@ int64_t   client_read_line(client_t *client);
 int64_t   con_read(connection_t *con);
 int64_t   con_read_line(connection_t *con, bool_t block);
 
+/// poller.c
+void     con_poll(connection_t *con, void *function);
+void     poller_loop(void);
+bool_t   poller_start(void);
+void     poller_stop(void);
+
 /// reverse.c
 stringer_t *  con_reverse_check(connection_t *con, uint32_t timeout);
 void          con_reverse_domain(connection_t *con, stringer_t *domain, int_t status);
@@ -130,8 +162,10 @@ void     net_shutdown(server_t *server);
 /// write.c
 int64_t   client_print(client_t *client, chr_t *format, ...);
 int64_t   client_write(client_t *client, stringer_t *s);
+int64_t   con_flush(connection_t *con);
 int64_t   con_print(connection_t *con, chr_t *format, ...);
 int64_t   con_write_bl(connection_t *con, char *block, size_t length);
+int64_t   con_write_iv(connection_t *con, struct iovec *vector, int_t count);
 int64_t   con_write_ns(connection_t *con, char *string);
 int64_t   con_write_pl(connection_t *con, placer_t string);
 int64_t   con_write_st(connection_t *con, stringer_t *string);
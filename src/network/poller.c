@@ -0,0 +1,282 @@
+
+/**
+ * @file /magma/network/poller.c
+ *
+ * @brief	Functions used to park idle connections inside an epoll descriptor, so a connection is only handed to a worker thread once
+ * 			the client has sent data, or the connection has timed out.
+ */
+
+#include "magma.h"
+
+struct {
+	int ed; /* The epoll descriptor holding the parked connections. */
+	time_t sweep; /* The next second of the timeout wheel that needs to be swept. */
+	pthread_t *thread; /* The thread waiting on the epoll descriptor. */
+	pthread_mutex_t lock; /* Protects the parked state of each connection and the timeout wheel. */
+	uint64_t parked; /* The statistic tracking the number of parked connections. */
+	connection_t *wheel[MAGMA_POLLER_WHEEL]; /* Parked connections, bucketed by the second they expire. */
+} poller = {
+	.ed = -1,
+	.thread = NULL
+};
+
+/**
+ * @brief	Add a connection to the timeout wheel.
+ * @note	The caller must be holding the poller lock.
+ * @param	con		the connection being parked.
+ * @return	This function returns no value.
+ */
+void poller_link(connection_t *con) {
+
+	connection_t **slot = &(poller.wheel[con->poller.deadline % MAGMA_POLLER_WHEEL]);
+
+	con->poller.prev = NULL;
+	con->poller.next = *slot;
+
+	if (*slot) {
+		(*slot)->poller.prev = con;
+	}
+
+	*slot = con;
+	con->poller.parked = true;
+	return;
+}
+
+/**
+ * @brief	Remove a connection from the timeout wheel.
+ * @note	The caller must be holding the poller lock.
+ * @param	con		the connection being released.
+ * @return	This function returns no value.
+ */
+void poller_unlink(connection_t *con) {
+
+	if (con->poller.prev) {
+		((connection_t *)con->poller.prev)->poller.next = con->poller.next;
+	}
+	else {
+		poller.wheel[con->poller.deadline % MAGMA_POLLER_WHEEL] = con->poller.next;
+	}
+
+	if (con->poller.next) {
+		((connection_t *)con->poller.next)->poller.prev = con->poller.prev;
+	}
+
+	con->poller.next = con->poller.prev = NULL;
+	con->poller.parked = false;
+	return;
+}
+
+/**
+ * @brief	Release every parked connection whose deadline has passed.
+ * @note	Expired connections are removed from the epoll descriptor and flagged with a network error, so the handler they were parked
+ * 			with will route them to the protocol specific logout/quit logic instead of blocking on a read.
+ * @param	now		the current time.
+ * @return	This function returns no value.
+ */
+void poller_expire(time_t now) {
+
+	connection_t *con, *next, *expired = NULL;
+
+	mutex_lock(&poller.lock);
+
+	for (; poller.sweep <= now; poller.sweep++) {
+		for (con = poller.wheel[poller.sweep % MAGMA_POLLER_WHEEL]; con; con = next) {
+
+			next = con->poller.next;
+
+			// The slot can also hold connections that expire on a later rotation of the wheel, or never expire.
+			if (con->poller.deadline && con->poller.deadline <= now) {
+				poller_unlink(con);
+				epoll_ctl(poller.ed, EPOLL_CTL_DEL, con->network.sockd, NULL);
+				con->poller.registered = false;
+				con->poller.next = expired;
+				expired = con;
+			}
+		}
+	}
+
+	mutex_unlock(&poller.lock);
+
+	// Enqueue the connections after the lock has been released.
+	while ((con = expired)) {
+		expired = con->poller.next;
+		con->poller.next = NULL;
+		con->network.status = -1;
+		stats_decrement_by_num(poller.parked);
+		enqueue(con->poller.function, con);
+	}
+
+	return;
+}
+
+/**
+ * @brief	Hand a connection to the worker pool once the client has sent data.
+ * @note	If the connection already has unprocessed input buffered, either inside the connection buffer or inside the TLS layer,
+ * 			or if the poller isn't available, the handler is enqueued immediately. Otherwise the connection is parked inside
+ * 			the poller until the socket becomes readable, or the server timeout is reached.
+ * @param	con			the connection waiting on client input.
+ * @param	function	the handler to enqueue once the connection is ready.
+ * @return	This function returns no value.
+ */
+void con_poll(connection_t *con, void *function) {
+
+	struct epoll_event event;
+
+	if (poller.ed == -1 || !status() || con_status(con) < 0 || (pl_length_get(con->network.line) &&
+		st_length_get(con->network.buffer) > pl_length_get(con->network.line)) || (con->network.tls && tls_pending(con->network.tls) > 0)) {
+		enqueue(function, con);
+		return;
+	}
+
+	// Send the buffered response before waiting on the client. If the flush fails, the handler will route the connection to the logout logic.
+	else if (con_flush(con) < 0) {
+		enqueue(function, con);
+		return;
+	}
+
+	mm_wipe(&event, sizeof(struct epoll_event));
+	event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+	event.data.ptr = con;
+
+	mutex_lock(&poller.lock);
+
+	con->poller.function = function;
+	con->poller.deadline = con->server->network.timeout ? time(NULL) + con->server->network.timeout : 0;
+	poller_link(con);
+
+	// The descriptor is armed while holding the lock so the poller thread can't observe the event before the connection is parked.
+	if (epoll_ctl(poller.ed, con->poller.registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, con->network.sockd, &event) == -1) {
+		log_pedantic("The epoll_ctl() call returned an error. { error = %s }", strerror_r(errno, MEMORYBUF(1024), 1024));
+		poller_unlink(con);
+		mutex_unlock(&poller.lock);
+		enqueue(function, con);
+		return;
+	}
+
+	con->poller.registered = true;
+	mutex_unlock(&poller.lock);
+
+	stats_increment_by_num(poller.parked);
+	return;
+}
+
+/**
+ * @brief	The poller thread entry point, which waits for parked connections to become readable and enqueues their handlers.
+ * @return	This function returns no value.
+ */
+void poller_loop(void) {
+
+	int ready;
+	bool_t dispatch;
+	connection_t *con;
+	struct epoll_event events[MAGMA_POLLER_EVENTS];
+
+	thread_start();
+
+	do {
+
+		if ((ready = epoll_wait(poller.ed, events, MAGMA_POLLER_EVENTS, 1000)) == -1 && errno != EINTR) {
+			log_info("The connection poller returned an error. { epoll_wait = -1 / error = %s }", strerror_r(errno, MEMORYBUF(1024), 1024));
+		}
+
+		for (int i = 0; i < ready; i++) {
+
+			con = events[i].data.ptr;
+
+			// A connection may have been released by the timeout sweep since the event was armed.
+			mutex_lock(&poller.lock);
+
+			if ((dispatch = con->poller.parked)) {
+				poller_unlink(con);
+			}
+
+			mutex_unlock(&poller.lock);
+
+			if (dispatch) {
+
+				// If the remote host hung up we don't bother trying to read from the socket.
+				if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+					con->network.status = -1;
+				}
+
+				stats_decrement_by_num(poller.parked);
+				enqueue(con->poller.function, con);
+			}
+		}
+
+		poller_expire(time(NULL));
+
+	} while (status());
+
+	thread_stop();
+	return;
+}
+
+/**
+ * @brief	Create the poller descriptor and launch the poller thread.
+ * @return	true on success, or false on failure.
+ */
+bool_t poller_start(void) {
+
+	mm_wipe(poller.wheel, sizeof(poller.wheel));
+	poller.parked = stats_get_name_pos("core.connections.parked");
+
+	if (mutex_init(&poller.lock, NULL)) {
+		log_critical("Unable to initialize the poller lock.");
+		return false;
+	}
+	else if ((poller.ed = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+		log_critical("The epoll_create1() call returned an error. { error = %s }", strerror_r(errno, MEMORYBUF(1024), 1024));
+		mutex_destroy(&poller.lock);
+		return false;
+	}
+
+	poller.sweep = time(NULL);
+
+	if (!(poller.thread = thread_alloc(poller_loop, NULL))) {
+		log_critical("Unable to launch the connection poller thread.");
+		close(poller.ed);
+		poller.ed = -1;
+		mutex_destroy(&poller.lock);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief	Stop the poller thread, and hand any connections still parked back to the worker pool so they can be shutdown.
+ * @note	This function must be called before the worker pool is shutdown.
+ * @return	This function returns no value.
+ */
+void poller_stop(void) {
+
+	connection_t *con;
+
+	if (poller.thread) {
+		thread_join(*poller.thread);
+		mm_free(poller.thread);
+		poller.thread = NULL;
+	}
+
+	mutex_lock(&poller.lock);
+
+	for (uint64_t i = 0; i < MAGMA_POLLER_WHEEL; i++) {
+		while ((con = poller.wheel[i])) {
+			poller_unlink(con);
+			con->network.status = -1;
+			stats_decrement_by_num(poller.parked);
+			enqueue(con->poller.function, con);
+		}
+	}
+
+	mutex_unlock(&poller.lock);
+
+	if (poller.ed != -1) {
+		close(poller.ed);
+		poller.ed = -1;
+	}
+
+	mutex_destroy(&poller.lock);
+	return;
+}
@@ -59,6 +59,11 @@ int64_t con_read_line(connection_t *con, bool_t block) {
 		con->network.line = pl_null();
 	}
 
+	// The client is probably waiting on our response before it sends anything else.
+	if (con_flush(con) < 0) {
+		return -1;
+	}
+
 	// Loop until we get a complete line, an error, or the buffer is filled.
 	do {
 //		blocking = st_length_get(con->network.buffer) ? false : true;
@@ -211,6 +216,11 @@ int64_t con_read(connection_t *con) {
 		con->network.line = pl_null();
 	}
 
+	// The client is probably waiting on our response before it sends anything else.
+	if (con_flush(con) < 0) {
+		return -1;
+	}
+
 	// Loop until the buffer has data or we get an error.
 	do {
 //		blocking = st_length_get(con->network.buffer) ? false : true;
@@ -53,7 +53,14 @@ enum {
 	SMTP_OUTCOME_BOUNCE_VIRUS = 64,
 	SMTP_OUTCOME_BOUNCE_PHISH = 128,
 	SMTP_OUTCOME_BOUNCE_SPAM = 256,
-	SMTP_OUTCOME_BOUNCE_RBL = 512
+	SMTP_OUTCOME_BOUNCE_RBL = 512,
+
+	SMTP_CLIENT_GREETED = 1, // The relay accepted our EHLO/HELO.
+	SMTP_CLIENT_PIPELINING = 2, // The relay advertised the PIPELINING extension.
+	SMTP_CLIENT_DATA = 4, // The relay already accepted a pipelined DATA command.
+	SMTP_CLIENT_PENDING = 8, // Pipelined replies are still outstanding, so the session can't be reused or politely closed.
+
+	SMTP_RELAY_RETRY = 10 // The number of seconds a relay is passed over after a failed connection attempt.
 };
 
 typedef struct {
@@ -13,97 +13,224 @@
 /// so that it is not lost (whether it is to be kept or not).
 
 /**
- * @brief	Write data to a network connection.
- * @note	This function works regardless of whether or not the connection is ssl-enabled.
- * 			If the network write requires multiple system calls, then this code will loop until all the data has been transmitted.
- * @param	con		the connection across which the supplied data will be written.
- * @param	block	a pointer to a data buffer containing the data to be written to the connection's remote client.
- * @param	length	the length, in bytes, of the data buffer to be written.
- * @return	-1 on general network failure, -2 if the connection was reset or closed, or the number of bytes that were written across the connection.
+ * @brief	Wait for a connection's socket to accept more output.
+ * @param	con		the connection being written to.
+ * @return	This function returns no value.
  */
-int64_t con_write_bl(connection_t *con, char *block, size_t length) {
+static void con_write_wait(connection_t *con) {
 
-	int_t counter = 0;
-	ssize_t bytes = 0, position = 0;
-//	stringer_t *ip = NULL, *cipher = NULL, *error = NULL;
+	struct pollfd descriptor = { .fd = con->network.sockd, .events = POLLOUT };
 
-	if (!con || con->network.sockd == -1 || con_status(con) < 0) {
-		return -1;
-	}
-	else if (!block || !length) {
-		con->network.status = 0;
-		return 0;
+	poll(&descriptor, 1, MAGMA_NETWORK_WAIT);
+	return;
+}
+
+/**
+ * @brief	Cork, or uncork, a connection's socket.
+ * @note	While corked the kernel only sends full segments, so the data written after a large block gets coalesced with its tail.
+ * @param	con		the connection being written to.
+ * @param	enable	true to cork the socket, or false to uncork the socket, and send any partial segment.
+ * @return	This function returns no value.
+ */
+static void con_write_cork(connection_t *con, bool_t enable) {
+
+	int_t value = enable ? 1 : 0;
+
+	if (con->network.corked != enable && !setsockopt(con->network.sockd, IPPROTO_TCP, TCP_CORK, &value, sizeof(value))) {
+		con->network.corked = enable;
 	}
 
-	// Loop until all of the bytes have been sent to the client.
+	return;
+}
+
+/**
+ * @brief	Write a vector of data blocks to a network connection.
+ * @note	Plain text connections send the blocks with a single writev() call, while TLS connections write the blocks one at a time.
+ * 			If the socket isn't ready the function waits for it to become writable, and gives up if no progress is made after 128 attempts.
+ * @param	con		the connection across which the supplied data will be written.
+ * @param	vector	an array of blocks to be written, which is updated to reflect the progress being made.
+ * @param	count	the number of blocks in the vector.
+ * @return	-1 on network failure, or the number of bytes that were written across the connection.
+ */
+static int64_t con_write_vector(connection_t *con, struct iovec *vector, int_t count) {
+
+	int_t counter = 0;
+	ssize_t bytes = 0, sent, position = 0;
+
 	do {
 
+		// Skip past the blocks which have been sent, and trim the block which was only partially sent.
+		for (sent = bytes; count && (size_t)sent >= vector->iov_len; count--) {
+			sent -= (vector++)->iov_len;
+		}
+
+		if (!count) {
+			break;
+		}
+		else if (sent) {
+			vector->iov_base += sent;
+			vector->iov_len -= sent;
+		}
+
 		if (con->network.tls) {
-			bytes = tls_write(con->network.tls, block + position, length, true);
+			bytes = tls_write(con->network.tls, vector->iov_base, vector->iov_len, true);
 		}
 		else {
-			bytes = tcp_write(con->network.sockd, block + position, length, true);
+			errno = 0;
+			bytes = writev(con->network.sockd, vector, count < IOV_MAX ? count : IOV_MAX);
+			bytes = tcp_continue(con->network.sockd, bytes, errno);
 		}
 
 		// Handle progress by advancing our position tracker.
 		if (bytes > 0) {
 			counter = 0;
-			length -= bytes;
 			position += bytes;
 		}
 		else if (bytes == 0) {
-			usleep(1000);
+			con_write_wait(con);
 		}
-		else if (bytes < 0) {
+		else {
 			con->network.status = -1;
 			return -1;
 		}
 
-	} while (length && counter++ < 128 && status());
+	} while (counter++ < 128 && status());
 
-	if (bytes > 0) {
-		con->network.status = 1;
+	// A partial write leaves the protocol stream in an unknown state, so the connection can't be used anymore.
+	if (count) {
+		con->network.status = -1;
+		return -1;
 	}
 
+	con->network.status = 1;
 	return position;
+}
 
-			// If zero bytes were written, or a negative value was returned to indicate an error, call tls_erorr(), which will return
-			// NULL if the error can be safely ignored. Otherwise log the output for debug purposes.
-//			if (bytes <= 0 && (error = tls_error(con->network.tls, bytes, MANAGEDBUF(512)))) {
-//				cipher = tls_cipher(con->network.tls, MANAGEDBUF(128));
-//				ip = con_addr_presentation(con, MANAGEDBUF(INET6_ADDRSTRLEN));
-//
-//				log_pedantic("TLS server write operation failed. { ip = %.*s / protocol = %s / %.*s / result = %zi%s%.*s }",
-//					st_length_int(ip), st_char_get(ip), st_char_get(protocol_type(con)), st_length_int(cipher), st_char_get(cipher),
-//					bytes, (error ? " / " : ""), st_length_int(error), st_char_get(error));
-//
-//				con->network.status = -1;
-//				return -1;
-//			}
-			// This will occur when the read operation results in a 0, or negative value, but TLS error returns NULL to
-			// indicate it was a transient error. For transient errors we simply set bytes equal to 0 so the read call gets retried.
-//			else if (bytes <= 0) {
-//				bytes = 0;
-//			}
-//		}
-//		else {
-//
-//
-//
-//			// Check for errors on non-SSL writes in the traditional way.
-//			if (bytes <= 0 && tcp_status(con->network.sockd)) {
-//
-//				int_t local = errno;
-//				ip = con_addr_presentation(con, MANAGEDBUF(INET6_ADDRSTRLEN));
-//
-//				log_pedantic("TCP server write operation failed. { ip = %.*s / result = %zi / error = %i / message = %s }",
-//					st_length_int(ip), st_char_get(ip), bytes, local, strerror_r(local, MEMORYBUF(1024), 1024));
-//
-//				con->network.status = -1;
-//				return -1;
-//			}
-//		}
+/**
+ * @brief	Send any buffered output to a network connection.
+ * @note	This function should be called whenever the server finishes a response and is about to wait on the client. It's called
+ * 			automatically before reading from the connection, before the connection is parked, and before the connection is destroyed.
+ * @param	con		the connection whose output should be flushed.
+ * @return	-1 on network failure, or the number of bytes that were written across the connection.
+ */
+int64_t con_flush(connection_t *con) {
+
+	int64_t result = 0;
+	struct iovec vector;
+
+	if (!con || !con->network.output) {
+		return 0;
+	}
+	else if (con->network.sockd == -1 || con_status(con) < 0) {
+		st_length_set(con->network.output, 0);
+		return -1;
+	}
+
+	if (st_length_get(con->network.output)) {
+		vector.iov_base = st_data_get(con->network.output);
+		vector.iov_len = st_length_get(con->network.output);
+		result = con_write_vector(con, &vector, 1);
+		st_length_set(con->network.output, 0);
+	}
+
+	if (con->network.corked) {
+		con_write_cork(con, false);
+	}
+
+	return result;
+}
+
+/**
+ * @brief	Write a vector of data blocks to a network connection.
+ * @note	This function works regardless of whether or not the connection is ssl-enabled.
+ * 			Small writes are appended to the connection's output buffer, which is sent once it fills up, or the connection is flushed.
+ * 			Writes too large for the buffer are sent along with the buffered output using a single vectored write, and the socket
+ * 			is corked until the next flush, so the remainder of the response is coalesced with the tail of the data.
+ * @param	con		the connection across which the supplied data will be written.
+ * @param	vector	an array of blocks containing the data to be written to the connection's remote client.
+ * @param	count	the number of blocks in the vector.
+ * @return	-1 on general network failure, -2 if the connection was reset or closed, or the number of bytes that were written across the connection.
+ */
+int64_t con_write_iv(connection_t *con, struct iovec *vector, int_t count) {
+
+	int_t used = 0;
+	int64_t result;
+	size_t length = 0;
+	struct iovec *combined;
+
+	if (!con || con->network.sockd == -1 || con_status(con) < 0) {
+		return -1;
+	}
+
+	for (int_t i = 0; vector && i < count; i++) {
+		length += vector[i].iov_len;
+	}
+
+	if (!length) {
+		con->network.status = 0;
+		return 0;
+	}
+
+	// If the output buffer can't be allocated, the data is written directly.
+	if (!con->network.output && !(con->network.output = st_alloc(MAGMA_NETWORK_OUTPUT))) {
+		log_pedantic("Unable to allocate a network output buffer of %u bytes.", MAGMA_NETWORK_OUTPUT);
+	}
+
+	else if (length < st_avail_get(con->network.output)) {
+
+		// Flush the buffer if there isn't enough room left for the data.
+		if (st_length_get(con->network.output) + length > st_avail_get(con->network.output) && con_flush(con) < 0) {
+			return -1;
+		}
+
+		for (int_t i = 0; i < count; i++) {
+			mm_copy(st_data_get(con->network.output) + st_length_get(con->network.output), vector[i].iov_base, vector[i].iov_len);
+			st_length_set(con->network.output, st_length_get(con->network.output) + vector[i].iov_len);
+		}
+
+		con->network.status = 1;
+		return length;
+	}
+
+	// The vector is copied, so the buffered output can be prepended, and because the copy is updated as the data is sent.
+	if (!(combined = mm_alloc(sizeof(struct iovec) * (count + 1)))) {
+		con->network.status = -1;
+		return -1;
+	}
+
+	if (con->network.output && st_length_get(con->network.output)) {
+		combined[used].iov_base = st_data_get(con->network.output);
+		combined[used++].iov_len = st_length_get(con->network.output);
+	}
+
+	if (con->network.output) {
+		con_write_cork(con, true);
+	}
+
+	mm_copy(combined + used, vector, sizeof(struct iovec) * count);
+	result = con_write_vector(con, combined, used + count);
+	mm_free(combined);
+
+	if (con->network.output) {
+		st_length_set(con->network.output, 0);
+	}
+
+	return result < 0 ? -1 : length;
+}
+
+/**
+ * @brief	Write data to a network connection.
+ * @see		con_write_iv()
+ * @param	con		the connection across which the supplied data will be written.
+ * @param	block	a pointer to a data buffer containing the data to be written to the connection's remote client.
+ * @param	length	the length, in bytes, of the data buffer to be written.
+ * @return	-1 on general network failure, -2 if the connection was reset or closed, or the number of bytes that were written across the connection.
+ */
+int64_t con_write_bl(connection_t *con, char *block, size_t length) {
+
+	struct iovec vector = { .iov_base = block, .iov_len = block ? length : 0 };
 
+	return con_write_iv(con, &vector, 1);
 }
 
 /**
@@ -10,19 +10,128 @@
 #define MAGMA_LOCK_TIMEOUT 60
 #define MAGMA_LOCK_EXPIRATION 600
 
+/// The first and longest delays, in microseconds, between attempts to acquire a contended lock, and the number of local queue buckets.
+#define MAGMA_LOCK_BACKOFF_MIN 1000
+#define MAGMA_LOCK_BACKOFF_MAX 100000
+#define MAGMA_LOCK_QUEUES 64
+
+/// The threads in this process waiting on a single lock name. Only the thread which is polling memcached has the turn.
+typedef struct lock_queue_t {
+	chr_t name[128];
+	size_t length;
+	bool_t polling;
+	uint32_t waiters;
+	pthread_cond_t turn;
+	struct lock_queue_t *next;
+} lock_queue_t;
+
+/// The bucket mutex only protects the list of queues, and is never held while polling, so unrelated names don't block each other.
+struct {
+	pthread_mutex_t mutex;
+	lock_queue_t *queues;
+} lock_buckets[MAGMA_LOCK_QUEUES] = {
+	[0 ... (MAGMA_LOCK_QUEUES - 1)] = { .mutex = PTHREAD_MUTEX_INITIALIZER, .queues = NULL }
+};
+
+/**
+ * @brief	Join the local queue for a lock name, and wait until it's our turn to poll memcached.
+ * @note	The caller must be holding the bucket mutex, which is released while waiting.
+ * @param	bucket		the index of the bucket holding the queue.
+ * @param	lock		a managed string containing the name of the lock.
+ * @param	deadline	the time at which to give up waiting.
+ * @return	NULL if the queue couldn't be allocated or the deadline passed, or a pointer to the queue, with the turn held.
+ */
+lock_queue_t * lock_queue_join(uint32_t bucket, stringer_t *lock, struct timespec *deadline) {
+
+	lock_queue_t *queue, **link;
+
+	for (queue = lock_buckets[bucket].queues; queue && (queue->length != st_length_get(lock) ||
+		memcmp(queue->name, st_data_get(lock), queue->length)); queue = queue->next);
+
+	if (!queue) {
+
+		if (st_length_get(lock) > sizeof(queue->name) || !(queue = mm_alloc(sizeof(lock_queue_t)))) {
+			return NULL;
+		}
+		else if (pthread_cond_init(&(queue->turn), NULL)) {
+			mm_free(queue);
+			return NULL;
+		}
+
+		mm_copy(queue->name, st_data_get(lock), st_length_get(lock));
+		queue->length = st_length_get(lock);
+		queue->next = lock_buckets[bucket].queues;
+		lock_buckets[bucket].queues = queue;
+	}
+
+	queue->waiters++;
+
+	while (queue->polling && !pthread_cond_timedwait(&(queue->turn), &(lock_buckets[bucket].mutex), deadline));
+
+	// If the thread ahead of us still has the turn, give up our place, and free the queue if we were the last one waiting.
+	if (queue->polling) {
+
+		if (!--(queue->waiters)) {
+			for (link = &(lock_buckets[bucket].queues); *link != queue; link = &((*link)->next));
+			*link = queue->next;
+			pthread_cond_destroy(&(queue->turn));
+			mm_free(queue);
+		}
+
+		return NULL;
+	}
+
+	queue->polling = true;
+
+	return queue;
+}
+
+/**
+ * @brief	Give up the turn to poll memcached for a lock name, handing it to the next waiting thread, if there is one.
+ * @note	The caller must be holding the bucket mutex.
+ * @param	bucket	the index of the bucket holding the queue.
+ * @param	queue	the queue being left.
+ * @return	This function returns no value.
+ */
+void lock_queue_leave(uint32_t bucket, lock_queue_t *queue) {
+
+	lock_queue_t **link;
+
+	queue->polling = false;
+
+	if (--(queue->waiters)) {
+		pthread_cond_signal(&(queue->turn));
+		return;
+	}
+
+	for (link = &(lock_buckets[bucket].queues); *link != queue; link = &((*link)->next));
+	*link = queue->next;
+	pthread_cond_destroy(&(queue->turn));
+	mm_free(queue);
+
+	return;
+}
+
  /**
   * @brief	Acquire a named lock, with synchronization provided via memcached.
   * @see	cache_silent_add()
-  * @note	The lock will be held for 10 seconds, and locking attempts will occur periodically for 60 seconds prior to failure.
+  * @note	The lock will be held for 10 minutes, and locking attempts will continue for 60 seconds prior to failure.
+  *
+  * 		Threads in this process waiting on the same lock name are queued, so only the thread at the head of the queue polls
+  * 		memcached. While the lock is held elsewhere, the delay between attempts starts at a millisecond and doubles, with some
+  * 		jitter, until it reaches a tenth of a second, so short critical sections are picked up quickly without a thundering herd
+  * 		of requests against the cache server.
   * @param	key		a managed string containing the name of the lock to be acquired.
   * @return	-1 on general failure, 0 on memcached failure, or 1 on success.
   */
 int_t lock_get(stringer_t *key) {
 
-	uint64_t value;
+	uint32_t bucket;
+	int_t success = 0;
+	lock_queue_t *queue;
+	struct timespec deadline, delay;
 	stringer_t *lock = MANAGEDBUF(128);
-	int_t success, iterations = (MAGMA_LOCK_TIMEOUT * 10);
-	const struct timespec delay = { .tv_sec = 0, .tv_nsec = 100000000 };
+	uint64_t value, backoff = MAGMA_LOCK_BACKOFF_MIN, started, wait;
 
 	// Build the key.
 	if (st_empty(key) || st_sprint(lock, "%.*s.lock", st_length_int(key), st_char_get(key)) <= 0) {
@@ -32,15 +141,40 @@ int_t lock_get(stringer_t *key) {
 
 	// Build the lock value.
 	value = time(NULL);
+	started = time_microseconds();
+
+	// Wait for our turn in the local queue for this lock name.
+	bucket = hash_murmur32(st_data_get(lock), st_length_get(lock)) % MAGMA_LOCK_QUEUES;
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += MAGMA_LOCK_TIMEOUT;
+
+	pthread_mutex_lock(&(lock_buckets[bucket].mutex));
+	queue = lock_queue_join(bucket, lock, &deadline);
+	pthread_mutex_unlock(&(lock_buckets[bucket].mutex));
 
-	do {
+	if (!queue) {
+		log_pedantic("Unable to obtain a cache lock for %.*s.", st_length_int(lock), st_char_get(lock));
+		return 0;
+	}
+
+	// Keep the lock for ten minutes.
+	while ((success = cache_silent_add(lock, PLACER(&value, sizeof(uint64_t)), MAGMA_LOCK_EXPIRATION)) != 1 &&
+		time_microseconds() - started < (MAGMA_LOCK_TIMEOUT * 1000000UL)) {
 
-		// Keep the lock for ten minutes.
-		if ((success = cache_silent_add(lock, PLACER(&value, sizeof(uint64_t)), MAGMA_LOCK_EXPIRATION)) != 1) {
-				nanosleep(&delay, NULL);
+		// Sleep somewhere between half and all of the current backoff interval, then double it.
+		wait = (backoff / 2) + (rand_get_uint32() % ((backoff / 2) + 1));
+		delay.tv_sec = wait / 1000000;
+		delay.tv_nsec = (wait % 1000000) * 1000;
+		nanosleep(&delay, NULL);
+
+		if ((backoff *= 2) > MAGMA_LOCK_BACKOFF_MAX) {
+			backoff = MAGMA_LOCK_BACKOFF_MAX;
 		}
+	}
 
-	} while (success != 1 && iterations--);
+	pthread_mutex_lock(&(lock_buckets[bucket].mutex));
+	lock_queue_leave(bucket, queue);
+	pthread_mutex_unlock(&(lock_buckets[bucket].mutex));
 
 	if (success != 1) {
 		log_pedantic("Unable to obtain a cache lock for %.*s.", st_length_int(lock), st_char_get(lock));
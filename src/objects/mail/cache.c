@@ -2,12 +2,30 @@
 /**
  * @file /magma/objects/mail/cache.c
  *
- * @brief	Functions used to cache a mail message in its parsed form.
+ * @brief	Functions used to cache decompressed message text, so repeated requests for the same message don't go back to disk, along
+ * 			with the IMAP BODYSTRUCTURE computed from it.
+ * @note	The cache is shared by every thread, and split into shards selected by message number, each with its own lock, hash table
+ * 			and least recently used list. The total size of the cached text is bounded by the magma.storage.cache setting.
  */
 
 #include "magma.h"
 
-static pthread_key_t mail_cache;
+typedef struct {
+	pthread_mutex_t lock;
+	size_t bytes; /* The number of bytes currently held by this shard. */
+	mail_cache_t *newest, *oldest; /* The least recently used list, ordered by the last time an entry was retrieved. */
+	mail_cache_t *buckets[MAIL_CACHE_BUCKETS];
+} mail_cache_shard_t;
+
+static struct {
+	bool_t started;
+	mail_cache_shard_t shards[MAIL_CACHE_SHARDS];
+	struct {
+		uint64_t hits, misses, evictions;
+	} stats;
+} mail_cache = {
+	.started = false
+};
 
 /**
  * @brief	Free a cached mail message.
@@ -20,6 +38,7 @@ void mail_cache_destroy(void *holder) {
 
 	 if (message) {
 		 st_cleanup(message->text);
+		 st_cleanup(message->structure);
 		 mm_free(message);
 	 }
 
@@ -27,116 +46,390 @@ void mail_cache_destroy(void *holder) {
 }
 
 /**
- * @brief	Initialize the thread-specific data key used for the mail message cache.
- * @return	true on success or false on failure.
+ * @brief	Get the shard responsible for a message.
+ * @param	messagenum	the numerical id of the message.
+ * @return	a pointer to the cache shard.
  */
-bool_t mail_cache_start(void) {
+mail_cache_shard_t * mail_cache_shard(uint64_t messagenum) {
 
-	 if (pthread_key_create(&mail_cache, mail_cache_destroy) != 0) {
-		 log_pedantic("Unable to create the thread local message cache.");
-		 return false;
-	 }
+	return &(mail_cache.shards[messagenum % MAIL_CACHE_SHARDS]);
+}
+
+/**
+ * @brief	Get the hash bucket used to hold a message inside its shard.
+ * @param	shard		the cache shard responsible for the message.
+ * @param	messagenum	the numerical id of the message.
+ * @return	a pointer to the head of the hash bucket.
+ */
+mail_cache_t ** mail_cache_bucket(mail_cache_shard_t *shard, uint64_t messagenum) {
+
+	return &(shard->buckets[(messagenum / MAIL_CACHE_SHARDS) % MAIL_CACHE_BUCKETS]);
+}
+
+/**
+ * @brief	Get the size of a cached message, which is the amount charged against the cache limit.
+ * @param	message		the cached message.
+ * @return	the number of bytes used by the message.
+ */
+size_t mail_cache_size(mail_cache_t *message) {
 
-	 return true;
+	return sizeof(mail_cache_t) + (message->text ? st_length_get(message->text) : 0) + (message->structure ? st_length_get(message->structure) : 0);
 }
 
 /**
- * @brief	Destroy the thread-specific data key used for the mail message cache.
+ * @brief	Remove a message from the least recently used list of its shard.
+ * @note	The caller must be holding the shard lock.
+ * @param	shard		the cache shard holding the message.
+ * @param	message		the cached message.
  * @return	This function returns no value.
  */
-void mail_cache_stop(void) {
+void mail_cache_detach(mail_cache_shard_t *shard, mail_cache_t *message) {
+
+	if (message->newer) message->newer->older = message->older;
+	else shard->newest = message->older;
+
+	if (message->older) message->older->newer = message->newer;
+	else shard->oldest = message->newer;
+
+	message->newer = message->older = NULL;
+	return;
+}
+
+/**
+ * @brief	Place a message at the front of the least recently used list of its shard.
+ * @note	The caller must be holding the shard lock.
+ * @param	shard		the cache shard holding the message.
+ * @param	message		the cached message.
+ * @return	This function returns no value.
+ */
+void mail_cache_attach(mail_cache_shard_t *shard, mail_cache_t *message) {
+
+	message->newer = NULL;
+	message->older = shard->newest;
+
+	if (shard->newest) shard->newest->newer = message;
+	else shard->oldest = message;
+
+	shard->newest = message;
+	return;
+}
+
+/**
+ * @brief	Remove a message from its shard entirely.
+ * @note	The caller must be holding the shard lock, and is responsible for freeing the message.
+ * @param	shard		the cache shard holding the message.
+ * @param	message		the cached message.
+ * @return	This function returns no value.
+ */
+void mail_cache_unlink(mail_cache_shard_t *shard, mail_cache_t *message) {
 
-	if (pthread_key_delete(mail_cache) != 0) {
-		log_pedantic("Unable to delete the thread local message cache.");
+	mail_cache_t **bucket = mail_cache_bucket(shard, message->messagenum);
+
+	while (*bucket && *bucket != message) {
+		bucket = &((*bucket)->chain);
+	}
+
+	if (*bucket) {
+		*bucket = message->chain;
 	}
 
+	mail_cache_detach(shard, message);
+	shard->bytes -= mail_cache_size(message);
+	message->chain = NULL;
+
 	return;
 }
 
 /**
- * @brief	Free the thread-specific data for the mail message cache.
+ * @brief	Find a message inside a shard.
+ * @note	The caller must be holding the shard lock.
+ * @param	shard		the cache shard responsible for the message.
+ * @param	messagenum	the numerical id of the message.
+ * @return	NULL if the message isn't cached, or a pointer to the cached message.
+ */
+mail_cache_t * mail_cache_find(mail_cache_shard_t *shard, uint64_t messagenum) {
+
+	mail_cache_t *message = *mail_cache_bucket(shard, messagenum);
+
+	while (message && message->messagenum != messagenum) {
+		message = message->chain;
+	}
+
+	return message;
+}
+
+/**
+ * @brief	Initialize the shared mail message cache.
+ * @return	true on success or false on failure.
+ */
+bool_t mail_cache_start(void) {
+
+	mm_wipe(mail_cache.shards, sizeof(mail_cache.shards));
+
+	for (uint_t i = 0; i < MAIL_CACHE_SHARDS; i++) {
+		if (mutex_init(&(mail_cache.shards[i].lock), NULL)) {
+			log_pedantic("Unable to initialize the message cache locks.");
+
+			for (uint_t j = 0; j < i; j++) {
+				mutex_destroy(&(mail_cache.shards[j].lock));
+			}
+
+			return false;
+		}
+	}
+
+	mail_cache.stats.hits = stats_get_name_pos("objects.mail.cache.hits");
+	mail_cache.stats.misses = stats_get_name_pos("objects.mail.cache.misses");
+	mail_cache.stats.evictions = stats_get_name_pos("objects.mail.cache.evictions");
+	mail_cache.started = true;
+
+	return true;
+}
+
+/**
+ * @brief	Free every cached message and destroy the shared mail message cache.
  * @return	This function returns no value.
  */
-void mail_cache_thread_stop(void) {
+void mail_cache_stop(void) {
 
-	mail_cache_t *message;
+	if (!mail_cache.started) {
+		return;
+	}
 
-	if ((message = pthread_getspecific(mail_cache))) {
-		mail_cache_destroy(message);
-		pthread_setspecific(mail_cache, NULL);
+	mail_cache_reset();
+	mail_cache.started = false;
+
+	for (uint_t i = 0; i < MAIL_CACHE_SHARDS; i++) {
+		mutex_destroy(&(mail_cache.shards[i].lock));
 	}
 
 	return;
 }
 
 /**
- * @brief	Attempt to retrieve the contents of a message from the thread's cached data.
- * @note	The thread's cache only has the capacity to store a single message.
+ * @brief	Attempt to retrieve the contents of a message from the shared message cache.
  * @param	messagenum		the id of the message to be retrieved.
- * @return	NULL on failure or a managed string containing the message data on success.
+ * @return	NULL on failure or a managed string containing a copy of the message data on success.
  */
 stringer_t * mail_cache_get(uint64_t messagenum) {
 
+	stringer_t *result = NULL;
 	mail_cache_t *message;
+	mail_cache_shard_t *shard;
 
-	if (!(message = pthread_getspecific(mail_cache))) {
+	if (!mail_cache.started) {
 		return NULL;
 	}
 
-	if (message->messagenum == messagenum) {
-		return st_dupe(message->text);
+	shard = mail_cache_shard(messagenum);
+	mutex_lock(&(shard->lock));
+
+	if ((message = mail_cache_find(shard, messagenum)) && message->text) {
+		mail_cache_detach(shard, message);
+		mail_cache_attach(shard, message);
+		result = st_dupe(message->text);
 	}
 
-	return NULL;
+	mutex_unlock(&(shard->lock));
+
+	stats_increment_by_num(result ? mail_cache.stats.hits : mail_cache.stats.misses);
+	return result;
 }
 
 /**
- * @brief	Reset the thread's mail cache and free any held message.
+ * @brief	Free every message held by the shared message cache.
  * @return	This function returns no value.
  */
 void mail_cache_reset(void) {
 
 	mail_cache_t *message;
+	mail_cache_shard_t *shard;
+
+	for (uint_t i = 0; mail_cache.started && i < MAIL_CACHE_SHARDS; i++) {
+
+		shard = &(mail_cache.shards[i]);
+		mutex_lock(&(shard->lock));
 
-	if ((message = pthread_getspecific(mail_cache))) {
-		st_cleanup(message->text);
-		message->text = NULL;
-		message->messagenum = 0;
-		mm_free(message);
-		pthread_setspecific(mail_cache, NULL);
+		while ((message = shard->oldest)) {
+			mail_cache_unlink(shard, message);
+			mail_cache_destroy(message);
+		}
+
+		mutex_unlock(&(shard->lock));
 	}
 
 	return;
 }
 
 /**
- * @brief	Set the contents of the thread's mail cache.
+ * @brief	Add the contents of a message to the shared message cache.
+ * @note	If the shard is over its share of the magma.storage.cache limit, the least recently used messages are evicted. Messages too
+ * 			large to fit inside a single shard aren't cached.
  * @param	messagenum	the numerical id of the message to be cached.
- * @text	a managed string containing the contents of the specified message to be cached.
+ * @param	text		a managed string containing the contents of the specified message to be cached.
  * @return	This function returns no value.
  */
 void mail_cache_set(uint64_t messagenum, stringer_t *text) {
 
+	size_t limit;
+	mail_cache_shard_t *shard;
+	mail_cache_t *message, *existing, *evicted = NULL;
+
+	limit = magma.storage.cache / MAIL_CACHE_SHARDS;
+
+	if (!mail_cache.started || st_empty(text) || sizeof(mail_cache_t) + st_length_get(text) > limit) {
+		return;
+	}
+
+	// Copy the message before acquiring the lock.
+	if (!(message = mm_alloc(sizeof(mail_cache_t))) || !(message->text = st_dupe_opts(MANAGED_T | HEAP | CONTIGUOUS, text))) {
+		log_pedantic("Unable to allocate memory for the message cache.");
+		mail_cache_destroy(message);
+		return;
+	}
+
+	message->messagenum = messagenum;
+	shard = mail_cache_shard(messagenum);
+
+	mutex_lock(&(shard->lock));
+
+	// Another thread may have loaded the same message while we were reading it. Keep the structure if it was already computed.
+	if ((existing = mail_cache_find(shard, messagenum))) {
+		mail_cache_unlink(shard, existing);
+		message->structure = existing->structure;
+		existing->structure = NULL;
+		existing->older = evicted;
+		evicted = existing;
+	}
+
+	message->chain = *mail_cache_bucket(shard, messagenum);
+	*mail_cache_bucket(shard, messagenum) = message;
+	mail_cache_attach(shard, message);
+	shard->bytes += mail_cache_size(message);
+
+	while (shard->bytes > limit && shard->oldest != message) {
+		existing = shard->oldest;
+		mail_cache_unlink(shard, existing);
+		existing->older = evicted;
+		evicted = existing;
+		stats_increment_by_num(mail_cache.stats.evictions);
+	}
+
+	mutex_unlock(&(shard->lock));
+
+	// Free the replaced and evicted messages after the lock has been released.
+	while ((message = evicted)) {
+		evicted = message->older;
+		mail_cache_destroy(message);
+	}
+
+	return;
+}
+
+/**
+ * @brief	Attempt to retrieve the IMAP BODYSTRUCTURE of a message from the shared message cache.
+ * @param	messagenum		the id of the message.
+ * @return	NULL if the structure isn't cached, or a managed string containing a copy of the structure.
+ */
+stringer_t * mail_cache_get_structure(uint64_t messagenum) {
+
+	stringer_t *result = NULL;
 	mail_cache_t *message;
+	mail_cache_shard_t *shard;
 
-	if (!(message = pthread_getspecific(mail_cache))) {
+	if (!mail_cache.started) {
+		return NULL;
+	}
 
-		if (!(message = mm_alloc(sizeof(mail_cache_t)))) {
-			return;
-		}
+	shard = mail_cache_shard(messagenum);
+	mutex_lock(&(shard->lock));
+
+	if ((message = mail_cache_find(shard, messagenum)) && message->structure) {
+		mail_cache_detach(shard, message);
+		mail_cache_attach(shard, message);
+		result = st_dupe(message->structure);
+	}
+
+	mutex_unlock(&(shard->lock));
+
+	return result;
+}
+
+/**
+ * @brief	Add the IMAP BODYSTRUCTURE of a message to the shared message cache.
+ * @note	Computing the structure means loading and parsing the entire message, and clients ask for it every time they synchronize a
+ * 			folder, so the result is kept alongside the message text. If the text isn't cached, because it was mapped from disk or
+ * 			has been evicted, an entry holding only the structure is created. The structure is charged against the same limit.
+ * @param	messagenum	the numerical id of the message.
+ * @param	structure	a managed string containing the structure.
+ * @return	This function returns no value.
+ */
+void mail_cache_set_structure(uint64_t messagenum, stringer_t *structure) {
+
+	size_t limit;
+	stringer_t *copy;
+	mail_cache_shard_t *shard;
+	mail_cache_t *message, *existing, *evicted = NULL;
+
+	limit = magma.storage.cache / MAIL_CACHE_SHARDS;
+
+	if (!mail_cache.started || st_empty(structure) || sizeof(mail_cache_t) + st_length_get(structure) > limit) {
+		return;
+	}
 
-		if (pthread_setspecific(mail_cache, message) != 0) {
-			log_pedantic("Unable to setup thread message cache.");
-			mm_free(message);
-			return;
+	// Allocate everything before acquiring the lock, in case the message doesn't have an entry yet.
+	if (!(message = mm_alloc(sizeof(mail_cache_t))) || !(copy = st_dupe_opts(MANAGED_T | HEAP | CONTIGUOUS, structure))) {
+		log_pedantic("Unable to allocate memory for the message cache.");
+		mail_cache_destroy(message);
+		return;
+	}
+
+	message->messagenum = messagenum;
+	shard = mail_cache_shard(messagenum);
+
+	mutex_lock(&(shard->lock));
+
+	if ((existing = mail_cache_find(shard, messagenum))) {
+
+		// Only the first structure computed is stored, since they will all be the same.
+		if (!existing->structure) {
+			existing->structure = copy;
+			shard->bytes += st_length_get(copy);
+			copy = NULL;
 		}
+
+		mail_cache_detach(shard, existing);
+		mail_cache_attach(shard, existing);
+		message->older = evicted;
+		evicted = message;
+		message = existing;
 	}
 	else {
-		st_cleanup(message->text);
+		message->structure = copy;
+		message->chain = *mail_cache_bucket(shard, messagenum);
+		*mail_cache_bucket(shard, messagenum) = message;
+		mail_cache_attach(shard, message);
+		shard->bytes += mail_cache_size(message);
+		copy = NULL;
 	}
 
-	message->messagenum = messagenum;
-	message->text = st_dupe_opts(MANAGED_T | HEAP | CONTIGUOUS, text);
+	while (shard->bytes > limit && shard->oldest != message) {
+		existing = shard->oldest;
+		mail_cache_unlink(shard, existing);
+		existing->older = evicted;
+		evicted = existing;
+		stats_increment_by_num(mail_cache.stats.evictions);
+	}
+
+	mutex_unlock(&(shard->lock));
+
+	// Free the unused allocations and evicted messages after the lock has been released.
+	while ((message = evicted)) {
+		evicted = message->older;
+		mail_cache_destroy(message);
+	}
+
+	st_cleanup(copy);
 
 	return;
 }
@@ -422,3 +422,138 @@ uint64_t mail_db_insert_duplicate_message(uint64_t usernum, uint64_t foldernum,
 
 	return result;
 }
+
+/**
+ * @brief	Store the summary of a newly inserted message.
+ * @param	messagenum	the numerical id of the message being summarized.
+ * @param	summary		a pointer to the summary of the message.
+ * @param	transaction	the transaction id for the database operation, in case the caller wants to roll back the transaction.
+ * @return	true on success or false on failure.
+ */
+bool_t mail_db_insert_summary(uint64_t messagenum, mail_summary_t *summary, int_t transaction) {
+
+	MYSQL_BIND parameters[4];
+
+	if (!messagenum || !summary || st_empty(summary->envelope) || st_empty(summary->header) || transaction < 0) {
+		log_pedantic("Passed an invalid message summary parameter.");
+		return false;
+	}
+
+	mm_wipe(parameters, sizeof(parameters));
+
+	// Messagenum
+	parameters[0].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[0].buffer_length = sizeof(uint64_t);
+	parameters[0].buffer = &messagenum;
+	parameters[0].is_unsigned = true;
+
+	// Envelope
+	parameters[1].buffer_type = MYSQL_TYPE_STRING;
+	parameters[1].buffer_length = st_length_get(summary->envelope);
+	parameters[1].buffer = st_char_get(summary->envelope);
+
+	// Body structure
+	if (!st_empty(summary->structure)) {
+		parameters[2].buffer_type = MYSQL_TYPE_STRING;
+		parameters[2].buffer_length = st_length_get(summary->structure);
+		parameters[2].buffer = st_char_get(summary->structure);
+	}
+	else {
+		parameters[2].buffer_type = MYSQL_TYPE_STRING;
+		parameters[2].is_null = ISNULL(true);
+	}
+
+	// Header
+	parameters[3].buffer_type = MYSQL_TYPE_STRING;
+	parameters[3].buffer_length = st_length_get(summary->header);
+	parameters[3].buffer = st_char_get(summary->header);
+
+	if (!stmt_exec_conn(stmts.insert_message_summary, parameters, transaction)) {
+		log_pedantic("Unable to store the message summary. { messagenum = %lu }", messagenum);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief	Give a copied message the summary of the original message.
+ * @note	Messages stored without a summary are ignored, so this function only fails if the query does.
+ * @param	original	the numerical id of the message being copied.
+ * @param	messagenum	the numerical id of the new copy.
+ * @param	transaction	the transaction id for the database operation, in case the caller wants to roll back the transaction.
+ * @return	true on success or false on failure.
+ */
+bool_t mail_db_copy_summary(uint64_t original, uint64_t messagenum, int_t transaction) {
+
+	MYSQL_BIND parameters[2];
+
+	if (!original || !messagenum || transaction < 0) {
+		log_pedantic("Passed an invalid message summary parameter.");
+		return false;
+	}
+
+	mm_wipe(parameters, sizeof(parameters));
+
+	// Messagenum
+	parameters[0].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[0].buffer_length = sizeof(uint64_t);
+	parameters[0].buffer = &messagenum;
+	parameters[0].is_unsigned = true;
+
+	// Original
+	parameters[1].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[1].buffer_length = sizeof(uint64_t);
+	parameters[1].buffer = &original;
+	parameters[1].is_unsigned = true;
+
+	if (stmt_exec_affected_conn(stmts.copy_message_summary, parameters, transaction) < 0) {
+		log_pedantic("Unable to copy the message summary. { original = %lu / messagenum = %lu }", original, messagenum);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief	Fetch the summary of a message.
+ * @param	messagenum	the numerical id of the message.
+ * @return	NULL if the message doesn't have a summary, or a pointer to the message summary on success.
+ */
+mail_summary_t * mail_db_fetch_summary(uint64_t messagenum) {
+
+	row_t *row;
+	table_t *result;
+	MYSQL_BIND parameters[1];
+	mail_summary_t *summary;
+
+	mm_wipe(parameters, sizeof(parameters));
+
+	// Messagenum
+	parameters[0].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[0].buffer_length = sizeof(uint64_t);
+	parameters[0].buffer = &messagenum;
+	parameters[0].is_unsigned = true;
+
+	if (!(result = stmt_get_result(stmts.select_message_summary, parameters))) {
+		return NULL;
+	}
+	else if (!(row = res_row_next(result)) || !(summary = mm_alloc(sizeof(mail_summary_t)))) {
+		res_table_free(result);
+		return NULL;
+	}
+
+	// The body structure is optional.
+	summary->envelope = res_field_string(row, 0);
+	summary->structure = res_field_string(row, 1);
+	summary->header = res_field_string(row, 2);
+	res_table_free(result);
+
+	if (!summary->envelope || !summary->header) {
+		log_pedantic("The stored message summary is incomplete. { messagenum = %lu }", messagenum);
+		mail_summary_free(summary);
+		return NULL;
+	}
+
+	return summary;
+}
@@ -0,0 +1,314 @@
+
+/**
+ * @file /magma/objects/mail/frames.c
+ *
+ * @brief	Functions used to compress messages in independent frames, and to stream a range of a stored message back out.
+ */
+
+#include "magma.h"
+
+/**
+ * @brief	Check that a frame table is consistent with the message length and the amount of compressed data available.
+ * @param	head		a pointer to the frame header.
+ * @param	ends		a pointer to the table holding the offset where each compressed frame ends.
+ * @param	available	the number of bytes of compressed frame data which follow the table.
+ * @return	true if the table is valid, or false if it is corrupted.
+ */
+bool_t mail_frames_valid(mail_frames_head_t *head, uint64_t *ends, size_t available) {
+
+	if (head->magic != MAIL_FRAMES_MAGIC || !head->frame || !head->length || head->count != ((head->length + head->frame - 1) / head->frame)) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < head->count; i++) {
+		if (ends[i] <= (i ? ends[i - 1] : 0) || ends[i] > available) {
+			return false;
+		}
+	}
+
+	return ends[head->count - 1] == available;
+}
+
+/**
+ * @brief	Decompress a single frame.
+ * @param	head	a pointer to the frame header.
+ * @param	frame	the zero-based index of the frame being decompressed.
+ * @param	data	a placer pointing to the compressed frame.
+ * @return	NULL on failure, or a managed string containing the uncompressed frame on success.
+ */
+stringer_t * mail_frames_decompress_frame(mail_frames_head_t *head, uint32_t frame, placer_t data) {
+
+	compress_t *compressed;
+	stringer_t *result = NULL;
+	size_t expected = frame + 1 == head->count ? head->length - ((uint64_t)frame * head->frame) : head->frame;
+
+	if (!(compressed = compress_import(&data)) || !(result = decompress_lzo(compressed)) || st_length_get(result) != expected) {
+		log_pedantic("Unable to decompress a message frame. { frame = %u / expected = %zu }", frame, expected);
+		st_cleanup(result);
+		return NULL;
+	}
+
+	return result;
+}
+
+/**
+ * @brief	Compress a message in independent frames.
+ * @note	Each frame holds MAIL_FRAMES_LENGTH bytes of the message, except for the last one, and is compressed on its own, so any
+ * 			range of the message can be recovered by decompressing only the frames which overlap it. The result holds the frame
+ * 			header, followed by a table with the offset where each compressed frame ends, followed by the frames themselves.
+ * @param	message		a managed string containing the message to be compressed.
+ * @return	NULL on failure, or a managed string containing the compressed frames on success.
+ */
+stringer_t * mail_frames_compress(stringer_t *message) {
+
+	size_t length;
+	uint64_t *ends;
+	compress_t **frames;
+	mail_frames_head_t head;
+	stringer_t *result = NULL;
+	uint64_t total = 0;
+
+	if (st_empty(message)) {
+		log_pedantic("Unable to compress an empty message.");
+		return NULL;
+	}
+
+	head.magic = MAIL_FRAMES_MAGIC;
+	head.frame = MAIL_FRAMES_LENGTH;
+	head.length = st_length_get(message);
+	head.count = (head.length + head.frame - 1) / head.frame;
+
+	if (!(frames = mm_alloc(head.count * sizeof(compress_t *))) || !(ends = mm_alloc(head.count * sizeof(uint64_t)))) {
+		log_pedantic("Unable to allocate the message frame table. { frames = %u }", head.count);
+		if (frames) mm_free(frames);
+		return NULL;
+	}
+
+	for (uint32_t i = 0; i < head.count; i++) {
+
+		length = (i + 1 == head.count) ? head.length - ((uint64_t)i * head.frame) : head.frame;
+
+		if (!(frames[i] = compress_lzo(PLACER(st_char_get(message) + ((uint64_t)i * head.frame), length)))) {
+			log_pedantic("Unable to compress a message frame. { frame = %u }", i);
+
+			for (uint32_t j = 0; j < i; j++) {
+				compress_free(frames[j]);
+			}
+
+			mm_free(frames);
+			mm_free(ends);
+			return NULL;
+		}
+
+		ends[i] = (total += compress_total_length(frames[i]));
+	}
+
+	// Write out the header, the table and then the frames.
+	if ((result = st_alloc(sizeof(mail_frames_head_t) + (head.count * sizeof(uint64_t)) + total))) {
+
+		mm_copy(st_char_get(result), &head, sizeof(mail_frames_head_t));
+		mm_copy(st_char_get(result) + sizeof(mail_frames_head_t), ends, head.count * sizeof(uint64_t));
+		length = sizeof(mail_frames_head_t) + (head.count * sizeof(uint64_t));
+
+		for (uint32_t i = 0; i < head.count; i++) {
+			mm_copy(st_char_get(result) + length, frames[i], compress_total_length(frames[i]));
+			length += compress_total_length(frames[i]);
+		}
+
+		st_length_set(result, length);
+	}
+
+	for (uint32_t i = 0; i < head.count; i++) {
+		compress_free(frames[i]);
+	}
+
+	mm_free(frames);
+	mm_free(ends);
+
+	return result;
+}
+
+/**
+ * @brief	Decompress every frame of a message.
+ * @param	data	a managed string containing the compressed frames, as generated by mail_frames_compress().
+ * @return	NULL on failure, or a managed string containing the uncompressed message on success.
+ */
+stringer_t * mail_frames_decompress(stringer_t *data) {
+
+	uint64_t *ends;
+	mail_frames_head_t *head;
+	stringer_t *result, *frame;
+	size_t base, available;
+
+	if (st_empty(data) || st_length_get(data) < sizeof(mail_frames_head_t) || !(head = st_data_get(data)) ||
+		st_length_get(data) < (base = sizeof(mail_frames_head_t) + ((size_t)head->count * sizeof(uint64_t)))) {
+		log_pedantic("The message frame header is truncated.");
+		return NULL;
+	}
+
+	ends = (uint64_t *)(st_char_get(data) + sizeof(mail_frames_head_t));
+	available = st_length_get(data) - base;
+
+	if (!mail_frames_valid(head, ends, available)) {
+		log_pedantic("The message frame table is corrupted.");
+		return NULL;
+	}
+	else if (!(result = st_alloc(head->length))) {
+		log_pedantic("Unable to allocate %lu bytes for the uncompressed message.", head->length);
+		return NULL;
+	}
+
+	for (uint32_t i = 0; i < head->count; i++) {
+
+		if (!(frame = mail_frames_decompress_frame(head, i, pl_init(st_char_get(data) + base + (i ? ends[i - 1] : 0),
+			ends[i] - (i ? ends[i - 1] : 0))))) {
+			st_free(result);
+			return NULL;
+		}
+
+		mm_copy(st_char_get(result) + ((uint64_t)i * head->frame), st_char_get(frame), st_length_get(frame));
+		st_free(frame);
+	}
+
+	st_length_set(result, head->length);
+
+	return result;
+}
+
+/**
+ * @brief	Free a message stream.
+ * @param	stream	a pointer to the message stream to be freed.
+ * @return	This function returns no value.
+ */
+void mail_stream_close(mail_stream_t *stream) {
+
+	if (stream) {
+		if (stream->fd >= 0) close(stream->fd);
+		st_cleanup(stream->frame);
+		if (stream->ends) mm_free(stream->ends);
+		mm_free(stream);
+	}
+
+	return;
+}
+
+/**
+ * @brief	Open a stream which returns a range of a stored message, decompressing only the frames which overlap the range.
+ * @note	Only messages stored in plain text frames can be streamed. For anything else NULL is returned, and the caller should load
+ * 			the message instead. Streams are also refused for empty ranges, since there wouldn't be anything to return.
+ * @param	meta	the meta message object of the message being streamed.
+ * @param	start	the offset of the first byte being requested.
+ * @param	length	the maximum number of bytes being requested, which is clamped to the end of the message.
+ * @return	NULL if the message can't be streamed, or a pointer to the message stream on success.
+ */
+mail_stream_t * mail_stream_open(meta_message_t *meta, size_t start, size_t length) {
+
+	chr_t *path;
+	struct stat info;
+	message_header_t header;
+	mail_stream_t *stream;
+
+	if (!meta || !length || (meta->status & MAIL_STATUS_ENCRYPTED) || !(path = mail_message_path(meta->messagenum, meta->server))) {
+		return NULL;
+	}
+	else if (!(stream = mm_alloc(sizeof(mail_stream_t)))) {
+		log_pedantic("Unable to allocate %zu bytes for the message stream.", sizeof(mail_stream_t));
+		ns_free(path);
+		return NULL;
+	}
+	else if ((stream->fd = open(path, O_RDONLY)) < 0) {
+		log_pedantic("Could not open a file descriptor for the message %s.", path);
+		mm_free(stream);
+		ns_free(path);
+		return NULL;
+	}
+
+	ns_free(path);
+	stream->base = sizeof(message_header_t) + sizeof(mail_frames_head_t);
+
+	// Messages which weren't stored in frames are loaded the traditional way.
+	if (fstat(stream->fd, &info) || info.st_size < stream->base || read(stream->fd, &header, sizeof(header)) != sizeof(header) ||
+		header.magic1 != FMESSAGE_MAGIC_1 || header.magic2 != FMESSAGE_MAGIC_2 || (header.flags & FMESSAGE_OPT_ENCRYPTED) ||
+		!(header.flags & FMESSAGE_OPT_FRAMED) || read(stream->fd, &(stream->head), sizeof(mail_frames_head_t)) != sizeof(mail_frames_head_t) ||
+		start >= stream->head.length) {
+		mail_stream_close(stream);
+		return NULL;
+	}
+
+	stream->base += (size_t)stream->head.count * sizeof(uint64_t);
+
+	if (info.st_size < stream->base || !(stream->ends = mm_alloc((size_t)stream->head.count * sizeof(uint64_t))) ||
+		read(stream->fd, stream->ends, stream->head.count * sizeof(uint64_t)) != (stream->head.count * sizeof(uint64_t)) ||
+		!mail_frames_valid(&(stream->head), stream->ends, info.st_size - stream->base)) {
+		log_pedantic("The message frame table is corrupted. { messagenum = %lu }", meta->messagenum);
+		mail_stream_close(stream);
+		return NULL;
+	}
+
+	stream->offset = start;
+	stream->length = (length < stream->head.length - start) ? length : stream->head.length - start;
+	stream->end = start + stream->length;
+
+	return stream;
+}
+
+/**
+ * @brief	Get the next chunk of a message stream.
+ * @note	The chunk points into a buffer held by the stream, so it is only valid until the next call.
+ * @param	stream	a pointer to the message stream.
+ * @param	chunk	a pointer to a placer which will point at the next chunk of the message.
+ * @return	-1 on failure, 0 when the entire range has been returned, or 1 if another chunk was returned.
+ */
+int_t mail_stream_next(mail_stream_t *stream, placer_t *chunk) {
+
+	stringer_t *buffer;
+	size_t within, remaining;
+	uint64_t begin, index;
+
+	if (!stream || !chunk) {
+		return -1;
+	}
+	else if (stream->offset >= stream->end) {
+		return 0;
+	}
+
+	index = stream->offset / stream->head.frame;
+
+	// Read and decompress the frame holding the next byte, unless we already have it.
+	if (!stream->frame || stream->current != index) {
+
+		st_cleanup(stream->frame);
+		stream->frame = NULL;
+
+		begin = index ? stream->ends[index - 1] : 0;
+
+		if (!(buffer = st_alloc(stream->ends[index] - begin)) ||
+			pread(stream->fd, st_data_get(buffer), stream->ends[index] - begin, stream->base + begin) != (stream->ends[index] - begin)) {
+			log_pedantic("Unable to read a message frame. { frame = %lu }", index);
+			st_cleanup(buffer);
+			return -1;
+		}
+
+		st_length_set(buffer, stream->ends[index] - begin);
+		stream->frame = mail_frames_decompress_frame(&(stream->head), index, pl_init(st_data_get(buffer), st_length_get(buffer)));
+		st_free(buffer);
+
+		if (!stream->frame) {
+			return -1;
+		}
+
+		stream->current = index;
+	}
+
+	within = stream->offset - (index * stream->head.frame);
+	remaining = st_length_get(stream->frame) - within;
+
+	if (remaining > stream->end - stream->offset) {
+		remaining = stream->end - stream->offset;
+	}
+
+	*chunk = pl_init(st_char_get(stream->frame) + within, remaining);
+	stream->offset += remaining;
+
+	return 1;
+}
@@ -8,41 +8,25 @@
 #include "magma.h"
 
 /**
- * @brief	Load a stored mail message from disk.
- * @note	The mail message will always, at the very least, be compressed using the lzo algorithm; however, on-disk encryption may be enabled.
- 			If parsing is enabled, a spam signature training link may be embedded in the message.
+ * @brief	Read the text of a stored mail message from disk, decrypting and decompressing it as necessary.
+ * @note	Messages stored without compression or encryption are mapped into memory instead of being read. Messages which can't be
+ * 			accessed are hidden, and the user's message serial number is incremented, so the message list gets refreshed.
  * @param	meta	the meta message object of the message to be loaded from disk.
  * @param	user	the meta user object of the user that owns the requested message.
- * @param	server	the server object of the web server where the spam teacher application is hosted.
- * @param	parse	if true, the header's Subject line is branded with any applicable labels such as JUNK, INFECTED, SPOOFED, BLACKHOLED, PHISHING.
- * @return	NULL on failure or a a mail message object containing the retrieved mail message data on success.
+ * @param	mapped	a pointer to a boolean which will be set to true if the returned string is a memory mapping of the message file.
+ * @return	NULL on failure or a managed string containing the message text, as it was originally stored, on success.
  */
-mail_message_t * mail_load_message(meta_message_t *meta, meta_user_t *user, server_t *server, bool_t parse) {
+stringer_t * mail_load_message_text(meta_message_t *meta, meta_user_t *user, bool_t *mapped) {
 
 	int_t fd;
 	chr_t *path;
 	size_t data_len;
 	struct stat file_info;
 	compress_t *compressed;
-	mail_message_t *result;
 	message_header_t header;
-	stringer_t *raw, *message;
-
-	if (!meta || (parse && (!user || !server))) {
-		log_pedantic("Invalid parameter combination passed in.");
-		return NULL;
-	}
-
-	// Check the thread local message cache first.
-	if ((message = mail_cache_get(meta->messagenum))) {
-
-		if (!(result = mail_message(message))) {
-			log_pedantic("Unable to build the message structure.");
-			return NULL;
-		}
+	stringer_t *raw, *message = NULL;
 
-		return result;
-	}
+	*mapped = false;
 
 	if (!(path = mail_message_path(meta->messagenum, meta->server))) {
 		log_pedantic("Could not build the message path.");
@@ -90,77 +74,98 @@ mail_message_t * mail_load_message(meta_message_t *meta, meta_user_t *user, serv
 		return NULL;
 	}
 
-	// Allocate a buffer big enough to hold the entire compressed file.
-	if (!(raw = st_alloc(data_len))) {
-		log_pedantic("Could not allocate a buffer of %li bytes to hold the message.", data_len);
-		close(fd);
-		ns_free(path);
-		return NULL;
+	// Messages stored without compression or encryption are mapped straight into memory, so the file contents are never copied. If the
+	// mapping fails we fall back to reading the file. On success the mapped string owns the descriptor.
+	if (!(meta->status & MAIL_STATUS_ENCRYPTED) && !(header.flags & (FMESSAGE_OPT_ENCRYPTED | FMESSAGE_OPT_COMPRESSED)) && data_len &&
+		(message = st_import_mapped(fd, sizeof(message_header_t), data_len))) {
+		*mapped = true;
 	}
+	else {
 
-	// Read the file in.
-	if (read(fd, st_char_get(raw), data_len) != data_len) {
-		log_pedantic("Could not read all %li bytes of the file %s.", data_len, path);
-		ns_free(path);
-		st_free(raw);
+		// Allocate a buffer big enough to hold the entire compressed file.
+		if (!(raw = st_alloc(data_len))) {
+			log_pedantic("Could not allocate a buffer of %li bytes to hold the message.", data_len);
+			close(fd);
+			ns_free(path);
+			return NULL;
+		}
+
+		// Read the file in.
+		if (read(fd, st_char_get(raw), data_len) != data_len) {
+			log_pedantic("Could not read all %li bytes of the file %s.", data_len, path);
+			ns_free(path);
+			st_free(raw);
+			close(fd);
+			return NULL;
+		}
+
+		// Were done with the file.
 		close(fd);
-		return NULL;
-	}
 
-	// Were done with the file.
-	close(fd);
+		// Tell the stringer how much data is there.
+		st_length_set(raw, data_len);
 
-	// Tell the stringer how much data is there.
-	st_length_set(raw, data_len);
+		if (meta->status & MAIL_STATUS_ENCRYPTED) {
 
-	if (meta->status & MAIL_STATUS_ENCRYPTED) {
+			if (!(header.flags & FMESSAGE_OPT_ENCRYPTED)) {
+				log_pedantic("Message state mismatch: encrypted in database but unencrypted on disk.");
+			}
 
-		if (!(header.flags & FMESSAGE_OPT_ENCRYPTED)) {
-			log_pedantic("Message state mismatch: encrypted in database but unencrypted on disk.");
-		}
+			if (!(user->flags & META_USER_ENCRYPT_DATA)) {
+				log_info("User with secure mode off requested encrypted message.");
+			}
 
-		if (!(user->flags & META_USER_ENCRYPT_DATA)) {
-			log_info("User with secure mode off requested encrypted message.");
-		}
+			if (!user->prime.key) {
+				log_pedantic("User cannot read encrypted message without a private key!");
+				ns_free(path);
+				st_free(raw);
+				return NULL;
+			}
 
-		if (!user->prime.key) {
-			log_pedantic("User cannot read encrypted message without a private key!");
-			ns_free(path);
+			else if (!(message = prime_message_decrypt(raw, org_signet, user->prime.key))) {
+				log_pedantic("Unable to decrypt mail message.");
+				ns_free(path);
+				st_free(raw);
+				return NULL;
+			}
+
+			// Free the raw buffer, but keep the path around in case we need it for error messages.
 			st_free(raw);
-			return NULL;
 		}
-
-		else if (!(message = prime_message_decrypt(raw, org_signet, user->prime.key))) {
-			log_pedantic("Unable to decrypt mail message.");
+		else if (header.flags & FMESSAGE_OPT_ENCRYPTED) {
+			log_pedantic("Message state mismatch, a message marked encrypted in the was found in plain text on disk.");
 			ns_free(path);
 			st_free(raw);
 			return NULL;
 		}
+		else if (header.flags & FMESSAGE_OPT_FRAMED) {
 
-		// Free the raw buffer, but keep the path around in case we need it for error messages.
-		st_free(raw);
-	}
-	else if (header.flags & FMESSAGE_OPT_ENCRYPTED) {
-		log_pedantic("Message state mismatch, a message marked encrypted in the was found in plain text on disk.");
-		ns_free(path);
-		st_free(raw);
-		return NULL;
-	}
-	else if (header.flags & FMESSAGE_OPT_COMPRESSED) {
+			message = mail_frames_decompress(raw);
 
-		// Convert the string buffer into a compression buffer.
-		if (!(compressed = compress_import(raw))) {
-			log_pedantic("Could not convert the stringer to a reducer.");
-			ns_free(path);
+			// Free the raw buffer, but keep the path around in case we need it for error messages.
 			st_free(raw);
-			return NULL;
 		}
+		else if (header.flags & FMESSAGE_OPT_COMPRESSED) {
+
+			// Convert the string buffer into a compression buffer.
+			if (!(compressed = compress_import(raw))) {
+				log_pedantic("Could not convert the stringer to a reducer.");
+				ns_free(path);
+				st_free(raw);
+				return NULL;
+			}
+
+			// Decompress the message.
+			message = decompress_lzo(compressed);
 
-		// Decompress the message.
-		message = decompress_lzo(compressed);
+			// Free the raw buffer, but keep the path around in case we need it for error messages.
+			st_free(raw);
+		}
 
-		// Free the raw buffer, but keep the path around in case we need it for error messages.
-		st_free(raw);
+		// The message was stored in plain text, but we couldn't map it.
+		else {
+			message = raw;
+		}
 	}
 
 	// If were unable to uncompress the file, hide it.
@@ -176,7 +181,50 @@ mail_message_t * mail_load_message(meta_message_t *meta, meta_user_t *user, serv
 	// Finally free the path.
 	ns_free(path);
 
-	// Only modify and cache the message if parsing is enabled.
+	return message;
+}
+
+/**
+ * @brief	Load a stored mail message, checking first in the shared message cache and then on disk.
+ * @note	The mail message will always, at the very least, be compressed using the lzo algorithm; however, on-disk encryption may be enabled.
+ 			If parsing is enabled, a spam signature training link may be embedded in the message.
+ * @param	meta	the meta message object of the message to be loaded from disk.
+ * @param	user	the meta user object of the user that owns the requested message.
+ * @param	server	the server object of the web server where the spam teacher application is hosted.
+ * @param	parse	if true, the header's Subject line is branded with any applicable labels such as JUNK, INFECTED, SPOOFED, BLACKHOLED, PHISHING.
+ * @return	NULL on failure or a a mail message object containing the retrieved mail message data on success.
+ */
+mail_message_t * mail_load_message(meta_message_t *meta, meta_user_t *user, server_t *server, bool_t parse) {
+
+	bool_t mapped = false;
+	mail_message_t *result;
+	stringer_t *message = NULL;
+
+	if (!meta || (parse && (!user || !server))) {
+		log_pedantic("Invalid parameter combination passed in.");
+		return NULL;
+	}
+
+	// Check the shared message cache first.
+	if (!(message = mail_cache_get(meta->messagenum))) {
+
+		if (!(message = mail_load_message_text(meta, user, &mapped))) {
+			return NULL;
+		}
+
+		// Add the message to the shared cache. Some IMAP clients like to pull messages in chunks leading to lots of
+		// serialized requests for small pieces of the same message, which may be serviced by any worker thread. Caching
+		// avoids having to read, decrypt and decompress the message repeatedly. The text is cached as it was stored, since
+		// the subject branding and signature below depend on the parse flag and the current message status, so they're
+		// applied after every load, cached or not. Mapped messages are skipped, since the kernel page cache already holds
+		// them and remapping the file is cheaper than copying it into the cache. Encrypted messages are never cached, since
+		// the shared cache outlives the session, and the plain text must only be reachable through prime_message_decrypt().
+		if (!mapped && !(meta->status & MAIL_STATUS_ENCRYPTED)) {
+			mail_cache_set(meta->messagenum, message);
+		}
+	}
+
+	// Only modify the message if parsing is enabled.
 	if (parse) {
 
 		// Modify the subject, if necessary.
@@ -214,11 +262,6 @@ mail_message_t * mail_load_message(meta_message_t *meta, meta_user_t *user, serv
 		return NULL;
 	}
 
-	// Set thread cache. We use a thread cache since some IMAP clients like to pull messages in chunks leading to
-	// lots of serialized requests for small pieces of the same message. Thread caching avoids having to process the
-	// message repeatedly.
-	mail_cache_set(meta->messagenum, result->text);
-
 	return result;
 }
 
@@ -11,9 +11,59 @@
 #define MAIL_MIME_RECURSION_LIMIT 16
 #define MAIL_SIGNATURES_RECURSION_LIMIT 16
 
+// The number of independently locked shards in the message cache, and the number of hash buckets in each shard.
+#define MAIL_CACHE_SHARDS 16
+#define MAIL_CACHE_BUCKETS 256
+
+// The search index signatures hold one bit for every three byte sequence, so the number of bits must be a power of two. Messages
+// setting more than the saturation percentage of the bits aren't indexed.
+#define MAIL_SEARCH_BITS_SHIFT 13
+#define MAIL_SEARCH_BITS (1 << MAIL_SEARCH_BITS_SHIFT)
+#define MAIL_SEARCH_SIGNATURE (MAIL_SEARCH_BITS / 8)
+#define MAIL_SEARCH_SATURATION 60
+#define MAIL_SEARCH_MAGIC 0x53524348
+
+// Plain text messages are compressed in frames holding this many bytes, so a range of the message can be decompressed on its own.
+#define MAIL_FRAMES_LENGTH 65536
+#define MAIL_FRAMES_MAGIC 0x464D5246
+
+enum {
+	MAIL_SEARCH_INDEXED = 1,
+	MAIL_SEARCH_REMOVED = 2
+};
+
+typedef struct __attribute__ ((packed)) {
+	uint64_t messagenum;
+	uint32_t magic, flags;
+} mail_search_record_t;
+
 typedef struct {
+	chr_t *path;
+	void *map;
+	size_t length;
+	inx_t *records; /* Maps message numbers to their signatures inside the mapped index. */
+} mail_search_t;
+
+typedef struct __attribute__ ((packed)) {
+	uint32_t magic, frame, count; /* The number of uncompressed bytes in each frame, and the number of frames. */
+	uint64_t length; /* The length of the uncompressed message. */
+} mail_frames_head_t;
+
+typedef struct mail_stream_t {
+	int_t fd;
+	mail_frames_head_t head;
+	uint64_t *ends; /* The offset where each compressed frame ends, relative to the first frame. */
+	size_t base; /* The file offset of the first frame. */
+	size_t offset, end, length; /* The position of the next byte, and the range being returned. */
+	uint64_t current; /* The index of the decompressed frame. */
+	stringer_t *frame;
+} mail_stream_t;
+
+typedef struct mail_cache_t {
 	uint64_t messagenum;
-	stringer_t *text;
+	stringer_t *text, *structure; /* Either may be NULL, the structure holds the IMAP BODYSTRUCTURE for the message. */
+	struct mail_cache_t *chain; /* The next message in the same hash bucket. */
+	struct mail_cache_t *newer, *older; /* The neighbors in the least recently used list. */
 } mail_cache_t;
 
 typedef struct {
@@ -27,7 +77,8 @@ typedef struct {
 typedef struct {
 	array_t *children;
 	stringer_t *boundary;
-	uint32_t type, encoding;
+	bool_t expanded; /* Whether the children have been parsed, see mail_mime_children(). */
+	uint32_t type, encoding, recursion;
 	placer_t header, body, entire;
 } mail_mime_t;
 
@@ -38,6 +89,11 @@ typedef struct {
 	stringer_t *text;
 } mail_message_t;
 
+// The IMAP responses for a plain text message, computed when it's stored so they can be returned without loading the message.
+typedef struct {
+	stringer_t *envelope, *structure, *header; /* The structure may be NULL. */
+} mail_summary_t;
+
 typedef struct {
 	chr_t *extension;
 	bool_t bin;
@@ -47,11 +103,12 @@ typedef struct {
 /// cache.c
 void          mail_cache_destroy(void *holder);
 stringer_t *  mail_cache_get(uint64_t messagenum);
+stringer_t *  mail_cache_get_structure(uint64_t messagenum);
 void          mail_cache_reset(void);
 void          mail_cache_set(uint64_t messagenum, stringer_t *text);
+void          mail_cache_set_structure(uint64_t messagenum, stringer_t *structure);
 bool_t        mail_cache_start(void);
 void          mail_cache_stop(void);
-void          mail_cache_thread_stop(void);
 
 /// cleanup.c
 void          mail_destroy_header(stringer_t *header);
@@ -62,12 +119,24 @@ uint32_t      mail_count_received(stringer_t *message);
 size_t        mail_header_end(stringer_t *message);
 
 /// datatier.c
+bool_t        mail_db_copy_summary(uint64_t original, uint64_t messagenum, int_t transaction);
 bool_t        mail_db_delete_message(uint64_t usernum, uint64_t messagenum, uint32_t size, int_t transaction);
+mail_summary_t *  mail_db_fetch_summary(uint64_t messagenum);
 void          mail_db_hide_message(uint64_t messagenum);
 uint64_t      mail_db_insert_duplicate_message(uint64_t usernum, uint64_t foldernum, uint32_t status, uint32_t size, uint64_t signum, uint64_t sigkey, uint64_t created, int_t transaction);
 uint64_t      mail_db_insert_message(uint64_t usernum, uint64_t foldernum, uint32_t status, uint32_t size, uint64_t signum, uint64_t sigkey, int_t transaction);
+bool_t        mail_db_insert_summary(uint64_t messagenum, mail_summary_t *summary, int_t transaction);
 int_t         mail_db_update_message_folder(uint64_t usernum, uint64_t messagenum, uint64_t source, uint64_t target, int64_t transaction);
 
+/// frames.c
+stringer_t *     mail_frames_compress(stringer_t *message);
+stringer_t *     mail_frames_decompress(stringer_t *data);
+stringer_t *     mail_frames_decompress_frame(mail_frames_head_t *head, uint32_t frame, placer_t data);
+bool_t           mail_frames_valid(mail_frames_head_t *head, uint64_t *ends, size_t available);
+void             mail_stream_close(mail_stream_t *stream);
+int_t            mail_stream_next(mail_stream_t *stream, placer_t *chunk);
+mail_stream_t *  mail_stream_open(meta_message_t *meta, size_t start, size_t length);
+
 /// headers.c
 void          mail_add_forward_headers(server_t *server, stringer_t **message, stringer_t *id, int_t mark, uint64_t signum, uint64_t sigkey);
 stringer_t *  mail_add_inbound_headers(connection_t *con, smtp_inbound_prefs_t *prefs);
@@ -84,16 +153,19 @@ placer_t      mail_store_header(chr_t *stream, size_t length);
 stringer_t *      mail_load_header(meta_message_t *meta, meta_user_t *user);
 mail_message_t *  mail_load_message(meta_message_t *meta, meta_user_t *user, server_t *server, bool_t parse);
 mail_message_t *  mail_load_message_top(meta_message_t *meta, meta_user_t *user, server_t *server, uint64_t lines, bool_t parse);
+stringer_t *      mail_load_message_text(meta_message_t *meta, meta_user_t *user, bool_t *mapped);
 
 /// mime.c
 stringer_t *   mail_mime_boundary(placer_t header);
 placer_t       mail_mime_child(placer_t body, stringer_t *boundary, uint32_t child);
+array_t *      mail_mime_children(mail_mime_t *mime);
 stringer_t *   mail_mime_content_encoding(placer_t header);
 stringer_t *   mail_mime_content_id(placer_t header);
 uint32_t       mail_mime_count(placer_t body, stringer_t *boundary);
 int_t          mail_mime_encoding(placer_t header);
 void           mail_mime_free(mail_mime_t *mime);
 placer_t       mail_mime_header(stringer_t *part);
+bool_t         mail_mime_next(placer_t body, stringer_t *boundary, size_t *offset, placer_t *part);
 mail_mime_t *  mail_mime_part(stringer_t *part, uint32_t recursion);
 array_t *      mail_mime_split(placer_t body, stringer_t *boundary);
 int_t          mail_mime_type(placer_t header);
@@ -127,6 +199,17 @@ int_t        mail_path_finder(chr_t *string);
 /// remove_message.c
 bool_t        mail_remove_message(uint64_t usernum, uint64_t messagenum, uint32_t size, chr_t *server);
 
+/// search.c
+bool_t          mail_search_append(uint64_t usernum, mail_search_record_t *record, uchr_t *signature);
+uint32_t        mail_search_bit(uchr_t *sequence);
+bool_t          mail_search_check(mail_search_t *search, uint64_t messagenum, stringer_t *value);
+void            mail_search_close(mail_search_t *search);
+void            mail_search_compact(mail_search_t *search);
+bool_t          mail_search_index(uint64_t usernum, uint64_t messagenum, stringer_t *text);
+mail_search_t * mail_search_open(uint64_t usernum);
+chr_t *         mail_search_path(uint64_t usernum, bool_t create);
+void            mail_search_remove(uint64_t usernum, uint64_t messagenum);
+
 /// signatures.c
 stringer_t *  mail_build_signature(server_t *server, int_t content_type, int_t content_encoding, uint64_t signum, uint64_t sigkey, int_t disposition);
 int_t         mail_discover_encoding(stringer_t *header);
@@ -146,4 +229,9 @@ int_t      mail_move_message(uint64_t usernum, uint64_t messagenum, uint64_t sou
 uint64_t   mail_store_message(uint64_t usernum, prime_t *signet, uint64_t foldernum, uint32_t *status, uint64_t signum, uint64_t sigkey, stringer_t *message);
 bool_t     mail_store_message_data(uint64_t messagenum, uint8_t fflags, stringer_t *data, chr_t **pathptr);
 
+/// summary.c
+mail_summary_t *  mail_summary_build(stringer_t *message, bool_t structure);
+void              mail_summary_free(mail_summary_t *summary);
+mail_summary_t *  mail_summary_get(meta_message_t *meta);
+
 #endif
@@ -689,55 +689,87 @@ stringer_t * mail_mime_boundary(placer_t header) {
 }
 
 /**
- * @brief	Count the number of instances of a boundary string inside a MIME body.
- * @note	The search is terminated if "--" is found right after the boundary string.
+ * @brief	Find the next child inside a MIME body.
+ * @note	This function lets callers walk every child of a multipart body in a single pass. The offset should start at zero, and is
+ * 			advanced past each child as it is returned, so the body is never rescanned. Children are returned as placers pointing into
+ * 			the body, and may be empty if two boundaries are adjacent. The walk ends at the closing boundary, which is the boundary
+ * 			string followed by two dashes.
  * @param	body		a placer containing the body text to be parsed.
- * @param	boundary	a pointer to a managed string containing the boundary string for the MIME content.
- * @return	0 on failure, or the number of times the boundary string was located in the MIME body on success.
+ * @param	boundary	a pointer to a managed string containing the boundary string used to split the MIME content.
+ * @param	offset		a pointer to the position inside the body where the search should begin, which will be updated.
+ * @param	part		a pointer to a placer which will receive the child.
+ * @return	true if another child was found, or false once the end of the body has been reached.
  */
-uint32_t mail_mime_count(placer_t body, stringer_t *boundary) {
+bool_t mail_mime_next(placer_t body, stringer_t *boundary, size_t *offset, placer_t *part) {
 
-	uint32_t result = 0;
 	chr_t *stream, *bounddata;
-	size_t increment = 0, length, boundlen;
+	size_t length, boundlen, position, start;
 
-	if (pl_empty(body) || st_empty(boundary)) {
-		return 0;
+	if (pl_empty(body) || st_empty(boundary) || !offset || !part) {
+		return false;
 	}
 
-	// Figure out the lengths.
-	if (!(length = st_length_get(&body))) {
-		log_pedantic("Cannot count boundary marker in zero-length MIME body..");
-		return 0;
+	length = pl_length_get(body);
+	stream = pl_char_get(body);
+	boundlen = st_length_get(boundary);
+	bounddata = st_char_get(boundary);
+	position = *offset;
+
+	// Find the next boundary marker, which must be followed by a non-printable character, or the end of the body.
+	while (position + boundlen <= length && (*(stream + position) != *bounddata || mm_cmp_cs_eq(stream + position, bounddata, boundlen) ||
+		(position + boundlen != length && *(stream + position + boundlen) >= '!' && *(stream + position + boundlen) <= '~'))) {
+		position++;
 	}
-	else if (!(boundlen = st_length_get(boundary))) {
-		log_pedantic("Cannot count zero-length MIME boundary.");
-		return 0;
+
+	position += boundlen;
+
+	// Two dashes indicate the end of this MIME section, and we need room for at least one more boundary marker.
+	if (position + boundlen >= length || mm_cmp_cs_eq(stream + position, "--", 2) == 0) {
+		*offset = length;
+		return false;
 	}
 
-	// Setup.
-	stream = st_char_get(&body);
-	bounddata = st_char_get(boundary);
+	// This will skip a line break after the boundary marker.
+	if (*(stream + position) == '\r') {
+		position++;
+	}
 
-	// Find the start of the first part.
-	while (increment + boundlen <= length) {
+	if (position < length && *(stream + position) == '\n') {
+		position++;
+	}
 
-		if (mm_cmp_cs_eq(stream, bounddata, boundlen) == 0) {
-			stream += boundlen + 1;
-			increment += boundlen + 1;
+	// Store the start position, then find the end, which is the start of the next boundary marker.
+	start = position;
 
-			// Two dashes indicate the end of this mime sections.
-			if (increment + 1 <= length && mm_cmp_cs_eq(stream, "--", 2) == 0) {
-				increment = length + 1;
-			}
-			else {
-				result++;
-			}
-		}
-		else {
-			stream++;
-			increment++;
-		}
+	while (position + boundlen < length && (*(stream + position) != *bounddata || mm_cmp_cs_eq(stream + position, bounddata, boundlen))) {
+		position++;
+	}
+
+	if (position + boundlen >= length) {
+		position = length;
+	}
+
+	*part = pl_init(stream + start, position - start);
+	*offset = position;
+
+	return true;
+}
+
+/**
+ * @brief	Count the number of children inside a MIME body.
+ * @see		mail_mime_next()
+ * @param	body		a placer containing the body text to be parsed.
+ * @param	boundary	a pointer to a managed string containing the boundary string for the MIME content.
+ * @return	0 on failure, or the number of non-empty children found in the MIME body on success.
+ */
+uint32_t mail_mime_count(placer_t body, stringer_t *boundary) {
+
+	placer_t part;
+	size_t offset = 0;
+	uint32_t result = 0;
+
+	while (mail_mime_next(body, boundary, &offset, &part)) {
+		if (!pl_empty(part)) result++;
 	}
 
 	return result;
@@ -844,33 +876,30 @@ placer_t mail_mime_child(placer_t body, stringer_t *boundary, uint32_t child) {
  */
 array_t * mail_mime_split(placer_t body, stringer_t *boundary) {
 
-	array_t *result;
-	uint32_t parts;
+	placer_t part;
+	size_t offset = 0;
 	stringer_t *item;
-
-	// Figure out how many children this body part has.
-	if (!(parts = mail_mime_count(body, boundary))) {
-		return NULL;
-	}
-
-	// Allocate an array to hold all of the children.
-	if (!(result = ar_alloc(parts))) {
-		log_pedantic("Could not allocate an array of %i elements for the MIME parts.", parts);
-		return NULL;
-	}
+	array_t *result = NULL;
 
 	// Build an array that contains all of the children.
-	for (uint32_t i = 1; i <= parts; i++) {
+	while (mail_mime_next(body, boundary, &offset, &part)) {
+
+		if (pl_empty(part)) {
+			continue;
+		}
+		else if (!result && !(result = ar_alloc(4))) {
+			log_pedantic("Could not allocate an array for the MIME parts.");
+			return NULL;
+		}
 
 		if ((item = st_alloc_opts(PLACER_T | JOINTED | HEAP | FOREIGNDATA, 0))) {
 
-			// Get the part and clean it up.
-			*((placer_t *)item) = pl_set(*((placer_t *)item), mail_mime_child(body, boundary, i));
+			*((placer_t *)item) = pl_set(*((placer_t *)item), part);
 
 			/// TODO: This is ugly. Because the array gets a placer pointer we need to free it when done. But that means differentiating between
 			/// these placers and what were usually passed which will likely stack allocated placers. We could probably just change it to a stringer
 			/// now that its going to st_free(), but that would mean lots of updates all over the place.
-			if (st_empty(item) || ar_append(&result, ARRAY_TYPE_STRINGER, item) != 1) {
+			if (ar_append(&result, ARRAY_TYPE_STRINGER, item) != 1) {
 				st_free(item);
 			}
 
@@ -911,18 +940,17 @@ void mail_mime_free(mail_mime_t *mime) {
 
 /**
  * @brief	Parse a block of data into a mail mime object.
- * @note	By parsing the specified mime part, this function fills in the content type and encoding of the resulting mail mime object.
- * 			If the message is multipart, the boundary string is determined and then used to split the body into children;
- * 			then each child part is passed to mail_mime_part() to be parsed likewise, recursively.
+ * @note	By parsing the specified mime part, this function fills in the content type and encoding of the resulting mail mime object,
+ * 			and if the part is multipart, its boundary string. The children aren't parsed until they are requested using
+ * 			mail_mime_children(), so callers which only need the top level part, or a single branch of the tree, don't pay to parse
+ * 			the rest. The parts point into the original data, which must remain valid for the life of the object.
  * @param	part		a managed string containing the mime part data to be parsed.
  * @param	recursion	an incremented recursion level tracker for calling this function, to prevent an overflow from occurring.
  * @return	NULL on failure or a pointer to a newly allocated and updated mail mime object parsed from the part data on success.
  */
 mail_mime_t * mail_mime_part(stringer_t *part, uint32_t recursion) {
 
-	array_t *holder;
-	size_t elements, increment;
-	mail_mime_t *result, *subpart;
+	mail_mime_t *result;
 
 	// Recursion limiter.
 	if (recursion >= MAIL_MIME_RECURSION_LIMIT) {
@@ -941,6 +969,7 @@ mail_mime_t * mail_mime_part(stringer_t *part, uint32_t recursion) {
 	}
 
 	// Store the entire part, and figure out the length of the header.
+	result->recursion = recursion;
 	result->entire = pl_init(st_data_get(part), st_length_get(part));
 	result->header = mail_mime_header(part);
 
@@ -954,37 +983,49 @@ mail_mime_t * mail_mime_part(stringer_t *part, uint32_t recursion) {
 	result->encoding = mail_mime_encoding(result->header);
 
 	// If were dealing with a multipart message, get the boundary.
-	if ((result->type == MESSAGE_TYPE_MULTI_ALTERNATIVE || result->type == MESSAGE_TYPE_MULTI_MIXED || result->type == MESSAGE_TYPE_MULTI_RELATED ||
-		result->type == MESSAGE_TYPE_MULTI_RFC822 || result->type == MESSAGE_TYPE_MULTI_UNKOWN) && (result->boundary = mail_mime_boundary(result->header))) {
-
-		// Get an array of message parts.
-		if ((holder = mail_mime_split(result->body, result->boundary)) && (elements = ar_length_get(holder))) {
+	if (result->type == MESSAGE_TYPE_MULTI_ALTERNATIVE || result->type == MESSAGE_TYPE_MULTI_MIXED || result->type == MESSAGE_TYPE_MULTI_RELATED ||
+		result->type == MESSAGE_TYPE_MULTI_RFC822 || result->type == MESSAGE_TYPE_MULTI_UNKOWN) {
+		result->boundary = mail_mime_boundary(result->header);
+	}
 
-			if ((result->children = ar_alloc(elements))) {
+	return result;
+}
 
-				for (increment = 0; increment < elements; increment++) {
+/**
+ * @brief	Get the children of a mail mime object, parsing them the first time they are requested.
+ * @note	The body is walked once using mail_mime_next(), and each child is parsed with mail_mime_part(), which leaves its own
+ * 			children for later.
+ * @param	mime	the mail mime object whose children are being requested.
+ * @return	NULL if the part has no children, or an array of mail mime objects.
+ */
+array_t * mail_mime_children(mail_mime_t *mime) {
 
-					if ((subpart = mail_mime_part(ar_field_st(holder, increment), recursion + 1))) {
+	placer_t part;
+	size_t offset = 0;
+	mail_mime_t *subpart;
 
-						if (ar_append(&(result->children), ARRAY_TYPE_POINTER, subpart) != 1) {
-							mail_mime_free(subpart);
-						}
+	if (!mime || mime->expanded) {
+		return mime ? mime->children : NULL;
+	}
 
-					}
+	mime->expanded = true;
 
-				}
+	if (!mime->boundary) {
+		return NULL;
+	}
 
-			}
+	while (mail_mime_next(mime->body, mime->boundary, &offset, &part)) {
 
+		if (pl_empty(part) || !(subpart = mail_mime_part(&part, mime->recursion + 1))) {
+			continue;
 		}
-
-		if (holder) {
-			ar_free(holder);
+		else if ((!mime->children && !(mime->children = ar_alloc(4))) || ar_append(&(mime->children), ARRAY_TYPE_POINTER, subpart) != 1) {
+			mail_mime_free(subpart);
 		}
 
 	}
 
-	return result;
+	return mime->children;
 }
 
 /**
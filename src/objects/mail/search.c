@@ -0,0 +1,385 @@
+
+/**
+ * @file /magma/objects/mail/search.c
+ *
+ * @brief	Functions used to maintain the per-user message search index.
+ * @note	The index is a signature file. Every message is summarized by a fixed size bitmap, with one bit set for every
+ * 			case-insensitive three byte sequence found in the message. A substring can only be present in a message if every bit
+ * 			for the substring's own sequences is set, which lets searches skip most messages without loading them. A message
+ * 			without a record must always be loaded, so records which are missing, or lost, can never hide a match.
+ *
+ * 			Records are appended to the index when a message is stored, and a removal record is appended when the message is
+ * 			deleted. The index is rewritten without the removed messages once they make up half of the file. Encrypted messages
+ * 			are never indexed, since the signature would reveal information about the plain text.
+ */
+
+#include "magma.h"
+
+/**
+ * @brief	Get the path of a user's search index.
+ * @param	usernum		the numerical id of the user that owns the index.
+ * @param	create		if true, create the directories leading up to the index.
+ * @return	NULL on failure, or a pointer to a null-terminated string containing the path of the index.
+ */
+chr_t * mail_search_path(uint64_t usernum, bool_t create) {
+
+	chr_t *result;
+
+	if (!(result = ns_alloc(1024))) {
+		log_pedantic("Unable to allocate a buffer of %i bytes for the search index path.", 1024);
+		return NULL;
+	}
+
+	// Check the search directory.
+	snprintf(result, 1024, "%.*s/%.*s/search", st_length_int(magma.storage.root), st_char_get(magma.storage.root),
+		st_length_int(magma.storage.active), st_char_get(magma.storage.active));
+
+	if (create && mkdir(result, S_IRWXU) && errno != EEXIST) {
+		log_error("An error occurred while attempting to create the directory %s.", result);
+		ns_free(result);
+		return NULL;
+	}
+
+	// Check the user directory.
+	snprintf(result, 1024, "%.*s/%.*s/search/%lu", st_length_int(magma.storage.root), st_char_get(magma.storage.root),
+		st_length_int(magma.storage.active), st_char_get(magma.storage.active), usernum / 32768);
+
+	if (create && mkdir(result, S_IRWXU) && errno != EEXIST) {
+		log_error("An error occurred while attempting to create the directory %s.", result);
+		ns_free(result);
+		return NULL;
+	}
+
+	// Build the index path.
+	if (snprintf(result, 1024, "%.*s/%.*s/search/%lu/%lu", st_length_int(magma.storage.root), st_char_get(magma.storage.root),
+		st_length_int(magma.storage.active), st_char_get(magma.storage.active), usernum / 32768, usernum) <= 0) {
+		log_pedantic("Unable to create the search index path.");
+		ns_free(result);
+		return NULL;
+	}
+
+	return result;
+}
+
+/**
+ * @brief	Get the signature bit used for a three byte sequence.
+ * @param	sequence	a pointer to the three bytes being hashed.
+ * @return	the position of the bit representing the sequence.
+ */
+uint32_t mail_search_bit(uchr_t *sequence) {
+
+	uint32_t value = (lower_chr(*sequence) << 16) | (lower_chr(*(sequence + 1)) << 8) | lower_chr(*(sequence + 2));
+
+	return (value * 2654435761U) >> (32 - MAIL_SEARCH_BITS_SHIFT);
+}
+
+/**
+ * @brief	Append a record to a user's search index.
+ * @note	The index is locked while the record is written. If the index was replaced while we were waiting for the lock, the
+ * 			new file is opened and we try again, so records aren't lost when the index is compacted.
+ * @param	usernum		the numerical id of the user that owns the index.
+ * @param	record		the record header.
+ * @param	signature	the message signature, or NULL if the record marks a removed message.
+ * @return	true on success or false on failure.
+ */
+bool_t mail_search_append(uint64_t usernum, mail_search_record_t *record, uchr_t *signature) {
+
+	int_t fd;
+	chr_t *path;
+	struct iovec vectors[2];
+	struct stat current, opened;
+	bool_t result = false;
+	size_t length = sizeof(mail_search_record_t) + (signature ? MAIL_SEARCH_SIGNATURE : 0);
+
+	if (!(path = mail_search_path(usernum, true))) {
+		return false;
+	}
+
+	vectors[0].iov_base = record;
+	vectors[0].iov_len = sizeof(mail_search_record_t);
+	vectors[1].iov_base = signature;
+	vectors[1].iov_len = signature ? MAIL_SEARCH_SIGNATURE : 0;
+
+	for (int_t attempt = 0; attempt < 3 && !result; attempt++) {
+
+		if ((fd = open(path, O_WRONLY | O_APPEND | O_CREAT, S_IRUSR | S_IWUSR)) < 0) {
+			log_pedantic("Unable to open the search index. { path = %s / errno = %i }", path, errno);
+			break;
+		}
+		else if (flock(fd, LOCK_EX)) {
+			close(fd);
+			break;
+		}
+
+		// Make sure the index wasn't replaced while we waited for the lock.
+		if (!fstat(fd, &opened) && !stat(path, &current) && opened.st_ino == current.st_ino && opened.st_dev == current.st_dev) {
+
+			if (writev(fd, vectors, signature ? 2 : 1) != length) {
+				log_pedantic("Unable to write to the search index. { path = %s }", path);
+				attempt = 3;
+			}
+			else {
+				result = true;
+			}
+		}
+
+		flock(fd, LOCK_UN);
+		close(fd);
+	}
+
+	ns_free(path);
+	return result;
+}
+
+/**
+ * @brief	Add a message to its owner's search index.
+ * @note	Messages which would set too many bits in their signature aren't indexed, since the signature would match almost any
+ * 			search. Those messages will simply be loaded during searches, like messages stored before the index existed.
+ * @param	usernum		the numerical id of the user that owns the message.
+ * @param	messagenum	the numerical id of the message.
+ * @param	text		a managed string containing the plain text of the message.
+ * @return	true if the message was indexed, or false otherwise.
+ */
+bool_t mail_search_index(uint64_t usernum, uint64_t messagenum, stringer_t *text) {
+
+	uchr_t *data;
+	size_t length;
+	uint64_t bits = 0;
+	mail_search_record_t record;
+	uchr_t signature[MAIL_SEARCH_SIGNATURE];
+
+	if (!usernum || !messagenum || st_empty_out(text, &data, &length) || length < 3) {
+		return false;
+	}
+
+	mm_wipe(signature, sizeof(signature));
+
+	for (size_t i = 0; i <= length - 3; i++) {
+		uint32_t bit = mail_search_bit(data + i);
+		signature[bit / 8] |= (1 << (bit % 8));
+	}
+
+	for (size_t i = 0; i < sizeof(signature); i += sizeof(uint64_t)) {
+		bits += __builtin_popcountll(*((uint64_t *)(signature + i)));
+	}
+
+	if ((bits * 100) / MAIL_SEARCH_BITS > MAIL_SEARCH_SATURATION) {
+		return false;
+	}
+
+	record.magic = MAIL_SEARCH_MAGIC;
+	record.flags = MAIL_SEARCH_INDEXED;
+	record.messagenum = messagenum;
+
+	return mail_search_append(usernum, &record, signature);
+}
+
+/**
+ * @brief	Record the removal of a message from its owner's search index.
+ * @param	usernum		the numerical id of the user that owns the message.
+ * @param	messagenum	the numerical id of the removed message.
+ * @return	This function returns no value.
+ */
+void mail_search_remove(uint64_t usernum, uint64_t messagenum) {
+
+	mail_search_record_t record;
+
+	if (!usernum || !messagenum) {
+		return;
+	}
+
+	record.magic = MAIL_SEARCH_MAGIC;
+	record.flags = MAIL_SEARCH_REMOVED;
+	record.messagenum = messagenum;
+
+	mail_search_append(usernum, &record, NULL);
+	return;
+}
+
+/**
+ * @brief	Rewrite a user's search index without the records for removed messages.
+ * @note	The live records are written to a temporary file, which replaces the index while the index is locked. If another
+ * 			thread is already holding the lock the compaction is skipped.
+ * @param	search	the opened search index, holding the live records.
+ * @return	This function returns no value.
+ */
+void mail_search_compact(mail_search_t *search) {
+
+	chr_t *temp;
+	int_t fd, out;
+	inx_cursor_t *cursor;
+	bool_t result = true;
+	mail_search_record_t record;
+	uchr_t *signature;
+
+	if (!search->path || !(temp = ns_alloc(1024))) {
+		return;
+	}
+
+	snprintf(temp, 1024, "%s.compact", search->path);
+
+	if ((fd = open(search->path, O_RDONLY)) < 0) {
+		ns_free(temp);
+		return;
+	}
+	else if (flock(fd, LOCK_EX | LOCK_NB)) {
+		ns_free(temp);
+		close(fd);
+		return;
+	}
+	else if ((out = open(temp, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR)) < 0 || !(cursor = inx_cursor_alloc(search->records))) {
+		if (out >= 0) close(out);
+		flock(fd, LOCK_UN);
+		ns_free(temp);
+		close(fd);
+		return;
+	}
+
+	record.magic = MAIL_SEARCH_MAGIC;
+	record.flags = MAIL_SEARCH_INDEXED;
+
+	while (result && (signature = inx_cursor_value_next(cursor))) {
+		record.messagenum = inx_cursor_key_active(cursor).val.u64;
+		result = write(out, &record, sizeof(record)) == sizeof(record) && write(out, signature, MAIL_SEARCH_SIGNATURE) == MAIL_SEARCH_SIGNATURE;
+	}
+
+	inx_cursor_free(cursor);
+
+	// The records were read before we took the lock. If anything was appended since, skip the compaction so nothing is lost.
+	if (result && search->length < lseek(fd, 0, SEEK_END)) {
+		result = false;
+	}
+
+	if (close(out) || !result || rename(temp, search->path)) {
+		unlink(temp);
+	}
+
+	flock(fd, LOCK_UN);
+	close(fd);
+	ns_free(temp);
+
+	return;
+}
+
+/**
+ * @brief	Open a user's search index.
+ * @note	The index is mapped into memory, and the records are collected into a hash table keyed by message number, so every
+ * 			message can be checked in constant time. Later records replace earlier ones, and removal records discard them.
+ * @param	usernum		the numerical id of the user that owns the index.
+ * @return	NULL if the index doesn't exist or couldn't be read, or a pointer to the opened search index.
+ */
+mail_search_t * mail_search_open(uint64_t usernum) {
+
+	int_t fd;
+	uchr_t *position;
+	struct stat info;
+	uint64_t removed = 0;
+	mail_search_t *search;
+	mail_search_record_t *record;
+	multi_t key = { .type = M_TYPE_UINT64, .val.u64 = 0 };
+
+	if (!usernum || !(search = mm_alloc(sizeof(mail_search_t)))) {
+		return NULL;
+	}
+
+	if (!(search->path = mail_search_path(usernum, false)) || (fd = open(search->path, O_RDONLY)) < 0) {
+		mail_search_close(search);
+		return NULL;
+	}
+	else if (fstat(fd, &info) || !info.st_size || (search->map = mmap64(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+		search->map = NULL;
+		mail_search_close(search);
+		close(fd);
+		return NULL;
+	}
+
+	// The mapping remains valid after the descriptor is closed.
+	close(fd);
+	search->length = info.st_size;
+
+	if (!(search->records = inx_alloc(M_INX_HASHED | M_INX_LOCK_MANUAL, NULL))) {
+		mail_search_close(search);
+		return NULL;
+	}
+
+	// Walk the records. A partially written record at the end of the file is ignored.
+	position = search->map;
+
+	while (position + sizeof(mail_search_record_t) <= (uchr_t *)search->map + search->length) {
+
+		record = (mail_search_record_t *)position;
+		key.val.u64 = record->messagenum;
+
+		if (record->magic != MAIL_SEARCH_MAGIC) {
+			log_pedantic("The search index is corrupted. { path = %s / offset = %zu }", search->path, (size_t)(position - (uchr_t *)search->map));
+			break;
+		}
+		else if (record->flags == MAIL_SEARCH_REMOVED) {
+			inx_delete(search->records, key);
+			position += sizeof(mail_search_record_t);
+			removed++;
+		}
+		else if (position + sizeof(mail_search_record_t) + MAIL_SEARCH_SIGNATURE <= (uchr_t *)search->map + search->length) {
+			inx_delete(search->records, key);
+			inx_insert(search->records, key, position + sizeof(mail_search_record_t));
+			position += sizeof(mail_search_record_t) + MAIL_SEARCH_SIGNATURE;
+		}
+		else {
+			break;
+		}
+	}
+
+	// Rewrite the index once the removed messages make up half of it.
+	if (removed && removed >= inx_count(search->records)) {
+		mail_search_compact(search);
+	}
+
+	return search;
+}
+
+/**
+ * @brief	Close a search index.
+ * @param	search	the search index to be closed.
+ * @return	This function returns no value.
+ */
+void mail_search_close(mail_search_t *search) {
+
+	if (search) {
+		inx_cleanup(search->records);
+		if (search->map) munmap(search->map, search->length);
+		ns_cleanup(search->path);
+		mm_free(search);
+	}
+
+	return;
+}
+
+/**
+ * @brief	Check whether a message could contain a search term.
+ * @param	search		the user's search index, which may be NULL.
+ * @param	messagenum	the numerical id of the message to be checked.
+ * @param	value		the search term, which will be matched without regard to case.
+ * @return	false if the message definitely doesn't contain the search term, or true if it must be loaded and searched.
+ */
+bool_t mail_search_check(mail_search_t *search, uint64_t messagenum, stringer_t *value) {
+
+	uchr_t *data;
+	size_t length;
+	uint32_t bit;
+	uchr_t *signature;
+	multi_t key = { .type = M_TYPE_UINT64, .val.u64 = messagenum };
+
+	if (!search || st_empty_out(value, &data, &length) || length < 3 || !(signature = inx_find(search->records, key))) {
+		return true;
+	}
+
+	for (size_t i = 0; i <= length - 3; i++) {
+		bit = mail_search_bit(data + i);
+
+		if (!(signature[bit / 8] & (1 << (bit % 8)))) {
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -105,8 +105,8 @@ uint64_t mail_store_message(uint64_t usernum, prime_t *signet, uint64_t foldernu
 	chr_t *path;
 	uint64_t messagenum;
 	bool_t store_result;
-	compress_t *reduced = NULL;
-	stringer_t *encrypted = NULL;
+	stringer_t *encrypted = NULL, *reduced = NULL;
+	mail_summary_t *summary = NULL;
 	int64_t transaction = -1, result = 0;
 	uint8_t flags = 0;
 
@@ -122,19 +122,29 @@ uint64_t mail_store_message(uint64_t usernum, prime_t *signet, uint64_t foldernu
 	}
 	else {
 
-		if (!(reduced = compress_lzo(message))) {
+		// If enabled, plain text messages are compressed in frames, so a range of the message can be read without decompressing all of it.
+		// Nodes running older releases can't read framed messages, so the option should only be enabled once the whole cluster is upgraded.
+		if (magma.storage.framed && !(reduced = mail_frames_compress(message))) {
+			log_pedantic("Unable to compress the email message.");
+			return 0;
+		}
+		else if (!magma.storage.framed && !(reduced = compress_lzo(message))) {
 			log_pedantic("Unable to compress the email message.");
 			return 0;
 		}
 
-		flags |= FMESSAGE_OPT_COMPRESSED;
-	}
+		flags |= (magma.storage.framed ? (FMESSAGE_OPT_COMPRESSED | FMESSAGE_OPT_FRAMED) : FMESSAGE_OPT_COMPRESSED);
 
+		// Precompute the IMAP summary of plain text messages. Encrypted messages are never summarized, since the summary would expose
+		// their contents, and the body structure is skipped for messages which will be signed when they're loaded.
+		summary = mail_summary_build(message, !(signum && sigkey));
+	}
 
 	// Begin the transaction.
 	if ((transaction = tran_start()) < 0) {
 		log_error("Could not start a transaction. { transaction = %li }", transaction);
-		compress_cleanup(reduced);
+		mail_summary_free(summary);
+		st_cleanup(reduced);
 		prime_cleanup(encrypted);
 		return 0;
 	}
@@ -143,16 +153,22 @@ uint64_t mail_store_message(uint64_t usernum, prime_t *signet, uint64_t foldernu
 	if ((messagenum = mail_db_insert_message(usernum, foldernum, *status, st_length_int(message), signum, sigkey, transaction)) == 0) {
 		log_pedantic("Could not create a record in the database. { mail_db_insert_message = 0 }");
 		tran_rollback(transaction);
-		compress_cleanup(reduced);
+		mail_summary_free(summary);
+		st_cleanup(reduced);
 		prime_cleanup(encrypted);
 		return 0;
 	}
 
+	// A missing summary isn't fatal, the message is simply parsed whenever the IMAP server needs it.
+	if (summary) {
+		mail_db_insert_summary(messagenum, summary, transaction);
+		mail_summary_free(summary);
+	}
+
 	// Now attempt to save everything to disk.
-	store_result = mail_store_message_data(messagenum, flags, (encrypted ? encrypted :
-		PLACER((uchr_t *)reduced, compress_total_length(reduced))), &path);
+	store_result = mail_store_message_data(messagenum, flags, (encrypted ? encrypted : reduced), &path);
 
-	compress_cleanup(reduced);
+	st_cleanup(reduced);
 	st_cleanup(encrypted);
 
 	// If the disk operation failed...
@@ -176,6 +192,11 @@ uint64_t mail_store_message(uint64_t usernum, prime_t *signet, uint64_t foldernu
 		return 0;
 	}
 
+	// Add plain text messages to the user's search index. Messages which aren't indexed are simply loaded during searches.
+	if (!signet) {
+		mail_search_index(usernum, messagenum, message);
+	}
+
 	ns_free(path);
 	return messagenum;
 }
@@ -229,6 +250,9 @@ uint64_t mail_copy_message(uint64_t usernum, uint64_t original, chr_t *server, u
 		return 0;
 	}
 
+	// Carry over the summary of the original message, if it has one.
+	mail_db_copy_summary(original, messagenum, transaction);
+
 	// Build the message path.
 	if (!(copypath = mail_message_path(messagenum, NULL))) {
 		log_error("Could not build the message path.");
@@ -0,0 +1,91 @@
+
+/**
+ * @file /magma/objects/mail/summary.c
+ *
+ * @brief	Functions used to precompute the IMAP summaries of a message when it is stored.
+ */
+
+#include "magma.h"
+
+/**
+ * @brief	Free a message summary.
+ * @param	summary		a pointer to the message summary to be freed.
+ * @return	This function returns no value.
+ */
+void mail_summary_free(mail_summary_t *summary) {
+
+	if (summary) {
+		st_cleanup(summary->envelope);
+		st_cleanup(summary->structure);
+		st_cleanup(summary->header);
+		mm_free(summary);
+	}
+
+	return;
+}
+
+/**
+ * @brief	Build the summary of a plain text message.
+ * @note	The header is extracted the same way mail_load_header() does it, and the envelope is built from it, so the summary
+ * 			matches what the IMAP server would compute from the unmodified message. The body structure is optional, since it changes
+ * 			when a spam signature is appended to the message as it's loaded.
+ * @param	message		a managed string containing the raw message.
+ * @param	structure	if true, the IMAP BODYSTRUCTURE for the message is also computed.
+ * @return	NULL on failure, or a pointer to the message summary on success.
+ */
+mail_summary_t * mail_summary_build(stringer_t *message, bool_t structure) {
+
+	size_t length;
+	mail_mime_t *mime;
+	mail_summary_t *result;
+
+	if (st_empty(message) || !(length = mail_header_end(message)) || length > st_length_get(message)) {
+		log_pedantic("Could not find the end of the message header.");
+		return NULL;
+	}
+	else if (!(result = mm_alloc(sizeof(mail_summary_t)))) {
+		log_pedantic("Unable to allocate %zu bytes for the message summary.", sizeof(mail_summary_t));
+		return NULL;
+	}
+
+	if (!(result->header = st_import(st_char_get(message), length)) || !(result->envelope = imap_fetch_envelope(result->header))) {
+		log_pedantic("Unable to build the message envelope.");
+		mail_summary_free(result);
+		return NULL;
+	}
+
+	// A missing structure isn't an error, the message will be parsed when the structure is requested.
+	if (structure && (mime = mail_mime_part(message, 1))) {
+		result->structure = imap_fetch_bodystructure(mime);
+		mail_mime_free(mime);
+	}
+
+	return result;
+}
+
+/**
+ * @brief	Get the stored summary for a message.
+ * @note	Encrypted messages are never summarized, and messages with a mark, like JUNK, have their subject branded when they're loaded,
+ * 			so neither can use a summary. Likewise the body structure is discarded if the message will be signed when it's loaded.
+ * @param	meta	the meta message object of the message being summarized.
+ * @return	NULL if the summary is unavailable or unusable, or a pointer to the message summary on success.
+ */
+mail_summary_t * mail_summary_get(meta_message_t *meta) {
+
+	mail_summary_t *result;
+
+	if (!meta || (meta->status & (MAIL_STATUS_ENCRYPTED | MAIL_MARK_JUNK | MAIL_MARK_INFECTED | MAIL_MARK_SPOOFED | MAIL_MARK_BLACKHOLED |
+		MAIL_MARK_PHISHING))) {
+		return NULL;
+	}
+	else if (!(result = mail_db_fetch_summary(meta->messagenum))) {
+		return NULL;
+	}
+
+	if (meta->signum && meta->sigkey) {
+		st_cleanup(result->structure);
+		result->structure = NULL;
+	}
+
+	return result;
+}
@@ -106,6 +106,115 @@ void meta_data_fetch_message_tags(meta_message_t *message) {
 	return;
 }
 
+/**
+ * @brief	Attach tags to a collection of messages using a batched query result.
+ * @note	Both the messages and the result rows must be ordered by message number, which allows the tags to be attached in a single
+ * 			pass. Tags are only attached to messages carrying the tagged status flag.
+ * @param	messages	an index of meta message objects, ordered by message number.
+ * @param	result		a database result holding the message number and tag columns.
+ * @return	This function returns no value.
+ */
+void meta_data_attach_message_tags(inx_t *messages, table_t *result) {
+
+	row_t *row;
+	stringer_t *tag;
+	inx_cursor_t *cursor;
+	meta_message_t *message;
+
+	if (!messages || !result || !(cursor = inx_cursor_alloc(messages))) {
+		return;
+	}
+
+	row = res_row_next(result);
+	message = inx_cursor_value_next(cursor);
+
+	while (row && message) {
+
+		if (res_field_uint64(row, 0) < message->messagenum) {
+			row = res_row_next(result);
+		}
+		else if (res_field_uint64(row, 0) > message->messagenum) {
+			message = inx_cursor_value_next(cursor);
+		}
+		else {
+
+			if ((message->status & MAIL_STATUS_TAGGED) && (tag = res_field_string(row, 1)) &&
+				!ar_append(&(message->tags), ARRAY_TYPE_STRINGER, tag)) {
+				st_free(tag);
+			}
+
+			row = res_row_next(result);
+		}
+	}
+
+	inx_cursor_free(cursor);
+
+	return;
+}
+
+/**
+ * @brief	Build a meta message object using a row returned by one of the message queries.
+ * @param	usernum		the numerical id of the user that owns the message.
+ * @param	row			a database result row holding the messagenum, foldernum, server, status, size, signum, sigkey and created columns.
+ * @return	NULL on failure, or a pointer to the newly allocated meta message object on success.
+ */
+meta_message_t * meta_data_message_alloc(uint64_t usernum, row_t *row) {
+
+	meta_message_t *message;
+
+	// We are using a fixed server name buffer of 33 bytes, so make sure the server name is 32 bytes or less.
+	if (res_field_length(row, 2) > 32) {
+		log_error("The server name found in the database was longer than 32 bytes. {usernum = %lu}", usernum);
+		return NULL;
+	}
+
+	else if (!(message = mm_alloc(sizeof(meta_message_t)))) {
+		log_pedantic("Could not allocate %zu bytes to hold the message meta information.", sizeof(meta_message_t));
+		return NULL;
+	}
+
+	// Store the data.
+	message->messagenum = res_field_uint64(row, 0);
+	message->foldernum = res_field_uint64(row, 1);
+	mm_copy(message->server, res_field_block(row, 2), res_field_length(row, 2));
+	message->status = res_field_uint32(row, 3);
+	message->size = res_field_uint32(row, 4);
+	message->signum = res_field_uint64(row, 5);
+	message->sigkey = res_field_uint64(row, 6);
+	message->created = res_field_uint64(row, 7);
+
+	if (!message->messagenum || !message->foldernum || !message->size || *(message->server) == '\0') {
+		log_error("One of the critical message variables was zero or NULL. {usernum = %lu}", usernum);
+		mm_free(message);
+		return NULL;
+	}
+
+	return message;
+}
+
+/**
+ * @brief	Get the current time according to the database server.
+ * @note	The database clock is used to checkpoint message refreshes, since the change log is timestamped by the database.
+ * @return	0 on failure, or the current database time as a UNIX timestamp.
+ */
+uint64_t meta_data_fetch_message_checkpoint(void) {
+
+	row_t *row;
+	table_t *result;
+	uint64_t checkpoint = 0;
+
+	if ((result = stmt_get_result(stmts.select_message_checkpoint, NULL))) {
+
+		if ((row = res_row_next(result))) {
+			checkpoint = res_field_uint64(row, 0);
+		}
+
+		res_table_free(result);
+	}
+
+	return checkpoint;
+}
+
 /**
  * @brief	Fetch all of a user's stored messages from the database and attach them to the meta user object.
  * @note	Any of the user's existing messages will be destroyed first to allow for updates.
@@ -117,7 +226,7 @@ bool_t meta_data_fetch_messages(meta_user_t *user) {
 	row_t *row;
 	multi_t key;
 	table_t *result;
-	inx_cursor_t *cursor;
+	uint64_t checkpoint;
 	MYSQL_BIND parameters[1];
 	meta_message_t *message;
 
@@ -129,6 +238,7 @@ bool_t meta_data_fetch_messages(meta_user_t *user) {
 
 	// If we're updating an existing index, free the current collection of messages.
 	if (user->messages) {
+		user->sequences.source = NULL;
 		inx_truncate(user->messages);
 	}
 
@@ -138,6 +248,10 @@ bool_t meta_data_fetch_messages(meta_user_t *user) {
 		return false;
 	}
 
+	// The checkpoint is taken before the messages are selected, so changes made while they are being loaded will be fetched again.
+	checkpoint = meta_data_fetch_message_checkpoint();
+	user->serials.synced = 0;
+
 	mm_wipe(parameters, sizeof(parameters));
 
 	// Usernum.
@@ -150,38 +264,14 @@ bool_t meta_data_fetch_messages(meta_user_t *user) {
 		return false;
 	}
 	else if (!(row = res_row_next(result))) {
+		user->serials.synced = checkpoint;
 		res_table_free(result);
 		return true;
 	}
 
 	while (row) {
 
-		// We are using a fixed server name buffer of 33 bytes, so make sure the server name is 32 bytes or less.
-		if (res_field_length(row, 2) > 32) {
-			log_error("The server name found in the database was longer than 32 bytes. {usernum = %lu}", user->usernum);
-			res_table_free(result);
-			return false;
-		}
-
-		else if (!(message = mm_alloc(sizeof(meta_message_t)))) {
-			log_pedantic("Could not allocate %zu bytes to hold the message meta information.", sizeof(meta_message_t));
-			res_table_free(result);
-			return false;
-		}
-
-		// Store the data.
-		message->messagenum = res_field_uint64(row, 0);
-		message->foldernum = res_field_uint64(row, 1);
-		mm_copy(message->server, res_field_block(row, 2), res_field_length(row, 2));
-		message->status = res_field_uint32(row, 3);
-		message->size = res_field_uint32(row, 4);
-		message->signum = res_field_uint64(row, 5);
-		message->sigkey = res_field_uint64(row, 6);
-		message->created = res_field_uint64(row, 7);
-
-		if (!message->messagenum || !message->foldernum || !message->size || *(message->server) == '\0') {
-			log_error("One of the critical message variables was zero or NULL. {usernum = %lu}", user->usernum);
-			mm_free(message);
+		if (!(message = meta_data_message_alloc(user->usernum, row))) {
 			res_table_free(result);
 			return false;
 		}
@@ -202,23 +292,242 @@ bool_t meta_data_fetch_messages(meta_user_t *user) {
 
 	res_table_free(result);
 
-	if ((cursor = inx_cursor_alloc(user->messages))) {
+	// Fetch the tags for every message using a single query.
+	if ((result = stmt_get_result(stmts.select_messages_tags, parameters))) {
+		meta_data_attach_message_tags(user->messages, result);
+		res_table_free(result);
+	}
+
+	user->serials.synced = checkpoint;
+
+	/// TODO: Do we still need this once the refactorization is complete?
+	/*if (meta_check_message_encryption(user) < 0) {
+		log_info("Storage encryption check failed on messages for user: %s", st_char_get(user->username));
+	}*/
+
+	return true;
+}
+
+/**
+ * @brief	Copy the stored values of a changed message into an existing meta message object.
+ * @note	The tag arrays are swapped, so the previous tags are released when the change object is freed. The in-memory sequence number
+ * 			is left alone, since it is recalculated after every refresh.
+ * @param	message		the existing meta message object to be updated.
+ * @param	change		the meta message object holding the updated values.
+ * @return	This function returns no value.
+ */
+void meta_data_message_update(meta_message_t *message, meta_message_t *change) {
+
+	array_t *tags = message->tags;
+
+	message->foldernum = change->foldernum;
+	mm_copy(message->server, change->server, sizeof(message->server));
+	message->status = change->status;
+	message->size = change->size;
+	message->signum = change->signum;
+	message->sigkey = change->sigkey;
+	message->created = change->created;
+
+	message->tags = change->tags;
+	change->tags = tags;
+
+	return;
+}
+
+/**
+ * @brief	Refresh a user's messages by fetching only the messages changed since they were last loaded.
+ * @note	The change log is read starting MESSAGES_CHANGES_OVERLAP seconds before the last checkpoint, so changes committed by
+ * 			transactions that started before the checkpoint are still picked up. Reapplying a change is harmless. The changes are merged
+ * 			with the existing messages in a single pass, since both are ordered by message number, and the existing collection is left
+ * 			untouched if anything fails. If the user's messages have never been loaded, or the last checkpoint is older than the change
+ * 			log retention window, every message is fetched instead. A changed message which no longer belongs to the user, because it
+ * 			was moved to another account, is treated as deleted.
+ * @param	user	the meta user object whose mail messages will be refreshed.
+ * @return	true on success or false on failure.
+ */
+bool_t meta_data_fetch_message_changes(meta_user_t *user) {
+
+	row_t *row;
+	multi_t key;
+	table_t *result;
+	MYSQL_BIND parameters[3];
+	uint64_t checkpoint, since;
+	inx_t *changes, *updated;
+	inx_cursor_t *existing, *delta;
+	meta_message_t *message, *change, *keep;
+
+	if (!user || !user->usernum) {
+		log_pedantic("Invalid data passed for structure build.");
+		return false;
+	}
+
+	// Fall back to a full load if the change log might not cover everything since the last checkpoint.
+	if (!user->messages || !user->serials.synced || !(checkpoint = meta_data_fetch_message_checkpoint()) ||
+		checkpoint > user->serials.synced + MESSAGES_CHANGES_WINDOW) {
+		return meta_data_fetch_messages(user);
+	}
+
+	since = user->serials.synced > MESSAGES_CHANGES_OVERLAP ? user->serials.synced - MESSAGES_CHANGES_OVERLAP : 0;
+
+	mm_wipe(parameters, sizeof(parameters));
+
+	// Usernum.
+	parameters[0].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[0].buffer_length = sizeof(uint64_t);
+	parameters[0].buffer = &(user->usernum);
+	parameters[0].is_unsigned = true;
+
+	// Since
+	parameters[1].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[1].buffer_length = sizeof(uint64_t);
+	parameters[1].buffer = &(since);
+	parameters[1].is_unsigned = true;
+
+	// Usernum, again, so a message which has moved to another user is treated as deleted. The tags query only uses the first two.
+	parameters[2].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[2].buffer_length = sizeof(uint64_t);
+	parameters[2].buffer = &(user->usernum);
+	parameters[2].is_unsigned = true;
+
+	if (!(result = stmt_get_result(stmts.select_message_changes, parameters))) {
+		return false;
+	}
+	else if (!res_row_count(result)) {
+		user->serials.synced = checkpoint;
+		res_table_free(result);
+		return true;
+	}
+	else if (!(changes = inx_alloc(M_INX_LINKED, &meta_message_free))) {
+		log_error("Could not create a linked list for the message changes.");
+		res_table_free(result);
+		return false;
+	}
+
+	// Messages which have been deleted, or hidden, are recorded using an empty object without a folder number.
+	while ((row = res_row_next(result))) {
+
+		if (res_field_int8(row, 8)) {
+			message = meta_data_message_alloc(user->usernum, row);
+		}
+		else if ((message = mm_alloc(sizeof(meta_message_t)))) {
+			message->messagenum = res_field_uint64(row, 0);
+		}
+
+		key.type = M_TYPE_UINT64;
+		key.val.u64 = message ? message->messagenum : 0;
+
+		if (!message || !inx_append(changes, key, message)) {
+			log_error("Could not append the message change to the linked list. {usernum = %lu}", user->usernum);
+			meta_message_free(message);
+			res_table_free(result);
+			inx_free(changes);
+			return false;
+		}
+	}
+
+	res_table_free(result);
+
+	// Fetch the tags for the changed messages using a single query.
+	if ((result = stmt_get_result(stmts.select_message_changes_tags, parameters))) {
+		meta_data_attach_message_tags(changes, result);
+		res_table_free(result);
+	}
+
+	if (!(updated = inx_alloc(M_INX_LINKED, &meta_message_free)) || !(existing = inx_cursor_alloc(user->messages))) {
+		log_error("Could not create a linked list for the updated messages.");
+		inx_cleanup(updated);
+		inx_free(changes);
+		return false;
+	}
+	else if (!(delta = inx_cursor_alloc(changes))) {
+		log_error("Could not create a cursor for the message changes.");
+		inx_cursor_free(existing);
+		inx_free(updated);
+		inx_free(changes);
+		return false;
+	}
+
+	// Build the updated ordering without modifying any of the existing objects, so we can bail out if an append fails.
+	message = inx_cursor_value_next(existing);
+	change = inx_cursor_value_next(delta);
 
-		while ((message = inx_cursor_value_next(cursor))) {
+	while (message || change) {
 
-			if (message->status & MAIL_STATUS_TAGGED) {
-				meta_data_fetch_message_tags(message);
+		if (message && (!change || message->messagenum < change->messagenum)) {
+			keep = message;
+			message = inx_cursor_value_next(existing);
+		}
+		else {
+
+			if (message && message->messagenum == change->messagenum) {
+				keep = change->foldernum ? message : NULL;
+				message = inx_cursor_value_next(existing);
+			}
+			else {
+				keep = change->foldernum ? change : NULL;
 			}
 
+			change = inx_cursor_value_next(delta);
 		}
 
-		inx_cursor_free(cursor);
+		key.type = M_TYPE_UINT64;
+		key.val.u64 = keep ? keep->messagenum : 0;
+
+		if (keep && !inx_append(updated, key, keep)) {
+			log_error("Could not append the message to the linked list. {usernum = %lu}", user->usernum);
+
+			// The records are still owned by the existing messages and the change list.
+			updated->data_free = NULL;
+			inx_cursor_free(existing);
+			inx_cursor_free(delta);
+			inx_free(updated);
+			inx_free(changes);
+			return false;
+		}
 	}
 
-	/// TODO: Do we still need this once the refactorization is complete?
-	/*if (meta_check_message_encryption(user) < 0) {
-		log_info("Storage encryption check failed on messages for user: %s", st_char_get(user->username));
-	}*/
+	// Now apply the changes. Updated messages keep their existing object, so the change objects merged into them are released along
+	// with any removed messages. New messages are now owned by the updated list.
+	inx_cursor_reset(existing);
+	inx_cursor_reset(delta);
+	message = inx_cursor_value_next(existing);
+
+	while ((change = inx_cursor_value_next(delta))) {
+
+		while (message && message->messagenum < change->messagenum) {
+			message = inx_cursor_value_next(existing);
+		}
+
+		if (message && message->messagenum == change->messagenum) {
+			keep = message;
+			message = inx_cursor_value_next(existing);
+
+			if (change->foldernum) {
+				meta_data_message_update(keep, change);
+			}
+			else {
+				meta_message_free(keep);
+			}
+
+			meta_message_free(change);
+		}
+		else if (!change->foldernum) {
+			meta_message_free(change);
+		}
+	}
+
+	inx_cursor_free(existing);
+	inx_cursor_free(delta);
+
+	changes->data_free = NULL;
+	user->messages->data_free = NULL;
+	inx_free(changes);
+	inx_free(user->messages);
+
+	// The message views reference the previous index, so they remain stale until the messages are re-sequenced.
+	user->sequences.source = NULL;
+	user->messages = updated;
+	user->serials.synced = checkpoint;
 
 	return true;
 }
@@ -35,6 +35,12 @@ enum {
 	MAIL_STATUS_ENCRYPTED = 65536
 };
 
+// How far back the message change log is read, to catch transactions which committed after the previous refresh, and how
+// long the last refresh can be trusted before the whole collection is reloaded. The window must be shorter than the change log
+// retention period used by the daily maintenance script.
+#define MESSAGES_CHANGES_OVERLAP 300
+#define MESSAGES_CHANGES_WINDOW 43200
+
 // The flags typically controlled by the user.
 #define MAIL_STATUS_USER_FLAGS (MAIL_STATUS_SEEN | MAIL_STATUS_ANSWERED | MAIL_STATUS_FLAGGED | MAIL_STATUS_DELETED | MAIL_STATUS_DRAFT)
 
@@ -105,6 +111,7 @@ typedef struct __attribute__ ((packed)) {
 
 #define FMESSAGE_OPT_COMPRESSED	0x1
 #define FMESSAGE_OPT_ENCRYPTED	0x2
+#define FMESSAGE_OPT_FRAMED		0x4 // The compressed data is split into independent frames, see mail_frames_compress().
 
 typedef struct __attribute__ ((packed)) {
 	uint8_t magic1;		// first magic byte: 0x17
@@ -126,12 +133,20 @@ bool_t            meta_messages_copier(meta_user_t *user, meta_message_t *messag
 bool_t            meta_messages_login_update(meta_user_t *user, META_LOCK_STATUS locked);
 int_t             meta_messages_mover(meta_user_t *user, meta_message_t *message, uint64_t target, bool_t lookup, bool_t sequences, META_LOCK_STATUS locked);
 int_t             meta_messages_update(meta_user_t *user, META_LOCK_STATUS locked);
-void              meta_messages_update_sequences(inx_t *folders, inx_t *messages);
+meta_sequence_t * meta_messages_sequence(meta_user_t *user, uint64_t foldernum);
+void              meta_messages_update_sequences(meta_user_t *user);
+void              meta_sequence_free(meta_sequence_t *sequence);
+uint64_t          meta_sequence_position(meta_sequence_t *sequence, uint64_t uid);
 
 /// datatier.c
-bool_t   meta_data_fetch_folder_messages(uint64_t usernum, message_folder_t *folder);
-void     meta_data_fetch_message_tags(meta_message_t *message);
-bool_t   meta_data_fetch_messages(meta_user_t *user);
+void             meta_data_attach_message_tags(inx_t *messages, table_t *result);
+bool_t           meta_data_fetch_folder_messages(uint64_t usernum, message_folder_t *folder);
+bool_t           meta_data_fetch_message_changes(meta_user_t *user);
+uint64_t         meta_data_fetch_message_checkpoint(void);
+void             meta_data_fetch_message_tags(meta_message_t *message);
+bool_t           meta_data_fetch_messages(meta_user_t *user);
+meta_message_t * meta_data_message_alloc(uint64_t usernum, row_t *row);
+void             meta_data_message_update(meta_message_t *message, meta_message_t *change);
 
 #endif
 
@@ -74,46 +74,162 @@ meta_message_t * meta_message_by_number(inx_t *messages, uint64_t number) {
 }
 
 /**
- * @brief	Update the sequence numbers of a series of messages, each re-indexed by their containing folder.
- * @note	All messages will be sequenced incrementally per folder, starting with a value of 1.
- * @param	folders		an inx holder containing all of the user's meta folder records.
- * @param	messages	an inx folder containing all the messages to be re-sequenced.
+ * @brief	Free a per-folder message view.
+ * @param	sequence	the message view to be freed.
  * @return	This function returns no value.
  */
-void meta_messages_update_sequences(inx_t *folders, inx_t *messages) {
+void meta_sequence_free(meta_sequence_t *sequence) {
 
-	uint64_t sequence;
-	meta_folder_t *folder;
+	if (sequence) {
+		mm_cleanup(sequence->messages);
+		mm_free(sequence);
+	}
+
+	return;
+}
+
+/**
+ * @brief	Update the sequence numbers of a user's messages, and rebuild the per-folder message views.
+ * @note	All messages will be sequenced incrementally per folder, starting with a value of 1. The messages are walked twice, once
+ * 			to count the messages in each folder and again to fill in the views, instead of once per folder. Since the messages are
+ * 			ordered by number, each view is also ordered by UID, which allows UID lookups to use a binary search.
+ * @param	user	the meta user object whose messages will be re-sequenced.
+ * @return	This function returns no value.
+ */
+void meta_messages_update_sequences(meta_user_t *user) {
+
+	inx_cursor_t *cursor;
 	meta_message_t *message;
-	inx_cursor_t *cursor_messages, *cursor_folders;
+	meta_sequence_t *sequence;
+	multi_t key = { .type = M_TYPE_UINT64, .val.u64 = 0 };
+
+	if (!user || !user->messages) {
+		return;
+	}
 
-	if (!folders || !messages || !(cursor_folders = inx_cursor_alloc(folders))) {
+	// Invalidate the existing views before rebuilding them, so a failure leaves the views marked as stale.
+	user->sequences.source = NULL;
+
+	if (user->sequences.views) {
+		inx_truncate(user->sequences.views);
+	}
+	// The views are only looked up by folder number, so they're held in a hashed index. No tree allocator is registered by default.
+	else if (!(user->sequences.views = inx_alloc(M_INX_HASHED, &meta_sequence_free))) {
+		log_pedantic("Unable to allocate the message sequence index.");
 		return;
 	}
 
-	// Iterate through all of the messages for each folder and set their sequence number.
-	while ((folder = inx_cursor_value_next(cursor_folders)) && (sequence = 1)) {
+	if (!(cursor = inx_cursor_alloc(user->messages))) {
+		return;
+	}
 
-		if ((cursor_messages = inx_cursor_alloc(messages))) {
+	// Count the messages in each folder.
+	while ((message = inx_cursor_value_next(cursor))) {
 
-			while ((message = inx_cursor_value_next(cursor_messages))) {
+		key.val.u64 = message->foldernum;
 
-				if (message->foldernum == folder->foldernum) {
-					message->sequencenum = sequence++;
-				}
+		if (!(sequence = inx_find(user->sequences.views, key))) {
 
+			if (!(sequence = mm_alloc(sizeof(meta_sequence_t)))) {
+				log_pedantic("Unable to allocate %zu bytes for a message sequence.", sizeof(meta_sequence_t));
+				inx_cursor_free(cursor);
+				return;
 			}
 
-			inx_cursor_free(cursor_messages);
+			sequence->foldernum = message->foldernum;
+
+			if (!inx_insert(user->sequences.views, key, sequence)) {
+				log_pedantic("Unable to add a message sequence to the index.");
+				inx_cursor_free(cursor);
+				mm_free(sequence);
+				return;
+			}
 		}
 
+		sequence->count++;
 	}
 
-	inx_cursor_free(cursor_folders);
+	inx_cursor_reset(cursor);
+
+	// Set the sequence numbers, and add each message to the view of its folder.
+	while ((message = inx_cursor_value_next(cursor))) {
+
+		key.val.u64 = message->foldernum;
+
+		if (!(sequence = inx_find(user->sequences.views, key))) {
+			inx_cursor_free(cursor);
+			return;
+		}
+
+		// The first message in each folder allocates the view, using the count, which is then reset and rebuilt as the view is filled.
+		else if (!sequence->messages) {
+
+			if (!(sequence->messages = mm_alloc(sequence->count * sizeof(meta_message_t *)))) {
+				log_pedantic("Unable to allocate %zu bytes for a message sequence.", sequence->count * sizeof(meta_message_t *));
+				inx_cursor_free(cursor);
+				return;
+			}
+
+			sequence->count = 0;
+		}
+
+		sequence->messages[sequence->count++] = message;
+		message->sequencenum = sequence->count;
+	}
+
+	inx_cursor_free(cursor);
+
+	user->sequences.serial = user->messages->serial;
+	user->sequences.source = user->messages;
 
 	return;
 }
 
+/**
+ * @brief	Get the view of the messages in a folder.
+ * @note	The views are rebuilt by meta_messages_update_sequences(), and will only be returned if the messages index hasn't been
+ * 			modified since, so callers must be prepared to scan the messages index instead.
+ * @param	user		the meta user object that owns the folder.
+ * @param	foldernum	the numerical id of the folder.
+ * @return	NULL if the folder is empty or the views are stale, or a pointer to the view of the folder.
+ */
+meta_sequence_t * meta_messages_sequence(meta_user_t *user, uint64_t foldernum) {
+
+	multi_t key = { .type = M_TYPE_UINT64, .val.u64 = foldernum };
+
+	if (!user || !user->messages || !user->sequences.views || user->sequences.source != user->messages ||
+		user->sequences.serial != user->messages->serial) {
+		return NULL;
+	}
+
+	return inx_find(user->sequences.views, key);
+}
+
+/**
+ * @brief	Find the position of the first message in a folder view with a UID greater than or equal to the specified value.
+ * @param	sequence	the folder view to be searched.
+ * @param	uid			the UID being searched for.
+ * @return	the zero-based position of the message, or the number of messages in the view if every UID is lower.
+ */
+uint64_t meta_sequence_position(meta_sequence_t *sequence, uint64_t uid) {
+
+	uint64_t low = 0, high = sequence ? sequence->count : 0, middle;
+
+	while (low < high) {
+
+		middle = low + ((high - low) / 2);
+
+		if (sequence->messages[middle]->messagenum < uid) {
+			low = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+
+	return low;
+}
+
 /**
  * @brief	Build a user's messages collection if it is empty, or needs to be refreshed (see note).
  * @note	This function will fetch and sequence the user's messages from the database if the meta user object has no messages,
@@ -143,8 +259,8 @@ bool_t meta_messages_login_update(meta_user_t *user, META_LOCK_STATUS locked) {
 			user->serials.messages = serial_increment(OBJECT_MESSAGES, user->usernum);
 		}
 
-		if ((output = meta_data_fetch_messages(user)) && user->folders) {
-			meta_messages_update_sequences(user->folders, user->messages);
+		if ((output = meta_data_fetch_message_changes(user))) {
+			meta_messages_update_sequences(user);
 		}
 	}
 
@@ -155,8 +271,8 @@ bool_t meta_messages_login_update(meta_user_t *user, META_LOCK_STATUS locked) {
 			user->serials.messages = serial_increment(OBJECT_MESSAGES, user->usernum);
 		}
 
-		if ((output = meta_data_fetch_messages(user)) && user->folders) {
-			meta_messages_update_sequences(user->folders, user->messages);
+		if ((output = meta_data_fetch_messages(user))) {
+			meta_messages_update_sequences(user);
 		}
 	}
 
@@ -171,7 +287,8 @@ bool_t meta_messages_login_update(meta_user_t *user, META_LOCK_STATUS locked) {
 /**
  * @brief	Refresh and resquence a user's message collection if it is stale.
  * @note	The user's messages will only be updated if they are empty or if they are out of sync and the user has no open pop sessions.
- * @see		meta_data_fetch_messages()
+ * 			Stale collections are refreshed using only the messages changed since they were last loaded.
+ * @see		meta_data_fetch_message_changes()
  * @param	user	a pointer to the meta user object requesting the messages update.
  * @param	locked	if set to META_NEED_LOCK, lock the specified meta user object for the duration of the request.
  * @return	-1 on failure, or 1 on success.
@@ -197,8 +314,8 @@ int_t meta_messages_update(meta_user_t *user, META_LOCK_STATUS locked) {
 			user->serials.messages = serial_increment(OBJECT_MESSAGES, user->usernum);
 		}
 
-		if ((output = meta_data_fetch_messages(user)) && user->folders) {
-			meta_messages_update_sequences(user->folders, user->messages);
+		if ((output = meta_data_fetch_message_changes(user))) {
+			meta_messages_update_sequences(user);
 		}
 	}
 
@@ -209,8 +326,8 @@ int_t meta_messages_update(meta_user_t *user, META_LOCK_STATUS locked) {
 			user->serials.messages = serial_increment(OBJECT_MESSAGES, user->usernum);
 		}
 
-		if ((output = meta_data_fetch_messages(user)) && user->folders) {
-			meta_messages_update_sequences(user->folders, user->messages);
+		if ((output = meta_data_fetch_messages(user))) {
+			meta_messages_update_sequences(user);
 		}
 
 	}
@@ -291,7 +408,7 @@ bool_t meta_messages_copier(meta_user_t *user, meta_message_t *message, uint64_t
 
 	// If this operation is part of a much larger one we might want to wait until the end to update the message sequence numbers.
 	if (sequences) {
-		meta_messages_update_sequences(user->folders, user->messages);
+		meta_messages_update_sequences(user);
 	}
 
 	if (locked == META_NEED_LOCK) {
@@ -359,7 +476,7 @@ int_t meta_messages_mover(meta_user_t *user, meta_message_t *message, uint64_t t
 
 	// If this operation is part of a much larger one we might want to wait until the end to update the message sequence numbers.
 	if (sequences) {
-		meta_messages_update_sequences(user->folders, user->messages);
+		meta_messages_update_sequences(user);
 	}
 
 	if (locked == META_NEED_LOCK) {
@@ -79,6 +79,10 @@ void meta_data_update_lock(uint64_t usernum, uint8_t lock) {
 	if (stmt_exec_affected(stmts.update_user_lock, parameters) != 1) {
 		log_pedantic("Unable to update the user lock. {usernum = %lu / lock = %hhu}", usernum, lock);
 	}
+	// Let any cached copies of the account, like the SMTP recipient preferences, know the lock changed.
+	else {
+		serial_increment(OBJECT_USER, usernum);
+	}
 
 	return;
 }
@@ -37,36 +37,65 @@ void meta_inx_remove(uint64_t usernum, META_PROTOCOL protocol) {
 	return;
 }
 
+/**
+ * @brief	Find a user's object in the cache, adding an empty object if the user isn't cached, and take a reference.
+ * @note	The common case, where the user is already cached, only needs the shared cache lock, since the reference counters are
+ * 			updated atomically and the prune function can't remove objects while any reader holds the lock. The exclusive lock is
+ * 			only taken to insert a new object, which is allocated beforehand, and we check again in case another thread won the race.
+ * @param	usernum		the numeric identifier of the user.
+ * @param	protocol	the protocol bound to the reference counter to be incremented (META_PROT_WEB, META_PROT_IMAP, etc.)
+ * @return	NULL on failure, or a pointer to the user's meta object.
+ */
 meta_user_t * meta_inx_find(uint64_t usernum, META_PROTOCOL protocol) {
 
-	meta_user_t *user = NULL;
+	meta_user_t *user = NULL, *created = NULL;
 	multi_t key = { .type = M_TYPE_UINT64, .val.u64 = usernum };
 
 	if (!usernum) {
 		return NULL;
 	}
 
-	// Pull the user from the cache, or add it.
+	// Try pulling the user from the cache first.
+	inx_lock_read(objects.meta);
+
+	if ((user = inx_find(objects.meta, key))) {
+		meta_user_ref_add(user, protocol);
+	}
+
+	inx_unlock(objects.meta);
+
+	if (user) {
+		return user;
+	}
+
+	// We need to create a new one.
+	if (!(created = meta_alloc())) {
+		return NULL;
+	}
+
+	created->usernum = usernum;
 	inx_lock_write(objects.meta);
 
-	// Pull the object.
+	// Another thread may have added the user while we were waiting for the lock.
 	if (!(user = inx_find(objects.meta, key))) {
 
-		// We need to create a new one.
-		if (!(user = meta_alloc()) || !inx_insert(objects.meta, key, user)) {
+		if (!inx_insert(objects.meta, key, created)) {
 			inx_unlock(objects.meta);
-			meta_free(user);
+			meta_free(created);
 			return NULL;
 		}
-		else {
-			user->usernum = usernum;
-		}
 
+		user = created;
+		created = NULL;
 	}
 
 	// Add a reference.
 	meta_user_ref_add(user, protocol);
 	inx_unlock(objects.meta);
 
+	if (created) {
+		meta_free(created);
+	}
+
 	return user;
 }
@@ -26,12 +26,12 @@ void meta_free(meta_user_t *user) {
 		inx_cleanup(user->message_folders);
 		inx_cleanup(user->messages);
 		inx_cleanup(user->contacts);
+		inx_cleanup(user->sequences.views);
 
 		st_cleanup(user->username, user->verification, user->realm.mail);
 
 		// When read/write locking issues have been fixed, this line can be used once again.
 		rwlock_destroy(&(user->lock));
-		mutex_destroy(&(user->refs.lock));
 
 		mm_free(user);
 	}
@@ -77,14 +77,6 @@ meta_user_t * meta_alloc(void) {
 		mm_free(user);
 		return NULL;
 	}
-	// Initialize the mutex.
-	else if (mutex_init(&(user->refs.lock), NULL) != 0) {
-		log_pedantic("Unable to initialize the user reference lock.");
-		rwlock_destroy(&(user->lock));
-		rwlock_attr_destroy(&attr);
-		mm_free(user);
-		return NULL;
-	}
 
 	rwlock_attr_destroy(&attr);
 
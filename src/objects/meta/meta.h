@@ -45,6 +45,7 @@ int_t   meta_update_user(meta_user_t *user, META_LOCK_STATUS locked);
 
 /// references.c
 void       meta_user_ref_add(meta_user_t *user, META_PROTOCOL protocol);
+uint64_t * meta_user_ref_counter(meta_user_t *user, META_PROTOCOL protocol);
 void       meta_user_ref_dec(meta_user_t *user, META_PROTOCOL protocol);
 uint64_t   meta_user_ref_protocol_total(meta_user_t *user, META_PROTOCOL protocol);
 time_t     meta_user_ref_stamp(meta_user_t *user);
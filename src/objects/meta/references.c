@@ -7,6 +7,31 @@
 
 #include "magma.h"
 
+/**
+ * @brief	Get the reference counter used to track a protocol.
+ * @note	The counters are updated atomically, so taking a reference doesn't require any locks.
+ * @param	user		a pointer to the meta user object holding the counters.
+ * @param	protocol	the protocol identifier for the session using the META_PROTOCOL enumerator.
+ * @return	NULL if the protocol doesn't have a counter, or a pointer to the counter.
+ */
+uint64_t * meta_user_ref_counter(meta_user_t *user, META_PROTOCOL protocol) {
+
+	uint64_t *result = NULL;
+
+	if ((protocol & META_PROTOCOL_WEB) == META_PROTOCOL_WEB) result = &(user->refs.web);
+	else if ((protocol & META_PROTOCOL_IMAP) == META_PROTOCOL_IMAP) result = &(user->refs.imap);
+	else if ((protocol & META_PROTOCOL_POP) == META_PROTOCOL_POP) result = &(user->refs.pop);
+	else if ((protocol & META_PROTOCOL_SMTP) == META_PROTOCOL_SMTP) result = &(user->refs.smtp);
+	else if ((protocol & META_PROTOCOL_GENERIC) == META_PROTOCOL_GENERIC) result = &(user->refs.generic);
+#ifdef MAGMA_PEDANTIC
+	else {
+		log_pedantic("The protocol enumerator doesn't have a reference counter. { protocol = %u }", protocol);
+	}
+#endif
+
+	return result;
+}
+
 /**
  * @brief	Increment a meta user's reference counter for a specified protocol and update the activity timestamp.
  *
@@ -19,28 +44,15 @@
  */
 void meta_user_ref_add(meta_user_t *user, META_PROTOCOL protocol) {
 
-	if (user) {
+	uint64_t *counter;
 
-		// Acquire the reference counter lock.
-		mutex_lock(&(user->refs.lock));
+	if (user && (counter = meta_user_ref_counter(user, protocol))) {
 
 		// Increment the right counter.
-		if ((protocol & META_PROTOCOL_WEB) == META_PROTOCOL_WEB) user->refs.web++;
-		else if ((protocol & META_PROTOCOL_IMAP) == META_PROTOCOL_IMAP) user->refs.imap++;
-		else if ((protocol & META_PROTOCOL_POP) == META_PROTOCOL_POP) user->refs.pop++;
-		else if ((protocol & META_PROTOCOL_SMTP) == META_PROTOCOL_SMTP) user->refs.smtp++;
-		else if ((protocol & META_PROTOCOL_GENERIC) == META_PROTOCOL_GENERIC) user->refs.generic++;
-#ifdef MAGMA_PEDANTIC
-		else {
-			log_pedantic("The protocol enumerator doesn't have a reference counter. { protocol = %u }", protocol);
-		}
-#endif
+		__atomic_add_fetch(counter, 1, __ATOMIC_RELAXED);
 
 		// Update the activity time stamp.
-		 user->refs.stamp = time(NULL);
-
-		// Release the reference counter lock.
-		mutex_unlock(&(user->refs.lock));
+		__atomic_store_n(&(user->refs.stamp), time(NULL), __ATOMIC_RELAXED);
 
 	}
 
@@ -59,28 +71,15 @@ void meta_user_ref_add(meta_user_t *user, META_PROTOCOL protocol) {
  */
 void meta_user_ref_dec(meta_user_t *user, META_PROTOCOL protocol) {
 
-	if (user) {
+	uint64_t *counter;
 
-		// Acquire the reference counter lock.
-		mutex_lock(&(user->refs.lock));
+	if (user && (counter = meta_user_ref_counter(user, protocol))) {
 
 		// Decrement the right counter.
-		if ((protocol & META_PROTOCOL_WEB) == META_PROTOCOL_WEB) user->refs.web--;
-		else if ((protocol & META_PROTOCOL_IMAP) == META_PROTOCOL_IMAP) user->refs.imap--;
-		else if ((protocol & META_PROTOCOL_POP) == META_PROTOCOL_POP) user->refs.pop--;
-		else if ((protocol & META_PROTOCOL_SMTP) == META_PROTOCOL_SMTP) user->refs.smtp--;
-		else if ((protocol & META_PROTOCOL_GENERIC) == META_PROTOCOL_GENERIC) user->refs.generic--;
-#ifdef MAGMA_PEDANTIC
-		else {
-			log_pedantic("The protocol enumerator doesn't have a reference counter. { protocol = %u }", protocol);
-		}
-#endif
+		__atomic_sub_fetch(counter, 1, __ATOMIC_RELAXED);
 
 		// Update the activity time stamp.
-		user->refs.stamp = time(NULL);
-
-		// Release the reference counter lock.
-		mutex_unlock(&(user->refs.lock));
+		__atomic_store_n(&(user->refs.stamp), time(NULL), __ATOMIC_RELAXED);
 
 	}
 
@@ -97,28 +96,10 @@ void meta_user_ref_dec(meta_user_t *user, META_PROTOCOL protocol) {
  */
 uint64_t meta_user_ref_protocol_total(meta_user_t *user, META_PROTOCOL protocol) {
 
-	uint64_t result = 0;
-
-	if (user) {
-
-		// Acquire the reference counter lock.
-		mutex_lock(&(user->refs.lock));
-
-		// Decrement the right counter.
-		if ((protocol & META_PROTOCOL_WEB) == META_PROTOCOL_WEB) result = user->refs.web;
-		else if ((protocol & META_PROTOCOL_IMAP) == META_PROTOCOL_IMAP) result = user->refs.imap;
-		else if ((protocol & META_PROTOCOL_POP) == META_PROTOCOL_POP) result = user->refs.pop;
-		else if ((protocol & META_PROTOCOL_SMTP) == META_PROTOCOL_SMTP) result = user->refs.smtp;
-		else if ((protocol & META_PROTOCOL_GENERIC) == META_PROTOCOL_GENERIC) result = user->refs.generic;
-#ifdef MAGMA_PEDANTIC
-		else {
-			log_pedantic("The protocol enumerator doesn't have a reference counter. { protocol = %u }", protocol);
-		}
-#endif
-
-		// Release the reference counter lock.
-		mutex_unlock(&(user->refs.lock));
+	uint64_t *counter, result = 0;
 
+	if (user && (counter = meta_user_ref_counter(user, protocol))) {
+		result = __atomic_load_n(counter, __ATOMIC_RELAXED);
 	}
 
 	return result;
@@ -137,14 +118,10 @@ uint64_t meta_user_ref_total(meta_user_t *user) {
 
 	if (user) {
 
-		// Acquire the reference counter lock.
-		mutex_lock(&(user->refs.lock));
-
 		// Sum the total.
-		result = user->refs.web + user->refs.imap + user->refs.pop + user->refs.smtp + user->refs.generic;
-
-		// Release the reference counter lock.
-		mutex_unlock(&(user->refs.lock));
+		result = __atomic_load_n(&(user->refs.web), __ATOMIC_RELAXED) + __atomic_load_n(&(user->refs.imap), __ATOMIC_RELAXED) +
+			__atomic_load_n(&(user->refs.pop), __ATOMIC_RELAXED) + __atomic_load_n(&(user->refs.smtp), __ATOMIC_RELAXED) +
+			__atomic_load_n(&(user->refs.generic), __ATOMIC_RELAXED);
 
 	}
 
@@ -164,14 +141,8 @@ time_t meta_user_ref_stamp(meta_user_t *user) {
 
 	if (user) {
 
-		// Acquire the reference counter lock.
-		mutex_lock(&(user->refs.lock));
-
 		// Grab the object time stamp.
-		stamp = user->refs.stamp;
-
-		// Release the reference counter lock.
-		mutex_unlock(&(user->refs.lock));
+		stamp = __atomic_load_n(&(user->refs.stamp), __ATOMIC_RELAXED);
 
 	}
 
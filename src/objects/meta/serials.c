@@ -88,7 +88,7 @@ bool_t meta_user_serial_check(meta_user_t *user, uint64_t object) {
 	int_t result = false;
 
 	// If the serial number indicates no outside changes we can increment it without forcing a refresh.{
-	if (user && meta_user_serial_get(user, object) == serial_get(object, user->usernum)) {
+	if (user && meta_user_serial_get(user, object) == serial_get_uncached(object, user->usernum)) {
 		meta_user_serial_set(user, object, serial_increment(object, user->usernum));
 	}
 	// Increment the reference counter and queue a session update.
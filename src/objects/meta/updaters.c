@@ -380,7 +380,7 @@ int_t meta_update_folders(meta_user_t *user, META_LOCK_STATUS locked) {
 		}
 
 		if ((output = meta_data_fetch_folders(user)) && user->messages) {
-			meta_messages_update_sequences(user->folders, user->messages);
+			meta_messages_update_sequences(user);
 		}
 	}
 
@@ -392,7 +392,7 @@ int_t meta_update_folders(meta_user_t *user, META_LOCK_STATUS locked) {
 		}
 
 		if ((output = meta_data_fetch_folders(user)) && user->messages) {
-			meta_messages_update_sequences(user->folders, user->messages);
+			meta_messages_update_sequences(user);
 		}
 	}
 
@@ -27,6 +27,9 @@ enum {
 	OBJECT_ALIASES
 };
 
+/// The number of object types tracked with serial numbers.
+#define SERIAL_OBJECTS (OBJECT_ALIASES + 1)
+
 typedef struct {
 	inx_t *meta, *sessions;
 } object_cache_t;
@@ -45,7 +48,11 @@ void obj_cache_prune(void);
 void obj_cache_stop(void);
 
 /// serials.c
+bool_t   serial_cache_get(uint64_t type, uint64_t num, uint64_t *value);
+void     serial_cache_set(uint64_t type, uint64_t num, uint64_t value);
 uint64_t serial_get(uint64_t type, uint64_t num);
+size_t   serial_get_all(uint64_t num, uint64_t *serials);
+uint64_t serial_get_uncached(uint64_t type, uint64_t num);
 uint64_t serial_increment(uint64_t type, uint64_t num);
 uint64_t serial_reset(uint64_t type, uint64_t num);
 
@@ -7,6 +7,17 @@
 
 #include "magma.h"
 
+/// The number of slots in the local serial cache, and the number of microseconds a value is trusted before memcached is asked again.
+#define SERIAL_CACHE_SLOTS 4096
+#define SERIAL_CACHE_TTL 500000
+
+typedef struct {
+	uint64_t type, num, value, expiration;
+} serial_slot_t;
+
+serial_slot_t serial_cache[SERIAL_CACHE_SLOTS];
+pthread_mutex_t serial_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 stringer_t *serial_prefix_strings[] = {
 	 CONSTANT("user"),
 	 CONSTANT("config"),
@@ -53,14 +64,89 @@ stringer_t * serial_prefix(uint64_t type) {
 	return prefix;
 }
 
+/**
+ * @brief	Look for a recently fetched serial number in the local cache.
+ * @param	type	the serial object type.
+ * @param	num		the specific object identifier.
+ * @param	value	a pointer to receive the serial number if it was found.
+ * @return	true if a fresh value was found, or false if memcached needs to be consulted.
+ */
+bool_t serial_cache_get(uint64_t type, uint64_t num, uint64_t *value) {
+
+	bool_t result = false;
+	serial_slot_t *slot = &(serial_cache[((num * SERIAL_OBJECTS) + type) % SERIAL_CACHE_SLOTS]);
+	uint64_t now = time_microseconds();
+
+	mutex_lock(&serial_cache_mutex);
+
+	if (slot->value && slot->type == type && slot->num == num && slot->expiration > now) {
+		*value = slot->value;
+		result = true;
+	}
+
+	mutex_unlock(&serial_cache_mutex);
+
+	return result;
+}
+
+/**
+ * @brief	Record a serial number in the local cache.
+ * @note	A value lower than the one already cached for the same object is refused until the cached value expires. Serial
+ * 			numbers only move forward, so a lower value can only come from a fetch which raced with an increment, and storing
+ * 			it would hide the increment from the compare-then-increment logic. Passing zero always discards the cached value.
+ * @param	type	the serial object type.
+ * @param	num		the specific object identifier.
+ * @param	value	the serial number, or zero to discard the cached value.
+ * @return	This function returns no value.
+ */
+void serial_cache_set(uint64_t type, uint64_t num, uint64_t value) {
+
+	serial_slot_t *slot = &(serial_cache[((num * SERIAL_OBJECTS) + type) % SERIAL_CACHE_SLOTS]);
+	uint64_t now = time_microseconds();
+
+	mutex_lock(&serial_cache_mutex);
+
+	if (!value || slot->type != type || slot->num != num || slot->expiration <= now || slot->value <= value) {
+		slot->type = type;
+		slot->num = num;
+		slot->value = value;
+		slot->expiration = now + SERIAL_CACHE_TTL;
+	}
+
+	mutex_unlock(&serial_cache_mutex);
+
+	return;
+}
+
 /**
  * @brief	Get the serial number (checkpoint value) for an object from memcached.
+ * @note	Values fetched within the last half second are answered from the local cache, so this function should only be used
+ * 			by read only polling paths. Callers which compare a serial before incrementing it must use serial_get_uncached().
  * @param	type	the serial type to be queried (OBJECT_USER, OBJECT_CONFIG, OBJECT_FOLDERS, OBJECT_MESSAGES, or OBJECT_CONTACTS).
  * @param	num		the specific object identifier.
  * @return	0 on failure or the serial number of the requested object.
  */
 uint64_t serial_get(uint64_t type, uint64_t num) {
 
+	uint64_t result = 0;
+
+	if (serial_cache_get(type, num, &result)) {
+		return result;
+	}
+
+	return serial_get_uncached(type, num);
+}
+
+/**
+ * @brief	Get the serial number (checkpoint value) for an object directly from memcached, bypassing the local cache.
+ * @note	This is the variant to use before a compare-then-increment, where a serial number incremented by another cluster node
+ * 			within the cache lifetime would otherwise go unnoticed. The value fetched is still used to refresh the local cache.
+ * @param	type	the serial type to be queried (OBJECT_USER, OBJECT_CONFIG, OBJECT_FOLDERS, OBJECT_MESSAGES, or OBJECT_CONTACTS).
+ * @param	num		the specific object identifier.
+ * @return	0 on failure or the serial number of the requested object.
+ */
+uint64_t serial_get_uncached(uint64_t type, uint64_t num) {
+
 	uint64_t result = 0;
 	stringer_t *key, *prefix;
 
@@ -72,11 +158,50 @@ uint64_t serial_get(uint64_t type, uint64_t num) {
 
 	// Get the key value. The increment functions store the value in binary form, so we must use them to access the value, even if we aren't incrementing the value.
 	result = cache_increment(key, 0, 0, 2592000);
+	serial_cache_set(type, num, result);
 	st_free(key);
 
 	return result;
 }
 
+/**
+ * @brief	Get every serial number associated with an object identifier using a single memcached request.
+ * @note	Callers which check several object types in a row, like the IMAP session update, should use this function so the
+ * 			serials are fetched together instead of with one round trip per type. The values are also stored in the local cache,
+ * 			so subsequent calls to serial_get() will be answered without contacting memcached.
+ * @param	num		the specific object identifier.
+ * @param	serials	an array of SERIAL_OBJECTS entries, indexed by object type, which will receive the serial numbers.
+ * @return	the number of serial numbers that were found.
+ */
+size_t serial_get_all(uint64_t num, uint64_t *serials) {
+
+	size_t result = 0;
+	stringer_t *prefix, *keys[SERIAL_OBJECTS];
+
+	if (!serials) {
+		return 0;
+	}
+
+	mm_wipe(keys, sizeof(keys));
+
+	for (uint64_t type = 0; type < SERIAL_OBJECTS; type++) {
+		if (!(prefix = serial_prefix(type)) || !(keys[type] = st_aprint("magma.%.*s.%lu", st_length_int(prefix), st_char_get(prefix), num))) {
+			log_pedantic("Unable to build %.*s serial key.", st_length_int(prefix), st_char_get(prefix));
+			for (uint64_t i = 0; i < type; i++) st_free(keys[i]);
+			return 0;
+		}
+	}
+
+	result = cache_counters(keys, serials, SERIAL_OBJECTS);
+
+	for (uint64_t type = 0; type < SERIAL_OBJECTS; type++) {
+		if (serials[type]) serial_cache_set(type, num, serials[type]);
+		st_free(keys[type]);
+	}
+
+	return result;
+}
+
 /**
  * @brief	Increment the serial number for an object in memcached.
  * @param	type	the serial type to be queried (OBJECT_USER, OBJECT_CONFIG, OBJECT_FOLDERS, OBJECT_MESSAGES, or OBJECT_CONTACTS).
@@ -96,6 +221,7 @@ uint64_t serial_increment(uint64_t type, uint64_t num) {
 
 	// Increment the key.
 	result = cache_increment(key, 1, 1, 2592000);
+	serial_cache_set(type, num, result);
 	st_free(key);
 
 	return result;
@@ -123,6 +249,8 @@ uint64_t serial_reset(uint64_t type, uint64_t num) {
 		result = 1;
 	}
 
+	// A reset lowers the serial number, which the local cache refuses to store, so the cached value is discarded instead.
+	serial_cache_set(type, num, 0);
 	st_free(key);
 
 	return result;
@@ -405,13 +405,18 @@ session_t *sess_create(connection_t *con, stringer_t *path, stringer_t *applicat
 
 	sess_ref_add(output);
 
+	inx_lock_write(objects.sessions);
+
 	if (inx_insert(objects.sessions, key, output) != 1) {
+		inx_unlock(objects.sessions);
 		log_pedantic("Unable to insert the session into the global context.");
 		sess_ref_dec(output);
 		sess_destroy(output);
 		return NULL;
 	}
 
+	inx_unlock(objects.sessions);
+
 	return output;
 }
 
@@ -509,10 +514,14 @@ int_t sess_get(connection_t *con, stringer_t *application, stringer_t *path, str
 	// QUESTION: This destruction needs a second look.
 	if (result < 0) {
 
+		inx_lock_write(objects.sessions);
+
 		if (!inx_delete(objects.sessions, key)) {
 			log_pedantic("Unexpected error occurred attempting to delete expired cookie { user = %s }", st_char_get(con->http.session->user->username));
 		}
 
+		inx_unlock(objects.sessions);
+
 		sess_ref_dec(con->http.session);
 		//sess_destroy(con->http.session);
 		con->http.session = NULL;
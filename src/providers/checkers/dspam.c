@@ -74,7 +74,7 @@ int_t dspam_check(uint64_t usernum, stringer_t *message, stringer_t **signature)
 
 	st_free(tmpdir);
 
-	if (pool_pull(sql_pool, &connection) != PL_RESERVED) {
+	if (sql_pull(&connection) != PL_RESERVED) {
 		log_info("Unable to get an available connection for the query.");
 		dspam_destroy_d(ctx);
 		return -1;
@@ -195,7 +195,7 @@ bool_t dspam_train(uint64_t usernum, int_t disposition, stringer_t *signature) {
 	st_free(tmpdir);
 
 	// Get a DB connection.
-	if (pool_pull(sql_pool, &connection) != PL_RESERVED) {
+	if (sql_pull(&connection) != PL_RESERVED) {
 		log_info("Unable to get an available connection for the query.");
 		dspam_destroy_d(ctx);
 		return false;
@@ -66,6 +66,7 @@ stringer_t * decompress_lzo(compress_t *compressed);
 /// zlib.c
 bool_t lib_load_zlib(void);
 const char * lib_version_zlib(void);
+stringer_t * compress_gzip(stringer_t *input);
 compress_t * compress_zlib(stringer_t *input);
 stringer_t * decompress_zlib(compress_t *compressed);
 
@@ -221,3 +221,53 @@ compress_t * compress_zlib(stringer_t *input) {
 
 	 return result;
 }
+
+/**
+ * @brief	Compress a block of data into the gzip format used by the HTTP content encoding.
+ * @note	Unlike compress_zlib(), the output doesn't have a compression header, so it can be sent to a web client as is.
+ * @param	input	a managed string containing the data to be compressed.
+ * @return	NULL on failure, or a managed string containing the gzip compressed data on success.
+ */
+stringer_t * compress_gzip(stringer_t *input) {
+
+	int_t ret;
+	z_stream zs;
+	stringer_t *result;
+
+	if (st_empty(input)) {
+		log_pedantic("An empty string was passed in.");
+		return NULL;
+	}
+
+	// The bound covers the zlib wrapper, so we add room for the larger gzip header and trailer.
+	else if (!(result = st_alloc(compressBound_d(st_length_get(input)) + 32))) {
+		log_info("Unable to allocate the compression buffer.");
+		return NULL;
+	}
+
+	mm_wipe(&zs, sizeof(z_stream));
+
+	// Adding 16 to the window bits tells zlib to write a gzip header and trailer.
+	if ((ret = deflateInit2__d(&zs, 9, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY, ZLIB_VERSION, sizeof(z_stream))) != Z_OK) {
+		log_info("Unable to initialize the compression stream. {deflateInit2 = %i}", ret);
+		st_free(result);
+		return NULL;
+	}
+
+	zs.next_in = st_data_get(input);
+	zs.avail_in = st_length_get(input);
+	zs.next_out = st_data_get(result);
+	zs.avail_out = st_avail_get(result);
+
+	if ((ret = deflate_d(&zs, Z_FINISH)) != Z_STREAM_END) {
+		log_info("Unable to compress the buffer. {deflate = %i}", ret);
+		deflateEnd_d(&zs);
+		st_free(result);
+		return NULL;
+	}
+
+	st_length_set(result, zs.total_out);
+	deflateEnd_d(&zs);
+
+	return result;
+}
@@ -17,9 +17,9 @@ bool_t lib_load_cache(void) {
 
 	symbol_t cache[] = {
 		M_BIND(memcached_add), M_BIND(memcached_append), M_BIND(memcached_behavior_set), M_BIND(memcached_cas), M_BIND(memcached_create),
-		M_BIND(memcached_decrement), M_BIND(memcached_decrement_with_initial), M_BIND(memcached_delete), M_BIND(memcached_flush),
-		M_BIND(memcached_free), M_BIND(memcached_get), M_BIND(memcached_increment),	M_BIND(memcached_increment_with_initial),
-		M_BIND(memcached_lib_version), M_BIND(memcached_prepend), M_BIND(memcached_replace), M_BIND(memcached_server_add_with_weight),
+		M_BIND(memcached_decrement), M_BIND(memcached_decrement_with_initial), M_BIND(memcached_delete), M_BIND(memcached_fetch),
+		M_BIND(memcached_flush), M_BIND(memcached_free), M_BIND(memcached_get), M_BIND(memcached_increment),
+		M_BIND(memcached_increment_with_initial), M_BIND(memcached_lib_version), M_BIND(memcached_mget), M_BIND(memcached_prepend), M_BIND(memcached_replace), M_BIND(memcached_server_add_with_weight),
 		M_BIND(memcached_set), M_BIND(memcached_strerror)
 	};
 
@@ -221,6 +221,73 @@ uint64_t cache_get_u64(stringer_t *key) {
 	return result;
 }
 
+/**
+ * @brief	Retrieve a group of counters from memcached using a single request.
+ * @note	Counters are the values maintained by the increment and decrement functions, which memcached stores as decimal
+ * 			text. The keys are sent to the servers together, and the replies are matched back to their keys as they arrive,
+ * 			so fetching a group of counters costs one round trip per server instead of one per key. Values which aren't found
+ * 			are left at zero.
+ * @param	keys	an array of managed strings holding the counter keys.
+ * @param	values	an array which will receive the counter values, in the same order as the keys.
+ * @param	count	the number of keys in the array.
+ * @return	the number of counters that were found.
+ */
+size_t cache_counters(stringer_t **keys, uint64_t *values, size_t count) {
+
+	void *data;
+	uint32_t flags, pool;
+	size_t found = 0, length, klength;
+	memcached_return_t error;
+	const char *names[count];
+	size_t lengths[count];
+	chr_t name[MEMCACHED_MAX_KEY];
+
+	if (!keys || !values || !count) {
+		return 0;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+
+		if (st_empty(keys[i])) {
+			return 0;
+		}
+
+		names[i] = st_char_get(keys[i]);
+		lengths[i] = st_length_get(keys[i]);
+		values[i] = 0;
+	}
+
+	if ((pool_pull(cache_pool, &pool)) != PL_RESERVED) {
+		return 0;
+	}
+	else if ((error = memcached_mget_d(pool_get_obj(cache_pool, pool), names, lengths, count)) != MEMCACHED_SUCCESS) {
+		log_info("Unable to request a group of counters. { count = %zu / error = %s }", count, memcached_strerror_d(pool_get_obj(cache_pool, pool), error));
+		pool_release(cache_pool, pool);
+		return 0;
+	}
+
+	// The replies have to be drained completely before the connection can be handed to another thread.
+	while ((data = memcached_fetch_d(pool_get_obj(cache_pool, pool), name, &klength, &length, &flags, &error))) {
+
+		for (size_t i = 0; i < count; i++) {
+			if (klength == lengths[i] && !mm_cmp_cs_eq(name, (void *)names[i], klength)) {
+				if (length && uint64_conv_bl(data, length, &values[i])) found++;
+				break;
+			}
+		}
+
+		mm_free(data);
+	}
+
+	if (error != MEMCACHED_END && error != MEMCACHED_NOTFOUND && error != MEMCACHED_SUCCESS) {
+		log_info("An error occurred while fetching a group of counters. { count = %zu / error = %s }", count,
+			memcached_strerror_d(pool_get_obj(cache_pool, pool), error));
+	}
+
+	pool_release(cache_pool, pool);
+	return found;
+}
+
 /**
  * @brief	Set a value in memcached by key.
  * @param	key			a managed string containing a key to be passed to memcached.
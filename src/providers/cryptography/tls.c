@@ -410,6 +410,25 @@ int tls_status(TLS *tls) {
 	return result;
 }
 
+/**
+ * @brief	Get the number of decrypted bytes buffered inside the TLS layer which are available for reading.
+ * @see		SSL_pending()
+ * @note	Data held by the TLS layer won't trigger a readable event on the underlying socket, so callers that wait on the socket
+ * 			descriptor need to check this value first.
+ * @param	tls		the TLS connection to be checked.
+ * @return	the number of bytes which can be read without touching the socket.
+ */
+int tls_pending(TLS *tls) {
+
+	int_t result = 0;
+
+	if (tls) {
+		result = SSL_pending_d(tls);
+	}
+
+	return result;
+}
+
 /**
  * @brief	Consolidate the complicated logic associated with handling SSL_read/SSL_write calls which result in 0, or a negative number.
  */
@@ -73,6 +73,7 @@ uint_t   sql_errno(MYSQL *mysql);
 const    chr_t * sql_error(MYSQL *mysql);
 MYSQL *  sql_open(bool_t silent);
 int_t    sql_ping(uint32_t connection);
+status_t sql_pull(uint32_t *connection);
 bool_t   sql_start(void);
 void     sql_stop(void);
 bool_t   sql_thread_start(void);
@@ -149,12 +149,37 @@ struct {
 	char serv_schema[32];
 
 	const chr_t *type_serv, *type_embed, *dash;
+
+	int64_t wait; /* The histogram tracking how long threads wait for a connection. */
 } sql = {
 	.type_serv = "MySQL",
 	.type_embed  = "Embedded",
-	.dash = "-"
+	.dash = "-",
+	.wait = -1
 };
 
+/**
+ * @brief	Reserve a connection from the database pool.
+ * @note	The time spent waiting for the connection is recorded in the provider.database.pool.wait histogram. Since the database is
+ * 			started before the statistics interface, the histogram is resolved on first use once the statistics are available.
+ * @param	connection	a pointer to receive the number of the reserved connection.
+ * @return	PL_RESERVED on success or PL_ERROR if a connection couldn't be reserved.
+ */
+status_t sql_pull(uint32_t *connection) {
+
+	status_t result;
+	uint64_t started = time_microseconds();
+
+	result = pool_pull(sql_pool, connection);
+
+	if (sql.wait < 0 && stats_histogram_count()) {
+		sql.wait = stats_histogram_pos("provider.database.pool.wait");
+	}
+
+	stats_histogram_record(sql.wait, time_microseconds() - started);
+	return result;
+}
+
 /**
  * @brief	Get the last error number for a mysql connection.
  * @param	mysql	a pointer to the MYSQL object of the connection to be queried.
@@ -309,7 +309,7 @@ bool_t stmt_exec(MYSQL_STMT **group, MYSQL_BIND *parameters) {
 	bool_t result;
 	uint32_t connection;
 
-	if (pool_pull(sql_pool, &connection) != PL_RESERVED) {
+	if (sql_pull(&connection) != PL_RESERVED) {
 			log_info("Unable to get an available connection for the query.");
 			return 0;
 		}
@@ -359,7 +359,7 @@ table_t * stmt_get_result(MYSQL_STMT **group, MYSQL_BIND *parameters) {
 	void *result;
 	uint32_t connection;
 
-	if (pool_pull(sql_pool, &connection) != PL_RESERVED) {
+	if (sql_pull(&connection) != PL_RESERVED) {
 		log_info("Unable to get an available connection for the query.");
 		return NULL;
 	}
@@ -411,7 +411,7 @@ uint64_t stmt_insert(MYSQL_STMT **group, MYSQL_BIND *parameters) {
 	uint64_t result;
 	uint32_t connection;
 
-	if (pool_pull(sql_pool, &connection) != PL_RESERVED) {
+	if (sql_pull(&connection) != PL_RESERVED) {
 			log_info("Unable to get an available connection for the query.");
 			return 0;
 		}
@@ -494,7 +494,7 @@ int64_t stmt_exec_affected(MYSQL_STMT **group, MYSQL_BIND *parameters) {
 	int64_t affected;
 	uint32_t connection;
 
-	if (pool_pull(sql_pool, &connection) != PL_RESERVED) {
+	if (sql_pull(&connection) != PL_RESERVED) {
 		log_info("Unable to get an available connection for the query.");
 		return -1;
 	}
@@ -29,7 +29,7 @@ int64_t tran_start(void) {
 	uint32_t transaction;
 
 	// QUESTION: Why aren't we using sql_query() for this whole process?
-	if (pool_pull(sql_pool, &transaction) != PL_RESERVED) {
+	if (sql_pull(&transaction) != PL_RESERVED) {
 		log_info("Unable to get an available connection for the query.");
 		return -1;
 	}
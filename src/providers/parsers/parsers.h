@@ -43,6 +43,7 @@ void xml_node_set_content(xmlNodePtr node, uchr_t *content);
 void xml_stop(void);
 xmlAttrPtr xml_node_set_property(xmlNodePtr node, uchr_t *name, uchr_t *value);
 xmlChar * xml_encode(xmlDocPtr doc, stringer_t *string);
+xmlDocPtr xml_copy_doc(xmlDocPtr doc);
 xmlDocPtr xml_create_doc(xmlParserCtxtPtr ctx, const chr_t *buffer, int_t size, const chr_t *url, const chr_t *encoding, int_t options);
 xmlNodePtr xml_node_add_sibling(xmlNodePtr current, xmlNodePtr element);
 xmlNodePtr xml_node_new(uchr_t *name);
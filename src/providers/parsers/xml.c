@@ -28,7 +28,7 @@ bool_t lib_load_xml(void) {
 	uint64_t xml_ver_num;
 	symbol_t xml[] = {
 		M_BIND(xmlAddSibling), M_BIND(xmlBufferContent), M_BIND(xmlBufferCreate), M_BIND(xmlBufferFree), M_BIND(xmlBufferLength),
-		M_BIND(xmlCleanupGlobals), M_BIND(xmlCleanupParser), M_BIND(xmlCtxtReadMemory),	M_BIND(xmlDocDumpFormatMemory),
+		M_BIND(xmlCleanupGlobals), M_BIND(xmlCleanupParser), M_BIND(xmlCopyDoc), M_BIND(xmlCtxtReadMemory),	M_BIND(xmlDocDumpFormatMemory),
 		M_BIND(xmlEncodeEntitiesReentrant),	M_BIND(xmlFreeDoc), M_BIND(xmlFreeNode), M_BIND(xmlFreeParserCtxt),	M_BIND(xmlInitParser),
 		M_BIND(xmlMemoryDump), M_BIND(xmlNewNode), M_BIND(xmlNewParserCtxt), M_BIND(xmlNodeBufGetContent), M_BIND(xmlNodeSetContent),
 		M_BIND(xmlParserVersion), M_BIND(xmlSetProp), M_BIND(xmlXPathEvalExpression), M_BIND(xmlXPathFreeContext), M_BIND(xmlXPathFreeObject),
@@ -1059,6 +1059,27 @@ xmlDocPtr xml_create_doc(xmlParserCtxtPtr ctx, const chr_t *buffer, int_t size,
 	return result;
 }
 
+/**
+ * @brief	Create a deep copy of an xml document object.
+ * @see		xmlCopyDoc()
+ * @param	doc		a pointer to the xml document to be copied.
+ * @return	NULL on failure, or a pointer to the copy of the xml document tree on success.
+ */
+xmlDocPtr xml_copy_doc(xmlDocPtr doc) {
+
+	xmlDocPtr result;
+
+	if (!doc) {
+		log_pedantic("Asked to copy a NULL document object.");
+		return NULL;
+	}
+	else if (!(result = xmlCopyDoc_d(doc, 1))) {
+		log_pedantic("Unable to copy the XML document object.");
+	}
+
+	return result;
+}
+
 /**
  * @brief	Cleanup the state and allocated memory of the xml parser in preparation to be shutdown.
  * @return	This function returns no value.
@@ -19,6 +19,8 @@ memcached_return_t (*memcached_server_add_with_weight_d)(memcached_st *ptr, cons
 memcached_return_t (*memcached_decrement_d)(memcached_st *ptr, const char *key, size_t key_length, uint32_t offset, uint64_t *value) = NULL;
 memcached_return_t (*memcached_increment_d)(memcached_st *ptr, const char *key, size_t key_length, uint32_t offset, uint64_t *value) = NULL;
 char * (*memcached_get_d)(memcached_st *ptr, const char *key, size_t key_length, size_t *value_length, uint32_t *flags, memcached_return_t *error) = NULL;
+char * (*memcached_fetch_d)(memcached_st *ptr, char *key, size_t *key_length, size_t *value_length, uint32_t *flags, memcached_return_t *error) = NULL;
+memcached_return_t (*memcached_mget_d)(memcached_st *ptr, const char * const *keys, const size_t *key_length, size_t number_of_keys) = NULL;
 memcached_return_t (*memcached_add_d)(memcached_st *ptr, const char *key, size_t key_length, const char *value, size_t value_length, time_t expiration, uint32_t flags) = NULL;
 memcached_return_t (*memcached_set_d)(memcached_st *ptr, const char *key, size_t key_length, const char *value, size_t value_length, time_t expiration, uint32_t flags) = NULL;
 memcached_return_t (*memcached_append_d)(memcached_st *ptr, const char *key, size_t key_length, const char *value, size_t value_length, time_t expiration, uint32_t flags) = NULL;
@@ -569,6 +571,7 @@ void (*xmlMemoryDump_d)(void) = NULL;
 void (*xmlCleanupParser_d)(void) = NULL;
 void (*xmlCleanupGlobals_d)(void) = NULL;
 void (*xmlFreeDoc_d)(xmlDocPtr doc) = NULL;
+xmlDocPtr (*xmlCopyDoc_d)(xmlDocPtr doc, int recursive) = NULL;
 void (*xmlFreeNode_d)(xmlNodePtr cur) = NULL;
 xmlBufferPtr (*xmlBufferCreate_d)(void) = NULL;
 void (*xmlBufferFree_d)(xmlBufferPtr buf) = NULL;
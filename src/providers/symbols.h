@@ -117,6 +117,8 @@ extern memcached_return_t (*memcached_server_add_with_weight_d)(memcached_st *pt
 extern memcached_return_t (*memcached_decrement_d)(memcached_st *ptr, const char *key, size_t key_length, uint32_t offset, uint64_t *value);
 extern memcached_return_t (*memcached_increment_d)(memcached_st *ptr, const char *key, size_t key_length, uint32_t offset, uint64_t *value);
 extern char * (*memcached_get_d)(memcached_st *ptr, const char *key, size_t key_length, size_t *value_length, uint32_t *flags, memcached_return_t *error);
+extern char * (*memcached_fetch_d)(memcached_st *ptr, char *key, size_t *key_length, size_t *value_length, uint32_t *flags, memcached_return_t *error);
+extern memcached_return_t (*memcached_mget_d)(memcached_st *ptr, const char * const *keys, const size_t *key_length, size_t number_of_keys);
 extern memcached_return_t (*memcached_add_d)(memcached_st *ptr, const char *key, size_t key_length, const char *value, size_t value_length, time_t expiration, uint32_t flags);
 extern memcached_return_t (*memcached_set_d)(memcached_st *ptr, const char *key, size_t key_length, const char *value, size_t value_length, time_t expiration, uint32_t flags);
 extern memcached_return_t (*memcached_append_d)(memcached_st *ptr, const char *key, size_t key_length, const char *value, size_t value_length, time_t expiration, uint32_t flags);
@@ -669,6 +671,7 @@ extern void (*xmlMemoryDump_d)(void);
 extern void (*xmlCleanupParser_d)(void);
 extern void (*xmlCleanupGlobals_d)(void);
 extern void (*xmlFreeDoc_d)(xmlDocPtr doc);
+extern xmlDocPtr (*xmlCopyDoc_d)(xmlDocPtr doc, int recursive);
 extern void (*xmlFreeNode_d)(xmlNodePtr cur);
 extern xmlBufferPtr (*xmlBufferCreate_d)(void);
 extern void (*xmlBufferFree_d)(xmlBufferPtr buf);
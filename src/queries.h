@@ -71,6 +71,18 @@
 #define SELECT_MESSAGE_TAGS "SELECT tag FROM Message_Tags WHERE messagenum = ?"
 #define INSERT_MESSAGE_TAG "INSERT INTO Message_Tags (messagenum, tag) VALUES (?, ?)"
 #define DELETE_MESSAGE_TAG "DELETE FROM Message_Tags WHERE messagenum = ? AND tag = ?"
+#define SELECT_MESSAGES_TAGS "SELECT Message_Tags.messagenum, Message_Tags.tag FROM Message_Tags INNER JOIN Messages ON (Message_Tags.messagenum = Messages.messagenum) WHERE Messages.usernum = ? AND Messages.visible = 1 ORDER BY Message_Tags.messagenum ASC"
+
+// Message Summaries table
+#define SELECT_MESSAGE_SUMMARY "SELECT envelope, bodystructure, header FROM Message_Summaries WHERE messagenum = ?"
+#define INSERT_MESSAGE_SUMMARY "INSERT INTO Message_Summaries (messagenum, envelope, bodystructure, header) VALUES (?, ?, ?, ?)"
+#define COPY_MESSAGE_SUMMARY "INSERT INTO Message_Summaries (messagenum, envelope, bodystructure, header) SELECT ?, envelope, bodystructure, header FROM Message_Summaries WHERE messagenum = ?"
+
+// Message_Changes table
+// The change log is populated by triggers on the Messages and Message_Tags tables, so it covers every statement that modifies a message.
+#define SELECT_MESSAGE_CHECKPOINT "SELECT UNIX_TIMESTAMP(NOW())"
+#define SELECT_MESSAGE_CHANGES "SELECT Changed.messagenum, Messages.foldernum, Messages.server, Messages.status, Messages.size, Messages.signum, Messages.sigkey, UNIX_TIMESTAMP(Messages.created), Messages.visible FROM (SELECT DISTINCT messagenum FROM Message_Changes WHERE usernum = ? AND timestamp >= FROM_UNIXTIME(?)) AS Changed LEFT JOIN Messages ON (Changed.messagenum = Messages.messagenum AND Messages.usernum = ?) ORDER BY Changed.messagenum ASC"
+#define SELECT_MESSAGE_CHANGES_TAGS "SELECT Message_Tags.messagenum, Message_Tags.tag FROM (SELECT DISTINCT messagenum FROM Message_Changes WHERE usernum = ? AND timestamp >= FROM_UNIXTIME(?)) AS Changed INNER JOIN Message_Tags ON (Changed.messagenum = Message_Tags.messagenum) ORDER BY Message_Tags.messagenum ASC"
 
 // Advertising queries
 #define SELECT_AGENTS "SELECT agentnum, agent, popularity FROM Agents"
@@ -93,6 +105,7 @@
 		"Dispatch.greylist, Dispatch.greytime, Dispatch.spf, Dispatch.spfaction, Dispatch.dkim, Dispatch.dkimaction, Dispatch.rbl, " \
 		"Dispatch.rblaction, Dispatch.filters, `Keys`.signet FROM Mailboxes LEFT JOIN Users ON Mailboxes.usernum = Users.usernum LEFT JOIN Dispatch ON " \
 		"Mailboxes.usernum = Dispatch.usernum LEFT JOIN `Keys` ON Mailboxes.usernum = `Keys`.usernum WHERE Mailboxes.address = ?"
+#define SELECT_PREFS_QUOTA "SELECT size, quota, overquota FROM Users WHERE usernum = ?"
 #define INSERT_TRANSMITTING "INSERT INTO Transmitting (usernum, timestamp) VALUES (?, NOW())"
 #define INSERT_SIGNATURE "INSERT INTO Signatures (usernum, cryptkey, junk, signature, created) VALUES (?, ?, ?, ?, NOW())"
 #define INSERT_RECEIVING "REPLACE INTO Receiving (usernum, subnet, timestamp) VALUES (?, ?, NOW())"
@@ -212,6 +225,13 @@
 											SELECT_MESSAGE_TAGS, \
 											INSERT_MESSAGE_TAG, \
 											DELETE_MESSAGE_TAG, \
+											SELECT_MESSAGES_TAGS, \
+											SELECT_MESSAGE_SUMMARY, \
+											INSERT_MESSAGE_SUMMARY, \
+											COPY_MESSAGE_SUMMARY, \
+											SELECT_MESSAGE_CHECKPOINT, \
+											SELECT_MESSAGE_CHANGES, \
+											SELECT_MESSAGE_CHANGES_TAGS, \
 											SELECT_AGENTS, \
 											SELECT_MAILBOX_ADDRESS, \
 											SELECT_MAILBOX_ADDRESS_ANY, \
@@ -224,6 +244,7 @@
 											SELECT_USERS_AUTH, \
 											SMTP_SELECT_USER_AUTH, \
 											SELECT_PREFS_INBOUND, \
+											SELECT_PREFS_QUOTA, \
 											INSERT_TRANSMITTING, \
 											INSERT_SIGNATURE, \
 											INSERT_RECEIVING, \
@@ -317,6 +338,13 @@
 											**select_message_tags, \
 											**insert_message_tag, \
 											**delete_message_tag, \
+											**select_messages_tags, \
+											**select_message_summary, \
+											**insert_message_summary, \
+											**copy_message_summary, \
+											**select_message_checkpoint, \
+											**select_message_changes, \
+											**select_message_changes_tags, \
 											**select_agents, \
 											**select_mailbox_address, \
 											**select_mailbox_address_any, \
@@ -329,6 +357,7 @@
 											**select_users_auth, \
 											**smtp_select_user_auth, \
 											**select_prefs_inbound, \
+											**select_prefs_quota, \
 											**insert_transmitting, \
 											**insert_signature, \
 											**insert_receiving, \
@@ -34,7 +34,7 @@ void dmtp_requeue(connection_t *con) {
 		enqueue(&dmtp_quit, con);
 	}
 	else {
-		enqueue(&dmtp_process, con);
+		con_poll(con, &dmtp_process);
 	}
 
 	return;
@@ -61,7 +61,7 @@ void dmtp_process(connection_t *con) {
 	}
 	else if (pl_empty(con->network.line)) {
 		con->command = NULL;
-		enqueue(&dmtp_process, con);
+		con_poll(con, &dmtp_process);
 		return;
 	}
 
@@ -27,6 +27,10 @@ struct {
 void http_free_content(http_content_t *page) {
 
 	if (page) {
+		if (page->compiled.doc) xml_free_doc(page->compiled.doc);
+		mm_cleanup(page->compiled.slots);
+		st_cleanup(page->cache.etag);
+		st_cleanup(page->cache.gzip);
 		st_cleanup(page->location);
 		st_cleanup(page->resource);
 		st_cleanup(page->type);
@@ -93,7 +97,8 @@ http_content_t * http_get_template(chr_t *location) {
 
 /**
  * @brief	Get a template page and prepare its xml document root for use.
- * @note	Each page is affixed with an xpath with a namespace after passing through the xml parser.
+ * @note	The template is parsed when it's loaded, so each page gets a copy of the parsed document, which is affixed
+ * 			with an xpath context and namespace.
  * @param	location	a pointer to a null-terminated string with the pathname of the template to be returned.
  * @return	NULL on failure, or a pointer to the http page object of the requested template.
  */
@@ -109,15 +114,14 @@ http_page_t * http_page_get(chr_t *location) {
 		http_page_free(page);
 		return NULL;
 	}
-	else if ((page->doc_ctx = xml_create_parser_ctx()) == NULL) {
-		log_pedantic("Could not create the parser context.");
+	else if (!page->content->compiled.doc) {
+		log_pedantic("The requested resource isn't a valid XML document. {location = %s}", location);
 		http_page_free(page);
 		return NULL;
 	}
-	// Build the document object.
-	else if ((page->doc_obj = xml_create_doc(page->doc_ctx, st_char_get(page->content->resource), st_length_get(page->content->resource), NULL, NULL,
-		XML_PARSE_RECOVER + XML_PARSE_NOERROR + XML_PARSE_NOWARNING)) == NULL) {
-		log_pedantic("Could not load the XML document. {location = %s}", location);
+	// Copy the document object.
+	else if ((page->doc_obj = xml_copy_doc(page->content->compiled.doc)) == NULL) {
+		log_pedantic("Could not copy the XML document. {location = %s}", location);
 		http_page_free(page);
 		return NULL;
 	}
@@ -136,6 +140,189 @@ http_page_t * http_page_get(chr_t *location) {
 	return page;
 }
 
+/**
+ * @brief	Measure the length of a template placeholder.
+ * @note	Placeholders are upper case names, which may also contain digits and underscores, surrounded by dollar signs.
+ * @param	data	a pointer to the dollar sign which may start the placeholder.
+ * @param	length	the number of bytes available, starting with the dollar sign.
+ * @return	the length of the placeholder, including both dollar signs, or 0 if the data doesn't start with a placeholder.
+ */
+size_t http_template_slot(chr_t *data, size_t length) {
+
+	size_t i = 1;
+
+	if (length < 3 || *data != '$') {
+		return 0;
+	}
+
+	while (i < length && ((data[i] >= 'A' && data[i] <= 'Z') || (data[i] >= '0' && data[i] <= '9') || data[i] == '_')) {
+		i++;
+	}
+
+	return (i > 1 && i < length && data[i] == '$') ? i + 1 : 0;
+}
+
+/**
+ * @brief	Compile a template by locating its placeholder slots, and parse the template into an xml document.
+ * @note	A placeholder can't be matched to a value until the template is rendered, so a dollar sign which closes one placeholder is also
+ * 			checked as the start of the next, and the slots are recorded even when they overlap. The document is parsed without a
+ * 			dictionary, so the copies made for each request don't share any mutable state. Templates which aren't valid xml documents can
+ * 			still be rendered using their slots.
+ * @param	resource	the template content being loaded.
+ * @return	true on success, or false on failure.
+ */
+bool_t http_template_compile(http_content_t *resource) {
+
+	chr_t *data;
+	xmlParserCtxtPtr ctx;
+	size_t length, slot, count = 0;
+
+	data = st_char_get(resource->resource);
+	length = st_length_get(resource->resource);
+
+	// Count the slots, so the slot array can be allocated. Scanning resumes on the closing dollar sign of each slot.
+	for (size_t i = 0; i < length; i++) {
+		if ((slot = http_template_slot(data + i, length - i))) {
+			i += slot - 2;
+			count++;
+		}
+	}
+
+	if (!(resource->compiled.slots = mm_alloc(sizeof(placer_t) * (count + 1)))) {
+		log_pedantic("Unable to allocate memory for the template slots.");
+		return false;
+	}
+
+	for (size_t i = 0; i < length; i++) {
+		if ((slot = http_template_slot(data + i, length - i))) {
+			resource->compiled.slots[resource->compiled.count++] = pl_init(data + i, slot);
+			i += slot - 2;
+		}
+	}
+
+	if (!(ctx = xml_create_parser_ctx())) {
+		log_pedantic("Could not create the parser context.");
+		return false;
+	}
+
+	resource->compiled.doc = xml_create_doc(ctx, data, length, NULL, NULL, XML_PARSE_RECOVER + XML_PARSE_NOERROR + XML_PARSE_NOWARNING + XML_PARSE_NODICT);
+	xml_free_parser_ctx(ctx);
+
+	return true;
+}
+
+/**
+ * @brief	Render a compiled template into a list of vectors, by substituting values into its placeholder slots.
+ * @note	The slots are matched from left to right, and only a substituted placeholder consumes its closing dollar sign, so in
+ * 			"A$B$SESSION$" the $SESSION$ placeholder is still found when no value is provided for $B$. Placeholders without a matching
+ * 			value are left untouched, while values which are NULL remove the placeholder.
+ * @param	content		the compiled template.
+ * @param	slots		an array of slot names and their values.
+ * @param	count		the number of slots in the array.
+ * @param	vector		an array which must hold at least twice the number of compiled slots, plus one, vectors.
+ * @return	the number of vectors used.
+ */
+int_t http_template_render(http_content_t *content, http_slot_t *slots, size_t count, struct iovec *vector) {
+
+	int_t used = 0;
+	placer_t placeholder;
+	chr_t *cursor = st_char_get(content->resource), *end = st_char_get(content->resource) + st_length_get(content->resource);
+
+	for (size_t i = 0; i < content->compiled.count; i++) {
+
+		placeholder = content->compiled.slots[i];
+
+		// This slot started on the closing dollar sign of a placeholder which has already been substituted.
+		if (pl_char_get(placeholder) < cursor) {
+			continue;
+		}
+
+		// Look for a value, comparing the names without the dollar signs.
+		for (size_t j = 0; j < count; j++) {
+			if (!st_cmp_cs_eq(PLACER(pl_char_get(placeholder) + 1, pl_length_get(placeholder) - 2), NULLER(slots[j].name))) {
+				vector[used].iov_base = cursor;
+				vector[used++].iov_len = pl_char_get(placeholder) - cursor;
+				vector[used].iov_base = st_char_get(slots[j].value);
+				vector[used++].iov_len = st_length_get(slots[j].value);
+				cursor = pl_char_get(placeholder) + pl_length_get(placeholder);
+				break;
+			}
+		}
+	}
+
+	vector[used].iov_base = cursor;
+	vector[used++].iov_len = end - cursor;
+
+	return used;
+}
+
+/**
+ * @brief	Render a template by substituting values into its placeholder slots, and send it to the client.
+ * @note	The page is written using a single vectored write, so it's never assembled in memory.
+ * @see		http_template_render()
+ * @param	con			the connection across which the page will be sent.
+ * @param	location	a null-terminated string with the location of the template.
+ * @param	slots		an array of slot names and their values.
+ * @param	count		the number of slots in the array.
+ * @return	true if the page was sent, or false if the template wasn't found, which means an error page should be sent instead.
+ */
+bool_t http_template_print(connection_t *con, chr_t *location, http_slot_t *slots, size_t count) {
+
+	int_t used;
+	size_t length = 0;
+	struct iovec *vector;
+	http_content_t *content;
+
+	if (!(content = http_get_template(location)) || !content->compiled.slots) {
+		log_pedantic("Unable to find the requested template. {location = %s}", location);
+		return false;
+	}
+	else if (!(vector = mm_alloc(sizeof(struct iovec) * ((content->compiled.count * 2) + 1)))) {
+		log_pedantic("Unable to allocate memory for the template vector.");
+		return false;
+	}
+
+	used = http_template_render(content, slots, count, vector);
+
+	for (int_t i = 0; i < used; i++) {
+		length += vector[i].iov_len;
+	}
+
+	http_response_header(con, 200, content->type, length);
+	con_write_iv(con, vector, used);
+	mm_free(vector);
+
+	return true;
+}
+
+/**
+ * @brief	Prepare a static resource for caching clients, by generating its entity tag and a precompressed copy.
+ * @note	Only text based resources are compressed, and the compressed copy is discarded unless it's at least ten percent smaller.
+ * @param	resource	the static content being loaded.
+ * @param	modified	the modification time of the file the resource was loaded from.
+ * @return	true on success, or false on failure.
+ */
+bool_t http_content_prepare(http_content_t *resource, time_t modified) {
+
+	resource->cache.modified = modified;
+
+	if (!(resource->cache.etag = st_aprint("\"%016lx-%zx\"", hash_murmur64(st_data_get(resource->resource), st_length_get(resource->resource)),
+		st_length_get(resource->resource)))) {
+		log_pedantic("Unable to build the entity tag.");
+		return false;
+	}
+
+	if (st_length_get(resource->resource) >= HTTP_COMPRESS_MINIMUM && (!st_cmp_ci_starts(resource->type, PLACER("text/", 5)) ||
+		!st_cmp_ci_eq(resource->type, PLACER("application/json", 16)) || !st_cmp_ci_eq(resource->type, PLACER("application/x-javascript", 24)) ||
+		!st_cmp_ci_eq(resource->type, PLACER("image/x-icon", 12))) && (resource->cache.gzip = compress_gzip(resource->resource)) &&
+		st_length_get(resource->cache.gzip) > (st_length_get(resource->resource) / 10) * 9) {
+		st_free(resource->cache.gzip);
+		resource->cache.gzip = NULL;
+	}
+
+	return true;
+}
+
 /**
  * @brief	Load file content into the http server repository.
  * @note	Each file that is loaded will be cached for retrieval by http clients, with its mime type determined automatically.
@@ -262,6 +449,18 @@ bool_t http_load_file(int_t template, chr_t *filename) {
 		st_length_set(resource->location, st_length_get(resource->location) - 9);
 	}
 
+	// Compile the templates now, so the requests which render them don't have to parse them.
+	if (template == 1 && !http_template_compile(resource)) {
+		log_pedantic("Unable to compile the template. { file = %s }", filename);
+		http_free_content(resource);
+		return false;
+	}
+	else if (template == 0 && !http_content_prepare(resource, file_info.st_mtime)) {
+		log_pedantic("Unable to prepare the static content for caching. { file = %s }", filename);
+		http_free_content(resource);
+		return false;
+	}
+
 	// Catch index pages.
 	if (template == 0 && !st_cmp_ci_ends(NULLER(filename), PLACER("/index.html", 11))) {
 
@@ -276,6 +475,13 @@ bool_t http_load_file(int_t template, chr_t *filename) {
 		// Trim the index.html from the location.
 		st_length_set(index->location, st_length_get(index->location) - 10);
 
+		if (!http_content_prepare(index, file_info.st_mtime)) {
+			log_pedantic("Unable to prepare the index page for caching.");
+			http_free_content(resource);
+			http_free_content(index);
+			return false;
+		}
+
 		// Insert the page into the content cache.
 		if (!(key.val.st = index->location) || inx_insert(content.pages, key, index) != 1) {
 			log_pedantic("Unable to add the content structure to the content cache. { location = %.*s }", st_length_int(index->location),
@@ -36,7 +36,7 @@ void http_requeue(connection_t *con) {
 		requeue(&http_parse_pairs, &http_requeue, con);
 	}
 	else if (con->http.mode == HTTP_COMPLETE) {
-		requeue(&http_session_reset, &http_process, con);
+		requeue(&http_session_reset, &http_requeue, con);
 	}
 	else if (con->http.mode == HTTP_ERROR_501) {
 		requeue(&http_print_501, &http_close, con);
@@ -56,9 +56,9 @@ void http_requeue(connection_t *con) {
 	else if (con->http.mode == HTTP_ERROR_400) {
 		requeue(&http_print_400, &http_close, con);
 	}
-	// HTTP_PARSE_HEADER and HTTP_READY should trigger the process function.
+	// HTTP_PARSE_HEADER and HTTP_READY should trigger the process function once the client sends data.
 	else {
-		enqueue(&http_process, con);
+		con_poll(con, &http_process);
 	}
 
 	return;
@@ -147,7 +147,7 @@ void http_process(connection_t *con) {
 		return;
 	}
 	else if (pl_empty(con->network.line)) {
-		enqueue(&http_process, con);
+		con_poll(con, &http_process);
 		return;
 	}
 
@@ -8,6 +8,12 @@
 #ifndef MAGMA_SERVERS_HTTP_H
 #define MAGMA_SERVERS_HTTP_H
 
+// Static resources smaller than this aren't worth compressing.
+#define HTTP_COMPRESS_MINIMUM 256
+
+// The number of seconds clients may cache static resources before revalidating them.
+#define HTTP_STATIC_MAX_AGE 3600
+
 enum {
 	HTTP_CONNECTION_CLOSE = -1,
 	HTTP_CONNECTION_NEUTRAL = 0,
@@ -49,6 +55,7 @@ enum {
 /// content.c
 bool_t            http_content_load_directory(int_t template, chr_t *directory);
 bool_t            http_content_load_fonts(void);
+bool_t            http_content_prepare(http_content_t *resource, time_t modified);
 bool_t            http_content_refresh(void);
 bool_t            http_content_start(void);
 void              http_content_stop(void);
@@ -58,6 +65,10 @@ http_content_t *  http_get_template(chr_t *location);
 bool_t             http_load_file(int_t template, chr_t *filename);
 void              http_page_free(http_page_t *page);
 http_page_t *     http_page_get(chr_t *location);
+bool_t            http_template_compile(http_content_t *resource);
+bool_t            http_template_print(connection_t *con, chr_t *location, http_slot_t *slots, size_t count);
+int_t             http_template_render(http_content_t *content, http_slot_t *slots, size_t count, struct iovec *vector);
+size_t            http_template_slot(chr_t *data, size_t length);
 
 /// data.c
 void           http_data_free(http_data_t *data);
@@ -98,10 +109,13 @@ bool_t	 multipart_get_boundary(connection_t *con, placer_t *output);
 /// response.c
 void          http_response(connection_t *con);
 stringer_t *  http_response_allow_cross(connection_t *con);
+bool_t        http_response_cached(connection_t *con, http_content_t *content);
 stringer_t *  http_response_connection(connection_t *con, int_t force);
 stringer_t *  http_response_cookie(connection_t *con);
+bool_t        http_response_gzip(connection_t *con);
 void          http_response_header(connection_t *con, int_t status, stringer_t *type, size_t len);
 void          http_response_options(connection_t *con);
+void          http_response_static(connection_t *con, http_content_t *content);
 chr_t *       http_response_status(int_t status);
 
 /// sessions.c
@@ -406,6 +406,152 @@ void http_response_header(connection_t *con, int_t status, stringer_t *type, siz
 	return;
 }
 
+/**
+ * @brief	Check whether a client's cached copy of a static resource is still valid.
+ * @note	The If-None-Match header takes precedence, and If-Modified-Since is only checked when it's absent. Since the
+ * 			entity tags are unique, we only need to find ours within the list of tags supplied by the client.
+ * @param	con			a pointer to the connection object of the remote http client.
+ * @param	content		the static resource being requested.
+ * @return	true if the client's copy is current and a 304 response should be sent, or false otherwise.
+ */
+bool_t http_response_cached(connection_t *con, http_content_t *content) {
+
+	struct tm tm;
+	time_t since;
+	http_data_t *data;
+	chr_t buffer[128];
+
+	if ((data = http_data_get(con, HTTP_DATA_HEADER, "If-None-Match")) && data->value) {
+		return st_search_cs(data->value, content->cache.etag, NULL) || !st_cmp_cs_eq(data->value, PLACER("*", 1));
+	}
+	else if ((data = http_data_get(con, HTTP_DATA_HEADER, "If-Modified-Since")) && !st_empty(data->value) &&
+		st_length_get(data->value) < sizeof(buffer)) {
+
+		mm_wipe(&tm, sizeof(struct tm));
+		snprintf(buffer, sizeof(buffer), "%.*s", st_length_int(data->value), st_char_get(data->value));
+
+		if (strptime(buffer, "%a, %d %b %Y %H:%M:%S GMT", &tm) && (since = timegm(&tm)) != -1 && content->cache.modified <= since) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief	Check whether a client will accept a gzip encoded response.
+ * @param	con		a pointer to the connection object of the remote http client.
+ * @return	true if the Accept-Encoding header lists gzip without a zero quality value, or false otherwise.
+ */
+bool_t http_response_gzip(connection_t *con) {
+
+	chr_t *stream;
+	size_t location, length;
+	http_data_t *data;
+
+	if (!(data = http_data_get(con, HTTP_DATA_HEADER, "Accept-Encoding")) || !st_search_ci(data->value, PLACER("gzip", 4), &location)) {
+		return false;
+	}
+
+	stream = st_char_get(data->value) + location + 4;
+	length = st_length_get(data->value) - location - 4;
+
+	// Skip past whitespace, and then check for a quality value that disables the encoding.
+	while (length && (*stream == ' ' || *stream == '\t')) {
+		stream++;
+		length--;
+	}
+
+	if (length >= 4 && !st_cmp_ci_starts(PLACER(stream, length), PLACER(";q=0", 4))) {
+		stream += 4;
+		length -= 4;
+
+		if (length && *stream == '.') {
+			do {
+				stream++;
+				length--;
+			} while (length && *stream == '0');
+		}
+
+		// Only zeros followed the decimal point, so the encoding was disabled.
+		if (!length || (*stream < '1' || *stream > '9')) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief	Send a static resource to the remote client.
+ * @note	Clients may cache static resources, and revalidate them using the entity tag or modification time, in which case a 304
+ * 			response is sent without a body. If the client accepts gzip, and a compressed copy is available, it gets sent instead.
+ * 			The body is written straight from the shared content buffer.
+ * @param	con			a pointer to the connection object of the remote http client.
+ * @param	content		the static resource being requested.
+ * @return	This function returns no value.
+ */
+void http_response_static(connection_t *con, http_content_t *content) {
+
+	int_t status = 200;
+	bool_t gzip = false;
+	stringer_t *connection, *allow = NULL, *length = NULL, *body = content->resource;
+
+	if (con->http.mode == HTTP_RESPOND) {
+		con->http.mode = HTTP_COMPLETE;
+	}
+
+	if (content->cache.etag && http_response_cached(con, content)) {
+		status = 304;
+	}
+	else if (content->cache.gzip && http_response_gzip(con)) {
+		body = content->cache.gzip;
+		gzip = true;
+	}
+
+	if (magma.http.allow_cross_domain) {
+		allow = http_response_allow_cross(con);
+	}
+
+	// A 304 response doesn't have a body, so the length is omitted.
+	if (status != 304) {
+		length = st_quick(MANAGEDBUF(64), "Content-Length: %zu\r\n", st_length_get(body));
+	}
+
+	connection = http_response_connection(con, HTTP_CONNECTION_NEUTRAL);
+
+	con_print(con, "HTTP/1.1 %i %s\r\n" \
+		"Date: %s\r\n" \
+		"Last-Modified: %s\r\n" \
+		"%.*s" \
+		"Cache-Control: public, max-age=%u\r\n" \
+		"ETag: %.*s\r\n" \
+		"Vary: Accept-Encoding\r\n" \
+		"%s" \
+		"Content-Type: %.*s\r\n" \
+		"%.*s" \
+		"%.*s" \
+		"\r\n",
+		status, http_response_status(status),
+		st_char_get(time_print_gmt(MANAGEDBUF(128), "%a, %d %b %Y %T %Z", time(NULL))),
+		st_char_get(time_print_gmt(MANAGEDBUF(128), "%a, %d %b %Y %T GMT", content->cache.modified)),
+		(allow ? st_length_int(allow) : 0),	(allow ? st_char_get(allow) : NULL),
+		HTTP_STATIC_MAX_AGE,
+		st_length_int(content->cache.etag), st_char_get(content->cache.etag),
+		(gzip ? "Content-Encoding: gzip\r\n" : ""),
+		st_length_int(content->type), st_char_get(content->type),
+		(length ? st_length_int(length) : 0), (length ? st_char_get(length) : NULL),
+		(connection ? st_length_int(connection) : 0), (connection ? st_char_get(connection) : NULL));
+
+	if (status != 304) {
+		con_write_st(con, body);
+	}
+
+	st_cleanup(allow);
+	st_cleanup(connection);
+	return;
+}
+
 /**
  * @brief	Make a response to an http client request.
  * @note	The following http methods aren't supported: PUT, DELETE, HEAD, TRACE, and CONNECT.
@@ -443,8 +589,7 @@ void http_response(connection_t *con) {
 
 	// We check this list first so that static resources take precedence. This allows for static content to be served using dynamic application paths.
 	else if ((content = http_get_static(con->http.location))) {
-		http_response_header(con, 200, content->type, st_length_get(content->resource));
-		con_write_st(con, content->resource);
+		http_response_static(con, content);
 	}
 	// A special case: upload through the portal.
 	else if (!st_cmp_cs_starts(con->http.location, NULLER("/portal/camel/attach/"))) {
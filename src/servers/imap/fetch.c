@@ -232,13 +232,14 @@ stringer_t * imap_fetch_bodystructure(mail_mime_t *mime) {
 	uint64_t lines = 0;
 	chr_t *stream, buffer[32];
 	size_t increment = 0, length;
+	array_t *children;
 	stringer_t *output = NULL, *current, *value, *literal, *holder[8];
 
 	if (!mime) {
 		return NULL;
 	}
 
-	if (!mime->children) {
+	if (!(children = mail_mime_children(mime))) {
 
 		// Content type group.
 		if ((holder[0] = mail_mime_type_group(mime->header))) {
@@ -349,10 +350,10 @@ stringer_t * imap_fetch_bodystructure(mail_mime_t *mime) {
 
 	}
 	else {
-		length = ar_length_get(mime->children);
+		length = ar_length_get(children);
 
 		while (increment < length) {
-			current = imap_fetch_bodystructure(ar_field_ptr(mime->children, increment));
+			current = imap_fetch_bodystructure(ar_field_ptr(children, increment));
 
 			if (current) {
 
@@ -562,7 +563,7 @@ mail_mime_t * imap_fetch_body_part(mail_message_t *message, placer_t portion) {
 	number = tok_get_count_st(&portion, '.');
 
 	// This is a non MIME message.
-	if (!current || !current->children) {
+	if (!current || !mail_mime_children(current)) {
 
 		// Get the number.
 		tok_get_st(&portion, '.', 0, &token);
@@ -588,13 +589,13 @@ mail_mime_t * imap_fetch_body_part(mail_message_t *message, placer_t portion) {
 		tok_get_st(&portion, '.', i, &token);
 
 		// Protection against requests for non-existent children.
-		if (!current || !current->children) {
+		if (!current || !mail_mime_children(current)) {
 			return NULL;
 		}
 
 		// Get the numeric portion.
 		if (uint32_conv_st(&token, &segment) == true) {
-			current = ar_field_ptr(current->children, segment - 1);
+			current = ar_field_ptr(mail_mime_children(current), segment - 1);
 		}
 		else {
 			return current;
@@ -759,12 +760,85 @@ mail_mime_t * imap_fetch_return_mime(connection_t *con, meta_message_t *meta, ma
 	return (*message)->mime;
 }
 
+/**
+ * @brief	Get the BODYSTRUCTURE for a message, using the summary computed when it was stored, or the copy held by the shared message
+ * 			cache, when possible.
+ * @note	Clients ask for the structure of every message when they synchronize a folder, so once it has been computed it's
+ * 			cached, and later requests don't need to load or parse the message. Messages with a spam signature are the exception,
+ * 			just like in mail_summary_get(), since the signature part added when they're loaded changes with the junk flag. On
+ * 			failure the message, header and response are freed, like the other imap_fetch_return functions.
+ * @return	NULL on failure, or a managed string containing the structure.
+ */
+stringer_t * imap_fetch_return_bodystructure(connection_t *con, meta_message_t *meta, mail_summary_t *summary, mail_message_t **message,
+	stringer_t **header, imap_fetch_response_t *output) {
+
+	mail_mime_t *mime;
+	stringer_t *result;
+
+	if (summary && summary->structure && (result = st_dupe(summary->structure))) {
+		return result;
+	}
+	else if ((result = mail_cache_get_structure(meta->messagenum))) {
+		return result;
+	}
+	else if (!(mime = imap_fetch_return_mime(con, meta, message, header, output))) {
+		return NULL;
+	}
+	else if (!(result = imap_fetch_bodystructure(mime))) {
+		mail_destroy(*message);
+		mail_destroy_header(*header);
+		imap_fetch_response_free(output);
+		return NULL;
+	}
+
+	// The text of the signature part depends on the junk flag, so the structure of a signed message can change, and isn't cached.
+	if (!meta->signum || !meta->sigkey) {
+		mail_cache_set_structure(meta->messagenum, result);
+	}
+
+	return result;
+}
+
+/**
+ * @brief	Open a stream for the entire message, or the range of it requested by a partial fetch.
+ * @note	Streams read the message straight from the frames holding the requested range, so large messages don't need to be loaded
+ * 			and decompressed in full. Messages which are branded or signed when they're loaded don't match the stored copy, and small
+ * 			messages are better served by the message cache, so neither is streamed.
+ * @param	meta	the meta message object of the message being fetched.
+ * @param	partial	the partial specifier for the fetch item, if there was one.
+ * @param	start	a pointer to receive the offset of the range being returned.
+ * @param	state	a pointer to receive the result of parsing the partial specifier, or 0 if the entire message is being returned.
+ * @return	NULL if the message can't be streamed, or a pointer to the message stream on success.
+ */
+mail_stream_t * imap_fetch_return_stream(meta_message_t *meta, stringer_t *partial, size_t *start, int_t *state) {
+
+	size_t length = SIZE_MAX;
+
+	*start = 0;
+	*state = 0;
+
+	if (meta->size <= MAIL_FRAMES_LENGTH || (meta->signum && meta->sigkey) || (meta->status & (MAIL_STATUS_ENCRYPTED | MAIL_MARK_JUNK |
+		MAIL_MARK_INFECTED | MAIL_MARK_SPOOFED | MAIL_MARK_BLACKHOLED | MAIL_MARK_PHISHING))) {
+		return NULL;
+	}
+	else if (partial && (*state = imap_fetch_parse_partial(partial, start, &length)) == 1) {
+		length = SIZE_MAX;
+	}
+	else if (*state == 0) {
+		*start = 0;
+		length = SIZE_MAX;
+	}
+
+	return mail_stream_open(meta, *start, length);
+}
+
 imap_fetch_response_t * imap_fetch_body(array_t *outer, array_t *partial, connection_t *con, meta_message_t *meta,
 	mail_message_t **message, stringer_t **header, imap_fetch_response_t *output) {
 
 	int_t state;
 	array_t *inner;
 	mail_mime_t *mime;
+	mail_stream_t *streamed;
 	uint32_t number;
 	chr_t buffer[128], *stream;
 	size_t start, length, value_len;
@@ -795,8 +869,29 @@ imap_fetch_response_t * imap_fetch_body(array_t *outer, array_t *partial, connec
 		// The items requested.
 		inner = ar_field_ar(outer, i);
 
-		// Empty array. Print_t the entire message.
-		if (inner == NULL || ar_length_get(inner) == 0) {
+		// Empty array. Print_t the entire message. Large messages are streamed, unless we've already loaded them.
+		if ((inner == NULL || ar_length_get(inner) == 0) && *message == NULL &&
+			(streamed = imap_fetch_return_stream(meta, imap_get_ptr(partial, i), &start, &state))) {
+
+			tag = imap_fetch_body_tag(NULL, NULL);
+
+			if (state != 0 && tag && snprintf(buffer, 128, "<%zu>", start) > 0 && (complete = st_merge("sn", tag, buffer))) {
+				st_free(tag);
+				tag = complete;
+			}
+
+			if (!tag) {
+				mail_stream_close(streamed);
+				mail_destroy_header(*header);
+				imap_fetch_response_free(output);
+				return NULL;
+			}
+
+			output = imap_fetch_response_add_stream(output, tag, streamed);
+			st_free(tag);
+			continue;
+		}
+		else if (inner == NULL || ar_length_get(inner) == 0) {
 			if ((holder = imap_fetch_return_text(con, meta, message, header, output)) == NULL) {
 				return NULL;
 			}
@@ -1047,6 +1142,7 @@ imap_fetch_response_t * imap_fetch_message(connection_t *con, meta_message_t *me
 	struct tm ltime;
 	chr_t buffer[128];
 	mail_message_t *message = NULL;
+	mail_summary_t *summary = NULL;
 	stringer_t *value, *header = NULL;
 	imap_fetch_response_t *output = NULL;
 
@@ -1126,19 +1222,18 @@ imap_fetch_response_t * imap_fetch_message(connection_t *con, meta_message_t *me
 		output = imap_fetch_response_add(output, PLACER("RFC822", 6), value);
 	}
 
+	// Messages summarized when they were stored can return their structure, envelope and header without being loaded. The header is
+	// handed over right away, so it's returned by imap_fetch_return_header() and released along with any header we would have loaded.
+	if (message == NULL && (items->body == 1 || items->bodystructure == 1 || items->envelope == 1 || items->rfc822_header == 1) &&
+		(summary = mail_summary_get(meta))) {
+		header = summary->header;
+		summary->header = NULL;
+	}
+
 	// Process the body.
 	if (items->body == 1) {
-		if (message == NULL && ((message = mail_load_message(meta, con->imap.user, con->server, 1)) == NULL
-			|| mail_mime_update(message) == 0)) {
-			mail_destroy(message);
-			mail_destroy_header(header);
-			imap_fetch_response_free(output);
-			return NULL;
-		}
-		else if ((value = imap_fetch_bodystructure(message->mime)) == NULL) {
-			mail_destroy(message);
-			mail_destroy_header(header);
-			imap_fetch_response_free(output);
+		if ((value = imap_fetch_return_bodystructure(con, meta, summary, &message, &header, output)) == NULL) {
+			mail_summary_free(summary);
 			return NULL;
 		}
 		output = imap_fetch_response_add(output, PLACER("BODY", 4), value);
@@ -1146,17 +1241,8 @@ imap_fetch_response_t * imap_fetch_message(connection_t *con, meta_message_t *me
 
 	// Process the bodystructure.
 	if (items->bodystructure == 1) {
-		if (message == NULL && ((message = mail_load_message(meta, con->imap.user, con->server, 1)) == NULL
-			|| mail_mime_update(message) == 0)) {
-			mail_destroy(message);
-			mail_destroy_header(header);
-			imap_fetch_response_free(output);
-			return NULL;
-		}
-		else if ((value = imap_fetch_bodystructure(message->mime)) == NULL) {
-			mail_destroy(message);
-			mail_destroy_header(header);
-			imap_fetch_response_free(output);
+		if ((value = imap_fetch_return_bodystructure(con, meta, summary, &message, &header, output)) == NULL) {
+			mail_summary_free(summary);
 			return NULL;
 		}
 		output = imap_fetch_response_add(output, PLACER("BODYSTRUCTURE", 13), value);
@@ -1166,6 +1252,7 @@ imap_fetch_response_t * imap_fetch_message(connection_t *con, meta_message_t *me
 	if (items->normal != NULL) {
 		if ((output = imap_fetch_body(items->normal, items->normal_partial, con, meta, &message, &header, output)) == NULL) {
 			log_pedantic("Unable to fetch the body for message %lu.", meta->messagenum);
+			mail_summary_free(summary);
 			return NULL;
 		}
 	}
@@ -1173,24 +1260,33 @@ imap_fetch_response_t * imap_fetch_message(connection_t *con, meta_message_t *me
 	if (items->peek != NULL) {
 		if ((output = imap_fetch_body(items->peek, items->peek_partial, con, meta, &message, &header, output)) == NULL) {
 			log_pedantic("Unable to fetch the body for message %lu.", meta->messagenum);
+			mail_summary_free(summary);
 			return NULL;
 		}
 	}
 
 	// Process the message envelope.
 	if (items->envelope == 1) {
-		if ((header = imap_fetch_return_header(con, meta, &message, &header, output)) == NULL) {
+		if (summary && summary->envelope) {
+			value = summary->envelope;
+			summary->envelope = NULL;
+		}
+		else if ((header = imap_fetch_return_header(con, meta, &message, &header, output)) == NULL) {
+			mail_summary_free(summary);
 			return NULL;
 		}
 		else if ((value = imap_fetch_envelope(header)) == NULL) {
 			mail_destroy(message);
 			mail_destroy_header(header);
+			mail_summary_free(summary);
 			imap_fetch_response_free(output);
 			return NULL;
 		}
 		output = imap_fetch_response_add(output, PLACER("ENVELOPE", 8), value);
 	}
 
+	mail_summary_free(summary);
+
 	// Process the RFC822 header.
 	if (items->rfc822_header == 1) {
 		if ((header = imap_fetch_return_header(con, meta, &message, &header, output)) == NULL) {
@@ -1275,19 +1371,21 @@ inx_t * imap_duplicate_messages(inx_t *messages) {
 	return output;
 }
 
-// Returns a copy of the messages. Make sure you rely on the message numbers and not the sequence numbers.
-inx_t * imap_narrow_messages(inx_t *messages, uint64_t selected, stringer_t *range, int_t uid) {
+// Returns a copy of the messages. Make sure you rely on the message numbers and not the sequence numbers. When the folder view is
+// current the ranges are resolved using positions and a binary search, otherwise the entire messages index is scanned.
+inx_t * imap_narrow_messages(meta_user_t *user, uint64_t selected, stringer_t *range, int_t uid) {
 
 	int_t asterisk;
 	inx_t *output = NULL;
 	inx_cursor_t *cursor;
 	uint32_t commas, parts;
 	meta_message_t *active;
+	meta_sequence_t *view;
 	placer_t sequence, start_token, end_token;
 	multi_t key = { .type = M_TYPE_UINT64, .val.u64 = 0 };
 	uint64_t start, end, number, highest_uid = 0, highest_seq = 0;
 
-	if (!messages || !range) {
+	if (!user || !user->messages || !range) {
 		log_error("Sanity check failed, passed a NULL parameter.");
 		return NULL;
 	}
@@ -1298,7 +1396,11 @@ inx_t * imap_narrow_messages(inx_t *messages, uint64_t selected, stringer_t *ran
 	}
 
 	// Find the highest message number.
-	if ((cursor = inx_cursor_alloc(messages))) {
+	if ((view = meta_messages_sequence(user, selected))) {
+		highest_seq = view->count;
+		highest_uid = view->messages[view->count - 1]->messagenum;
+	}
+	else if ((cursor = inx_cursor_alloc(user->messages))) {
 
 		while ((active = inx_cursor_value_next(cursor))) {
 
@@ -1397,7 +1499,16 @@ inx_t * imap_narrow_messages(inx_t *messages, uint64_t selected, stringer_t *ran
 
 		//log_pedantic("start = %lu / end = %lu / asterisk = %i / uid = %i { %.*s }", start, end, asterisk, uid, st_length_int(range), st_char_get(range));
 
-		if ((cursor = inx_cursor_alloc(messages))) {
+		if (view) {
+
+			for (number = (uid == 0 ? (start ? start - 1 : 0) : meta_sequence_position(view, start)); number < view->count &&
+				(asterisk == 1 || (uid == 0 && number < end) || (uid == 1 && view->messages[number]->messagenum <= end)); number++) {
+				key.val.u64 = view->messages[number]->messagenum;
+				inx_append(output, key, view->messages[number]);
+			}
+
+		}
+		else if ((cursor = inx_cursor_alloc(user->messages))) {
 
 			while ((active = inx_cursor_value_next(cursor))) {
 
@@ -14,6 +14,7 @@ void imap_fetch_response_free(imap_fetch_response_t *response) {
 	while (response) {
 		st_cleanup(response->key);
 		st_cleanup(response->value);
+		mail_stream_close((mail_stream_t *)response->stream);
 		holder = response;
 		response = (imap_fetch_response_t *)response->next;
 		mm_free(holder);
@@ -63,3 +64,87 @@ imap_fetch_response_t * imap_fetch_response_add(imap_fetch_response_t *response,
 
 	return response;
 }
+
+/**
+ * @brief	Add a message literal which will be streamed to the client when the response is written.
+ * @param	response	the response being extended.
+ * @param	key			the name of the fetch item.
+ * @param	stream		the message stream which will supply the literal, which is freed along with the response.
+ * @return	the response, with the new item appended on success.
+ */
+imap_fetch_response_t * imap_fetch_response_add_stream(imap_fetch_response_t *response, stringer_t *key, mail_stream_t *stream) {
+
+	imap_fetch_response_t *output, *holder;
+
+	// Sanity
+	if (!key || !stream) {
+		log_error("Passed a NULL value.");
+		mail_stream_close(stream);
+		return response;
+	}
+
+	// Allocate structure.
+	if (!(output = mm_alloc(sizeof(imap_fetch_response_t)))) {
+		mail_stream_close(stream);
+		return response;
+	}
+
+	// Setup structure.
+	if (!(output->key = st_dupe_opts(MANAGED_T | HEAP | CONTIGUOUS, key))) {
+		mm_free(output);
+		mail_stream_close(stream);
+		return response;
+	}
+
+	output->stream = (struct mail_stream_t *)stream;
+
+	// If this is the first element.
+	if (!response) {
+		return output;
+	}
+
+	// Otherwise iterate to the end and append.
+	holder = response;
+
+	while (holder->next) {
+		holder = (imap_fetch_response_t *)holder->next;
+	}
+
+	holder->next = (struct imap_fetch_response_t *)output;
+
+	return response;
+}
+
+/**
+ * @brief	Write the value of a fetch item to the client.
+ * @note	Streamed literals are written one frame at a time, as they're decompressed. Since the literal length has already been sent,
+ * 			a stream which fails part way through leaves the client unable to parse the rest of the response, so the connection is
+ * 			closed.
+ * @param	con			the client connection.
+ * @param	response	the fetch item being written.
+ * @return	This function returns no value.
+ */
+void imap_fetch_response_write(connection_t *con, imap_fetch_response_t *response) {
+
+	int_t state = 0;
+	placer_t chunk;
+	mail_stream_t *stream = (mail_stream_t *)response->stream;
+
+	if (!stream) {
+		con_write_st(con, response->value);
+		return;
+	}
+
+	con_print(con, "{%zu}\r\n", stream->length);
+
+	while (con_status(con) >= 0 && (state = mail_stream_next(stream, &chunk)) == 1) {
+		con_write_bl(con, pl_char_get(chunk), pl_length_get(chunk));
+	}
+
+	if (state < 0) {
+		log_pedantic("Unable to stream the message literal, so the connection is being closed.");
+		con->network.status = -1;
+	}
+
+	return;
+}
@@ -38,6 +38,11 @@ void imap_starttls(connection_t *con) {
 	// Tell the user that we are ready to start the negotiation.
 	con_print(con, "%.*s OK Ready to start TLS negotiation.\r\n", st_length_get(con->imap.tag), st_char_get(con->imap.tag));
 
+	// The response must reach the client before the negotiation starts, and it can't be left in the output buffer, where it would be encrypted.
+	if (con_flush(con) < 0) {
+		return;
+	}
+
 	if (!(con->network.tls = tls_server_alloc(con->server, con->network.sockd, M_SSL_BIO_NOCLOSE))) {
 		con_print(con, "%.*s NO TLS Connection attempt failed.\r\n", st_length_get(con->imap.tag), st_char_get(con->imap.tag));
 		log_pedantic("The TLS connection attempt failed.");
@@ -474,7 +479,7 @@ void imap_create(connection_t *con) {
 	state = imap_folder_create(con->imap.user->usernum, con->imap.user->folders, imap_get_st_ar(con->imap.arguments, 0));
 
 	// If the serial number indicates no outside changes we can increment it without forcing a refresh.
-	if (con->imap.user->serials.folders == serial_get(OBJECT_FOLDERS, con->imap.user->usernum)) {
+	if (con->imap.user->serials.folders == serial_get_uncached(OBJECT_FOLDERS, con->imap.user->usernum)) {
 		con->imap.folders_checkpoint = con->imap.user->serials.folders = serial_increment(OBJECT_FOLDERS, con->imap.user->usernum);
 	}
 	// The context is already due for a refresh, but we increment the serial to let the rest of the cluster know about the change.
@@ -541,7 +546,7 @@ void imap_delete(connection_t *con) {
 	state = imap_folder_remove(con->imap.user->usernum, con->imap.user->folders, con->imap.user->messages, imap_get_st_ar(con->imap.arguments, 0));
 
 	// If the serial number indicates no outside changes we can increment it without forcing a refresh.
-	if (con->imap.user->serials.folders == serial_get(OBJECT_FOLDERS, con->imap.user->usernum)) {
+	if (con->imap.user->serials.folders == serial_get_uncached(OBJECT_FOLDERS, con->imap.user->usernum)) {
 		con->imap.folders_checkpoint = con->imap.user->serials.folders = serial_increment(OBJECT_FOLDERS, con->imap.user->usernum);
 	}
 	// The context is already due for a refresh, but we increment the serial to let the rest of the cluster know about the change.
@@ -595,7 +600,7 @@ void imap_rename(connection_t *con) {
 	state = imap_folder_rename(con->imap.user->usernum, con->imap.user->folders, imap_get_st_ar(con->imap.arguments, 0), imap_get_st_ar(con->imap.arguments, 1));
 
 	// If the serial number indicates no outside changes we can increment it without forcing a refresh.
-	if (con->imap.user->serials.folders == serial_get(OBJECT_FOLDERS, con->imap.user->usernum)) {
+	if (con->imap.user->serials.folders == serial_get_uncached(OBJECT_FOLDERS, con->imap.user->usernum)) {
 		con->imap.folders_checkpoint = con->imap.user->serials.folders = serial_increment(OBJECT_FOLDERS, con->imap.user->usernum);
 	}
 	// The context is already due for a refresh, but we increment the serial to let the rest of the cluster know about the change.
@@ -995,7 +1000,7 @@ void imap_store(connection_t *con) {
 	}
 
 	// Narrow by the sequence range provided.
-	else if (!(messages = imap_narrow_messages(con->imap.user->messages, con->imap.selected, imap_get_st_ar(con->imap.arguments, 0), con->imap.uid))) {
+	else if (!(messages = imap_narrow_messages(con->imap.user, con->imap.selected, imap_get_st_ar(con->imap.arguments, 0), con->imap.uid))) {
 		meta_user_unlock(con->imap.user);
 		con_print(con, "%.*s OK Store complete.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
 		return;
@@ -1008,7 +1013,7 @@ void imap_store(connection_t *con) {
 	imap_update_flags(con->imap.user, messages, con->imap.selected, action, flags);
 
 	// If the serial number indicates no outside changes we can increment it without forcing a refresh.
-	if (con->imap.user->serials.messages == serial_get(OBJECT_MESSAGES, con->imap.user->usernum)) {
+	if (con->imap.user->serials.messages == serial_get_uncached(OBJECT_MESSAGES, con->imap.user->usernum)) {
 		con->imap.messages_checkpoint = con->imap.user->serials.messages = serial_increment(OBJECT_MESSAGES, con->imap.user->usernum);
 	}
 
@@ -1144,10 +1149,10 @@ void imap_close(connection_t *con) {
 		}
 
 		// Update all of the sequences at once.
-		meta_messages_update_sequences(con->imap.user->folders, con->imap.user->messages);
+		meta_messages_update_sequences(con->imap.user);
 
 		// If the serial number indicates no outside changes we can increment it without forcing a refresh.
-		if (con->imap.user->serials.messages == serial_get(OBJECT_MESSAGES, con->imap.user->usernum)) {
+		if (con->imap.user->serials.messages == serial_get_uncached(OBJECT_MESSAGES, con->imap.user->usernum)) {
 			con->imap.messages_checkpoint = con->imap.user->serials.messages = serial_increment(OBJECT_MESSAGES, con->imap.user->usernum);
 		}
 		// The context is already due for a refresh, but we increment the serial to let the rest of the cluster know about the change.
@@ -1182,6 +1187,7 @@ void imap_expunge(connection_t *con) {
 
 	int_t deleted = 0;
 	inx_cursor_t *cursor;
+	meta_sequence_t *view;
 	meta_message_t *active;
 	uint64_t sequencenum, expunged = 0;
 
@@ -1238,8 +1244,17 @@ void imap_expunge(connection_t *con) {
 			return;
 		}
 
-		// Loop through and perform the deletes.
-		if ((cursor = inx_cursor_alloc(con->imap.user->messages))) {
+		// Loop through and perform the deletes. The folder view holds its own array of messages, so it can still be walked while the
+		// expunged messages are removed from the index, and the positions provide the sequence numbers.
+		if ((view = meta_messages_sequence(con->imap.user, con->imap.selected))) {
+			for (uint64_t i = 0; i < view->count; i++) {
+				active = view->messages[i];
+				if ((active->status & MAIL_STATUS_DELETED) == MAIL_STATUS_DELETED && imap_message_expunge(con, active) != 0) {
+					con_print(con, "* %lu EXPUNGE\r\n", i + 1 - expunged++);
+				}
+			}
+		}
+		else if ((cursor = inx_cursor_alloc(con->imap.user->messages))) {
 			while ((active = inx_cursor_value_next(cursor))) {
 				if (active->foldernum == con->imap.selected && (active->status & MAIL_STATUS_DELETED) == MAIL_STATUS_DELETED) {
 					sequencenum = active->sequencenum;
@@ -1252,10 +1267,10 @@ void imap_expunge(connection_t *con) {
 		}
 
 		// Update all of the sequences at once.
-		meta_messages_update_sequences(con->imap.user->folders, con->imap.user->messages);
+		meta_messages_update_sequences(con->imap.user);
 
 		// If the serial number indicates no outside changes we can increment it without forcing a refresh.
-		if (con->imap.user->serials.messages == serial_get(OBJECT_MESSAGES, con->imap.user->usernum)) {
+		if (con->imap.user->serials.messages == serial_get_uncached(OBJECT_MESSAGES, con->imap.user->usernum)) {
 			con->imap.messages_checkpoint = con->imap.user->serials.messages = serial_increment(OBJECT_MESSAGES, con->imap.user->usernum);
 		}
 		// The context is already due for a refresh, but we increment the serial to let the rest of the cluster know about the change.
@@ -1335,7 +1350,7 @@ void imap_copy(connection_t *con) {
 
 	// Narrow by the sequence range provided.
 	// Due to bugs in several clients, invalid sequences may be submitted. Return an okay if the sequence isn't found so the client doesn't hang.
-	else if (con->imap.user->messages == NULL || (messages = imap_narrow_messages(con->imap.user->messages, con->imap.selected, imap_get_st_ar(con->imap.arguments, 0), con->imap.uid)) == NULL) {
+	else if (con->imap.user->messages == NULL || (messages = imap_narrow_messages(con->imap.user, con->imap.selected, imap_get_st_ar(con->imap.arguments, 0), con->imap.uid)) == NULL) {
 		meta_user_unlock(con->imap.user);
 		con_print(con, "%.*s OK No messages were found matching the range provided.\r\n", st_length_int(con->imap.tag),
 			st_char_get(con->imap.tag));
@@ -1574,7 +1589,7 @@ void imap_fetch(connection_t *con) {
 	}
 
 	// Narrow by the sequence range provided.
-	if (con->imap.user->messages == NULL || (messages = imap_narrow_messages(con->imap.user->messages, con->imap.selected, imap_get_st_ar(con->imap.arguments, 0), con->imap.uid)) == NULL) {
+	if (con->imap.user->messages == NULL || (messages = imap_narrow_messages(con->imap.user, con->imap.selected, imap_get_st_ar(con->imap.arguments, 0), con->imap.uid)) == NULL) {
 		meta_user_unlock(con->imap.user);
 		con_print(con, "%.*s OK Fetch complete. No messages were found matching the range provided.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
 		imap_fetch_free_items(items);
@@ -1601,7 +1616,7 @@ void imap_fetch(connection_t *con) {
 		}
 
 		// If the serial number indicates no outside changes we can increment it without forcing a refresh.
-		if (con->imap.user->serials.messages == serial_get(OBJECT_MESSAGES, con->imap.user->usernum)) {
+		if (con->imap.user->serials.messages == serial_get_uncached(OBJECT_MESSAGES, con->imap.user->usernum)) {
 			con->imap.messages_checkpoint = con->imap.user->serials.messages = serial_increment(OBJECT_MESSAGES, con->imap.user->usernum);
 		}
 		// The context is already due for a refresh, but we increment the serial to let the rest of the cluster know about the change.
@@ -1673,7 +1688,7 @@ void imap_fetch(connection_t *con) {
 					}
 					con_write_st(con, iterate->key);
 					con_write_bl(con, " ", 1);
-					con_write_st(con, iterate->value);
+					imap_fetch_response_write(con, iterate);
 				}
 				iterate = (imap_fetch_response_t *)iterate->next;
 			}
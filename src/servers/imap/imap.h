@@ -28,6 +28,13 @@
 #define IMAP_FETCH_BODY_MIME 5
 #define IMAP_FETCH_BODY_PART 6
 
+// The user's search index, which is only opened once a body or text criterion is evaluated, and only once per search.
+typedef struct {
+	bool_t opened;
+	uint64_t usernum;
+	mail_search_t *search;
+} imap_search_index_t;
+
 // IMAP Flags actions.
 #define IMAP_FLAG_SILENT 1
 #define IMAP_FLAG_ADD 2
@@ -42,7 +49,9 @@ void    imap_sort(void);
 
 /// fetch_response.c
 imap_fetch_response_t *  imap_fetch_response_add(imap_fetch_response_t *response, stringer_t *key, stringer_t *value);
+imap_fetch_response_t *  imap_fetch_response_add_stream(imap_fetch_response_t *response, stringer_t *key, mail_stream_t *stream);
 void                     imap_fetch_response_free(imap_fetch_response_t *response);
+void                     imap_fetch_response_write(connection_t *con, imap_fetch_response_t *response);
 
 /// fetch.c
 inx_t *                   imap_duplicate_messages(inx_t *messages);
@@ -57,11 +66,13 @@ stringer_t *              imap_fetch_envelope(stringer_t *header);
 void                      imap_fetch_free_items(imap_fetch_dataitems_t *items);
 imap_fetch_response_t *   imap_fetch_message(connection_t *con, meta_message_t *meta, imap_fetch_dataitems_t *items);
 int_t                     imap_fetch_parse_partial(stringer_t *partial, size_t *start, size_t *length);
+stringer_t *              imap_fetch_return_bodystructure(connection_t *con, meta_message_t *meta, mail_summary_t *summary, mail_message_t **message, stringer_t **header, imap_fetch_response_t *output);
 stringer_t *              imap_fetch_return_header(connection_t *con, meta_message_t *meta, mail_message_t **message, stringer_t **header, imap_fetch_response_t *output);
 mail_message_t *          imap_fetch_return_message(connection_t *con, meta_message_t *meta, mail_message_t **message, stringer_t **header, imap_fetch_response_t *output);
 mail_mime_t *             imap_fetch_return_mime(connection_t *con, meta_message_t *meta, mail_message_t **message, stringer_t **header, imap_fetch_response_t *output);
+mail_stream_t *           imap_fetch_return_stream(meta_message_t *meta, stringer_t *partial, size_t *start, int_t *state);
 stringer_t *              imap_fetch_return_text(connection_t *con, meta_message_t *meta, mail_message_t **message, stringer_t **header, imap_fetch_response_t *output);
-inx_t *                   imap_narrow_messages(inx_t *messages, uint64_t selected, stringer_t *range, int_t uid);
+inx_t *                   imap_narrow_messages(meta_user_t *user, uint64_t selected, stringer_t *range, int_t uid);
 imap_fetch_dataitems_t *  imap_parse_dataitems(imap_arguments_t *arguments);
 int_t                     imap_valid_sequence(stringer_t *range);
 
@@ -145,15 +156,16 @@ stringer_t *  imap_range_build(size_t length, uint64_t *numbers);
 
 /// search.c
 int_t    imap_search_flag(uint32_t status, uint32_t flag, int_t has);
+mail_search_t * imap_search_index(imap_search_index_t *index);
 inx_t *  imap_search_messages(connection_t *con);
-int_t    imap_search_messages_body(meta_user_t *user, mail_message_t **data, meta_message_t *active, stringer_t *value);
+int_t    imap_search_messages_body(meta_user_t *user, imap_search_index_t *index, mail_message_t **data, meta_message_t *active, stringer_t *value);
 int_t    imap_search_messages_date(meta_user_t *user, mail_message_t **data, stringer_t **header, meta_message_t *active, stringer_t *date, int_t internal, int_t expected);
 int_t    imap_search_messages_date_compare(stringer_t *one, stringer_t *two);
 int_t    imap_search_messages_header(meta_user_t *user, mail_message_t **data, stringer_t **header, meta_message_t *active, stringer_t *field, stringer_t *value);
-int_t    imap_search_messages_inner(meta_user_t *user, mail_message_t **message, stringer_t **header, meta_message_t *current, imap_arguments_t *array, unsigned recursion);
+int_t    imap_search_messages_inner(meta_user_t *user, imap_search_index_t *index, mail_message_t **message, stringer_t **header, meta_message_t *current, imap_arguments_t *array, unsigned recursion);
 int_t    imap_search_messages_range(meta_message_t *active, stringer_t *range, int_t uid);
 int_t    imap_search_messages_size(meta_message_t *active, stringer_t *value, int_t expected);
-int_t    imap_search_messages_text(meta_user_t *user, mail_message_t **data, meta_message_t *active, stringer_t *value);
+int_t    imap_search_messages_text(meta_user_t *user, imap_search_index_t *index, mail_message_t **data, meta_message_t *active, stringer_t *value);
 
 /// sessions.c
 void    imap_session_destroy(connection_t *con);
@@ -37,10 +37,10 @@ int_t imap_append_message(connection_t *con, meta_folder_t *folder, uint32_t fla
 		mm_free(new);
 	}
 
-	meta_messages_update_sequences(con->imap.user->folders, con->imap.user->messages);
+	meta_messages_update_sequences(con->imap.user);
 
 	// Update the checkpoint, so other connections know things have changed.
-	if (con->imap.user->serials.messages != serial_get(OBJECT_MESSAGES, con->imap.user->usernum)) {
+	if (con->imap.user->serials.messages != serial_get_uncached(OBJECT_MESSAGES, con->imap.user->usernum)) {
 		con->imap.messages_checkpoint = con->imap.user->serials.messages = serial_increment(OBJECT_MESSAGES, con->imap.user->usernum) - 1;
 	}
 	else {
@@ -98,11 +98,11 @@ int_t imap_message_copier(connection_t *con, meta_message_t *message, uint64_t t
 		mm_free(new);
 	}
 
-	meta_messages_update_sequences(con->imap.user->folders, con->imap.user->messages);
+	meta_messages_update_sequences(con->imap.user);
 
 	// If the serial number indicates no outside changes we can increment the checkpoint and store the value. Otherwise we just increment it
 	// so a full refresh will be triggered.
-	if (con->imap.user->serials.messages == serial_get(OBJECT_MESSAGES, con->imap.user->usernum)) {
+	if (con->imap.user->serials.messages == serial_get_uncached(OBJECT_MESSAGES, con->imap.user->usernum)) {
 		con->imap.messages_checkpoint = con->imap.user->serials.messages = serial_increment(OBJECT_MESSAGES, con->imap.user->usernum);
 	}
 	// The context is already due for a refresh, but we increment the serial to let the rest of the cluster know about the change.
@@ -194,14 +194,36 @@ int_t imap_search_messages_header(meta_user_t *user, mail_message_t **data, stri
 	return compare;
 }
 
-int_t imap_search_messages_body(meta_user_t *user, mail_message_t **data, meta_message_t *active, stringer_t *value) {
+/**
+ * @brief	Get the user's search index, opening it the first time a body or text criterion needs it.
+ * @note	Opening the index maps the whole file and indexes every record, so searches which only check flags, dates or sizes never
+ * 			open it. A failed open is remembered, so it isn't retried for every message.
+ * @param	index	the search index holder for the current search.
+ * @return	NULL if the index isn't available, or a pointer to the opened search index.
+ */
+mail_search_t * imap_search_index(imap_search_index_t *index) {
+
+	if (!index->opened) {
+		index->search = index->usernum ? mail_search_open(index->usernum) : NULL;
+		index->opened = true;
+	}
+
+	return index->search;
+}
+
+int_t imap_search_messages_body(meta_user_t *user, imap_search_index_t *index, mail_message_t **data, meta_message_t *active, stringer_t *value) {
 
 	size_t location;
 	int_t compare = -1;
 	stringer_t *current = NULL;
 
+	// Skip messages which the search index says can't contain the value.
+	if (*data == NULL && !mail_search_check(imap_search_index(index), active->messagenum, value)) {
+		compare = -1;
+	}
+
 	// Load the message, if necessary.
-	if (*data == NULL && ((*data = mail_load_message(active, user, NULL, 0)) == NULL || mail_mime_update(*data) == 0)) {
+	else if (*data == NULL && ((*data = mail_load_message(active, user, NULL, 0)) == NULL || mail_mime_update(*data) == 0)) {
 		compare = -1;
 	}
 
@@ -218,14 +240,19 @@ int_t imap_search_messages_body(meta_user_t *user, mail_message_t **data, meta_m
 	return compare;
 }
 
-int_t imap_search_messages_text(meta_user_t *user, mail_message_t **data, meta_message_t *active, stringer_t *value) {
+int_t imap_search_messages_text(meta_user_t *user, imap_search_index_t *index, mail_message_t **data, meta_message_t *active, stringer_t *value) {
 
 	size_t location;
 	int_t compare = -1;
 	stringer_t *current = NULL;
 
+	// Skip messages which the search index says can't contain the value.
+	if (*data == NULL && !mail_search_check(imap_search_index(index), active->messagenum, value)) {
+		compare = -1;
+	}
+
 	// Load the message, if necessary.
-	if (*data == NULL && ((*data = mail_load_message(active, user, NULL, 0)) == NULL || mail_mime_update(*data) == 0)) {
+	else if (*data == NULL && ((*data = mail_load_message(active, user, NULL, 0)) == NULL || mail_mime_update(*data) == 0)) {
 		compare = -1;
 	}
 
@@ -344,7 +371,7 @@ int_t imap_search_messages_range(meta_message_t *active, stringer_t *range, int_
 	return -1;
 }
 
-int_t imap_search_messages_inner(meta_user_t *user, mail_message_t **message, stringer_t **header, meta_message_t *current, imap_arguments_t *array, unsigned recursion) {
+int_t imap_search_messages_inner(meta_user_t *user, imap_search_index_t *index, mail_message_t **message, stringer_t **header, meta_message_t *current, imap_arguments_t *array, unsigned recursion) {
 
 	stringer_t *item;
 	unsigned number, increment = 0;
@@ -365,7 +392,7 @@ int_t imap_search_messages_inner(meta_user_t *user, mail_message_t **message, st
 
 		// Handle nested arrays.
 		if (imap_get_type_ar(array, increment) == IMAP_ARGUMENT_TYPE_ARRAY) {
-			eval = imap_search_messages_inner(user, message, header, current, imap_get_ar_ar(array, increment++), recursion + 1);
+			eval = imap_search_messages_inner(user, index, message, header, current, imap_get_ar_ar(array, increment++), recursion + 1);
 		}
 		else if ((item = imap_get_st_ar(array, increment++)) == NULL) {
 			eval = -1;
@@ -462,12 +489,12 @@ int_t imap_search_messages_inner(meta_user_t *user, mail_message_t **message, st
 
 		// Body checks.
 		else if (increment < number && !st_cmp_ci_eq(item, PLACER("BODY", 4)) && imap_get_type_ar(array, increment) != IMAP_ARGUMENT_TYPE_ARRAY) {
-			eval = imap_search_messages_body(user, message, current, imap_get_st_ar(array, increment++));
+			eval = imap_search_messages_body(user, index, message, current, imap_get_st_ar(array, increment++));
 		}
 
 		// Full message checks.
 		else if (increment < number && !st_cmp_ci_eq(item, PLACER("TEXT", 4)) && imap_get_type_ar(array, increment) != IMAP_ARGUMENT_TYPE_ARRAY) {
-			eval = imap_search_messages_text(user, message, current, imap_get_st_ar(array, increment++));
+			eval = imap_search_messages_text(user, index, message, current, imap_get_st_ar(array, increment++));
 		}
 
 		// Size checks.
@@ -566,6 +593,7 @@ inx_t * imap_search_messages(connection_t *con) {
 	inx_t *output = NULL;
 	inx_cursor_t *cursor = NULL;
 	stringer_t *header = NULL;
+	imap_search_index_t index = { .opened = false, .usernum = 0, .search = NULL };
 	mail_message_t *message = NULL;
 	uint64_t finished = 0, uid = 0, count = 0;
 	meta_message_t *duplicate = NULL, *active = NULL;
@@ -575,6 +603,9 @@ inx_t * imap_search_messages(connection_t *con) {
 		return NULL;
 	}
 
+	// The search index is used to skip messages during body and text searches. Without it every message is loaded.
+	index.usernum = con->imap.user ? con->imap.user->usernum : 0;
+
 	while (status() && !finished) {
 
 		/// LOW: Is a read lock necessary now that were using index reference counters and thread safe iteration cursors?
@@ -592,7 +623,7 @@ inx_t * imap_search_messages(connection_t *con) {
 
 			// Check for a match.
 			if (active->foldernum == con->imap.selected &&
-					imap_search_messages_inner(con->imap.user, &message, &header, active, con->imap.arguments, 0) == 1 &&
+					imap_search_messages_inner(con->imap.user, &index, &message, &header, active, con->imap.arguments, 0) == 1 &&
 					(key.val.u64 = active->messagenum) && (duplicate = meta_message_dupe(active)) &&
 					inx_append(output, key, duplicate) != true) {
 				meta_message_free(duplicate);
@@ -626,6 +657,8 @@ inx_t * imap_search_messages(connection_t *con) {
 
 	}
 
+	mail_search_close(index.search);
+
 	// If the user serial number has changed, then messages may have been added or removed from the user's mailbox, which
 	// means the sequence numbers, which are relative, for messages in the output index could have changed. The  logic below
 	// iterates through the output index and updates the sequence number duplicate message strucutre with the current sequence
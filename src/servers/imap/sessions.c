@@ -16,13 +16,17 @@ int_t imap_session_update(connection_t *con) {
 	int_t result = 0;
 	inx_cursor_t *cursor;
 	meta_message_t *active;
-	uint64_t recent = 0, exists = 0, checkpoint;
+	uint64_t recent = 0, exists = 0, checkpoint, serials[SERIAL_OBJECTS];
 
 	// Check for the right state.
 	if (con->imap.session_state != 1 || con->imap.user == NULL || con->imap.selected == 0) {
 		return -1;
 	}
 
+	// Fetch all of the user's serials with one request, so the checks below, and the serial checks made by the update
+	// functions, are answered from the local serial cache.
+	serial_get_all(con->imap.user->usernum, serials);
+
 	if ((checkpoint = serial_get(OBJECT_USER, con->imap.user->usernum)) != con->imap.user_checkpoint) {
 		meta_user_wlock(con->imap.user);
 
@@ -138,7 +142,5 @@ void imap_session_destroy(connection_t *con) {
 		con->imap.arguments = NULL;
 	}
 
-	mail_cache_reset();
-
 	return;
 }
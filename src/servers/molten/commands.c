@@ -40,7 +40,7 @@ void molten_parse(connection_t *con) {
 	}
 	else if (pl_empty(con->network.line)) {
 		con->command = NULL;
-		enqueue(&molten_parse, con);
+		con_poll(con, &molten_parse);
 		return;
 	}
 
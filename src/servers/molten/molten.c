@@ -33,14 +33,27 @@ void molten_stats(connection_t *con) {
 
 	}
 
-	con_write_bl(con, "END\r\n", 5) < 0 ? enqueue(&molten_quit, con) : enqueue(&molten_parse, con);
+	length = stats_histogram_count();
+
+	for(size_t i = 0; i < length; i++) {
+
+		if (con_print(con, "STAT %s.count %lu\r\nSTAT %s.sum %lu\r\nSTAT %s.p50 %lu\r\nSTAT %s.p99 %lu\r\n",
+			stats_histogram_name(i), stats_histogram_total(i), stats_histogram_name(i), stats_histogram_sum(i),
+			stats_histogram_name(i), stats_histogram_percentile(i, 50), stats_histogram_name(i), stats_histogram_percentile(i, 99)) < 0) {
+			enqueue(&molten_quit, con);
+			return;
+		}
+
+	}
+
+	con_write_bl(con, "END\r\n", 5) < 0 ? enqueue(&molten_quit, con) : con_poll(con, &molten_parse);
 
 	return;
 }
 
 void molten_invalid(connection_t *con) {
 
-	con_write_bl(con, "ERROR\r\n", 7) < 0 ? enqueue(&molten_quit, con) : enqueue(&molten_parse, con);
+	con_write_bl(con, "ERROR\r\n", 7) < 0 ? enqueue(&molten_quit, con) : con_poll(con, &molten_parse);
 	return;
 }
 
@@ -52,6 +65,6 @@ void molten_quit(connection_t *con) {
 
 void molten_init(connection_t *con) {
 
-	enqueue(&molten_parse, con);
+	con_poll(con, &molten_parse);
 	return;
 }
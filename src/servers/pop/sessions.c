@@ -76,7 +76,7 @@ void pop_session_destroy(connection_t *con) {
 				}
 
 				if (deleted) {
-					meta_messages_update_sequences(con->pop.user->folders, con->pop.user->messages);
+					meta_messages_update_sequences(con->pop.user);
 					con->pop.user->serials.messages = serial_increment(OBJECT_MESSAGES, con->pop.user->usernum);
 				}
 
@@ -95,6 +95,5 @@ void pop_session_destroy(connection_t *con) {
 
 	st_cleanup(con->pop.username);
 	con->pop.usernum = 0;
-	mail_cache_reset();
 	return;
 }
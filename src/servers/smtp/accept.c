@@ -228,14 +228,20 @@ int_t smtp_accept_message(connection_t *con, smtp_inbound_prefs_t *prefs) {
 	// Check the message for a virus. If vscanned is equal to ten, then the message is virus free.
 	if ((prefs->virus == 1 || prefs->phish == 1) && con->smtp.checked.virus != 1) {
 
-		// The message hasn't been scanned, or encountered an error during the last attempt, so rescan it now.
-		if (con->smtp.checked.virus == 0 || con->smtp.checked.virus == -1) {
+		// The message hasn't been scanned by the checker pool, or for a previous recipient, so scan it now. Errors aren't retried for
+		// each recipient, since the result only depends on the message.
+		if (con->smtp.checked.virus == 0) {
 			con->smtp.checked.virus = state = virus_check(con->smtp.message->text);
 		}
 		else {
 			state = con->smtp.checked.virus;
 		}
 
+		// The checker pool was still scanning the message when its deadline passed, so ask the sender to try again later.
+		if (state == SMTP_PIPELINE_TIMEOUT) {
+			return SMTP_OUTCOME_TEMP_SERVER;
+		}
+
 		// If a virus was found.
 		if (prefs->virus == 1 && state == -2) {
 			if (prefs->virusaction == SMTP_ACTION_MARK_READ) {
@@ -345,7 +351,7 @@ int_t smtp_accept_message(connection_t *con, smtp_inbound_prefs_t *prefs) {
 	}
 
 	if (!con->smtp.bypass && (prefs->mark == SMTP_MARK_NONE) && (prefs->spam == 1)) {
-		if ((prefs->spam_checked = dspam_check(prefs->usernum, local, &(prefs->spamsig))) == -1) {
+		if ((prefs->spam_checked = smtp_pipeline_dspam(prefs->usernum, local, &(prefs->spamsig))) == -1) {
 			st_free(local);
 			return SMTP_OUTCOME_TEMP_SERVER;
 		}
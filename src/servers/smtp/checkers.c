@@ -70,53 +70,22 @@ int_t smtp_check_greylist(connection_t *con, smtp_inbound_prefs_t *prefs) {
 
 /**
  * @brief	Check the SMTP connection's remote address against a collection of real-time blacklists.
- * @note	The connection's IP address will be checked against each of the servers configured in magma.smtp.blacklists.domain.
+ * @note	The connection's IP address will be checked against each of the servers configured in magma.smtp.blacklists.domain. The
+ * 			lists are queried concurrently, and the results are cached according to their DNS TTLs.
+ * @see		smtp_rbl_check()
  * @param	con		the connection to have its address examined against the RBLs.
  * @return	-1 on general error, -2 if the address was blacklisted, or 1 if it passed the check.
  */
 int_t smtp_check_rbl(connection_t *con) {
 
-	int_t ret, result = -1;
-	chr_t query[NI_MAXHOST];
-	struct addrinfo *lookup, hints;
 	stringer_t *addr = MANAGEDBUF(128);
 
-	mm_wipe(&hints, sizeof(struct addrinfo));
-	hints.ai_family = AF_UNSPEC;
-	hints.ai_socktype = 0;
-	hints.ai_flags = 0;
-	hints.ai_protocol = 0;
-
 	if (!(addr = con_addr_reversed(con, addr))) {
 		log_pedantic("Address string creation failed.");
-		return result;
-	}
-
-	for (uint32_t i = 0; i < magma.smtp.blacklists.count; i++) {
-
-		// Build the DNS query.
-		if ((snprintf(query, NI_MAXHOST, "%.*s.%*s", st_length_int(addr), st_char_get(addr),
-			st_length_int(magma.smtp.blacklists.domain[i]),	st_char_get(magma.smtp.blacklists.domain[i]))) == 0) {
-				log_pedantic("Address string creation failed.");
-		}
-
-		// A zero means we found a blacklist entry, so we need to free the entry.
-		else if (!(ret = getaddrinfo(query, NULL, &hints, &lookup))) {
-			freeaddrinfo(lookup);
-			return -2;
-		}
-		// If the return code code indicates an error, rather than simply not finding a matching entry.
-		// Do we also want to exclude EAI_ADDRFAMILY or EAI_NODATA
-		else if (ret != EAI_NONAME) {
-			log_pedantic("Blacklist DNS attempt resulted in an error. { getaddrinfo = %s }", gai_strerror(ret));
-		}
-		else {
-			result = 1;
-		}
-
+		return -1;
 	}
 
-	return result;
+	return smtp_rbl_check(addr);
 }
 
 /**
@@ -127,44 +96,50 @@ int_t smtp_check_filters(smtp_inbound_prefs_t *prefs, stringer_t **local) {
 
 	placer_t data;
 	size_t length;
+	uint32_t rule = 0;
 	stringer_t *field;
 	inx_cursor_t *cursor;
 	chr_t *error = MEMORYBUF(1024);
-	struct re_pattern_buffer regbuff;
+	smtp_filter_program_t *program;
 	smtp_inbound_filter_t *filter = NULL;
-	int_t match = -1, result = 0, holder = 0;
+	int_t match = -1, result = 0;
 
 	if (!prefs || !prefs->filters || !(cursor = inx_cursor_alloc(prefs->filters))) {
 		return -1;
 	}
+	// The expressions are compiled once, and reused until the user's filters change.
+	else if (!(program = smtp_filters_get(prefs->usernum, prefs->filters))) {
+		inx_cursor_free(cursor);
+		return -1;
+	}
 
-	while (match == -1 && (filter = inx_cursor_value_next(cursor))) {
+	// The message is only modified when a filter matches, which ends the loop, so the header length only needs to be found once.
+	length = mail_header_end(*local);
+
+	while (match == -1 && rule < program->count && (filter = inx_cursor_value_next(cursor))) {
 
 		field = NULL;
 		data = pl_null();
-		mm_wipe(&regbuff, sizeof(struct re_pattern_buffer));
 
-		// Use regcomp, so we can use the case insensitive flag.
-		if ((holder = regcomp(&regbuff, st_char_get(filter->expression), REG_ICASE)) != 0) {
-			regerror(holder, &regbuff, error, 1024);
+		if (program->errors[rule]) {
+			regerror(program->errors[rule], &(program->patterns[rule]), error, 1024);
 			log_pedantic("Regular expression compilation failed. {user = %lu / rule = %lu / expression = %.*s / error = %s }",
 				prefs->usernum, filter->rulenum, st_length_int(filter->expression), st_char_get(filter->expression), error);
+			smtp_filters_release(program);
 			inx_cursor_free(cursor);
 			return -1;
 		}
 
 		// Set the start position beginning, and the length to the end of the header.
 		if ((filter->location & SMTP_FILTER_LOCATION_HEADER) == SMTP_FILTER_LOCATION_HEADER) {
-			data = pl_init(st_char_get(*local), mail_header_end(*local));
+			data = pl_init(st_char_get(*local), length);
 		}
 		// Set the start to end of the header, and the length of the body.
 		else if ((filter->location & SMTP_FILTER_LOCATION_BODY) == SMTP_FILTER_LOCATION_BODY) {
-			length = mail_header_end(*local);
 			data = pl_init(st_char_get(*local) + length, st_length_get(*local) - length);
 		}
 		// Pull a specific field.
 		else if ((filter->location & SMTP_FILTER_LOCATION_FIELD) == SMTP_FILTER_LOCATION_FIELD && filter->field) {
-			length = mail_header_end(*local);
 
 			if ((field = mail_header_fetch_all(PLACER(st_char_get(*local), length), filter->field)) != NULL) {
 
@@ -199,12 +174,13 @@ int_t smtp_check_filters(smtp_inbound_prefs_t *prefs, stringer_t **local) {
 		}
 		else {
 			log_pedantic("Unrecognized location %i.", filter->location);
+			smtp_filters_release(program);
 			inx_cursor_free(cursor);
 			return -1;
 		}
 
 		// Use the re_search function because it allows us to specify length.
-		match = re_search(&regbuff, pl_data_get(data), pl_length_get(data), 0, pl_length_get(data), NULL);
+		match = re_search(&(program->patterns[rule++]), pl_data_get(data), pl_length_get(data), 0, pl_length_get(data), NULL);
 
 		// What do we do with matches? Move it to a folder.
 		if (match != -1 && (filter->action & SMTP_FILTER_ACTION_MOVE) == SMTP_FILTER_ACTION_MOVE && filter->foldernum != 0) {
@@ -224,10 +200,11 @@ int_t smtp_check_filters(smtp_inbound_prefs_t *prefs, stringer_t **local) {
 		}
 
 		// Cleanup
-		regfree(&regbuff);
 		st_cleanup(field);
 	}
 
+	smtp_filters_release(program);
+
 	// Detect deletes and return a -2 to trigger the action.
 	if (match != -1 && filter && (filter->action & SMTP_FILTER_ACTION_DELETE) == SMTP_FILTER_ACTION_DELETE) {
 		result = -2;
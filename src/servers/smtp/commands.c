@@ -34,7 +34,7 @@ void smtp_requeue(connection_t *con) {
 		enqueue(&smtp_quit, con);
 	}
 	else {
-		enqueue(&smtp_process, con);
+		con_poll(con, &smtp_process);
 	}
 
 	return;
@@ -61,7 +61,7 @@ void smtp_process(connection_t *con) {
 	}
 	else if (pl_empty(con->network.line)) {
 		con->command = NULL;
-		enqueue(&smtp_process, con);
+		con_poll(con, &smtp_process);
 		return;
 	}
 
@@ -532,6 +532,45 @@ void smtp_update_transmission_stats(connection_t *con) {
 	return;
 }
 
+/**
+ * @brief	Refresh the storage quota fields of a recipient's inbound preferences.
+ * @note	Storing a message updates the user's size and quota flag without touching the user serial number, so preferences taken
+ * 			from the recipient cache must be refreshed, or an account could keep accepting mail after crossing its quota.
+ * @param	prefs	the inbound preferences to be updated.
+ * @return	-1 on error, or 1 on success.
+ */
+int_t smtp_fetch_quota(smtp_inbound_prefs_t *prefs) {
+
+	row_t *row;
+	table_t *result;
+	MYSQL_BIND parameters[1];
+
+	mm_wipe(parameters, sizeof(parameters));
+
+	// Usernum
+	parameters[0].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[0].buffer_length = sizeof(uint64_t);
+	parameters[0].buffer = &(prefs->usernum);
+	parameters[0].is_unsigned = true;
+
+	if (!(result = stmt_get_result(stmts.select_prefs_quota, parameters))) {
+		log_pedantic("Could not fetch the storage quota.");
+		return -1;
+	}
+	else if (!(row = res_row_next(result))) {
+		log_pedantic("Could not fetch the first SQL result row.");
+		res_table_free(result);
+		return -1;
+	}
+
+	prefs->stor_size = res_field_uint64(row, 0);
+	prefs->quota = res_field_uint64(row, 1);
+	prefs->overquota = res_field_int8(row, 2);
+	res_table_free(result);
+
+	return 1;
+}
+
 /**
  * @brief	Check to see if a user's current mail send request would push them over their daily transmission quota.
  * @note	This check is performed by querying the database to see how many messages a user has sent in the past 24 hour period, and by
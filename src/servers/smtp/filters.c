@@ -0,0 +1,258 @@
+
+/**
+ * @file /magma/servers/smtp/filters.c
+ *
+ * @brief	Functions used to compile a user's inbound filter expressions, and cache the compiled programs between deliveries.
+ * @note	The cache is a direct mapped table of SMTP_FILTER_CACHE_SLOTS programs, selected by user number. A program is taken out
+ * 			of the cache while a delivery is using it, so the compiled expressions are never shared between threads, and is put back
+ * 			once the delivery is finished. Each program records a serial computed from the user's rules, so any change to the rules
+ * 			causes the program to be recompiled.
+ */
+
+#include "magma.h"
+
+static struct {
+	bool_t started;
+	pthread_mutex_t locks[SMTP_FILTER_CACHE_SHARDS];
+	smtp_filter_program_t *slots[SMTP_FILTER_CACHE_SLOTS];
+	struct {
+		uint64_t hits, misses;
+	} stats;
+} smtp_filters = {
+	.started = false
+};
+
+/**
+ * @brief	Free a compiled filter program.
+ * @param	program		a pointer to the filter program to be freed.
+ * @return	This function returns no value.
+ */
+void smtp_filters_free(smtp_filter_program_t *program) {
+
+	if (program) {
+
+		if (program->patterns) {
+			for (uint32_t i = 0; i < program->count; i++) {
+				if (!program->errors[i]) regfree(&(program->patterns[i]));
+			}
+
+			mm_free(program->patterns);
+		}
+
+		if (program->errors) mm_free(program->errors);
+		mm_free(program);
+	}
+
+	return;
+}
+
+/**
+ * @brief	Initialize the compiled filter cache.
+ * @return	true on success or false on failure.
+ */
+bool_t smtp_filters_start(void) {
+
+	mm_wipe(smtp_filters.slots, sizeof(smtp_filters.slots));
+
+	for (uint_t i = 0; i < SMTP_FILTER_CACHE_SHARDS; i++) {
+		if (mutex_init(&(smtp_filters.locks[i]), NULL)) {
+			log_pedantic("Unable to initialize the filter cache locks.");
+
+			for (uint_t j = 0; j < i; j++) {
+				mutex_destroy(&(smtp_filters.locks[j]));
+			}
+
+			return false;
+		}
+	}
+
+	smtp_filters.stats.hits = stats_get_name_pos("smtp.filters.cache.hits");
+	smtp_filters.stats.misses = stats_get_name_pos("smtp.filters.cache.misses");
+	smtp_filters.started = true;
+
+	return true;
+}
+
+/**
+ * @brief	Free every cached filter program and destroy the cache.
+ * @return	This function returns no value.
+ */
+void smtp_filters_stop(void) {
+
+	if (!smtp_filters.started) {
+		return;
+	}
+
+	smtp_filters.started = false;
+
+	for (uint_t i = 0; i < SMTP_FILTER_CACHE_SLOTS; i++) {
+		smtp_filters_free(smtp_filters.slots[i]);
+		smtp_filters.slots[i] = NULL;
+	}
+
+	for (uint_t i = 0; i < SMTP_FILTER_CACHE_SHARDS; i++) {
+		mutex_destroy(&(smtp_filters.locks[i]));
+	}
+
+	return;
+}
+
+/**
+ * @brief	Calculate the serial for a collection of filter rules.
+ * @note	Only the expressions, and their order, affect the compiled program, so the serial is a checksum of each expression and its length.
+ * @param	filters		an inx holder containing the user's inbound filters, in the order they are applied.
+ * @param	count		a pointer to receive the number of filters.
+ * @return	the serial of the filter rules.
+ */
+uint64_t smtp_filters_serial(inx_t *filters, uint32_t *count) {
+
+	size_t length;
+	uint64_t serial = 0;
+	inx_cursor_t *cursor;
+	smtp_inbound_filter_t *filter;
+
+	*count = 0;
+
+	if (!(cursor = inx_cursor_alloc(filters))) {
+		return 0;
+	}
+
+	while ((filter = inx_cursor_value_next(cursor))) {
+		length = st_length_get(filter->expression);
+		serial = crc64_update(&length, sizeof(size_t), serial);
+		serial = crc64_update(st_data_get(filter->expression), length, serial);
+		(*count)++;
+	}
+
+	inx_cursor_free(cursor);
+
+	return serial;
+}
+
+/**
+ * @brief	Compile a user's inbound filter expressions.
+ * @note	An expression which fails to compile doesn't invalidate the program. Its error is recorded, and returned when a message
+ * 			reaches that rule, just as if the expression had been compiled during the delivery.
+ * @param	usernum		the numerical id of the user who owns the filters.
+ * @param	filters		an inx holder containing the user's inbound filters, in the order they are applied.
+ * @return	NULL on failure, or a pointer to the compiled filter program on success.
+ */
+smtp_filter_program_t * smtp_filters_compile(uint64_t usernum, inx_t *filters) {
+
+	uint32_t i = 0;
+	inx_cursor_t *cursor;
+	smtp_inbound_filter_t *filter;
+	smtp_filter_program_t *program;
+
+	if (!(program = mm_alloc(sizeof(smtp_filter_program_t)))) {
+		log_pedantic("Unable to allocate %zu bytes for the filter program.", sizeof(smtp_filter_program_t));
+		return NULL;
+	}
+
+	program->usernum = usernum;
+	program->serial = smtp_filters_serial(filters, &(program->count));
+
+	if (!program->count) {
+		return program;
+	}
+	else if (!(program->patterns = mm_alloc(program->count * sizeof(struct re_pattern_buffer))) ||
+		!(program->errors = mm_alloc(program->count * sizeof(int_t))) || !(cursor = inx_cursor_alloc(filters))) {
+		log_pedantic("Unable to allocate the filter program. { count = %u }", program->count);
+
+		// Nothing has been compiled yet, so make sure the free function doesn't try to release any patterns.
+		if (program->patterns) mm_free(program->patterns);
+		program->patterns = NULL;
+		smtp_filters_free(program);
+		return NULL;
+	}
+
+	while (i < program->count && (filter = inx_cursor_value_next(cursor))) {
+
+		// Use regcomp, so we can use the case insensitive flag.
+		program->errors[i] = regcomp(&(program->patterns[i]), st_char_get(filter->expression), REG_ICASE);
+		i++;
+	}
+
+	inx_cursor_free(cursor);
+
+	return program;
+}
+
+/**
+ * @brief	Take the compiled filter program for a user out of the cache, compiling the program if necessary.
+ * @param	usernum		the numerical id of the user who owns the filters.
+ * @param	filters		an inx holder containing the user's current inbound filters, in the order they are applied.
+ * @return	NULL on failure, or a pointer to a compiled filter program which must be handed back using smtp_filters_release().
+ */
+smtp_filter_program_t * smtp_filters_get(uint64_t usernum, inx_t *filters) {
+
+	uint32_t count;
+	uint64_t serial;
+	smtp_filter_program_t *program = NULL, *stale = NULL;
+	uint32_t slot = usernum % SMTP_FILTER_CACHE_SLOTS;
+
+	if (!filters) {
+		return NULL;
+	}
+	else if (!smtp_filters.started) {
+		return smtp_filters_compile(usernum, filters);
+	}
+
+	serial = smtp_filters_serial(filters, &count);
+	mutex_lock(&(smtp_filters.locks[slot % SMTP_FILTER_CACHE_SHARDS]));
+
+	if ((program = smtp_filters.slots[slot]) && program->usernum == usernum) {
+		smtp_filters.slots[slot] = NULL;
+
+		// The rules changed since the program was compiled.
+		if (program->serial != serial || program->count != count) {
+			stale = program;
+			program = NULL;
+		}
+	}
+	else {
+		program = NULL;
+	}
+
+	mutex_unlock(&(smtp_filters.locks[slot % SMTP_FILTER_CACHE_SHARDS]));
+	smtp_filters_free(stale);
+
+	if (program) {
+		stats_increment_by_num(smtp_filters.stats.hits);
+		return program;
+	}
+
+	stats_increment_by_num(smtp_filters.stats.misses);
+
+	return smtp_filters_compile(usernum, filters);
+}
+
+/**
+ * @brief	Put a compiled filter program back into the cache, replacing whatever program held the slot before.
+ * @param	program		a pointer to the filter program being released.
+ * @return	This function returns no value.
+ */
+void smtp_filters_release(smtp_filter_program_t *program) {
+
+	uint32_t slot;
+	smtp_filter_program_t *previous;
+
+	if (!program) {
+		return;
+	}
+	else if (!smtp_filters.started) {
+		smtp_filters_free(program);
+		return;
+	}
+
+	slot = program->usernum % SMTP_FILTER_CACHE_SLOTS;
+	mutex_lock(&(smtp_filters.locks[slot % SMTP_FILTER_CACHE_SHARDS]));
+
+	previous = smtp_filters.slots[slot];
+	smtp_filters.slots[slot] = program;
+
+	mutex_unlock(&(smtp_filters.locks[slot % SMTP_FILTER_CACHE_SHARDS]));
+	smtp_filters_free(previous);
+
+	return;
+}
@@ -0,0 +1,408 @@
+
+/**
+ * @file /magma/servers/smtp/pipeline.c
+ *
+ * @brief	Functions used to run the virus, DKIM and SPF checks concurrently, once per inbound message, on a dedicated thread pool.
+ * @note	The checks are launched as soon as the message has been received, and the results are stored in the connection, so they're
+ * 			shared by every recipient. Each checker has its own deadline. A checker which misses its deadline is left to finish on
+ * 			its own, which is why the pipeline holds its own copy of the message. The DKIM and SPF checkers are then treated as if
+ * 			they had failed, while a virus scan which never left the queue is run inline, and one which was still running causes
+ * 			the message to be deferred, so a busy pool never lets a message through unscanned.
+ */
+
+#include "magma.h"
+
+static struct {
+	bool_t running;
+	uint32_t count;
+	sem_t sema;
+	pthread_t *threads;
+	pthread_mutex_t lock;
+	smtp_pipeline_task_t *head, *tail;
+	struct {
+		uint64_t timeouts;
+		int64_t latency[SMTP_PIPELINE_CHECKERS];
+	} stats;
+} smtp_pipeline = {
+	.running = false,
+	.stats.latency = { -1, -1, -1, -1 }
+};
+
+/**
+ * @brief	Release a reference to a message pipeline, and free the pipeline once the last reference is gone.
+ * @param	pipeline	a pointer to the pipeline being released.
+ * @return	This function returns no value.
+ */
+void smtp_pipeline_release(smtp_pipeline_t *pipeline) {
+
+	uint32_t refs;
+
+	if (!pipeline) {
+		return;
+	}
+
+	mutex_lock(&(pipeline->lock));
+	refs = --(pipeline->refs);
+	mutex_unlock(&(pipeline->lock));
+
+	if (!refs) {
+		st_cleanup(pipeline->id, pipeline->text, pipeline->helo, pipeline->mailfrom);
+		mutex_destroy(&(pipeline->lock));
+		sem_destroy(&(pipeline->done));
+		mm_free(pipeline);
+	}
+
+	return;
+}
+
+/**
+ * @brief	Run a single checker against a message, and record how long it took.
+ * @param	pipeline	a pointer to the pipeline holding the message.
+ * @param	checker		the checker being run, which must be SMTP_PIPELINE_VIRUS, SMTP_PIPELINE_DKIM or SMTP_PIPELINE_SPF.
+ * @return	the value returned by the checker, or -1 on error.
+ */
+int_t smtp_pipeline_execute(smtp_pipeline_t *pipeline, uint_t checker) {
+
+	int_t result = -1;
+	uint64_t started = time_microseconds();
+
+	if (checker == SMTP_PIPELINE_VIRUS) {
+		result = virus_check(pipeline->text);
+	}
+	else if (checker == SMTP_PIPELINE_DKIM) {
+		result = dkim_signature_verify(pipeline->id, pipeline->text);
+	}
+	else if (checker == SMTP_PIPELINE_SPF) {
+		result = spf_check(&(pipeline->ip), pipeline->helo, pipeline->mailfrom);
+	}
+
+	stats_histogram_record(smtp_pipeline.stats.latency[checker], time_microseconds() - started);
+
+	return result;
+}
+
+/**
+ * @brief	Run the spam filter for a recipient, and record how long it took.
+ * @note	The spam filter depends on the recipient's training data, so it can't be shared, and is run by smtp_accept_message().
+ * @see		dspam_check()
+ * @param	usernum		the numerical id of the recipient.
+ * @param	message		a managed string containing the message, with the recipient's headers.
+ * @param	signature	a pointer to receive the spam signature.
+ * @return	the value returned by dspam_check().
+ */
+int_t smtp_pipeline_dspam(uint64_t usernum, stringer_t *message, stringer_t **signature) {
+
+	int_t result;
+	uint64_t started = time_microseconds();
+
+	result = dspam_check(usernum, message, signature);
+	stats_histogram_record(smtp_pipeline.stats.latency[SMTP_PIPELINE_DSPAM], time_microseconds() - started);
+
+	return result;
+}
+
+/**
+ * @brief	The checker thread entry point, which runs queued checkers until the pool is stopped.
+ * @param	unused	this parameter is ignored.
+ * @return	This function always returns NULL.
+ */
+void * smtp_pipeline_worker(void *unused) {
+
+	int_t result;
+	bool_t expired;
+	smtp_pipeline_task_t *task;
+
+	thread_start();
+
+	while (true) {
+
+		sem_wait(&(smtp_pipeline.sema));
+
+		mutex_lock(&(smtp_pipeline.lock));
+
+		if ((task = smtp_pipeline.head) && !(smtp_pipeline.head = task->next)) {
+			smtp_pipeline.tail = NULL;
+		}
+
+		mutex_unlock(&(smtp_pipeline.lock));
+
+		// The semaphore is posted once for each thread when the pool is stopped.
+		if (!task && !smtp_pipeline.running) {
+			break;
+		}
+		else if (!task) {
+			continue;
+		}
+
+		// If the connection stopped waiting while the task sat in the queue, the check is skipped, since its result would be discarded.
+		mutex_lock(&(task->pipeline->lock));
+		expired = task->pipeline->checkers[task->checker].expired;
+		task->pipeline->checkers[task->checker].started = !expired;
+		mutex_unlock(&(task->pipeline->lock));
+
+		if (!expired) {
+
+			result = smtp_pipeline_execute(task->pipeline, task->checker);
+
+			// If the connection stopped waiting, the result is simply discarded.
+			mutex_lock(&(task->pipeline->lock));
+			if (!task->pipeline->checkers[task->checker].expired) {
+				task->pipeline->checkers[task->checker].result = result;
+				task->pipeline->checkers[task->checker].finished = true;
+			}
+			mutex_unlock(&(task->pipeline->lock));
+		}
+
+		sem_post(&(task->pipeline->done));
+		smtp_pipeline_release(task->pipeline);
+		mm_free(task);
+	}
+
+	thread_stop();
+
+	return NULL;
+}
+
+/**
+ * @brief	Launch the checker thread pool.
+ * @note	If magma.smtp.checkers.threads is zero, no threads are launched, and the checks are run by smtp_accept_message() as needed.
+ * @return	true on success or false on failure.
+ */
+bool_t smtp_pipeline_start(void) {
+
+	chr_t *names[SMTP_PIPELINE_CHECKERS] = { "smtp.checkers.virus", "smtp.checkers.dkim", "smtp.checkers.spf", "smtp.checkers.dspam" };
+
+	for (uint_t i = 0; i < SMTP_PIPELINE_CHECKERS; i++) {
+		smtp_pipeline.stats.latency[i] = stats_histogram_pos(names[i]);
+	}
+
+	smtp_pipeline.stats.timeouts = stats_get_name_pos("smtp.checkers.timeouts");
+
+	if (!magma.smtp.checkers.threads) {
+		return true;
+	}
+	else if (sem_init(&(smtp_pipeline.sema), 0, 0)) {
+		log_pedantic("Unable to initialize the checker queue semaphore.");
+		return false;
+	}
+	else if (mutex_init(&(smtp_pipeline.lock), NULL)) {
+		log_pedantic("Unable to initialize the checker queue lock.");
+		sem_destroy(&(smtp_pipeline.sema));
+		return false;
+	}
+	else if (!(smtp_pipeline.threads = mm_alloc(sizeof(pthread_t) * magma.smtp.checkers.threads))) {
+		log_pedantic("Unable to allocate the checker thread pool. { threads = %u }", magma.smtp.checkers.threads);
+		mutex_destroy(&(smtp_pipeline.lock));
+		sem_destroy(&(smtp_pipeline.sema));
+		return false;
+	}
+
+	smtp_pipeline.running = true;
+
+	for (uint32_t i = 0; i < magma.smtp.checkers.threads; i++) {
+
+		if (thread_launch(smtp_pipeline.threads + i, &smtp_pipeline_worker, NULL)) {
+			log_error("Unable to launch the configured number of checker threads. { threads = %u / configured = %u }", i,
+				magma.smtp.checkers.threads);
+			smtp_pipeline_stop();
+			return false;
+		}
+
+		smtp_pipeline.count++;
+	}
+
+	return true;
+}
+
+/**
+ * @brief	Stop the checker thread pool, and discard any checkers still waiting in the queue.
+ * @return	This function returns no value.
+ */
+void smtp_pipeline_stop(void) {
+
+	smtp_pipeline_task_t *task;
+
+	if (!smtp_pipeline.threads) {
+		return;
+	}
+
+	smtp_pipeline.running = false;
+
+	for (uint32_t i = 0; i < smtp_pipeline.count; i++) {
+		sem_post(&(smtp_pipeline.sema));
+	}
+
+	for (uint32_t i = 0; i < smtp_pipeline.count; i++) {
+		thread_join(smtp_pipeline.threads[i]);
+	}
+
+	while ((task = smtp_pipeline.head)) {
+		smtp_pipeline.head = task->next;
+		smtp_pipeline_release(task->pipeline);
+		mm_free(task);
+	}
+
+	mm_free(smtp_pipeline.threads);
+	mutex_destroy(&(smtp_pipeline.lock));
+	sem_destroy(&(smtp_pipeline.sema));
+
+	smtp_pipeline.tail = NULL;
+	smtp_pipeline.threads = NULL;
+	smtp_pipeline.count = 0;
+
+	return;
+}
+
+/**
+ * @brief	Run the virus, DKIM and SPF checks needed by the recipients of an inbound message concurrently, and wait for the results.
+ * @note	A check is only launched if at least one recipient has enabled it, and it hasn't already been run for this message. The
+ * 			results are stored in con->smtp.checked, which is where smtp_accept_message() looks for them. A DKIM or SPF checker
+ * 			which misses its deadline, or fails, is stored as -1. A virus scan which misses its deadline before it starts is stored
+ * 			as 0, so smtp_accept_message() runs it inline, and one which was already running is stored as SMTP_PIPELINE_TIMEOUT.
+ * @param	con		the SMTP client connection which received the message.
+ * @return	This function returns no value.
+ */
+void smtp_pipeline_run(connection_t *con) {
+
+	bool_t pending;
+	struct timespec now, earliest = { 0, 0 };
+	smtp_pipeline_t *pipeline;
+	smtp_pipeline_task_t *task;
+	smtp_inbound_prefs_t *current;
+	bool_t needed[SMTP_PIPELINE_SHARED] = { false, false, false };
+	uint32_t timeouts[SMTP_PIPELINE_SHARED] = {
+		magma.smtp.checkers.timeout.virus, magma.smtp.checkers.timeout.dkim, magma.smtp.checkers.timeout.spf
+	};
+	int_t *results[SMTP_PIPELINE_SHARED] = { &(con->smtp.checked.virus), &(con->smtp.checked.dkim), &(con->smtp.checked.spf) };
+
+	if (!smtp_pipeline.running || !con->smtp.message || st_empty(con->smtp.message->text)) {
+		return;
+	}
+
+	for (current = con->smtp.in_prefs; current; current = (smtp_inbound_prefs_t *)current->next) {
+		needed[SMTP_PIPELINE_VIRUS] |= (current->virus == 1 || current->phish == 1) && con->smtp.checked.virus == 0;
+		needed[SMTP_PIPELINE_DKIM] |= !con->smtp.bypass && current->dkim == 1 && con->smtp.checked.dkim == 0;
+		needed[SMTP_PIPELINE_SPF] |= !con->smtp.bypass && current->spf == 1 && con->smtp.checked.spf == 0;
+	}
+
+	if (!needed[SMTP_PIPELINE_VIRUS] && !needed[SMTP_PIPELINE_DKIM] && !needed[SMTP_PIPELINE_SPF]) {
+		return;
+	}
+	else if (!(pipeline = mm_alloc(sizeof(smtp_pipeline_t)))) {
+		log_pedantic("Unable to allocate %zu bytes for the message pipeline.", sizeof(smtp_pipeline_t));
+		return;
+	}
+	else if (sem_init(&(pipeline->done), 0, 0)) {
+		log_pedantic("Unable to initialize the message pipeline semaphore.");
+		mm_free(pipeline);
+		return;
+	}
+	else if (mutex_init(&(pipeline->lock), NULL)) {
+		log_pedantic("Unable to initialize the message pipeline lock.");
+		sem_destroy(&(pipeline->done));
+		mm_free(pipeline);
+		return;
+	}
+
+	pipeline->refs = 1;
+
+	// The checkers may outlive the connection, so they get their own copy of the message.
+	if (!(pipeline->text = st_dupe(con->smtp.message->text)) || (con->smtp.message->id && !(pipeline->id = st_dupe(con->smtp.message->id))) ||
+		(con->smtp.helo && !(pipeline->helo = st_dupe(con->smtp.helo))) || (con->smtp.mailfrom && !(pipeline->mailfrom = st_dupe(con->smtp.mailfrom)))) {
+		log_pedantic("Unable to copy the message into the pipeline.");
+		smtp_pipeline_release(pipeline);
+		return;
+	}
+
+	if (needed[SMTP_PIPELINE_SPF] && !con_addr(con, &(pipeline->ip))) {
+		needed[SMTP_PIPELINE_SPF] = false;
+	}
+
+	clock_gettime(CLOCK_REALTIME, &now);
+
+	for (uint_t i = 0; i < SMTP_PIPELINE_SHARED; i++) {
+
+		if (!needed[i]) {
+			continue;
+		}
+		else if (!(task = mm_alloc(sizeof(smtp_pipeline_task_t)))) {
+			log_pedantic("Unable to allocate %zu bytes for a message checker.", sizeof(smtp_pipeline_task_t));
+			continue;
+		}
+
+		task->checker = i;
+		task->pipeline = pipeline;
+		pipeline->checkers[i].launched = true;
+		pipeline->checkers[i].deadline.tv_sec = now.tv_sec + timeouts[i];
+		pipeline->checkers[i].deadline.tv_nsec = now.tv_nsec;
+
+		mutex_lock(&(pipeline->lock));
+		pipeline->refs++;
+		mutex_unlock(&(pipeline->lock));
+
+		mutex_lock(&(smtp_pipeline.lock));
+		if (smtp_pipeline.tail) {
+			smtp_pipeline.tail->next = task;
+		}
+		else {
+			smtp_pipeline.head = task;
+		}
+		smtp_pipeline.tail = task;
+		mutex_unlock(&(smtp_pipeline.lock));
+
+		sem_post(&(smtp_pipeline.sema));
+	}
+
+	// Wait for every checker to finish, or miss its deadline.
+	do {
+
+		pending = false;
+		clock_gettime(CLOCK_REALTIME, &now);
+		mutex_lock(&(pipeline->lock));
+
+		for (uint_t i = 0; i < SMTP_PIPELINE_SHARED; i++) {
+
+			if (!pipeline->checkers[i].launched || pipeline->checkers[i].finished || pipeline->checkers[i].expired) {
+				continue;
+			}
+			else if (now.tv_sec > pipeline->checkers[i].deadline.tv_sec || (now.tv_sec == pipeline->checkers[i].deadline.tv_sec &&
+				now.tv_nsec >= pipeline->checkers[i].deadline.tv_nsec)) {
+				log_pedantic("A message checker missed its deadline. { checker = %u / timeout = %u }", i, timeouts[i]);
+				stats_increment_by_num(smtp_pipeline.stats.timeouts);
+				pipeline->checkers[i].expired = true;
+			}
+			else if (!pending || pipeline->checkers[i].deadline.tv_sec < earliest.tv_sec || (pipeline->checkers[i].deadline.tv_sec ==
+				earliest.tv_sec && pipeline->checkers[i].deadline.tv_nsec < earliest.tv_nsec)) {
+				earliest = pipeline->checkers[i].deadline;
+				pending = true;
+			}
+		}
+
+		mutex_unlock(&(pipeline->lock));
+
+	} while (pending && (!sem_timedwait(&(pipeline->done), &earliest) || errno == ETIMEDOUT || errno == EINTR));
+
+	// Store the results. The checkers which didn't finish are recorded as failures, so they aren't run again for every recipient.
+	mutex_lock(&(pipeline->lock));
+
+	for (uint_t i = 0; i < SMTP_PIPELINE_SHARED; i++) {
+
+		if (pipeline->checkers[i].launched && pipeline->checkers[i].finished) {
+			*(results[i]) = pipeline->checkers[i].result;
+		}
+		// Skipping the virus scan would deliver the message unscanned, so it's either scanned inline, or the message is deferred.
+		else if (pipeline->checkers[i].launched && i == SMTP_PIPELINE_VIRUS) {
+			*(results[i]) = pipeline->checkers[i].started ? SMTP_PIPELINE_TIMEOUT : 0;
+			pipeline->checkers[i].expired = true;
+		}
+		else if (pipeline->checkers[i].launched) {
+			*(results[i]) = -1;
+			pipeline->checkers[i].expired = true;
+		}
+	}
+
+	mutex_unlock(&(pipeline->lock));
+	smtp_pipeline_release(pipeline);
+
+	return;
+}
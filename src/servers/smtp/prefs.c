@@ -0,0 +1,321 @@
+
+/**
+ * @file /magma/servers/smtp/prefs.c
+ *
+ * @brief	Functions used to cache the inbound preferences of recipients, so repeated RCPT TO commands don't hit the database.
+ * @note	The cache is a direct mapped table of SMTP_PREFS_CACHE_SLOTS entries, keyed by the sanitized recipient address. Unknown
+ * 			recipients, non-local domains and locked accounts are cached for SMTP_PREFS_NEGATIVE_TTL seconds, which bounds how long a
+ * 			new or unlocked account may be refused. Valid recipients are cached for SMTP_PREFS_CACHE_TTL seconds, and are discarded
+ * 			early if the user's serial changes. Storing a message doesn't change the serial, so the storage size and quota flag of a
+ * 			cached recipient are re-read on every hit. Accounts which are over their quota are never cached, since the storage size
+ * 			is needed to roll out old messages.
+ */
+
+#include "magma.h"
+
+typedef struct {
+	int_t result; /* The value returned by smtp_fetch_inbound(). */
+	time_t expires; /* When the cached result needs to be refreshed. */
+	uint64_t serial; /* The user serial when the preferences were fetched. */
+	stringer_t *address; /* The sanitized recipient address. */
+	smtp_inbound_prefs_t *prefs; /* The preferences for a valid recipient. */
+} smtp_prefs_entry_t;
+
+static struct {
+	bool_t started;
+	pthread_mutex_t locks[SMTP_PREFS_CACHE_SHARDS];
+	smtp_prefs_entry_t slots[SMTP_PREFS_CACHE_SLOTS];
+	struct {
+		uint64_t hits, misses;
+	} stats;
+} smtp_prefs = {
+	.started = false
+};
+
+/**
+ * @brief	Initialize the recipient preference cache.
+ * @return	true on success or false on failure.
+ */
+bool_t smtp_prefs_start(void) {
+
+	mm_wipe(smtp_prefs.slots, sizeof(smtp_prefs.slots));
+
+	for (uint_t i = 0; i < SMTP_PREFS_CACHE_SHARDS; i++) {
+		if (mutex_init(&(smtp_prefs.locks[i]), NULL)) {
+			log_pedantic("Unable to initialize the recipient preference cache locks.");
+
+			for (uint_t j = 0; j < i; j++) {
+				mutex_destroy(&(smtp_prefs.locks[j]));
+			}
+
+			return false;
+		}
+	}
+
+	smtp_prefs.stats.hits = stats_get_name_pos("smtp.prefs.cache.hits");
+	smtp_prefs.stats.misses = stats_get_name_pos("smtp.prefs.cache.misses");
+	smtp_prefs.started = true;
+
+	return true;
+}
+
+/**
+ * @brief	Free every cached recipient and destroy the cache.
+ * @return	This function returns no value.
+ */
+void smtp_prefs_stop(void) {
+
+	if (!smtp_prefs.started) {
+		return;
+	}
+
+	smtp_prefs.started = false;
+
+	for (uint_t i = 0; i < SMTP_PREFS_CACHE_SLOTS; i++) {
+		st_cleanup(smtp_prefs.slots[i].address);
+		smtp_free_inbound(smtp_prefs.slots[i].prefs);
+	}
+
+	mm_wipe(smtp_prefs.slots, sizeof(smtp_prefs.slots));
+
+	for (uint_t i = 0; i < SMTP_PREFS_CACHE_SHARDS; i++) {
+		mutex_destroy(&(smtp_prefs.locks[i]));
+	}
+
+	return;
+}
+
+/**
+ * @brief	Duplicate a recipient's inbound preferences, including the signet and the filters.
+ * @note	Only the values loaded by smtp_fetch_inbound() are copied. The fields which track the progress of a delivery are left empty.
+ * @param	inbound		a pointer to the inbound preferences being duplicated.
+ * @return	NULL on failure, or a pointer to the copy on success.
+ */
+smtp_inbound_prefs_t * smtp_prefs_dupe(smtp_inbound_prefs_t *inbound) {
+
+	inx_cursor_t *cursor;
+	stringer_t *signet = NULL;
+	smtp_inbound_prefs_t *result;
+	smtp_inbound_filter_t *filter, *copy;
+	multi_t key = {
+		.type = M_TYPE_UINT64, .val.u64 = 0
+	};
+
+	if (!inbound || !(result = mm_alloc(sizeof(smtp_inbound_prefs_t)))) {
+		log_pedantic("Unable to allocate %zu bytes for the inbound preferences.", sizeof(smtp_inbound_prefs_t));
+		return NULL;
+	}
+
+	result->usernum = inbound->usernum;
+	result->stor_size = inbound->stor_size;
+	result->quota = inbound->quota;
+	result->overquota = inbound->overquota;
+	result->secure = inbound->secure;
+	result->bounces = inbound->bounces;
+	result->rollout = inbound->rollout;
+	result->spam = inbound->spam;
+	result->spamaction = inbound->spamaction;
+	result->virus = inbound->virus;
+	result->virusaction = inbound->virusaction;
+	result->phish = inbound->phish;
+	result->phishaction = inbound->phishaction;
+	result->autoreply = inbound->autoreply;
+	result->inbox = inbound->inbox;
+	result->recv_size_limit = inbound->recv_size_limit;
+	result->daily_recv_limit = inbound->daily_recv_limit;
+	result->daily_recv_limit_ip = inbound->daily_recv_limit_ip;
+	result->greylist = inbound->greylist;
+	result->greytime = inbound->greytime;
+	result->spf = inbound->spf;
+	result->spfaction = inbound->spfaction;
+	result->dkim = inbound->dkim;
+	result->dkimaction = inbound->dkimaction;
+	result->rbl = inbound->rbl;
+	result->rblaction = inbound->rblaction;
+
+	if ((inbound->rcptto && !(result->rcptto = st_dupe(inbound->rcptto))) ||
+		(inbound->address && !(result->address = st_dupe_opts(MANAGED_T | CONTIGUOUS | HEAP, inbound->address))) ||
+		(inbound->domain && !(result->domain = st_dupe(inbound->domain))) ||
+		(inbound->forwarded && !(result->forwarded = st_dupe(inbound->forwarded)))) {
+		log_pedantic("Unable to duplicate the inbound preference strings.");
+		smtp_free_inbound(result);
+		return NULL;
+	}
+
+	if (inbound->signet && (!(signet = prime_get(inbound->signet, BINARY, NULL)) || !(result->signet = prime_set(signet, BINARY, NONE)))) {
+		log_pedantic("Unable to duplicate the inbound preference signet.");
+		st_cleanup(signet);
+		smtp_free_inbound(result);
+		return NULL;
+	}
+
+	st_cleanup(signet);
+
+	if (!inbound->filters) {
+		return result;
+	}
+	else if (!(result->filters = inx_alloc(M_INX_LINKED, &smtp_list_free_filter)) || !(cursor = inx_cursor_alloc(inbound->filters))) {
+		log_pedantic("Unable to duplicate the inbound filters.");
+		smtp_free_inbound(result);
+		return NULL;
+	}
+
+	while ((filter = inx_cursor_value_next(cursor))) {
+
+		if (!(copy = mm_alloc(sizeof(smtp_inbound_filter_t)))) {
+			log_pedantic("Unable to allocate %zu bytes for an inbound filter.", sizeof(smtp_inbound_filter_t));
+			inx_cursor_free(cursor);
+			smtp_free_inbound(result);
+			return NULL;
+		}
+
+		copy->rulenum = key.val.u64 = filter->rulenum;
+		copy->location = filter->location;
+		copy->type = filter->type;
+		copy->action = filter->action;
+		copy->foldernum = filter->foldernum;
+
+		if ((filter->field && !(copy->field = st_dupe(filter->field))) || (filter->label && !(copy->label = st_dupe(filter->label))) ||
+			!(copy->expression = st_dupe(filter->expression)) || !inx_insert(result->filters, key, copy)) {
+			log_pedantic("Unable to duplicate an inbound filter. { rulenum = %lu }", filter->rulenum);
+			smtp_list_free_filter(copy);
+			inx_cursor_free(cursor);
+			smtp_free_inbound(result);
+			return NULL;
+		}
+	}
+
+	inx_cursor_free(cursor);
+
+	return result;
+}
+
+/**
+ * @brief	Retrieve a recipient from the cache.
+ * @note	The storage quota fields of a valid recipient are refreshed using smtp_fetch_quota(), and if that fails, the entry is treated
+ * 			as a miss.
+ * @param	address		the sanitized recipient address.
+ * @param	output		a pointer to receive a copy of the cached preferences, which must be freed by the caller.
+ * @return	-1 if the recipient isn't cached, or the cached result of smtp_fetch_inbound().
+ */
+int_t smtp_prefs_cache_get(stringer_t *address, smtp_inbound_prefs_t **output) {
+
+	uint64_t serial = 0;
+	int_t result = -1;
+	smtp_prefs_entry_t *entry;
+	smtp_inbound_prefs_t *prefs = NULL;
+	uint32_t slot = hash_murmur32(st_data_get(address), st_length_get(address)) % SMTP_PREFS_CACHE_SLOTS;
+
+	*output = NULL;
+	entry = &(smtp_prefs.slots[slot]);
+	mutex_lock(&(smtp_prefs.locks[slot % SMTP_PREFS_CACHE_SHARDS]));
+
+	if (entry->address && entry->expires > time(NULL) && !st_cmp_ci_eq(entry->address, address)) {
+
+		// Valid recipients are copied, since the caller will modify the preferences as the message is delivered.
+		if (entry->result != 1) {
+			result = entry->result;
+		}
+		else if ((prefs = smtp_prefs_dupe(entry->prefs))) {
+			serial = entry->serial;
+			result = 1;
+		}
+
+	}
+
+	mutex_unlock(&(smtp_prefs.locks[slot % SMTP_PREFS_CACHE_SHARDS]));
+
+	// The account was updated after the preferences were cached. Delivering a message doesn't update the serial number, so the
+	// storage quota is always refreshed.
+	if (prefs && (serial != serial_get(OBJECT_USER, prefs->usernum) || smtp_fetch_quota(prefs) != 1)) {
+		smtp_free_inbound(prefs);
+		prefs = NULL;
+		result = -1;
+	}
+
+	*output = prefs;
+
+	return result;
+}
+
+/**
+ * @brief	Store a recipient in the cache, replacing whatever held the slot before.
+ * @note	Errors are never cached, so a database failure is retried by the next command.
+ * @param	address		the sanitized recipient address.
+ * @param	result		the value returned by smtp_fetch_inbound().
+ * @param	inbound		the preferences for a valid recipient, which are copied into the cache.
+ * @return	This function returns no value.
+ */
+void smtp_prefs_cache_set(stringer_t *address, int_t result, smtp_inbound_prefs_t *inbound) {
+
+	uint64_t serial = 0;
+	smtp_prefs_entry_t *entry;
+	smtp_inbound_prefs_t *prefs = NULL, *stale;
+	stringer_t *duplicate, *previous;
+	uint32_t slot = hash_murmur32(st_data_get(address), st_length_get(address)) % SMTP_PREFS_CACHE_SLOTS;
+
+	if (result == -1 || result < -6 || result > 1 || (result == 1 && (!inbound || inbound->overquota == 1))) {
+		return;
+	}
+
+	// A user without a serial gets one, just like meta_update_user(), so the next update to the account can be detected.
+	if (result == 1 && !(serial = serial_get(OBJECT_USER, inbound->usernum)) && !(serial = serial_increment(OBJECT_USER, inbound->usernum))) {
+		return;
+	}
+	else if (result == 1 && !(prefs = smtp_prefs_dupe(inbound))) {
+		return;
+	}
+	else if (!(duplicate = st_dupe(address))) {
+		log_pedantic("Unable to copy the recipient address.");
+		smtp_free_inbound(prefs);
+		return;
+	}
+
+	entry = &(smtp_prefs.slots[slot]);
+	mutex_lock(&(smtp_prefs.locks[slot % SMTP_PREFS_CACHE_SHARDS]));
+
+	previous = entry->address;
+	stale = entry->prefs;
+	entry->address = duplicate;
+	entry->result = result;
+	entry->serial = serial;
+	entry->prefs = prefs;
+	entry->expires = time(NULL) + (result == 1 ? SMTP_PREFS_CACHE_TTL : SMTP_PREFS_NEGATIVE_TTL);
+
+	mutex_unlock(&(smtp_prefs.locks[slot % SMTP_PREFS_CACHE_SHARDS]));
+	st_cleanup(previous);
+	smtp_free_inbound(stale);
+
+	return;
+}
+
+/**
+ * @brief	Fetch a recipient's inbound preferences, using the cache whenever possible.
+ * @see		smtp_fetch_inbound()
+ * @param	address		the sanitized recipient address.
+ * @param	output		a pointer to receive the inbound preferences, which must be freed by the caller.
+ * @return	the same values as smtp_fetch_inbound().
+ */
+int_t smtp_prefs_fetch(stringer_t *address, smtp_inbound_prefs_t **output) {
+
+	int_t result;
+
+	if (st_empty(address) || !output) {
+		return -1;
+	}
+	else if (!smtp_prefs.started) {
+		return smtp_fetch_inbound(address, output);
+	}
+	else if ((result = smtp_prefs_cache_get(address, output)) != -1) {
+		stats_increment_by_num(smtp_prefs.stats.hits);
+		return result;
+	}
+
+	stats_increment_by_num(smtp_prefs.stats.misses);
+
+	if ((result = smtp_fetch_inbound(address, output)) != -1) {
+		smtp_prefs_cache_set(address, result, *output);
+	}
+
+	return result;
+}
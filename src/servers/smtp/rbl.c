@@ -0,0 +1,410 @@
+
+/**
+ * @file /magma/servers/smtp/rbl.c
+ *
+ * @brief	Functions used to query realtime blacklists concurrently, and to cache the results.
+ * @note	The cache is a direct mapped table of SMTP_RBL_CACHE_SLOTS entries, keyed by the query name, which combines the reversed
+ * 			address with the blacklist domain. A colliding entry simply replaces the previous one, so the cache never grows, and entries
+ * 			are only returned until the TTL provided by the blacklist expires.
+ */
+
+#include "magma.h"
+
+typedef struct {
+	int_t result; /* -2 if the address is listed, or 1 if it isn't. */
+	time_t expires; /* When the cached result needs to be refreshed. */
+	stringer_t *name; /* The query name. */
+} smtp_rbl_entry_t;
+
+static struct {
+	bool_t started;
+	pthread_mutex_t locks[SMTP_RBL_CACHE_SHARDS];
+	smtp_rbl_entry_t slots[SMTP_RBL_CACHE_SLOTS];
+	struct {
+		uint64_t hits, misses, errors;
+	} stats;
+} smtp_rbl = {
+	.started = false
+};
+
+/**
+ * @brief	Initialize the blacklist result cache.
+ * @return	true on success or false on failure.
+ */
+bool_t smtp_rbl_start(void) {
+
+	mm_wipe(smtp_rbl.slots, sizeof(smtp_rbl.slots));
+
+	for (uint_t i = 0; i < SMTP_RBL_CACHE_SHARDS; i++) {
+		if (mutex_init(&(smtp_rbl.locks[i]), NULL)) {
+			log_pedantic("Unable to initialize the blacklist cache locks.");
+
+			for (uint_t j = 0; j < i; j++) {
+				mutex_destroy(&(smtp_rbl.locks[j]));
+			}
+
+			return false;
+		}
+	}
+
+	smtp_rbl.stats.hits = stats_get_name_pos("smtp.rbl.cache.hits");
+	smtp_rbl.stats.misses = stats_get_name_pos("smtp.rbl.cache.misses");
+	smtp_rbl.stats.errors = stats_get_name_pos("smtp.rbl.errors");
+	smtp_rbl.started = true;
+
+	return true;
+}
+
+/**
+ * @brief	Free every cached blacklist result and destroy the cache.
+ * @return	This function returns no value.
+ */
+void smtp_rbl_stop(void) {
+
+	if (!smtp_rbl.started) {
+		return;
+	}
+
+	smtp_rbl.started = false;
+
+	for (uint_t i = 0; i < SMTP_RBL_CACHE_SLOTS; i++) {
+		st_cleanup(smtp_rbl.slots[i].name);
+	}
+
+	mm_wipe(smtp_rbl.slots, sizeof(smtp_rbl.slots));
+
+	for (uint_t i = 0; i < SMTP_RBL_CACHE_SHARDS; i++) {
+		mutex_destroy(&(smtp_rbl.locks[i]));
+	}
+
+	return;
+}
+
+/**
+ * @brief	Retrieve a cached blacklist result.
+ * @param	name	a null-terminated string containing the query name.
+ * @return	0 if the result isn't cached or has expired, -2 if the address is listed, or 1 if it isn't.
+ */
+int_t smtp_rbl_cache_get(chr_t *name) {
+
+	int_t result = 0;
+	smtp_rbl_entry_t *entry;
+	size_t length = ns_length_get(name);
+	uint32_t slot = hash_murmur32(name, length) % SMTP_RBL_CACHE_SLOTS;
+
+	if (!smtp_rbl.started || !length) {
+		return 0;
+	}
+
+	entry = &(smtp_rbl.slots[slot]);
+	mutex_lock(&(smtp_rbl.locks[slot % SMTP_RBL_CACHE_SHARDS]));
+
+	if (entry->name && entry->expires > time(NULL) && !st_cmp_ci_eq(entry->name, PLACER(name, length))) {
+		result = entry->result;
+	}
+
+	mutex_unlock(&(smtp_rbl.locks[slot % SMTP_RBL_CACHE_SHARDS]));
+	stats_increment_by_num(result ? smtp_rbl.stats.hits : smtp_rbl.stats.misses);
+
+	return result;
+}
+
+/**
+ * @brief	Store a blacklist result in the cache, replacing whatever held the slot before.
+ * @note	Errors are never cached, so a transient DNS failure is retried by the next connection.
+ * @param	name	a null-terminated string containing the query name.
+ * @param	result	the result to be cached, which must be -2 if the address is listed, or 1 if it isn't.
+ * @param	ttl		the number of seconds the result may be cached.
+ * @return	This function returns no value.
+ */
+void smtp_rbl_cache_set(chr_t *name, int_t result, uint32_t ttl) {
+
+	smtp_rbl_entry_t *entry;
+	stringer_t *duplicate, *previous;
+	size_t length = ns_length_get(name);
+	uint32_t slot = hash_murmur32(name, length) % SMTP_RBL_CACHE_SLOTS;
+
+	if (!smtp_rbl.started || !length || !ttl || (result != -2 && result != 1)) {
+		return;
+	}
+	else if (!(duplicate = st_import(name, length))) {
+		log_pedantic("Unable to copy the blacklist query name.");
+		return;
+	}
+
+	entry = &(smtp_rbl.slots[slot]);
+	mutex_lock(&(smtp_rbl.locks[slot % SMTP_RBL_CACHE_SHARDS]));
+
+	previous = entry->name;
+	entry->name = duplicate;
+	entry->result = result;
+	entry->expires = time(NULL) + (ttl > SMTP_RBL_CACHE_TTL ? SMTP_RBL_CACHE_TTL : ttl);
+
+	mutex_unlock(&(smtp_rbl.locks[slot % SMTP_RBL_CACHE_SHARDS]));
+	st_cleanup(previous);
+
+	return;
+}
+
+/**
+ * @brief	Parse the response to a blacklist query.
+ * @note	A listed address resolves to one or more A records, so any A record in the answer means the address is listed, and the result
+ * 			may be cached for the lowest record TTL. A name error, or an answer without any A records, means the address isn't listed,
+ * 			and the result may be cached for the SOA minimum, as described by RFC 2308, or for SMTP_RBL_NEGATIVE_TTL seconds if the
+ * 			response doesn't include an SOA record.
+ * @param	answer	a pointer to the raw DNS response.
+ * @param	length	the length, in bytes, of the response.
+ * @param	ttl		a pointer to receive the number of seconds the result may be cached.
+ * @return	-1 if the response is invalid or reports a server error, -2 if the address is listed, or 1 if it isn't.
+ */
+int_t smtp_rbl_parse(uchr_t *answer, size_t length, uint32_t *ttl) {
+
+	ns_rr rr;
+	ns_msg handle;
+	bool_t listed = false;
+	int_t mname, rname;
+	const uchr_t *rdata, *end;
+	uint32_t lowest = SMTP_RBL_CACHE_TTL;
+
+	if (ns_initparse(answer, length, &handle) < 0 || (ns_msg_getflag(handle, ns_f_rcode) != ns_r_noerror &&
+		ns_msg_getflag(handle, ns_f_rcode) != ns_r_nxdomain)) {
+		return -1;
+	}
+
+	for (int_t i = 0; i < ns_msg_count(handle, ns_s_an); i++) {
+
+		if (ns_parserr(&handle, ns_s_an, i, &rr) < 0) {
+			return -1;
+		}
+		else if (ns_rr_type(rr) == ns_t_a) {
+			lowest = ns_rr_ttl(rr) < lowest ? ns_rr_ttl(rr) : lowest;
+			listed = true;
+		}
+
+	}
+
+	if (listed) {
+		*ttl = lowest;
+		return -2;
+	}
+
+	// Negative answers are cached according to the SOA record in the authority section. The minimum field follows the two
+	// domain names, and the serial, refresh, retry and expire fields.
+	lowest = SMTP_RBL_NEGATIVE_TTL;
+
+	for (int_t i = 0; i < ns_msg_count(handle, ns_s_ns); i++) {
+
+		if (ns_parserr(&handle, ns_s_ns, i, &rr) < 0 || ns_rr_type(rr) != ns_t_soa) {
+			continue;
+		}
+
+		rdata = ns_rr_rdata(rr);
+		end = rdata + ns_rr_rdlen(rr);
+
+		if ((mname = dn_skipname(rdata, end)) >= 0 && (rname = dn_skipname(rdata + mname, end)) >= 0 &&
+			rdata + mname + rname + 20 <= end) {
+			lowest = ns_get32(rdata + mname + rname + 16);
+			lowest = ns_rr_ttl(rr) < lowest ? ns_rr_ttl(rr) : lowest;
+		}
+
+	}
+
+	*ttl = lowest > SMTP_RBL_CACHE_TTL ? SMTP_RBL_CACHE_TTL : lowest;
+
+	return 1;
+}
+
+/**
+ * @brief	Query several blacklists one after another using the system resolver.
+ * @note	This is only used when the concurrent lookup can't reach the name server.
+ * @param	names		an array of null-terminated strings holding the query names.
+ * @param	results		an array which will receive the result of each query, which is -1 on error, -2 if the address is listed, or 1 if it isn't.
+ * @param	ttls		an array which will receive the number of seconds each result may be cached.
+ * @param	count		the number of queries.
+ * @return	This function returns no value.
+ */
+void smtp_rbl_lookup_serial(chr_t **names, int_t *results, uint32_t *ttls, uint32_t count) {
+
+	int_t length;
+	uchr_t answer[SMTP_RBL_PACKET_SIZE];
+
+	for (uint32_t i = 0; i < count; i++) {
+
+		ttls[i] = 0;
+
+		if ((length = res_query(names[i], ns_c_in, ns_t_a, answer, sizeof(answer))) > 0) {
+			results[i] = smtp_rbl_parse(answer, length, &(ttls[i]));
+		}
+		else if (h_errno == HOST_NOT_FOUND || h_errno == NO_DATA) {
+			ttls[i] = SMTP_RBL_NEGATIVE_TTL;
+			results[i] = 1;
+		}
+		else {
+			results[i] = -1;
+		}
+
+	}
+
+	return;
+}
+
+/**
+ * @brief	Query several blacklists concurrently.
+ * @note	Every query is sent to the first configured name server over a single UDP socket before any replies are read, so the lookups
+ * 			take as long as the slowest blacklist, rather than the sum of them all. Replies are matched using the query id and question,
+ * 			and unanswered queries are retransmitted using the retry interval and count from the resolver configuration. If the first
+ * 			name server isn't an IPv4 address, the queries are made one after another using the system resolver instead.
+ * @param	names		an array of null-terminated strings holding the query names.
+ * @param	results		an array which will receive the result of each query, which is -1 on error, -2 if the address is listed, or 1 if it isn't.
+ * @param	ttls		an array which will receive the number of seconds each result may be cached.
+ * @param	count		the number of queries, which can't exceed MAGMA_BLACKLIST_INSTANCES.
+ * @return	This function returns no value.
+ */
+void smtp_rbl_lookup(chr_t **names, int_t *results, uint32_t *ttls, uint32_t count) {
+
+	ns_rr question;
+	ns_msg handle;
+	socklen_t size;
+	ssize_t length;
+	time_t now, deadline, retransmit = 0;
+	struct pollfd descriptor;
+	struct sockaddr_in server, source;
+	int_t sd = -1, pending = 0, lengths[MAGMA_BLACKLIST_INSTANCES];
+	uchr_t queries[MAGMA_BLACKLIST_INSTANCES][NS_PACKETSZ], answer[SMTP_RBL_PACKET_SIZE];
+
+	// The resolver state is thread local, and initialized the first time each thread uses it.
+	if (count > MAGMA_BLACKLIST_INSTANCES || (!(_res.options & RES_INIT) && res_init()) || !_res.nscount ||
+		_res.nsaddr_list[0].sin_family != AF_INET || (sd = socket(AF_INET, SOCK_DGRAM, 0)) == -1) {
+		smtp_rbl_lookup_serial(names, results, ttls, count);
+		return;
+	}
+
+	server = _res.nsaddr_list[0];
+
+	// A result of zero marks the queries which are still waiting for a reply.
+	for (uint32_t i = 0; i < count; i++) {
+
+		ttls[i] = 0;
+
+		if ((lengths[i] = res_mkquery(ns_o_query, names[i], ns_c_in, ns_t_a, NULL, 0, NULL, queries[i], NS_PACKETSZ)) <= 0) {
+			log_pedantic("Unable to build the blacklist query. { name = %s }", names[i]);
+			results[i] = -1;
+		}
+		else {
+			results[i] = 0;
+			pending++;
+		}
+
+	}
+
+	deadline = time(NULL) + (_res.retrans * (_res.retry ? _res.retry : 1));
+
+	while (pending && (now = time(NULL)) < deadline && status()) {
+
+		// Send, or resend, every query which hasn't been answered yet.
+		if (now >= retransmit) {
+
+			for (uint32_t i = 0; i < count; i++) {
+				if (!results[i] && sendto(sd, queries[i], lengths[i], 0, (struct sockaddr *)&server, sizeof(server)) != lengths[i]) {
+					log_pedantic("Unable to send the blacklist query. { name = %s / errno = %s }", names[i], strerror_r(errno, MEMORYBUF(256), 256));
+				}
+			}
+
+			retransmit = now + (_res.retrans ? _res.retrans : 1);
+		}
+
+		descriptor.fd = sd;
+		descriptor.events = POLLIN;
+		descriptor.revents = 0;
+
+		if (poll(&descriptor, 1, (retransmit - now) * 1000) <= 0) {
+			continue;
+		}
+
+		// Ignore anything which didn't come from the name server, or can't be parsed.
+		size = sizeof(source);
+
+		if ((length = recvfrom(sd, answer, sizeof(answer), 0, (struct sockaddr *)&source, &size)) <= 0 || size != sizeof(source) ||
+			source.sin_addr.s_addr != server.sin_addr.s_addr || source.sin_port != server.sin_port ||
+			ns_initparse(answer, length, &handle) < 0 || ns_parserr(&handle, ns_s_qd, 0, &question) < 0) {
+			continue;
+		}
+
+		for (uint32_t i = 0; i < count; i++) {
+			if (!results[i] && ns_get16(queries[i]) == ns_msg_id(handle) && !strcasecmp(ns_rr_name(question), names[i])) {
+				results[i] = smtp_rbl_parse(answer, length, &(ttls[i]));
+				pending--;
+				break;
+			}
+		}
+
+	}
+
+	close(sd);
+
+	// Any query which wasn't answered timed out.
+	for (uint32_t i = 0; i < count; i++) {
+		if (!results[i]) {
+			results[i] = -1;
+		}
+	}
+
+	return;
+}
+
+/**
+ * @brief	Check an address against a collection of realtime blacklists, using the cache whenever possible.
+ * @param	addr	a managed string containing the reversed address being checked.
+ * @return	-1 if every blacklist lookup failed, -2 if the address is listed, or 1 if it isn't.
+ */
+int_t smtp_rbl_check(stringer_t *addr) {
+
+	int_t cached, result = -1, results[MAGMA_BLACKLIST_INSTANCES];
+	uint32_t count = 0, ttls[MAGMA_BLACKLIST_INSTANCES];
+	chr_t queries[MAGMA_BLACKLIST_INSTANCES][NI_MAXHOST], *names[MAGMA_BLACKLIST_INSTANCES];
+
+	for (uint32_t i = 0; i < magma.smtp.blacklists.count && i < MAGMA_BLACKLIST_INSTANCES; i++) {
+
+		// Build the DNS query.
+		if (snprintf(queries[i], NI_MAXHOST, "%.*s.%.*s", st_length_int(addr), st_char_get(addr),
+			st_length_int(magma.smtp.blacklists.domain[i]), st_char_get(magma.smtp.blacklists.domain[i])) <= 0) {
+			log_pedantic("Address string creation failed.");
+		}
+
+		// Cached results don't need to be looked up again.
+		else if ((cached = smtp_rbl_cache_get(queries[i])) == -2) {
+			return -2;
+		}
+		else if (cached == 1) {
+			result = 1;
+		}
+		else {
+			names[count++] = queries[i];
+		}
+
+	}
+
+	if (!count) {
+		return result;
+	}
+
+	smtp_rbl_lookup(names, results, ttls, count);
+
+	for (uint32_t i = 0; i < count; i++) {
+
+		if (results[i] == -1) {
+			log_pedantic("Blacklist DNS attempt resulted in an error. { name = %s }", names[i]);
+			stats_increment_by_num(smtp_rbl.stats.errors);
+			continue;
+		}
+
+		smtp_rbl_cache_set(names[i], results[i], ttls[i]);
+
+		if (results[i] == -2 || result != -2) {
+			result = results[i];
+		}
+
+	}
+
+	return result;
+}
@@ -7,72 +7,288 @@
 
 #include "magma.h"
 
+static struct {
+	bool_t started;
+	smtp_relay_pool_t relays[MAGMA_RELAY_INSTANCES];
+} smtp_relay_pool = {
+	.started = false
+};
+
 /**
- * @brief	Issue an smtp client QUIT command.
- * @param	client	 a pointer to the smtp client session to be closed.
+ * @brief	Initialize the relay connection pools.
+ * @note	Each configured relay gets room for magma.relay.pool.limit idle connections. If the limit is zero, connections aren't
+ * 			reused, but the pools are still used to balance the load across the relays.
+ * @return	true on success or false on failure.
+ */
+bool_t smtp_client_pool_start(void) {
+
+	mm_wipe(smtp_relay_pool.relays, sizeof(smtp_relay_pool.relays));
+
+	for (uint_t i = 0; i < MAGMA_RELAY_INSTANCES; i++) {
+		if (mutex_init(&(smtp_relay_pool.relays[i].lock), NULL)) {
+			log_pedantic("Unable to initialize the relay pool locks.");
+
+			for (uint_t j = 0; j < i; j++) {
+				mutex_destroy(&(smtp_relay_pool.relays[j].lock));
+			}
+
+			return false;
+		}
+	}
+
+	for (uint_t i = 0; i < MAGMA_RELAY_INSTANCES; i++) {
+		if (magma.relay.host[i] && magma.relay.pool.limit &&
+			!(smtp_relay_pool.relays[i].idle = mm_alloc(magma.relay.pool.limit * sizeof(client_t *)))) {
+			log_pedantic("Unable to allocate the relay pool. { limit = %u }", magma.relay.pool.limit);
+
+			for (uint_t j = 0; j < MAGMA_RELAY_INSTANCES; j++) {
+				if (smtp_relay_pool.relays[j].idle) mm_free(smtp_relay_pool.relays[j].idle);
+				mutex_destroy(&(smtp_relay_pool.relays[j].lock));
+			}
+
+			return false;
+		}
+	}
+
+	smtp_relay_pool.started = true;
+
+	return true;
+}
+
+/**
+ * @brief	Close every idle relay connection and destroy the relay connection pools.
  * @return	This function returns no value.
  */
-void smtp_client_close(client_t *client) {
+void smtp_client_pool_stop(void) {
 
-	if (client_write(client, PLACER("QUIT\r\n", 6)) >= 0) {
-		client_read_line(client);
+	smtp_relay_pool_t *pool;
+
+	if (!smtp_relay_pool.started) {
+		return;
 	}
 
-	client_close(client);
+	smtp_relay_pool.started = false;
+
+	for (uint_t i = 0; i < MAGMA_RELAY_INSTANCES; i++) {
+
+		pool = &(smtp_relay_pool.relays[i]);
+
+		while (pool->count) {
+			smtp_client_close(pool->idle[--(pool->count)]);
+		}
+
+		if (pool->idle) {
+			mm_free(pool->idle);
+			pool->idle = NULL;
+		}
+
+		mutex_destroy(&(pool->lock));
+	}
 
 	return;
 }
 
 /**
- * @brief	Connect to a randomly selected mail relay server, and wait for a successful banner message.
- * @param	premium		if set, a premium relay will be selected instead of a standard one.
- * @return	NULL on failure or a pointer to the newly established network client object connected to a mail relay on success.
+ * @brief	Close the idle connections in a relay pool which have been held longer than magma.relay.pool.timeout seconds.
+ * @note	The connections are closed outside the lock, since the QUIT command requires a round trip.
+ * @param	pool	a pointer to the relay pool being pruned.
+ * @return	This function returns no value.
  */
-client_t * smtp_client_connect(int_t premium) {
+void smtp_client_pool_prune(smtp_relay_pool_t *pool) {
 
-	uint32_t num = 0;
 	client_t *client;
-	relay_t *relay = NULL;
+	time_t now = time(NULL);
 
-	// If the premium flag is set, pick a random premium relay.
-	if (premium && magma.relay.count.premium) {
-		num = (rand_get_uint32() % magma.relay.count.premium);
+	do {
 
-		for (uint32_t i = 0; !relay && i < MAGMA_RELAY_INSTANCES; i++) {
+		client = NULL;
+		mutex_lock(&(pool->lock));
 
-			if (magma.relay.host[i] && magma.relay.host[i]->premium && !num) {
-					relay = magma.relay.host[i];
-			}
-			else if (magma.relay.host[i] && magma.relay.host[i]->premium) {
-				num--;
-			}
+		// The oldest connection is always at the bottom of the stack.
+		if (pool->count && (now - pool->idle[0]->idle) >= magma.relay.pool.timeout) {
+			client = pool->idle[0];
+			mm_move(pool->idle, pool->idle + 1, --(pool->count) * sizeof(client_t *));
+		}
+
+		mutex_unlock(&(pool->lock));
 
+		if (client) {
+			smtp_client_close(client);
 		}
 
+	} while (client);
+
+	return;
+}
+
+/**
+ * @brief	Take the most recently used idle connection out of a relay pool, after checking that it's still healthy.
+ * @note	A connection is only handed out if it hasn't expired, has no unread data buffered, and the socket isn't readable. Since
+ * 			the session was reset before the connection was pooled, a readable socket means the relay closed the connection, or
+ * 			sent a timeout notice. Unhealthy connections are closed, and the next one is tried.
+ * @param	pool	a pointer to the relay pool.
+ * @return	NULL if no healthy connections are available, or a pointer to the network client on success.
+ */
+client_t * smtp_client_pool_get(smtp_relay_pool_t *pool) {
+
+	client_t *client;
+	time_t now = time(NULL);
+	struct pollfd descriptor;
+
+	while (true) {
+
+		mutex_lock(&(pool->lock));
+		client = pool->count ? pool->idle[--(pool->count)] : NULL;
+		mutex_unlock(&(pool->lock));
+
+		if (!client) {
+			return NULL;
+		}
+
+		descriptor.fd = client->sockd;
+		descriptor.events = POLLIN;
+		descriptor.revents = 0;
+
+		if (poll(&descriptor, 1, 0) || client->status != 1 || st_length_get(client->buffer) > pl_length_get(client->line)) {
+			client_close(client);
+		}
+		else if ((now - client->idle) >= magma.relay.pool.timeout) {
+			smtp_client_close(client);
+		}
+		else {
+			return client;
+		}
 	}
+}
 
-	// Otherwise, if no premium relays are defined, or premium is zero, pick a standard relay.
-	else {
-		num = (rand_get_uint32() % magma.relay.count.standard);
+/**
+ * @brief	Pick the relay with the fewest outstanding connections.
+ * @note	The search starts at a random position, so relays with the same load share the work evenly. Relays which refused a
+ * 			connection in the last SMTP_RELAY_RETRY seconds are passed over, unless every relay in the class has failed recently.
+ * @param	premium		if set, a premium relay will be selected instead of a standard one, if any premium relays are configured.
+ * @return	-1 if no suitable relay is configured, or the index of the selected relay.
+ */
+int_t smtp_client_pick(int_t premium) {
 
-		for (uint32_t i = 0; !relay && i < MAGMA_RELAY_INSTANCES; i++) {
+	int_t result = -1;
+	relay_t *relay;
+	smtp_relay_pool_t *pool;
+	time_t now = time(NULL);
+	uint32_t number, offset, load, best = 0;
+	bool_t wanted = (premium && magma.relay.count.premium) ? true : false;
 
-			if (magma.relay.host[i] && !magma.relay.host[i]->premium && !num) {
-					relay = magma.relay.host[i];
-			}
-			else if (magma.relay.host[i] && !magma.relay.host[i]->premium) {
-				num--;
+	offset = rand_get_uint32() % MAGMA_RELAY_INSTANCES;
+
+	for (int_t pass = 0; result == -1 && pass < 2; pass++) {
+		for (uint32_t i = 0; i < MAGMA_RELAY_INSTANCES; i++) {
+
+			number = (offset + i) % MAGMA_RELAY_INSTANCES;
+
+			if (!(relay = magma.relay.host[number]) || (relay->premium ? true : false) != wanted) {
+				continue;
 			}
 
+			// The load is read without the lock, since it's only used as a hint.
+			pool = &(smtp_relay_pool.relays[number]);
+			load = smtp_relay_pool.started ? pool->outstanding : 0;
+
+			if (!pass && smtp_relay_pool.started && pool->failed && (now - pool->failed) < SMTP_RELAY_RETRY) {
+				continue;
+			}
+			else if (result == -1 || load < best) {
+				result = number;
+				best = load;
+			}
 		}
+	}
+
+	return result;
+}
+
+/**
+ * @brief	Issue an smtp client QUIT command.
+ * @note	If the client was checked out of a relay pool, it's no longer counted against the relay. If pipelined replies are still
+ * 			outstanding, or the relay is waiting for message data, the connection is simply dropped, since the relay could mistake
+ * 			the QUIT for message data.
+ * @param	client	 a pointer to the smtp client session to be closed.
+ * @return	This function returns no value.
+ */
+void smtp_client_close(client_t *client) {
+
+	smtp_relay_pool_t *pool;
 
+	if (!client) {
+		return;
 	}
 
-	if (!relay) {
-		log_pedantic("Unable to find a suitable mail relay to connect to.");
-		return NULL;
+	if ((pool = client->pool) && smtp_relay_pool.started) {
+		mutex_lock(&(pool->lock));
+		pool->outstanding--;
+		mutex_unlock(&(pool->lock));
+	}
+
+	if (!(client->options & (SMTP_CLIENT_PENDING | SMTP_CLIENT_DATA)) && client_write(client, PLACER("QUIT\r\n", 6)) >= 0) {
+		client_read_line(client);
+	}
+
+	client_close(client);
+
+	return;
+}
+
+/**
+ * @brief	Return an smtp client session to its relay pool once a message has been sent, so the next message can skip the handshake.
+ * @note	The session is reset with RSET, which also confirms the relay is still responsive. If the client wasn't pooled, the reset
+ * 			fails, or the pool is already full, the connection is closed instead.
+ * @param	client	a pointer to the smtp client session to be released.
+ * @return	This function returns no value.
+ */
+void smtp_client_release(client_t *client) {
+
+	smtp_relay_pool_t *pool;
+
+	if (!client) {
+		return;
+	}
+	else if (!(pool = client->pool) || !smtp_relay_pool.started || !pool->idle || (client->options & (SMTP_CLIENT_PENDING | SMTP_CLIENT_DATA)) ||
+		client_write(client, PLACER("RSET\r\n", 6)) != 6 || client_read_line(client) <= 0 || !pl_starts_with_char(client->line, '2')) {
+		smtp_client_close(client);
+		return;
+	}
+
+	client->pool = NULL;
+	client->idle = time(NULL);
+
+	mutex_lock(&(pool->lock));
+
+	pool->outstanding--;
+
+	if (pool->count < magma.relay.pool.limit) {
+		pool->idle[(pool->count)++] = client;
+		client = NULL;
 	}
 
+	mutex_unlock(&(pool->lock));
+
+	// The pool was full.
+	if (client) {
+		smtp_client_close(client);
+	}
+
+	smtp_client_pool_prune(pool);
+
+	return;
+}
+
+/**
+ * @brief	Open a new connection to a mail relay server, and wait for a successful banner message.
+ * @param	relay	a pointer to the relay server configuration.
+ * @return	NULL on failure or a pointer to the newly established network client object connected to the mail relay on success.
+ */
+client_t * smtp_client_open(relay_t *relay) {
+
+	client_t *client;
+
 	// Connect
 	if (!(client = client_connect(relay->name, relay->port))) {
 		log_pedantic("Unable to establish a network connection with the mail relay. {host = %s:%u}", relay->name, relay->port);
@@ -80,7 +296,7 @@ client_t * smtp_client_connect(int_t premium) {
 	}
 
 	// If a valid timeout was provided.
-	if (!magma.relay.timeout) {
+	if (magma.relay.timeout) {
 		net_set_timeout(client->sockd, magma.relay.timeout, magma.relay.timeout);
 	}
 
@@ -102,8 +318,58 @@ client_t * smtp_client_connect(int_t premium) {
 	return client;
 }
 
+/**
+ * @brief	Connect to the least loaded mail relay server, reusing an idle connection if one is available.
+ * @note	Reused connections have already been greeted, so smtp_client_send_helo() returns right away for them. Clients returned
+ * 			by this function should be handed back with smtp_client_release() after a message is sent successfully, and closed with
+ * 			smtp_client_close() otherwise.
+ * @param	premium		if set, a premium relay will be selected instead of a standard one.
+ * @return	NULL on failure or a pointer to the network client object connected to a mail relay on success.
+ */
+client_t * smtp_client_connect(int_t premium) {
+
+	int_t number;
+	client_t *client = NULL;
+	smtp_relay_pool_t *pool = NULL;
+
+	if ((number = smtp_client_pick(premium)) == -1) {
+		log_pedantic("Unable to find a suitable mail relay to connect to.");
+		return NULL;
+	}
+
+	// Count the connection against the relay right away, so concurrent senders spread out while we connect.
+	if (smtp_relay_pool.started) {
+		pool = &(smtp_relay_pool.relays[number]);
+		mutex_lock(&(pool->lock));
+		pool->outstanding++;
+		mutex_unlock(&(pool->lock));
+
+		if (pool->idle) {
+			client = smtp_client_pool_get(pool);
+		}
+	}
+
+	if (!client && !(client = smtp_client_open(magma.relay.host[number]))) {
+
+		if (pool) {
+			mutex_lock(&(pool->lock));
+			pool->outstanding--;
+			pool->failed = time(NULL);
+			mutex_unlock(&(pool->lock));
+		}
+
+		return NULL;
+	}
+
+	client->pool = pool;
+
+	return client;
+}
+
 /**
  * @brief	Issue a EHLO command to an smtp server, or fall back to HELO, and wait for a successful response.
+ * @note	Pooled connections have already been greeted, so nothing is sent for them. The EHLO response is checked for the
+ * 			PIPELINING extension, which allows smtp_client_send_envelope() to batch its commands.
  * @param	client	a pointer to the network client to issue the remote command.
  * @return	-1 on failure or 1 on success.
  */
@@ -111,6 +377,10 @@ int_t smtp_client_send_helo(client_t *client) {
 
 	int_t state;
 
+	if (client->options & SMTP_CLIENT_GREETED) {
+		return 1;
+	}
+
 	client_print(client, "EHLO %s\r\n", magma.host.name);
 
 	if ((client_read_line(client)) <= 0) {
@@ -134,6 +404,11 @@ int_t smtp_client_send_helo(client_t *client) {
 
 		do {
 
+			if (st_length_get(&(client->line)) >= 14 && !st_cmp_ci_starts(PLACER(st_char_get(&(client->line)) + 4,
+				st_length_get(&(client->line)) - 4), PLACER("PIPELINING", 10))) {
+				client->options |= SMTP_CLIENT_PIPELINING;
+			}
+
 			if (st_length_get(&(client->line)) < 4 || *(st_char_get(client->buffer) + 3) == ' ') {
 				state = 0;
 			}
@@ -147,6 +422,8 @@ int_t smtp_client_send_helo(client_t *client) {
 
 	}
 
+	client->options |= SMTP_CLIENT_GREETED;
+
 	return 1;
 }
 
@@ -224,6 +501,114 @@ int_t smtp_client_send_rcptto(client_t *client, stringer_t *rcptto) {
 	return 1;
 }
 
+/**
+ * @brief	Issue the MAIL FROM and RCPT TO commands for a message, pipelining them along with the DATA command if the relay supports it.
+ * @note	If the relay didn't advertise PIPELINING, each command waits for its reply, just like smtp_client_send_mailfrom() and
+ * 			smtp_client_send_rcptto(). Otherwise the commands are written in a single batch and the replies are read back in order,
+ * 			so the envelope only costs a single round trip. Once the DATA command is accepted, smtp_client_send_data() sends the
+ * 			message right away. If a command is rejected, the remaining replies are left unread, and the client line holds the rejection.
+ * @param	client		a pointer to the network client to issue the commands.
+ * @param	mailfrom	a pointer to a managed string containing the address parameter for the MAIL FROM command.
+ * @param	recipients	a linked list of the recipient addresses, with a RCPT TO command issued for each.
+ * @return	-2 if the remote server rejected a command, -1 on general network failure, or 1 on success.
+ */
+int_t smtp_client_send_envelope(client_t *client, stringer_t *mailfrom, smtp_recipients_t *recipients) {
+
+	int_t state;
+	stringer_t *batch;
+	size_t length, used = 0;
+	smtp_recipients_t *holder;
+
+	if (!(client->options & SMTP_CLIENT_PIPELINING)) {
+
+		if ((state = smtp_client_send_mailfrom(client, mailfrom, 0)) != 1) {
+			return state;
+		}
+
+		for (holder = recipients; holder; holder = (smtp_recipients_t *)holder->next) {
+			if ((state = smtp_client_send_rcptto(client, holder->address)) != 1) {
+				return state;
+			}
+		}
+
+		return 1;
+	}
+
+	// Calculate the size of the batch, which includes the MAIL FROM, RCPT TO and DATA commands.
+	length = st_length_get(mailfrom) + 21;
+
+	for (holder = recipients; holder; holder = (smtp_recipients_t *)holder->next) {
+		length += st_length_get(holder->address) + 13;
+	}
+
+	if (!(batch = st_alloc(length + 1))) {
+		log_pedantic("Unable to allocate %zu bytes for the pipelined commands.", length + 1);
+		return -1;
+	}
+
+	used += snprintf(st_char_get(batch), length + 1, "MAIL FROM: <%.*s>\r\n", st_length_int(mailfrom), st_char_get(mailfrom));
+
+	for (holder = recipients; holder; holder = (smtp_recipients_t *)holder->next) {
+		used += snprintf(st_char_get(batch) + used, length + 1 - used, "RCPT TO: <%.*s>\r\n", st_length_int(holder->address),
+			st_char_get(holder->address));
+	}
+
+	used += snprintf(st_char_get(batch) + used, length + 1 - used, "DATA\r\n");
+	st_length_set(batch, used);
+
+	// Until every reply has been read, the session is out of step with the relay.
+	client->options |= SMTP_CLIENT_PENDING;
+
+	if (client_write(client, batch) != st_length_get(batch)) {
+		log_pedantic("An error occurred while attempting to send the pipelined commands.");
+		st_free(batch);
+		return -1;
+	}
+
+	st_free(batch);
+
+	if (client_read_line(client) <= 0) {
+		log_pedantic("An error occurred while attempting to send the MAIL FROM command.");
+		return -1;
+	}
+	else if (!pl_starts_with_char(client->line, '2')) {
+		log_pedantic("An error occurred while attempting to send the MAIL FROM command. {mailfrom = %.*s / response = %.*s}",
+			st_length_int(mailfrom), st_char_get(mailfrom), st_length_int(&(client->line)), st_char_get(&(client->line)));
+		return -2;
+	}
+
+	for (holder = recipients; holder; holder = (smtp_recipients_t *)holder->next) {
+
+		if (client_read_line(client) <= 0) {
+			log_pedantic("An error occurred while attempting to send the RCPT TO command.");
+			return -1;
+		}
+		else if (!pl_starts_with_char(client->line, '2')) {
+			log_pedantic("An error occurred while attempting to send the RCPT TO command. {rcptto = %.*s / response = %.*s}",
+				st_length_int(holder->address), st_char_get(holder->address), st_length_int(&(client->line)), st_char_get(&(client->line)));
+			return -2;
+		}
+
+	}
+
+	if (client_read_line(client) <= 0) {
+		log_pedantic("An error occurred while trying to send the DATA command.");
+		return -1;
+	}
+
+	client->options &= ~SMTP_CLIENT_PENDING;
+
+	if (!pl_starts_with_char(client->line, '3')) {
+		log_pedantic("An error occurred while trying to send the DATA command. { response = %.*s }", st_length_int(&(client->line)),
+			st_char_get(&(client->line)));
+		return -2;
+	}
+
+	client->options |= SMTP_CLIENT_DATA;
+
+	return 1;
+}
+
 /**
  * @brief	Issue a DATA command to an smtp server, and wait for a successful response.
  * @param	client		a pointer to the network client to issue the DATA command.
@@ -235,9 +620,14 @@ int_t smtp_client_send_data(client_t *client, stringer_t *message, bool_t dotstu
 
 	int64_t sent = 0, line = 0;
 	stringer_t *duplicate = NULL;
+	bool_t pipelined = (client->options & SMTP_CLIENT_DATA) ? true : false;
+
+	// If the DATA command was pipelined with the envelope, the relay is already waiting for the message.
+	client->options &= ~SMTP_CLIENT_DATA;
 
 	if (st_empty(message)) {
 		log_pedantic("The naked mail relay was asked to send an empty message buffer.");
+		if (pipelined) client->options |= SMTP_CLIENT_PENDING;
 		return -3;
 	}
 
@@ -250,6 +640,7 @@ int_t smtp_client_send_data(client_t *client, stringer_t *message, bool_t dotstu
 		// easy resizing.
 		if (!(duplicate = st_dupe_opts(MAPPED_T | JOINTED | HEAP, message)) || st_replace(&duplicate, PLACER("\n.", 2), PLACER("\n..", 3)) < 0) {
 			log_pedantic("The naked mail message could not be properly dot stuffed in preparation for sending.");
+			if (pipelined) client->options |= SMTP_CLIENT_PENDING;
 			return -3;
 		}
 
@@ -257,7 +648,8 @@ int_t smtp_client_send_data(client_t *client, stringer_t *message, bool_t dotstu
 	}
 
 	// Send the DATA command and confirm the proceed response was recieved in response.
-	if ((sent = client_write(client, PLACER("DATA\r\n", 6))) != 6 || (line = client_read_line(client)) <= 0 || !pl_starts_with_char(client->line, '3')) {
+	if (!pipelined && ((sent = client_write(client, PLACER("DATA\r\n", 6))) != 6 || (line = client_read_line(client)) <= 0 ||
+		!pl_starts_with_char(client->line, '3'))) {
 
 		log_pedantic("A%serror occurred while trying to send the DATA command.%s", (sent != 6 || line <= 0 ? " network " : "n "),
 			(sent == 6 && line > 0 ? st_char_get(st_quick(MANAGEDBUF(1024), " { response = %.*s }", st_length_int(&(client->line)),
@@ -29,6 +29,11 @@ void smtp_starttls(connection_t *con) {
 
 	con_write_bl(con, "220 READY\r\n", 11);
 
+	// The response must reach the client before the negotiation starts, and it can't be left in the output buffer, where it would be encrypted.
+	if (con_flush(con) < 0) {
+		return;
+	}
+
 	if (!(con->network.tls = tls_server_alloc(con->server, con->network.sockd, M_SSL_BIO_NOCLOSE))) {
 		con_write_bl(con, "454 STARTTLS FAILED\r\n", 21);
 		log_pedantic("The SSL connection attempt failed.");
@@ -572,8 +577,8 @@ void smtp_rcpt_to(connection_t *con) {
 		return;
 	}
 
-	// Hit the mailboxes table, and see if this is a legitimate address.
-	state = smtp_fetch_inbound(sanitized, &result);
+	// Hit the mailboxes table, unless the address was looked up recently, and see if this is a legitimate address.
+	state = smtp_prefs_fetch(sanitized, &result);
 	st_free(sanitized);
 
 	// If the account is locked.
@@ -813,10 +818,43 @@ void smtp_data_finish(connection_t *con, size_t read, int_t checker) {
 	return;
 }
 
+/**
+ * @brief	Make sure the buffer used to hold an incoming message has room for a specified number of bytes.
+ * @note	The buffer size is doubled each time it runs out of room, so large messages are only copied a handful of times.
+ * @param	result	a pointer to the managed string holding the message, which will be updated if the buffer moves.
+ * @param	size	a pointer to the current buffer size, which will be updated if the buffer grows.
+ * @param	needed	the number of bytes that must fit inside the buffer.
+ * @return	true if the buffer is large enough, or false if the buffer couldn't be resized.
+ */
+bool_t smtp_data_reserve(stringer_t **result, size_t *size, size_t needed) {
+
+	size_t grow = *size;
+	stringer_t *holder;
+
+	if (needed <= *size) {
+		return true;
+	}
+
+	while (grow < needed) {
+		grow *= 2;
+	}
+
+	if (!(holder = st_realloc(*result, grow))) {
+		log_pedantic("Attempted to allocate a buffer of %zu bytes to hold an incoming message, and failed. Returning an error to the client.", grow);
+		return false;
+	}
+
+	*result = holder;
+	*size = grow;
+
+	return true;
+}
+
 int_t smtp_data_read(connection_t *con, stringer_t **message) {
 
+	size_t span;
 	chr_t *stream, *buffer;
-	stringer_t *result, *holder;
+	stringer_t *result;
 	int_t read = 0, increment;
 	size_t used = 0, size = 128 * 1024;
 	int_t header = 1, checker = 1, carriage = 0;
@@ -825,7 +863,7 @@ int_t smtp_data_read(connection_t *con, stringer_t **message) {
 	*message = NULL;
 	stream = st_data_get(con->network.buffer);
 
-	// Expand the stringer in 128 KB chunks.
+	// Start with a 128 KB buffer, and double it whenever we run out of room.
 	if (!(result = st_alloc_opts(MAPPED_T | JOINTED | HEAP, size))) {
 		smtp_data_finish(con, 0, checker);
 		return -1;
@@ -851,6 +889,28 @@ int_t smtp_data_read(connection_t *con, stringer_t **message) {
 		// Read in the new data.
 		for (increment = 0; checker != 4 && increment < read; increment++) {
 
+			// Runs of bytes which aren't line breaks leave the parser state unchanged, unless we're in the middle of a line break sequence,
+			// so we locate the end of the run in bulk and copy it in one go. In header mode, the run also ends at any non-ASCII byte,
+			// since those are dropped by the logic below.
+			if (checker == 0 && carriage == 0 && (header == 0 || header == 3) && (span = mm_span_text(stream, read - increment, header != 3))) {
+
+				if (!smtp_data_reserve(&result, &size, used + span + 32)) {
+					smtp_data_finish(con, read, checker);
+					st_free(result);
+					return -1;
+				}
+
+				buffer = st_char_get(result) + used;
+				mm_copy(buffer, stream, span);
+				buffer += span;
+				used += span;
+				stream += span;
+
+				// The loop increment accounts for the last byte in the span.
+				increment += span - 1;
+				continue;
+			}
+
 			// Logic for detecting header mode.
 			if (header != 3) {
 				if (header == 0 && *stream == '\n') {
@@ -918,16 +978,13 @@ int_t smtp_data_read(connection_t *con, stringer_t **message) {
 
 			// Make sure we have enough room in the buffer.
 			if (used + 32 > size) {
-				if ((holder = st_realloc(result, size + (128 * 1024))) == NULL) {
-					log_pedantic("Attempted to allocate a buffer of %zu bytes to hold an incoming message, and failed. Returning an error to the client.", size + (128 * 1024));
+				if (!smtp_data_reserve(&result, &size, used + 32)) {
 					smtp_data_finish(con, read, checker);
 					st_free(result);
 					return -1;
 				}
 
-				// Setup the pointers again.
-				size += 128 * 1024;
-				result = holder;
+				// Setup the pointer again.
 				buffer = st_char_get(result) + used;
 			}
 
@@ -1060,6 +1117,9 @@ void smtp_data_inbound(connection_t *con) {
 	smtp_inbound_prefs_t *current;
 	uint32_t perm_errors = 0, temp_errors = 0, delivered = 0, bounces = 0;
 
+	// Run the checks which only depend on the message once, concurrently, so the results can be shared by every recipient.
+	smtp_pipeline_run(con);
+
 	current = con->smtp.in_prefs;
 	while (current != NULL) {
 
@@ -8,6 +8,77 @@
 #ifndef MAGMA_SERVERS_SMTP_H
 #define MAGMA_SERVERS_SMTP_H
 
+// The blacklist result cache holds SMTP_RBL_CACHE_SLOTS entries, split across SMTP_RBL_CACHE_SHARDS locks. Results are cached for
+// their DNS TTL, capped at SMTP_RBL_CACHE_TTL seconds. Negative answers without an SOA record are cached for SMTP_RBL_NEGATIVE_TTL seconds.
+#define SMTP_RBL_CACHE_SLOTS 65536
+#define SMTP_RBL_CACHE_SHARDS 16
+#define SMTP_RBL_CACHE_TTL 3600
+#define SMTP_RBL_NEGATIVE_TTL 300
+#define SMTP_RBL_PACKET_SIZE 4096
+
+// The compiled filter cache holds the programs for SMTP_FILTER_CACHE_SLOTS users, split across SMTP_FILTER_CACHE_SHARDS locks.
+#define SMTP_FILTER_CACHE_SLOTS 4096
+#define SMTP_FILTER_CACHE_SHARDS 16
+
+// The recipient preference cache holds SMTP_PREFS_CACHE_SLOTS addresses, split across SMTP_PREFS_CACHE_SHARDS locks. Valid recipients
+// are cached for SMTP_PREFS_CACHE_TTL seconds, while unknown, non-local and locked recipients are cached for SMTP_PREFS_NEGATIVE_TTL seconds.
+#define SMTP_PREFS_CACHE_SLOTS 16384
+#define SMTP_PREFS_CACHE_SHARDS 16
+#define SMTP_PREFS_CACHE_TTL 120
+#define SMTP_PREFS_NEGATIVE_TTL 60
+
+// The message checkers, in the order their latency histograms are resolved. Only the first SMTP_PIPELINE_SHARED checkers depend
+// solely on the message, so they are run once per message by the checker pool. The spam filter depends on the recipient.
+#define SMTP_PIPELINE_VIRUS 0
+#define SMTP_PIPELINE_DKIM 1
+#define SMTP_PIPELINE_SPF 2
+#define SMTP_PIPELINE_DSPAM 3
+#define SMTP_PIPELINE_SHARED 3
+#define SMTP_PIPELINE_CHECKERS 4
+
+// Stored as the virus result when the scan was still running at its deadline, so the message is deferred instead of delivered unscanned.
+#define SMTP_PIPELINE_TIMEOUT -4
+
+// The checks being run on a single inbound message. The structure is reference counted, since a checker which misses its deadline
+// keeps running after the connection has moved on.
+typedef struct {
+	sem_t done; /* Posted every time a checker finishes. */
+	pthread_mutex_t lock;
+	uint32_t refs;
+	ip_t ip;
+	stringer_t *id, *text, *helo, *mailfrom;
+	struct {
+		int_t result;
+		bool_t launched, started, finished, expired;
+		struct timespec deadline;
+	} checkers[SMTP_PIPELINE_SHARED];
+} smtp_pipeline_t;
+
+// A single checker waiting to be run by the checker pool.
+typedef struct smtp_pipeline_task_t {
+	uint_t checker;
+	smtp_pipeline_t *pipeline;
+	struct smtp_pipeline_task_t *next;
+} smtp_pipeline_task_t;
+
+// The compiled form of a user's inbound filter expressions.
+typedef struct {
+	uint64_t usernum; /* The user who owns the filters. */
+	uint64_t serial; /* A checksum of the filter expressions, used to detect changes. */
+	uint32_t count; /* The number of filters. */
+	int_t *errors; /* The regcomp() result for each filter, which is zero if the expression compiled. */
+	struct re_pattern_buffer *patterns; /* The compiled expressions, in the order the filters are applied. */
+} smtp_filter_program_t;
+
+// The idle connections and load information kept for each mail relay.
+typedef struct {
+	pthread_mutex_t lock;
+	uint32_t count; /* The number of idle connections held by the pool. */
+	uint32_t outstanding; /* The number of connections currently checked out of the pool. */
+	time_t failed; /* When the last connection attempt failed. */
+	client_t **idle; /* The idle connections, ordered from the least to the most recently used. */
+} smtp_relay_pool_t;
+
 /// accept.c
 int_t   smtp_accept_message(connection_t *con, smtp_inbound_prefs_t *prefs);
 int_t   smtp_rollout(smtp_inbound_prefs_t *prefs);
@@ -34,6 +105,7 @@ int_t         smtp_check_transmit_quota(uint64_t usernum, size_t num_recipients,
 int_t         smtp_fetch_authorization(stringer_t *username, stringer_t *verification, smtp_outbound_prefs_t **output);
 stringer_t *  smtp_fetch_autoreply(uint64_t autoreply, uint64_t usernum);
 int_t         smtp_fetch_inbound(stringer_t *address, smtp_inbound_prefs_t **output);
+int_t         smtp_fetch_quota(smtp_inbound_prefs_t *prefs);
 table_t *     smtp_fetch_rollmessages(uint64_t usernum);
 int_t         smtp_get_action(chr_t *string, size_t length);
 uint64_t      smtp_insert_spamsig(smtp_inbound_prefs_t *prefs, uint64_t key, int_t code);
@@ -45,6 +117,7 @@ void   smtp_auth_login(connection_t *con);
 void   smtp_auth_plain(connection_t *con);
 void   smtp_data(connection_t *con);
 void   smtp_data(connection_t *con);
+int_t  smtp_data_read(connection_t *con, stringer_t **message);
 void   smtp_disabled(connection_t *con);
 void   smtp_ehlo(connection_t *con);
 void   smtp_helo(connection_t *con);
@@ -58,16 +131,60 @@ void   smtp_rset(connection_t *con);
 void   smtp_starttls(connection_t *con);
 void   submission_init(connection_t *con);
 
+/// filters.c
+smtp_filter_program_t *  smtp_filters_compile(uint64_t usernum, inx_t *filters);
+void                     smtp_filters_free(smtp_filter_program_t *program);
+smtp_filter_program_t *  smtp_filters_get(uint64_t usernum, inx_t *filters);
+void                     smtp_filters_release(smtp_filter_program_t *program);
+uint64_t                 smtp_filters_serial(inx_t *filters, uint32_t *count);
+bool_t                   smtp_filters_start(void);
+void                     smtp_filters_stop(void);
+
 /// parse.c
 stringer_t *  smtp_parse_auth(stringer_t *data);
 stringer_t *  smtp_parse_helo_domain(connection_t *con);
 stringer_t *  smtp_parse_mail_from_path(connection_t *con);
 stringer_t *  smtp_parse_rcpt_to(connection_t *con);
 
+/// pipeline.c
+int_t    smtp_pipeline_dspam(uint64_t usernum, stringer_t *message, stringer_t **signature);
+int_t    smtp_pipeline_execute(smtp_pipeline_t *pipeline, uint_t checker);
+void     smtp_pipeline_release(smtp_pipeline_t *pipeline);
+void     smtp_pipeline_run(connection_t *con);
+bool_t   smtp_pipeline_start(void);
+void     smtp_pipeline_stop(void);
+void *   smtp_pipeline_worker(void *unused);
+
+/// prefs.c
+int_t                   smtp_prefs_cache_get(stringer_t *address, smtp_inbound_prefs_t **output);
+void                    smtp_prefs_cache_set(stringer_t *address, int_t result, smtp_inbound_prefs_t *inbound);
+smtp_inbound_prefs_t *  smtp_prefs_dupe(smtp_inbound_prefs_t *inbound);
+int_t                   smtp_prefs_fetch(stringer_t *address, smtp_inbound_prefs_t **output);
+bool_t                  smtp_prefs_start(void);
+void                    smtp_prefs_stop(void);
+
+/// rbl.c
+int_t   smtp_rbl_cache_get(chr_t *name);
+void    smtp_rbl_cache_set(chr_t *name, int_t result, uint32_t ttl);
+int_t   smtp_rbl_check(stringer_t *addr);
+void    smtp_rbl_lookup(chr_t **names, int_t *results, uint32_t *ttls, uint32_t count);
+void    smtp_rbl_lookup_serial(chr_t **names, int_t *results, uint32_t *ttls, uint32_t count);
+int_t   smtp_rbl_parse(uchr_t *answer, size_t length, uint32_t *ttl);
+bool_t  smtp_rbl_start(void);
+void    smtp_rbl_stop(void);
+
 /// relay.c
 void        smtp_client_close(client_t *client);
 client_t *  smtp_client_connect(int_t premium);
+client_t *  smtp_client_open(relay_t *relay);
+int_t       smtp_client_pick(int_t premium);
+client_t *  smtp_client_pool_get(smtp_relay_pool_t *pool);
+void        smtp_client_pool_prune(smtp_relay_pool_t *pool);
+bool_t      smtp_client_pool_start(void);
+void        smtp_client_pool_stop(void);
+void        smtp_client_release(client_t *client);
 int_t       smtp_client_send_data(client_t *client, stringer_t *message, bool_t dotstuffed);
+int_t       smtp_client_send_envelope(client_t *client, stringer_t *mailfrom, smtp_recipients_t *recipients);
 int_t       smtp_client_send_helo(client_t *client);
 int_t       smtp_client_send_mailfrom(client_t *client, stringer_t *mailfrom, size_t send_size);
 int_t       smtp_client_send_nullfrom(client_t *client);
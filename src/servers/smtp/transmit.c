@@ -13,7 +13,7 @@
  * 			1. Necessary outbound headers are attached to the message.*
  * 			2. An outbound connection to a mail relay server is established (with a premium or normal server pool).
  * 			3. Once the connection is negotiated, an RCPT TO command is issued for each of the message's recipients.
- * 			4. The mail message data is sent and the client connection is closed.
+ * 			4. The mail message data is sent and the client connection is returned to the pool.
  * @param	con		a pointer to the connection object across which the outbound mail was attempted to be sent.
  * @param	result	a pointer to the address of a managed string that will receive the server's last response to the mail send attempt,
  * 			regardless of whether or not it was successful.
@@ -22,7 +22,6 @@
 int_t smtp_relay_message(connection_t *con, stringer_t **result) {
 
 	int_t state;
-	smtp_recipients_t *holder;
 	client_t *client;
 
 	if (!result || !con || !con->smtp.message || !con->smtp.message->text || !con->smtp.out_prefs->recipients) {
@@ -51,39 +50,19 @@ int_t smtp_relay_message(connection_t *con, stringer_t **result) {
 		return -1;
 	}
 
-	// Send MAIL FROM.
-	if ((state = smtp_client_send_mailfrom(client, con->smtp.mailfrom, 0)) == -2) {
-		log_pedantic("An error occurred while trying to send the mail from.");
+	// Send the MAIL FROM and RCPT TO commands, which are pipelined along with the DATA command if the relay supports it.
+	if ((state = smtp_client_send_envelope(client, con->smtp.mailfrom, con->smtp.out_prefs->recipients)) == -2) {
+		log_pedantic("An error occurred while trying to send the message envelope.");
 		*result = st_dupe_opts(MANAGED_T | CONTIGUOUS | HEAP, &(client->line));
 		smtp_client_close(client);
 		return -1;
 	}
 	else if (state != 1) {
-		log_pedantic("An error occurred while trying to send the mail from.");
+		log_pedantic("An error occurred while trying to send the message envelope.");
 		smtp_client_close(client);
 		return -1;
 	}
 
-	// Send the RCPT TO command.
-	holder = con->smtp.out_prefs->recipients;
-
-	while (holder) {
-
-		if ((state = smtp_client_send_rcptto(client, holder->address)) == -2) {
-			log_pedantic("An error occurred while trying to send a rcpt to command.");
-			*result = st_dupe_opts(MANAGED_T | CONTIGUOUS | HEAP, &(client->line));
-			smtp_client_close(client);
-			return -1;
-		}
-		else if (state != 1) {
-			log_pedantic("An error occurred while trying to send a rcpt to command.");
-			smtp_client_close(client);
-			return -1;
-		}
-
-		holder = (smtp_recipients_t *)holder->next;
-	}
-
 	// Ensure the message is properly dot stuffed before sending.
 	st_replace(&(con->smtp.message->text), PLACER("\n.", 2), PLACER("\n..", 3));
 
@@ -102,9 +81,9 @@ int_t smtp_relay_message(connection_t *con, stringer_t **result) {
 		return -1;
 	}
 
-	// Store the result.
+	// Store the result, and return the connection to the pool so the next message can reuse it.
 	*result = st_dupe_opts(MANAGED_T | CONTIGUOUS | HEAP, &(client->line));
-	smtp_client_close(client);
+	smtp_client_release(client);
 
 	return 1;
 }
@@ -169,8 +148,8 @@ int_t smtp_forward_message(server_t *server, stringer_t *address, stringer_t *me
 		return -1;
 	}
 
-	// Store the result.
-	smtp_client_close(client);
+	// Return the connection to the pool.
+	smtp_client_release(client);
 	st_free(new);
 
 	return 1;
@@ -544,8 +523,8 @@ int_t smtp_send_message(stringer_t *to, stringer_t *from, stringer_t *message) {
 		return -1;
 	}
 
-	// Store the result.
-	smtp_client_close(client);
+	// Return the connection to the pool.
+	smtp_client_release(client);
 
 	return 1;
 }
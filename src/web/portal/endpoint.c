@@ -829,7 +829,7 @@ void portal_endpoint_folders_rename(connection_t *con) {
 	// And finally, increment the serial number. If the serial number indicates no outside changes we can increment it without forcing a refresh.
 	if (context == PORTAL_ENDPOINT_CONTEXT_MAIL) {
 
-		if (con->http.session->user->serials.folders == serial_get(OBJECT_FOLDERS, con->http.session->user->usernum)) {
+		if (con->http.session->user->serials.folders == serial_get_uncached(OBJECT_FOLDERS, con->http.session->user->usernum)) {
 			con->http.session->user->serials.folders = serial_increment(OBJECT_FOLDERS, con->http.session->user->usernum);
 		}
 		// Increment the reference counter and queue a session update.
@@ -840,7 +840,7 @@ void portal_endpoint_folders_rename(connection_t *con) {
 
 	} else if (context == PORTAL_ENDPOINT_CONTEXT_CONTACTS) {
 
-		if (con->http.session->user->serials.contacts == serial_get(OBJECT_CONTACTS, con->http.session->user->usernum)) {
+		if (con->http.session->user->serials.contacts == serial_get_uncached(OBJECT_CONTACTS, con->http.session->user->usernum)) {
 			con->http.session->user->serials.contacts = serial_increment(OBJECT_CONTACTS, con->http.session->user->usernum);
 		}
 		// Increment the reference counter and queue a session update.
@@ -1113,12 +1113,12 @@ void portal_endpoint_messages_copy(connection_t *con) {
 		}
 
 		// If any messages are copied to a different folder we'll need to update the sequence numbers to reflect the new status.
-		meta_messages_update_sequences(con->http.session->user->folders, con->http.session->user->messages);
+		meta_messages_update_sequences(con->http.session->user);
 
 		if (commit) {
 
 			// And finally, increment the serial number. If the serial number indicates no outside changes we can increment it without forcing a refresh.
-			if (con->http.session->user->serials.messages == serial_get(OBJECT_MESSAGES, con->http.session->user->usernum)) {
+			if (con->http.session->user->serials.messages == serial_get_uncached(OBJECT_MESSAGES, con->http.session->user->usernum)) {
 				con->http.session->user->serials.messages = serial_increment(OBJECT_MESSAGES, con->http.session->user->usernum);
 			}
 			// Increment the reference counter and queue a session update.
@@ -1296,7 +1296,7 @@ void portal_endpoint_messages_flag(connection_t *con) {
 			}
 
 			// And finally, increment the serial number. If the serial number indicates no outside changes we can increment it without forcing a refresh.
-			if (con->http.session->user->serials.messages == serial_get(OBJECT_MESSAGES, con->http.session->user->usernum)) {
+			if (con->http.session->user->serials.messages == serial_get_uncached(OBJECT_MESSAGES, con->http.session->user->usernum)) {
 				con->http.session->user->serials.messages = serial_increment(OBJECT_MESSAGES, con->http.session->user->usernum);
 			}
 			// Increment the reference counter and queue a session update.
@@ -1402,12 +1402,12 @@ void portal_endpoint_messages_move(connection_t *con) {
 		}
 
 		// If any messages are moved to a different folder we'll need to update the sequence numbers to reflect the new status.
-		meta_messages_update_sequences(con->http.session->user->folders, con->http.session->user->messages);
+		meta_messages_update_sequences(con->http.session->user);
 
 		if (commit) {
 
 			// And finally, increment the serial number. If the serial number indicates no outside changes we can increment it without forcing a refresh.
-			if (con->http.session->user->serials.messages == serial_get(OBJECT_MESSAGES, con->http.session->user->usernum)) {
+			if (con->http.session->user->serials.messages == serial_get_uncached(OBJECT_MESSAGES, con->http.session->user->usernum)) {
 				con->http.session->user->serials.messages = serial_increment(OBJECT_MESSAGES, con->http.session->user->usernum);
 			}
 			// Increment the reference counter and queue a session update.
@@ -1485,12 +1485,12 @@ void portal_endpoint_messages_remove(connection_t *con) {
 		}
 
 		// If any messages are moved to a different folder we'll need to update the sequence numbers to reflect the new status.
-		meta_messages_update_sequences(con->http.session->user->folders, con->http.session->user->messages);
+		meta_messages_update_sequences(con->http.session->user);
 
 		if (commit) {
 
 			// And finally, increment the serial number. If the serial number indicates no outside changes we can increment it without forcing a refresh.
-			if (con->http.session->user->serials.messages == serial_get(OBJECT_MESSAGES, con->http.session->user->usernum)) {
+			if (con->http.session->user->serials.messages == serial_get_uncached(OBJECT_MESSAGES, con->http.session->user->usernum)) {
 				con->http.session->user->serials.messages = serial_increment(OBJECT_MESSAGES, con->http.session->user->usernum);
 			}
 			// Increment the reference counter and queue a session update.
@@ -156,7 +156,7 @@ bool_t portal_smtp_relay_message(stringer_t *from, inx_t *to, stringer_t *data,
 
 	// Store the result.
 	//*result = st_dupe_opts(MANAGED_T | CONTIGUOUS | HEAP, &(client->line));
-	smtp_client_close(client);
+	smtp_client_release(client);
 
 	// TODO: smtp_update_transmission_stats() needs to be called here.
 	return true;
@@ -120,9 +120,9 @@ json_t * portal_message_body(meta_message_t *meta, mail_message_t *data) {
 	for (size_t i = 0; !quarry && i < MAIL_MIME_RECURSION_LIMIT; i++) {
 
 		// Keep diving through multipart messages until we find our quary.
-		if (active && active->children && (active->type == MESSAGE_TYPE_MULTI_RELATED || active->type == MESSAGE_TYPE_MULTI_MIXED ||
+		if (active && mail_mime_children(active) && (active->type == MESSAGE_TYPE_MULTI_RELATED || active->type == MESSAGE_TYPE_MULTI_MIXED ||
 			active->type == MESSAGE_TYPE_HTML || active->type == MESSAGE_TYPE_MULTI_ALTERNATIVE || active->type == MESSAGE_TYPE_MULTI_UNKOWN)) {
-			active = ar_field_ptr(active->children, 0);
+			active = ar_field_ptr(mail_mime_children(active), 0);
 		}
 
 		if (active && (active->type == MESSAGE_TYPE_HTML || active->type == MESSAGE_TYPE_PLAIN)) {
@@ -174,7 +174,7 @@ json_t * portal_message_attachments(meta_message_t *meta, mail_message_t *data)
 		return array;
 	}
 
-	if (data->mime->type == MESSAGE_TYPE_MULTI_MIXED && (count = ar_length_get(data->mime->children))) {
+	if (data->mime->type == MESSAGE_TYPE_MULTI_MIXED && (count = ar_length_get(mail_mime_children(data->mime)))) {
 
 		// Start at one so we skip the first MIME part. Presumably because the first entry is the display data.
 		for (size_t i = 1; i < count; i++) {
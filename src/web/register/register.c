@@ -16,24 +16,14 @@
  */
 void register_print_message(connection_t *con, chr_t *message) {
 
-	stringer_t *template;
-	http_content_t *content;
+	http_slot_t slots[] = {
+		{ .name = "MESSAGE", .value = NULLER(message) }
+	};
 
-	if (!(content = http_get_template("register/message")) || !(template = st_dupe(content->resource))) {
+	if (!http_template_print(con, "register/message", slots, sizeof(slots) / sizeof(http_slot_t))) {
 		http_print_500(con);
-		return;
-	}
-
-	if (st_replace(&template, PLACER("$MESSAGE$", 9), NULLER(message)) != 1) {
-		http_print_500(con);
-		st_free(template);
-		return;
 	}
 
-	http_response_header(con, 200, content->type, st_length_get(template));
-	con_write_st(con, template);
-	st_free(template);
-
 	return;
 }
 
@@ -77,39 +67,16 @@ void register_print_captcha(connection_t *con, register_session_t *reg) {
  */
 void register_print_step1(connection_t *con, register_session_t *reg, chr_t *message) {
 
-	stringer_t *template, *pmessage = NULL;
-	http_content_t *content;
-
-	if (message) {
-		pmessage = PLACER(message, ns_length_get(message));
-	}
+	http_slot_t slots[] = {
+		{ .name = "USERNAME", .value = reg->username },
+		{ .name = "ERROR", .value = message ? NULLER(message) : NULL },
+		{ .name = "SESSION", .value = reg->name }
+	};
 
-	if (!(content = http_get_template("register/step1")) || !(template = st_dupe(content->resource))) {
+	if (!http_template_print(con, "register/step1", slots, sizeof(slots) / sizeof(http_slot_t))) {
 		http_print_500_log(con, "Could not open user registration template.");
-		return;
-	}
-
-	if ((reg->username && st_replace(&template, PLACER("$USERNAME$", 10), reg->username) != 1) || (!reg->username && st_replace(&template, PLACER("$USERNAME$", 10), PLACER("", 0)) != 1)) {
-		http_print_500_log(con, "Unable to process username variable in registration template.");
-		st_free(template);
-		return;
 	}
 
-	if ((pmessage && st_replace(&template, PLACER("$ERROR$", 7), pmessage) != 1) || (!message && st_replace(&template, PLACER("$ERROR$", 7), PLACER("", 0)) != 1)) {
-		http_print_500_log(con, "Unable to process error variable in registration template.");
-		st_free(template);
-		return;
-	}
-	if (st_replace(&template, PLACER("$SESSION$", 9), reg->name) != 2) {
-		http_print_500_log(con, "Unable to process session variable in registration template.");
-		st_free(template);
-		return;
-	}
-
-	http_response_header(con, 200, content->type, st_length_get(template));
-	con_write_st(con, template);
-	st_free(template);
-
 	return;
 }
 
@@ -124,35 +91,15 @@ void register_print_step1(connection_t *con, register_session_t *reg, chr_t *mes
  */
 void register_print_step2(connection_t *con, register_session_t *reg, chr_t *message) {
 
-	http_content_t *content;
-	stringer_t *template, *pmessage = NULL;
-
-	if (message) {
-		pmessage = PLACER(message, ns_length_get(message));
-	}
+	http_slot_t slots[] = {
+		{ .name = "ERROR", .value = message ? NULLER(message) : NULL },
+		{ .name = "SESSION", .value = reg->name }
+	};
 
-	if (!(content = http_get_template("register/step2")) || !(template = st_dupe(content->resource))) {
+	if (!http_template_print(con, "register/step2", slots, sizeof(slots) / sizeof(http_slot_t))) {
 		http_print_500_log(con, "Could not load step2 template.");
-		return;
-	}
-
-	if ((message && st_replace(&template, PLACER("$ERROR$", 7), pmessage) != 1) || (!message && st_replace(&template, PLACER("$ERROR$", 7), PLACER("", 0)) != 1)) {
-		http_print_500_log(con, "Unable to replace variable $ERROR$ in step 2 template.");
-		st_free(template);
-		return;
 	}
 
-	if (st_replace(&template, PLACER("$SESSION$", 9), reg->name) != 1) {
-		http_print_500_log(con, "Unable to replace variable $SESSIONS$ in step 2 template.");
-		st_free(template);
-		return;
-	}
-
-	// Short-circuit all of this for now.
-	http_response_header(con, 200, content->type, st_length_get(template));
-	con_write_st(con, template);
-	st_free(template);
-
 	return;
 }
 
@@ -163,18 +110,10 @@ void register_print_step2(connection_t *con, register_session_t *reg, chr_t *mes
  */
 void register_print_step3(connection_t *con) {
 
-	stringer_t *template;
-	http_content_t *content;
-
-	if (!(content = http_get_template("register/step3"))  || !(template = st_dupe(content->resource))) {
+	if (!http_template_print(con, "register/step3", NULL, 0)) {
 		http_print_500(con);
-		return;
 	}
 
-	http_response_header(con, 200, content->type, st_length_get(template));
-	con_write_st(con, template);
-	st_free(template);
-
 	return;
 }
 